@@ -0,0 +1,26 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "arkin_core.h"
+
+// Runs 'func' until at least 'min_time' seconds have passed and returns the
+// average time in seconds of a single run.
+#define BENCH_RUN(min_time, ...) ({ \
+    U64 _bench_iters = 0; \
+    F64 _bench_start = ar_os_get_time(); \
+    F64 _bench_elapsed = 0.0; \
+    do { \
+        __VA_ARGS__; \
+        _bench_iters++; \
+        _bench_elapsed = ar_os_get_time() - _bench_start; \
+    } while (_bench_elapsed < (min_time)); \
+    _bench_elapsed / _bench_iters; \
+})
+
+// Keeps the compiler from optimizing away results.
+#define BENCH_KEEP(value) __asm__ volatile("" : : "r"(value) : "memory")
+
+extern void bench_strings(ArArena *arena);
+extern void bench_os(ArArena *arena);
+
+#endif
@@ -0,0 +1,16 @@
+#include "arkin_core.h"
+#include "arkin_log.h"
+
+#include "bench.h"
+
+I32 main(void) {
+    arkin_init(&(ArkinCoreDesc) {0});
+    ArArena *arena = ar_arena_create_default();
+
+    bench_strings(arena);
+    bench_os(arena);
+
+    ar_arena_destroy(&arena);
+    arkin_terminate();
+    return 0;
+}
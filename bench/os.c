@@ -0,0 +1,240 @@
+#include "arkin_core.h"
+#include "arkin_log.h"
+
+#include "bench.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const F64 MIN_TIME = 0.25;
+
+static void report(U64 bytes, F64 time, const char *fmt, ...) {
+    char name[64];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(name, sizeof(name), fmt, args);
+    va_end(args);
+
+    ar_info("%-40s %9.3f ms %7.2f GB/s", name, time * 1e3, bytes / time / 1e9);
+}
+
+// Reads every block of the file in a shuffled order, keeping up to 'depth'
+// reads in flight.
+static void io_ring_read_blocks(ArIoRing *ring, I32 fd, U8 *buffers, const U32 *order, U32 block_count, U32 block_size) {
+    ArIoRequest requests[64];
+    ArIoCompletion completions[64];
+    U32 submitted = 0;
+    U32 completed = 0;
+    while (completed < block_count) {
+        U32 count = ar_min(ar_arrlen(requests), block_count - submitted);
+        for (U32 i = 0; i < count; i++) {
+            U64 offset = (U64) order[submitted + i] * block_size;
+            requests[i] = (ArIoRequest) {
+                .op = AR_IO_OP_READ,
+                .fd = fd,
+                .offset = offset,
+                .buffer = buffers + offset,
+                .len = block_size,
+            };
+        }
+        submitted += ar_io_ring_submit(ring, requests, count);
+        completed += ar_io_ring_wait(ring, completions, ar_arrlen(completions), 1);
+    }
+}
+
+static void bench_io_ring(ArArena *arena, U64 size, U32 block_size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    U32 block_count = size / block_size;
+    U8 *buffers = ar_arena_push_arr_no_zero(temp.arena, U8, size);
+    U32 *order = ar_arena_push_arr_no_zero(temp.arena, U32, block_count);
+    srand(1);
+    for (U32 i = 0; i < block_count; i++) {
+        order[i] = i;
+    }
+    for (U32 i = block_count - 1; i > 0; i--) {
+        U32 j = rand() % (i + 1);
+        U32 tmp = order[i];
+        order[i] = order[j];
+        order[j] = tmp;
+    }
+
+    char path[] = "/tmp/arkin_bench_XXXXXX";
+    I32 fd = mkstemp(path);
+    if (fd < 0 || ftruncate(fd, size) != 0) {
+        ar_error("Failed to create the bench file.");
+        ar_temp_end(&temp);
+        return;
+    }
+
+    B8 no_io_uring[] = {false, true};
+    F64 time = 0.0;
+    for (U32 i = 0; i < ar_arrlen(no_io_uring); i++) {
+        ArIoRing *ring = ar_io_ring_create(temp.arena, (ArIoRingDesc) {.no_io_uring = no_io_uring[i]});
+        time = BENCH_RUN(MIN_TIME, io_ring_read_blocks(ring, fd, buffers, order, block_count, block_size));
+        report(size, time, "ring, %s", ar_io_ring_uses_io_uring(ring) ? "io_uring" : "worker threads");
+        ar_io_ring_destroy(&ring);
+    }
+    time = BENCH_RUN(MIN_TIME, {
+        for (U32 i = 0; i < block_count; i++) {
+            U64 offset = (U64) order[i] * block_size;
+            BENCH_KEEP(pread(fd, buffers + offset, block_size, offset));
+        }
+    });
+    report(size, time, "  pread loop");
+
+    close(fd);
+    unlink(path);
+    ar_temp_end(&temp);
+}
+
+static void count_entries(const ArDirEntry *entries, U32 count, void *args) {
+    (void) entries;
+    __atomic_fetch_add((U64 *) args, count, __ATOMIC_RELAXED);
+}
+
+// The usual recursive opendir and readdir walk.
+static U64 walk_readdir(const char *path) {
+    DIR *dir = opendir(path);
+    if (dir == NULL) {
+        return 0;
+    }
+    U64 count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        count++;
+        if (entry->d_type == DT_DIR) {
+            char child[4096];
+            snprintf(child, sizeof(child), "%s/%s", path, entry->d_name);
+            count += walk_readdir(child);
+        }
+    }
+    closedir(dir);
+    return count;
+}
+
+static void bench_dir_walk(const char *root) {
+    U32 thread_counts[] = {1, 4, 0};
+    F64 time = 0.0;
+    // Warms up the dentry cache so every run sees the same state.
+    U64 count = walk_readdir(root);
+    for (U32 i = 0; i < ar_arrlen(thread_counts); i++) {
+        time = BENCH_RUN(MIN_TIME, {
+            count = 0;
+            ar_os_dir_walk((ArDirWalkDesc) {
+                .root = ar_str_cstr(root),
+                .func = count_entries,
+                .args = &count,
+                .thread_count = thread_counts[i],
+            });
+        });
+        char name[64];
+        if (thread_counts[i] == 0) {
+            snprintf(name, sizeof(name), "dir walk, all cores");
+        } else {
+            snprintf(name, sizeof(name), "dir walk, %u threads", thread_counts[i]);
+        }
+        ar_info("%-40s %9.3f ms %9llu entries", name, time * 1e3, count);
+    }
+    time = BENCH_RUN(MIN_TIME, count = walk_readdir(root));
+    ar_info("%-40s %9.3f ms %9llu entries", "  readdir", time * 1e3, count);
+}
+
+// Streams newline separated records through a 64 KiB ring in 1500 byte
+// chunks and counts them, against a plain ring that copies records that
+// wrap around into a separate buffer.
+static void bench_ring_buffer(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    U8 *text = ar_arena_push_arr_no_zero(temp.arena, U8, size);
+    srand(1);
+    for (U64 i = 0; i < size; i++) {
+        text[i] = rand() % 80 == 0 ? '\n' : 'a' + i % 26;
+    }
+    const U64 chunk_size = 1500;
+    const U64 capacity = KiB(64);
+
+    ArRingBuffer *ring = ar_ring_buffer_create(temp.arena, (ArRingBufferDesc) {.capacity = capacity});
+    U64 records = 0;
+    F64 time = BENCH_RUN(MIN_TIME, {
+        records = 0;
+        for (U64 offset = 0; offset < size;) {
+            offset += ar_ring_buffer_write(ring, ar_str(text + offset, ar_min(chunk_size, size - offset)));
+            ArStr data = ar_ring_buffer_read_span(ring);
+            U64 consumed = 0;
+            for (;;) {
+                const U8 *end = memchr(data.data + consumed, '\n', data.len - consumed);
+                if (end == NULL) {
+                    break;
+                }
+                BENCH_KEEP(data.data + consumed);
+                consumed = end - data.data + 1;
+                records++;
+            }
+            ar_ring_buffer_consume(ring, consumed);
+        }
+        ar_ring_buffer_consume(ring, ar_ring_buffer_len(ring));
+    });
+    report(size, time, "double mapped ring, %llu records", records);
+    ar_ring_buffer_destroy(&ring);
+
+    U8 *buffer = ar_arena_push_arr_no_zero(temp.arena, U8, capacity);
+    U8 *record = ar_arena_push_arr_no_zero(temp.arena, U8, capacity);
+    time = BENCH_RUN(MIN_TIME, {
+        records = 0;
+        U64 read_pos = 0;
+        U64 write_pos = 0;
+        for (U64 offset = 0; offset < size;) {
+            U64 len = ar_min(ar_min(chunk_size, size - offset), capacity - (write_pos - read_pos));
+            for (U64 i = 0; i < len; i++) {
+                buffer[(write_pos + i) % capacity] = text[offset + i];
+            }
+            write_pos += len;
+            offset += len;
+
+            for (;;) {
+                U64 start = read_pos % capacity;
+                U64 avail = write_pos - read_pos;
+                U64 first = ar_min(avail, capacity - start);
+                const U8 *end = memchr(buffer + start, '\n', first);
+                U64 record_len;
+                if (end != NULL) {
+                    record_len = end - (buffer + start) + 1;
+                    BENCH_KEEP(buffer + start);
+                } else {
+                    end = memchr(buffer, '\n', avail - first);
+                    if (end == NULL) {
+                        break;
+                    }
+                    // The record wraps, so it's put back together first.
+                    record_len = first + (end - buffer) + 1;
+                    memcpy(record, buffer + start, first);
+                    memcpy(record + first, buffer, record_len - first);
+                    BENCH_KEEP(record);
+                }
+                read_pos += record_len;
+                records++;
+            }
+        }
+    });
+    report(size, time, "  wrapping ring, %llu records", records);
+
+    ar_temp_end(&temp);
+}
+
+void bench_os(ArArena *arena) {
+    ar_info("random %u KiB reads over a cached %u MiB file", 4, 64);
+    bench_io_ring(arena, MiB(64), KiB(4));
+    ar_info("streaming records through a ring buffer over %u MiB", 64);
+    bench_ring_buffer(arena, MiB(64));
+    ar_info("walking %s", "/usr");
+    bench_dir_walk("/usr");
+}
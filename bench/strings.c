@@ -0,0 +1,716 @@
+#include "arkin_core.h"
+#include "arkin_log.h"
+
+#include "bench.h"
+
+#include <ctype.h>
+#include <regex.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static const F64 MIN_TIME = 0.25;
+
+// Random lowercase text with spaces and newlines sprinkled in, resembling log
+// lines.
+static ArStr gen_text(ArArena *arena, U64 len) {
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, len);
+    srand(42);
+    for (U64 i = 0; i < len; i++) {
+        U32 r = rand() % 64;
+        if (r < 8) {
+            data[i] = ' ';
+        } else if (r == 8) {
+            data[i] = '\n';
+        } else {
+            data[i] = 'a' + r % 26;
+        }
+    }
+    return ar_str(data, len);
+}
+
+// The search ar_str_find used to do, kept around as a reference point.
+static U64 find_naive(ArStr haystack, ArStr needle, ArStrMatchFlag flags) {
+    for (U64 i = 0; i + needle.len <= haystack.len; i++) {
+        U64 index = flags & AR_STR_MATCH_FLAG_LAST ? haystack.len - needle.len - i : i;
+        if (ar_str_match(needle, ar_str(haystack.data + index, needle.len), flags)) {
+            return index;
+        }
+    }
+    return haystack.len;
+}
+
+// Byte at a time validation, the way it's usually written.
+static B8 utf8_valid_naive(ArStr str) {
+    for (U64 i = 0; i < str.len;) {
+        U32 codepoint;
+        U32 len = ar_utf8_decode(ar_str(str.data + i, str.len - i), &codepoint);
+        if (codepoint == AR_UTF8_REPLACEMENT && !(len == 3 && str.data[i] == 0xef)) {
+            return false;
+        }
+        i += len;
+    }
+    return true;
+}
+
+// The per byte loops the scanning functions used to be.
+static U64 find_char_naive(ArStr haystack, char needle) {
+    for (U64 i = 0; i < haystack.len; i++) {
+        if (haystack.data[i] == needle) {
+            return i;
+        }
+    }
+    return haystack.len;
+}
+
+static ArStr trim_front_naive(ArStr str) {
+    U64 i = 0;
+    while (i < str.len && ar_char_is_whitespace(str.data[i])) {
+        i++;
+    }
+    return ar_str(str.data + i, str.len - i);
+}
+
+static B8 match_ci_naive(ArStr a, ArStr b) {
+    if (a.len != b.len) {
+        return false;
+    }
+    for (U64 i = 0; i < a.len; i++) {
+        if (ar_char_to_lower(a.data[i]) != ar_char_to_lower(b.data[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report(U64 bytes, F64 time, const char *fmt, ...) {
+    char name[64];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(name, sizeof(name), fmt, args);
+    va_end(args);
+
+    ar_info("%-40s %9.3f ms %7.2f GB/s", name, time * 1e3, bytes / time / 1e9);
+}
+
+static void bench_find(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+    // None of these occur in the text so every search scans all of it.
+    const char *needles[] = {
+        "z#",
+        "nee#le",
+        "a longer needle #n the text",
+        "an even longer needle which is long enough to be searched for with #orspool instead",
+    };
+
+    for (U32 i = 0; i < ar_arrlen(needles); i++) {
+        ArStr needle = ar_str_cstr(needles[i]);
+        ArStr haystack = text;
+
+        struct {
+            const char *name;
+            ArStrMatchFlag flags;
+        } variants[] = {
+            {"exact", AR_STR_MATCH_FLAG_EXACT},
+            {"last", AR_STR_MATCH_FLAG_LAST},
+            {"case insensitive", AR_STR_MATCH_FLAG_CASE_INSENSITIVE},
+        };
+
+        for (U32 j = 0; j < ar_arrlen(variants); j++) {
+            F64 time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_find(haystack, needle, variants[j].flags)));
+            report(size, time, "find %s, needle %llu", variants[j].name, needle.len);
+        }
+
+        F64 time = BENCH_RUN(MIN_TIME, BENCH_KEEP(find_naive(haystack, needle, AR_STR_MATCH_FLAG_EXACT)));
+        report(size, time, "  naive reference");
+    }
+
+    ar_temp_end(&temp);
+}
+
+static void bench_scan(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+    F64 time = 0.0;
+
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_find_char(text, '#', AR_STR_MATCH_FLAG_EXACT)));
+    report(size, time, "find_char exact");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_find_char(text, '#', AR_STR_MATCH_FLAG_LAST)));
+    report(size, time, "find_char last");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_find_char(text, '#', AR_STR_MATCH_FLAG_CASE_INSENSITIVE)));
+    report(size, time, "find_char case insensitive");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(find_char_naive(text, '#')));
+    report(size, time, "  naive reference");
+
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_find_any_char(text, ar_str_lit("#$%"), AR_STR_MATCH_FLAG_EXACT)));
+    report(size, time, "find_any_char, 3 bytes");
+
+    U8 *spaces = ar_arena_push_arr_no_zero(temp.arena, U8, size);
+    memset(spaces, ' ', size);
+    ArStr blank = ar_str(spaces, size);
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_trim_front(blank).len));
+    report(size, time, "trim_front, all whitespace");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(trim_front_naive(blank).len));
+    report(size, time, "  naive reference");
+
+    // Roughly one field per 64 bytes, like splitting lines.
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp split_temp = ar_temp_begin(temp.arena);
+        ArStrList lines = ar_str_split_char(split_temp.arena, text, '\n', AR_STR_MATCH_FLAG_EXACT);
+        BENCH_KEEP(lines.first);
+        ar_temp_end(&split_temp);
+    });
+    report(size, time, "split_char lines");
+    time = BENCH_RUN(MIN_TIME, {
+        U64 count = 0;
+        for (ArStrSplitIter iter = ar_str_split_iter_init(text, ar_str_lit("\n"), AR_STR_MATCH_FLAG_EXACT);
+                ar_str_split_iter_valid(&iter);
+                ar_str_split_iter_next(&iter)) {
+            count++;
+        }
+        BENCH_KEEP(count);
+    });
+    report(size, time, "split iter lines");
+
+    ar_temp_end(&temp);
+}
+
+static void bench_array(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+
+    F64 time = BENCH_RUN(MIN_TIME, {
+        ArTemp split_temp = ar_temp_begin(temp.arena);
+        ArStrList words = ar_str_split_char(split_temp.arena, text, ' ', AR_STR_MATCH_FLAG_EXACT);
+        BENCH_KEEP(words.first);
+        ar_temp_end(&split_temp);
+    });
+    report(size, time, "split_char words into list");
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp split_temp = ar_temp_begin(temp.arena);
+        ArStrArray words = ar_str_split_char_array(split_temp.arena, text, ' ', AR_STR_MATCH_FLAG_EXACT);
+        BENCH_KEEP(words.count);
+        ar_temp_end(&split_temp);
+    });
+    report(size, time, "split_char words into array");
+
+    U64 list_start = ar_arena_used(temp.arena);
+    ArStrList list = ar_str_split_char(temp.arena, text, ' ', AR_STR_MATCH_FLAG_EXACT);
+    U64 array_start = ar_arena_used(temp.arena);
+    ArStrArray array = ar_str_split_char_array(temp.arena, text, ' ', AR_STR_MATCH_FLAG_EXACT);
+    U64 array_end = ar_arena_used(temp.arena);
+
+    time = BENCH_RUN(MIN_TIME, {
+        U64 len = 0;
+        for (ArStrListNode *node = list.first; node != NULL; node = node->next) {
+            len += node->str.len;
+        }
+        BENCH_KEEP(len);
+    });
+    report(size, time, "walk list");
+    time = BENCH_RUN(MIN_TIME, {
+        U64 len = 0;
+        for (U64 i = 0; i < array.count; i++) {
+            len += ar_str_array_get(&array, i).len;
+        }
+        BENCH_KEEP(len);
+    });
+    report(size, time, "walk array");
+    // The list only holds slices of the text, the array also holds the bytes.
+    ar_info("%llu words, list %llu KiB, array %llu KiB", array.count,
+            (array_start - list_start) / KiB(1), (array_end - array_start) / KiB(1));
+
+    ar_temp_end(&temp);
+}
+
+// Counting lines of a file with the reader, mapped and streamed, against
+// reading it whole and splitting it into a list.
+static void bench_file_reader(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+    char path[] = "/tmp/arkin_bench_XXXXXX";
+    I32 fd = mkstemp(path);
+    if (fd < 0 || write(fd, text.data, text.len) != (ssize_t) text.len) {
+        ar_error("Failed to write the bench file.");
+        ar_temp_end(&temp);
+        return;
+    }
+    close(fd);
+
+    B8 no_map[] = {false, true};
+    const char *names[] = {"reader, mapped", "reader, streamed"};
+    F64 time = 0.0;
+    for (U32 i = 0; i < ar_arrlen(no_map); i++) {
+        time = BENCH_RUN(MIN_TIME, {
+            ArTemp reader_temp = ar_temp_begin(temp.arena);
+            ArFileReader *reader = ar_file_reader_open(reader_temp.arena, (ArFileReaderDesc) {
+                .path = ar_str_cstr(path),
+                .no_map = no_map[i],
+            });
+            U64 lines = 0;
+            ArStr record;
+            while (ar_file_reader_next(reader, &record)) {
+                lines++;
+            }
+            BENCH_KEEP(lines);
+            ar_file_reader_close(&reader);
+            ar_temp_end(&reader_temp);
+        });
+        report(size, time, "%s", names[i]);
+    }
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp read_temp = ar_temp_begin(temp.arena);
+        FILE *file = fopen(path, "rb");
+        U8 *data = ar_arena_push_arr_no_zero(read_temp.arena, U8, size);
+        U64 len = fread(data, 1, size, file);
+        fclose(file);
+        ArStrList list = ar_str_split_char(read_temp.arena, ar_str(data, len), '\n', AR_STR_MATCH_FLAG_EXACT);
+        BENCH_KEEP(list.last);
+        ar_temp_end(&read_temp);
+    });
+    report(size, time, "  fread and split");
+
+    unlink(path);
+    ar_temp_end(&temp);
+}
+
+static void bench_rope(ArArena *arena, U64 size, U32 edits) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+    U8 *flat = ar_arena_push_arr_no_zero(temp.arena, U8, size + edits * 8);
+
+    // Same edits on both: an insert of 8 bytes and a delete of 4 at random
+    // positions.
+    F64 time = BENCH_RUN(MIN_TIME, {
+        ArTemp rope_temp = ar_temp_begin(temp.arena);
+        ArRope *rope = ar_rope_init(rope_temp.arena, text);
+        srand(1);
+        for (U32 i = 0; i < edits; i++) {
+            U64 len = ar_rope_len(rope);
+            ar_rope_insert(rope, rand() % len, ar_str_lit("inserted"));
+            ar_rope_delete(rope, rand() % len, 4);
+        }
+        BENCH_KEEP(ar_rope_len(rope));
+        ar_temp_end(&rope_temp);
+    });
+    ar_info("%-40s %9.3f ms", "rope edits", time * 1e3);
+    time = BENCH_RUN(MIN_TIME, {
+        memcpy(flat, text.data, text.len);
+        U64 len = text.len;
+        srand(1);
+        for (U32 i = 0; i < edits; i++) {
+            U64 pos = rand() % len;
+            memmove(flat + pos + 8, flat + pos, len - pos);
+            memcpy(flat + pos, "inserted", 8);
+            len += 8;
+            pos = rand() % (len - 8);
+            U64 n = ar_min(4, len - pos);
+            memmove(flat + pos, flat + pos + n, len - pos - n);
+            len -= n;
+        }
+        BENCH_KEEP(len);
+    });
+    ar_info("%-40s %9.3f ms", "  memmove reference", time * 1e3);
+
+    ar_temp_end(&temp);
+}
+
+// Longest prefix routing of request paths, against scanning every route
+// with a sloppy length match.
+static void bench_radix_tree(ArArena *arena, U32 route_count) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr *routes = ar_arena_push_arr(temp.arena, ArStr, route_count);
+    ArRadixTree *tree = ar_radix_tree_init(temp.arena);
+    srand(1);
+    for (U32 i = 0; i < route_count; i++) {
+        routes[i] = ar_str_pushf(temp.arena, "/api/v%d/%s%u/", rand() % 3, i % 2 ? "users" : "orders", i);
+        ar_radix_tree_set(tree, routes[i], &routes[i]);
+    }
+
+    enum { PATH_COUNT = 4096 };
+    ArStr *paths = ar_arena_push_arr(temp.arena, ArStr, PATH_COUNT);
+    U64 bytes = 0;
+    for (U32 i = 0; i < PATH_COUNT; i++) {
+        ArStr route = routes[rand() % route_count];
+        paths[i] = ar_str_pushf(temp.arena, "%.*sitems/%d", (I32) route.len, route.data, rand());
+        bytes += paths[i].len;
+    }
+
+    F64 time = BENCH_RUN(MIN_TIME, {
+        for (U32 i = 0; i < PATH_COUNT; i++) {
+            BENCH_KEEP(ar_radix_tree_longest_prefix(tree, paths[i], NULL));
+        }
+    });
+    report(bytes, time, "radix tree, %u routes", route_count);
+    time = BENCH_RUN(MIN_TIME, {
+        for (U32 i = 0; i < PATH_COUNT; i++) {
+            const ArStr *best = NULL;
+            for (U32 j = 0; j < route_count; j++) {
+                if (routes[j].len <= paths[i].len &&
+                        ar_str_match(routes[j], paths[i], AR_STR_MATCH_FLAG_SLOPPY_LENGTH) &&
+                        (best == NULL || routes[j].len > best->len)) {
+                    best = &routes[j];
+                }
+            }
+            BENCH_KEEP(best);
+        }
+    });
+    report(bytes, time, "  linear scan");
+
+    ar_temp_end(&temp);
+}
+
+static void bench_builder(ArArena *arena) {
+    const U32 lines = 10000;
+    F64 time = 0.0;
+    U64 bytes = 0;
+
+    {
+        ArTemp temp = ar_temp_begin(arena);
+        ArStrBuilder builder = ar_str_builder_init(temp.arena, 0);
+        for (U32 i = 0; i < lines; i++) {
+            ar_str_builder_pushf(&builder, "key_%u: %u\n", i, i * 7);
+        }
+        bytes = builder.len;
+        ar_temp_end(&temp);
+    }
+
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp temp = ar_temp_begin(arena);
+        ArStrList list = {0};
+        for (U32 i = 0; i < lines; i++) {
+            ar_str_list_push(temp.arena, &list, ar_str_pushf(temp.arena, "key_%u: %u\n", i, i * 7));
+        }
+        BENCH_KEEP(ar_str_list_join(temp.arena, list).data);
+        ar_temp_end(&temp);
+    });
+    report(bytes, time, "pushf into list, join");
+
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp temp = ar_temp_begin(arena);
+        ArStrBuilder builder = ar_str_builder_init(temp.arena, 0);
+        for (U32 i = 0; i < lines; i++) {
+            ar_str_builder_pushf(&builder, "key_%u: %u\n", i, i * 7);
+        }
+        BENCH_KEEP(ar_str_builder_finalize(temp.arena, &builder).data);
+        ar_temp_end(&temp);
+    });
+    report(bytes, time, "builder pushf, finalize");
+}
+
+// Only exists to hand a va_list to both formatters.
+static U64 format_with(B8 fast, char *buffer, U64 size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    U64 len = fast ? ar_formatv(buffer, size, fmt, args) : (U64) vsnprintf(buffer, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+static void bench_format(void) {
+    const U32 count = 10000;
+    char buffer[256];
+    F64 time = 0.0;
+    U64 bytes = 0;
+
+    for (U32 fast = 0; fast < 2; fast++) {
+        const char *name = fast ? "ar_formatv" : "vsnprintf";
+
+        bytes = 0;
+        for (U32 i = 0; i < count; i++) {
+            bytes += format_with(fast, buffer, sizeof(buffer), "id=%u count=%lld offset=%x", i, i * 123456789ll, i);
+        }
+        time = BENCH_RUN(MIN_TIME, {
+            for (U32 i = 0; i < count; i++) {
+                BENCH_KEEP(format_with(fast, buffer, sizeof(buffer), "id=%u count=%lld offset=%x", i, i * 123456789ll, i));
+            }
+        });
+        report(bytes, time, "%s integers", name);
+
+        bytes = 0;
+        for (U32 i = 0; i < count; i++) {
+            bytes += format_with(fast, buffer, sizeof(buffer), "name=%s path=%-20s", "request", "/some/path");
+        }
+        time = BENCH_RUN(MIN_TIME, {
+            for (U32 i = 0; i < count; i++) {
+                BENCH_KEEP(format_with(fast, buffer, sizeof(buffer), "name=%s path=%-20s", "request", "/some/path"));
+            }
+        });
+        report(bytes, time, "%s strings", name);
+    }
+
+    // Shortest round-trip against the %.17g usually used to round-trip.
+    bytes = 0;
+    time = BENCH_RUN(MIN_TIME, {
+        for (U32 i = 0; i < count; i++) {
+            BENCH_KEEP(snprintf(buffer, sizeof(buffer), "%.17g", i * 1.1));
+        }
+    });
+    report(count * 17, time, "snprintf %%.17g");
+    time = BENCH_RUN(MIN_TIME, {
+        for (U32 i = 0; i < count; i++) {
+            BENCH_KEEP(ar_format_f64(buffer, i * 1.1));
+        }
+    });
+    report(count * 17, time, "ar_format_f64");
+}
+
+// What parsing used to take: a null-terminated copy and libc.
+static F64 parse_f64_libc(ArStr str) {
+    char buffer[64];
+    memcpy(buffer, str.data, str.len);
+    buffer[str.len] = 0;
+    return strtod(buffer, NULL);
+}
+
+static U64 parse_u64_libc(ArStr str) {
+    char buffer[64];
+    memcpy(buffer, str.data, str.len);
+    buffer[str.len] = 0;
+    return strtoull(buffer, NULL, 10);
+}
+
+static void bench_parse(ArArena *arena) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    const U64 count = 100000;
+    ArStr *ints = ar_arena_push_arr_no_zero(temp.arena, ArStr, count);
+    ArStr *floats = ar_arena_push_arr_no_zero(temp.arena, ArStr, count);
+    U64 int_bytes = 0;
+    U64 float_bytes = 0;
+    srand(42);
+    for (U64 i = 0; i < count; i++) {
+        U64 value = ((U64) rand() << 31 | rand()) % 10000000000000ull;
+        ints[i] = ar_str_pushf(temp.arena, "%llu", value);
+        floats[i] = ar_str_pushf(temp.arena, "%.17g", (F64) rand() / RAND_MAX * 1000.0);
+        int_bytes += ints[i].len;
+        float_bytes += floats[i].len;
+    }
+
+    U64 *u64_values = ar_arena_push_arr_no_zero(temp.arena, U64, count);
+    F64 *f64_values = ar_arena_push_arr_no_zero(temp.arena, F64, count);
+    F64 time = 0.0;
+
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_to_u64_array(ints, count, u64_values)));
+    report(int_bytes, time, "ar_str_to_u64_array");
+    time = BENCH_RUN(MIN_TIME, {
+        for (U64 i = 0; i < count; i++) {
+            u64_values[i] = parse_u64_libc(ints[i]);
+        }
+        BENCH_KEEP(u64_values);
+    });
+    report(int_bytes, time, "  strtoull reference");
+
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_to_f64_array(floats, count, f64_values)));
+    report(float_bytes, time, "ar_str_to_f64_array");
+    time = BENCH_RUN(MIN_TIME, {
+        for (U64 i = 0; i < count; i++) {
+            f64_values[i] = parse_f64_libc(floats[i]);
+        }
+        BENCH_KEEP(f64_values);
+    });
+    report(float_bytes, time, "  strtod reference");
+
+    ar_temp_end(&temp);
+}
+
+static void bench_matcher(ArArena *arena, U32 pattern_count) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    U64 size = MiB(1);
+    ArStr text = gen_text(temp.arena, size);
+
+    // Random words of 4 to 11 letters, hardly ever found in the text.
+    ArStrList patterns = {0};
+    for (U32 i = 0; i < pattern_count; i++) {
+        U32 len = 4 + rand() % 8;
+        U8 *data = ar_arena_push_arr_no_zero(temp.arena, U8, len);
+        for (U32 j = 0; j < len; j++) {
+            data[j] = 'a' + rand() % 26;
+        }
+        ar_str_list_push(temp.arena, &patterns, ar_str(data, len));
+    }
+
+    ArStrMatcher *matcher = ar_str_matcher_create(temp.arena, patterns, AR_STR_MATCH_FLAG_EXACT);
+    F64 time = BENCH_RUN(MIN_TIME, {
+        U64 count = 0;
+        for (ArStrMatcherIter iter = ar_str_matcher_iter_init(matcher, text);
+                ar_str_matcher_iter_valid(&iter);
+                ar_str_matcher_iter_next(&iter)) {
+            count++;
+        }
+        BENCH_KEEP(count);
+    });
+    report(size, time, "matcher, %u patterns", pattern_count);
+
+    time = BENCH_RUN(MIN_TIME, {
+        for (ArStrListNode *node = patterns.first; node != NULL; node = node->next) {
+            BENCH_KEEP(ar_str_find(text, node->str, AR_STR_MATCH_FLAG_EXACT));
+        }
+    });
+    report(size, time, "  ar_str_find per pattern");
+
+    ar_temp_end(&temp);
+}
+
+static void bench_regex(ArArena *arena, const char *pattern) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    U64 size = MiB(1);
+    ArStr text = gen_text(temp.arena, size);
+
+    ArRegex *regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_cstr(pattern),
+    });
+    F64 time = BENCH_RUN(MIN_TIME, {
+        U64 count = 0;
+        for (ArStrSplitIter iter = ar_str_split_iter_init(text, ar_str_lit("\n"), AR_STR_MATCH_FLAG_EXACT);
+                ar_str_split_iter_valid(&iter);
+                ar_str_split_iter_next(&iter)) {
+            count += ar_regex_search(regex, ar_str_split_iter_get(&iter));
+        }
+        BENCH_KEEP(count);
+    });
+    report(size, time, "ar_regex_search lines, %s", pattern);
+    ar_regex_destroy(&regex);
+
+    regex_t posix;
+    regcomp(&posix, pattern, REG_EXTENDED | REG_NOSUB);
+    time = BENCH_RUN(MIN_TIME, {
+        U64 count = 0;
+        for (ArStrSplitIter iter = ar_str_split_iter_init(text, ar_str_lit("\n"), AR_STR_MATCH_FLAG_EXACT);
+                ar_str_split_iter_valid(&iter);
+                ar_str_split_iter_next(&iter)) {
+            ArStr line = ar_str_split_iter_get(&iter);
+            regmatch_t range = {
+                .rm_so = 0,
+                .rm_eo = line.len,
+            };
+            count += regexec(&posix, (const char *) line.data, 1, &range, REG_STARTEND) == 0;
+        }
+        BENCH_KEEP(count);
+    });
+    report(size, time, "  regexec lines");
+    regfree(&posix);
+
+    ar_temp_end(&temp);
+}
+
+static void bench_utf8(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    // Mostly ASCII with two, three and four byte sequences mixed in, and
+    // pure ASCII.
+    ArStr ascii = gen_text(temp.arena, size);
+    U8 *data = ar_arena_push_arr_no_zero(temp.arena, U8, size);
+    const char *sequences[] = {"\xc3\xa9", "\xe2\x82\xac", "\xf0\x9f\x98\x80"};
+    for (U64 i = 0; i < size;) {
+        const char *seq = sequences[rand() % 3];
+        U64 len = strlen(seq);
+        if (rand() % 4 == 0 && i + len <= size) {
+            memcpy(data + i, seq, len);
+            i += len;
+        } else {
+            data[i++] = 'a' + rand() % 26;
+        }
+    }
+    ArStr mixed = ar_str(data, size);
+
+    F64 time = BENCH_RUN(MIN_TIME, {
+        BENCH_KEEP(ar_str_utf8_valid(mixed));
+    });
+    report(size, time, "ar_str_utf8_valid mixed");
+    time = BENCH_RUN(MIN_TIME, {
+        BENCH_KEEP(utf8_valid_naive(mixed));
+    });
+    report(size, time, "  naive mixed");
+    time = BENCH_RUN(MIN_TIME, {
+        BENCH_KEEP(ar_str_utf8_valid(ascii));
+    });
+    report(size, time, "ar_str_utf8_valid ascii");
+    time = BENCH_RUN(MIN_TIME, {
+        BENCH_KEEP(ar_str_is_ascii(ascii));
+    });
+    report(size, time, "ar_str_is_ascii");
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp utf16_temp = ar_temp_begin(temp.arena);
+        BENCH_KEEP(ar_str_to_utf16(utf16_temp.arena, mixed, NULL));
+        ar_temp_end(&utf16_temp);
+    });
+    report(size, time, "ar_str_to_utf16 mixed");
+
+    ar_temp_end(&temp);
+}
+
+static void bench_case(ArArena *arena, U64 size) {
+    ArTemp temp = ar_temp_begin(arena);
+
+    ArStr text = gen_text(temp.arena, size);
+    ArStr upper = ar_str_to_upper(temp.arena, text);
+
+    F64 time = BENCH_RUN(MIN_TIME, {
+        ArTemp case_temp = ar_temp_begin(temp.arena);
+        BENCH_KEEP(ar_str_to_lower(case_temp.arena, upper));
+        ar_temp_end(&case_temp);
+    });
+    report(size, time, "ar_str_to_lower");
+    time = BENCH_RUN(MIN_TIME, {
+        ArTemp case_temp = ar_temp_begin(temp.arena);
+        U8 *data = ar_arena_push_arr_no_zero(case_temp.arena, U8, upper.len);
+        for (U64 i = 0; i < upper.len; i++) {
+            data[i] = tolower(upper.data[i]);
+        }
+        BENCH_KEEP(data);
+        ar_temp_end(&case_temp);
+    });
+    report(size, time, "  tolower reference");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(ar_str_match(text, upper, AR_STR_MATCH_FLAG_CASE_INSENSITIVE)));
+    report(size, time, "match case insensitive");
+    time = BENCH_RUN(MIN_TIME, BENCH_KEEP(match_ci_naive(text, upper)));
+    report(size, time, "  naive reference");
+
+    ar_temp_end(&temp);
+}
+
+void bench_strings(ArArena *arena) {
+    ar_info("case mapping over %u MiB", 16);
+    bench_case(arena, MiB(16));
+    ar_info("utf-8 over %u MiB", 16);
+    bench_utf8(arena, MiB(16));
+    ar_info("regex matching over %u MiB", 1);
+    bench_regex(arena, "qu[a-z]+ [a-z]{2,4}z");
+    bench_regex(arena, "(foo|bar|baz)[a-z]* +[xyz]");
+    ar_info("multi-pattern matching over %u MiB", 1);
+    bench_matcher(arena, 10);
+    bench_matcher(arena, 100);
+    bench_matcher(arena, 1000);
+    ar_info("parsing %u numbers", 100000);
+    bench_parse(arena);
+    ar_info("formatting %u values", 10000);
+    bench_format();
+    ar_info("routing %u paths", 4096);
+    bench_radix_tree(arena, 10);
+    bench_radix_tree(arena, 1000);
+    ar_info("reading lines of a %u MiB file", 64);
+    bench_file_reader(arena, MiB(64));
+    ar_info("%u rope edits over %u MiB", 1000, 16);
+    bench_rope(arena, MiB(16), 1000);
+    ar_info("string arrays over %u MiB", 16);
+    bench_array(arena, MiB(16));
+    ar_info("building %u formatted lines", 10000);
+    bench_builder(arena);
+    ar_info("scanning over %u MiB", 16);
+    bench_scan(arena, MiB(16));
+    ar_info("ar_str_find over %u MiB", 1);
+    bench_find(arena, MiB(1));
+    ar_info("ar_str_find over %u MiB", 16);
+    bench_find(arena, MiB(16));
+}
@@ -50,7 +50,7 @@
 #ifdef ARKIN_OS_LINUX
 #define AR_FORMAT_FUNCTION(FORMAT_INDEX, VA_INDEX) __attribute__((format(printf, FORMAT_INDEX, VA_INDEX)))
 #else
-#define RE_FORMAT_FUNCTION(FORMAT_INDEX, VA_INDEX)
+#define AR_FORMAT_FUNCTION(FORMAT_INDEX, VA_INDEX)
 #endif
 
 // https://github.com/google/sanitizers/wiki/AddressSanitizerManualPoisoning
@@ -143,12 +143,24 @@ static const I64 I64_MAX = (I64) ~0 ^ I64_MIN;
 #define MB(value) (value * 1000000)
 #define GB(value) ((U64) value * 1000000000)
 
+// Non-destructive length based strings.
+// No operation shall change the data of the string, instead producing a new
+// one.
 typedef struct ArStr ArStr;
+struct ArStr {
+    U64 len;
+    const U8 *data;
+};
+
+typedef struct ArReservation ArReservation;
 
 typedef struct ArkinCoreDesc ArkinCoreDesc;
 struct ArkinCoreDesc {
     U32 thread_pool_capacity;
     U32 mutex_pool_capacity;
+    // Number of scratch arenas available to each thread. Defaults to 2,
+    // which is also the least accepted.
+    U32 scratch_arena_count;
 
     struct {
         void (*callback)(ArStr error);
@@ -157,6 +169,9 @@ struct ArkinCoreDesc {
     struct {
         U64 default_capacity;
         U64 default_align;
+        // If non-zero, thread context arenas are carved out of one shared
+        // reservation of this size instead of mapping their own memory.
+        U64 reservation_size;
     } arena;
 };
 
@@ -176,13 +191,99 @@ ARKIN_API void arkin_terminate(void);
 
 typedef struct ArArena ArArena;
 
+typedef enum {
+    AR_ARENA_FLAG_NONE,
+
+    // Populate pages as soon as they get committed so the first write to them
+    // doesn't page fault. Prefaulted pages stay committed through pops and
+    // resets.
+    AR_ARENA_FLAG_PREFAULT = 1 << 0,
+    // Prefault on a background thread instead of the calling thread.
+    // Requires the thread pool to have room for one more thread.
+    AR_ARENA_FLAG_PREFAULT_ASYNC = 1 << 1,
+} ArArenaFlag;
+
+typedef struct ArArenaDesc ArArenaDesc;
+struct ArArenaDesc {
+    // Uses the default capacity if zero.
+    U64 capacity;
+    ArArenaFlag flags;
+    // Number of bytes to prefault when the arena is created.
+    U64 prefault;
+    // Reservation to carve the arena out of. If NULL or if the reservation is
+    // out of space the arena will map its own memory.
+    ArReservation *reservation;
+    // Name shown in arena stats. Copied and truncated to
+    // ARKIN_ARENA_NAME_MAX_LENGTH.
+    ArStr name;
+};
+
 ARKIN_API ArArena *ar_arena_create(U64 capacity);
 // Uses a default capacity of 4 GiB.
 ARKIN_API ArArena *ar_arena_create_default(void);
+ARKIN_API ArArena *ar_arena_create_desc(ArArenaDesc desc);
 ARKIN_API void ar_arena_destroy(ArArena **arena);
 
+// Creates an arena in named shared memory which other processes can attach
+// to with ar_arena_attach_shared. Each process maps it at a different
+// address, so anything linking memory inside of it should use ArOffPtr.
+// Like any arena it isn't synchronized, have one process push at a time.
+//
+// Destroying the returned arena removes the name, processes already attached
+// keep working with it. Copies inherited through fork don't remove it.
+// Returns NULL if the name is taken or the memory can't be mapped.
+ARKIN_API ArArena *ar_arena_create_shared(ArStr name, U64 capacity);
+// Maps a shared arena created by another process. Destroying the returned
+// arena only unmaps it.
+ARKIN_API ArArena *ar_arena_attach_shared(ArStr name);
+// Where the first push into a shared arena lands, usually a root structure
+// the other processes start from.
+ARKIN_API void *ar_arena_shared_first(ArArena *arena);
+
 ARKIN_API void ar_arena_set_align(ArArena *arena, U64 align);
 
+// Commits and populates 'bytes' of memory past the current position so pushes
+// into that region won't page fault.
+ARKIN_API void ar_arena_prefault(ArArena *arena, U64 bytes);
+
+// Arena stats
+//
+// Only tracked when compiled with ARKIN_ARENA_STATS. Without it the functions
+// below are still available but peak and syscall numbers are always zero and
+// the dump is empty.
+
+#ifndef ARKIN_ARENA_NAME_MAX_LENGTH
+#define ARKIN_ARENA_NAME_MAX_LENGTH 32
+#endif
+
+typedef struct ArArenaStats ArArenaStats;
+struct ArArenaStats {
+    ArStr name;
+    U64 capacity;
+    U64 position;
+    U64 peak_position;
+    U64 commited;
+    U64 commit_count;
+    U64 decommit_count;
+    // Seconds spent inside of ar_os_mem_commit.
+    F64 commit_time;
+};
+
+typedef enum {
+    AR_ARENA_STATS_FORMAT_TEXT,
+    AR_ARENA_STATS_FORMAT_JSON,
+} ArArenaStatsFormat;
+
+ARKIN_API void ar_arena_set_name(ArArena *arena, ArStr name);
+// The name of the stats points into the arena and is valid until it's
+// destroyed.
+ARKIN_API ArArenaStats ar_arena_stats_get(const ArArena *arena);
+// Formats the stats of every live arena into 'arena'. Text output has one
+// line per arena.
+// Stats are read without synchronizing with the threads using the arenas so
+// numbers of arenas being used during the dump might be slightly off.
+ARKIN_API ArStr ar_arena_stats_dump(ArArena *arena, ArArenaStatsFormat format);
+
 // Returns a zero initialized region of memory.
 ARKIN_API void *ar_arena_push(ArArena *arena, U64 size);
 // Returns an uninitialized region of memory.
@@ -197,6 +298,40 @@ ARKIN_API U64 ar_arena_used(const ArArena *arena);
 #define ar_arena_push_type(arena, type) ar_arena_push((arena), sizeof(type))
 #define ar_arena_push_type_no_zero(arena, type) ar_arena_push_no_zero((arena), sizeof(type))
 
+// Allocation tracing
+//
+// When compiled with ARKIN_ALLOC_TRACE every arena push records the bytes
+// pushed per call site into a table owned by the calling thread's context.
+// Pushes from threads without a context aren't recorded.
+
+#ifndef ARKIN_ALLOC_TRACE_CAPACITY
+// Number of distinct call sites each thread can track. Pushes from sites
+// which don't fit are summed up in a single entry with a NULL file.
+#define ARKIN_ALLOC_TRACE_CAPACITY 1024
+#endif
+
+typedef struct ArAllocSite ArAllocSite;
+struct ArAllocSite {
+    const char *file;
+    U32 line;
+    U64 bytes;
+    U64 count;
+};
+
+// Merges the tables of all threads into an array sorted by bytes pushed,
+// largest first. Returns NULL if tracing is disabled or nothing was recorded.
+ARKIN_API ArAllocSite *ar_alloc_trace_collect(ArArena *arena, U32 *count);
+// Formats the 'max_sites' largest call sites, one per line.
+ARKIN_API ArStr ar_alloc_trace_report(ArArena *arena, U32 max_sites);
+
+#ifdef ARKIN_ALLOC_TRACE
+ARKIN_API void *_ar_arena_push_traced(ArArena *arena, U64 size, const char *file, U32 line);
+ARKIN_API void *_ar_arena_push_no_zero_traced(ArArena *arena, U64 size, const char *file, U32 line);
+
+#define ar_arena_push(arena, size) _ar_arena_push_traced((arena), (size), __FILE__, __LINE__)
+#define ar_arena_push_no_zero(arena, size) _ar_arena_push_no_zero_traced((arena), (size), __FILE__, __LINE__)
+#endif
+
 typedef struct ArTemp ArTemp;
 struct ArTemp {
     ArArena *const arena;
@@ -209,13 +344,49 @@ ARKIN_API void ar_temp_end(ArTemp *temp);
 ARKIN_API ArTemp ar_scratch_get(ArArena *const *conflicting, U32 count);
 ARKIN_INLINE void ar_scratch_release(ArTemp *scratch) { ar_temp_end(scratch); }
 
+// Offset pointers
+//
+// A pointer stored as the distance from its own address, so it stays valid
+// wherever the memory holding both of them gets mapped. Zero means NULL,
+// which leaves no way of pointing at itself.
+
+typedef I64 ArOffPtr;
+
+ARKIN_INLINE void *ar_off_ptr_get(const ArOffPtr *off) {
+    return *off == 0 ? NULL : (U8 *) off + *off;
+}
+
+ARKIN_INLINE void ar_off_ptr_set(ArOffPtr *off, const void *ptr) {
+    *off = ptr == NULL ? 0 : (const U8 *) ptr - (U8 *) off;
+}
+
+// ArStr with its data behind an offset pointer.
+typedef struct ArOffStr ArOffStr;
+struct ArOffStr {
+    U64 len;
+    ArOffPtr data;
+};
+
+ARKIN_INLINE ArStr ar_off_str_get(const ArOffStr *off) {
+    return (ArStr) {off->len, ar_off_ptr_get(&off->data)};
+}
+
+ARKIN_INLINE void ar_off_str_set(ArOffStr *off, ArStr str) {
+    off->len = str.len;
+    ar_off_ptr_set(&off->data, str.data);
+}
+
 //
 // Thread context
 //
 
 typedef struct ArThreadCtx ArThreadCtx;
 
+// Thread contexts are recycled. Creating one reuses a previously destroyed
+// context if available and scratch arenas are only created once they are
+// first requested through ar_scratch_get.
 ARKIN_API ArThreadCtx *ar_thread_ctx_create(void);
+// Resets the arenas of the context and hands it back for reuse.
 ARKIN_API void ar_thread_ctx_destroy(ArThreadCtx **ctx);
 ARKIN_API void ar_thread_ctx_set(ArThreadCtx *ctx);
 
@@ -334,23 +505,59 @@ ARKIN_API void ar_thread_ctx_set(ArThreadCtx *ctx);
 //
 
 // Char helpers
-ARKIN_API B8 ar_char_is_numeric(char c);
-ARKIN_API B8 ar_char_is_alpha(char c);
-ARKIN_API B8 ar_char_is_lower(char c);
-ARKIN_API B8 ar_char_is_upper(char c);
-ARKIN_API B8 ar_char_is_whitespace(char c);
-ARKIN_API char ar_char_to_lower(char c);
-ARKIN_API char ar_char_to_upper(char c);
-
-// Non-destructive length based strings.
-// No operation shall change the data of the string, instead producing a new
-// one.
+//
+// Classification is a single lookup into '_ar_char_class'. The upper case flag
+// is the ASCII case bit and the lower case flag the bit above it, so case
+// mapping needs no branches.
+
+enum {
+    _AR_CHAR_CLASS_NUMERIC = 1 << 0,
+    _AR_CHAR_CLASS_WHITESPACE = 1 << 1,
+    _AR_CHAR_CLASS_UPPER = 1 << 5,
+    _AR_CHAR_CLASS_LOWER = 1 << 6,
+};
 
-struct ArStr {
-    U64 len;
-    const U8 *data;
+static const U8 _ar_char_class[256] = {
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x02, 0x02, 0x02, 0x02, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20,
+    0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40,
+    0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x40, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
 };
 
+ARKIN_INLINE B8 ar_char_is_numeric(char c) {
+    return (_ar_char_class[(U8) c] & _AR_CHAR_CLASS_NUMERIC) != 0;
+}
+ARKIN_INLINE B8 ar_char_is_alpha(char c) {
+    return (_ar_char_class[(U8) c] & (_AR_CHAR_CLASS_UPPER | _AR_CHAR_CLASS_LOWER)) != 0;
+}
+ARKIN_INLINE B8 ar_char_is_lower(char c) {
+    return (_ar_char_class[(U8) c] & _AR_CHAR_CLASS_LOWER) != 0;
+}
+ARKIN_INLINE B8 ar_char_is_upper(char c) {
+    return (_ar_char_class[(U8) c] & _AR_CHAR_CLASS_UPPER) != 0;
+}
+ARKIN_INLINE B8 ar_char_is_whitespace(char c) {
+    return (_ar_char_class[(U8) c] & _AR_CHAR_CLASS_WHITESPACE) != 0;
+}
+ARKIN_INLINE char ar_char_to_lower(char c) {
+    return (char) (c | (_ar_char_class[(U8) c] & _AR_CHAR_CLASS_UPPER));
+}
+ARKIN_INLINE char ar_char_to_upper(char c) {
+    return (char) (c ^ ((_ar_char_class[(U8) c] & _AR_CHAR_CLASS_LOWER) >> 1));
+}
+
 typedef enum {
     AR_STR_MATCH_FLAG_EXACT,
 
@@ -416,6 +623,13 @@ ARKIN_INLINE ArStr ar_str_chop_end(ArStr str, U64 len) {
 // Returns haystack length if no needle was found.
 ARKIN_API U64 ar_str_find(ArStr haystack, ArStr needle, ArStrMatchFlag flags);
 ARKIN_API U64 ar_str_find_char(ArStr haystack, char needle, ArStrMatchFlag flags);
+// Finds any of the bytes in 'chars'.
+ARKIN_API U64 ar_str_find_any_char(ArStr haystack, ArStr chars, ArStrMatchFlag flags);
+
+// Copies 'str' with ASCII letters mapped to lower or upper case. Other bytes,
+// including UTF-8 sequences, are copied unchanged.
+ARKIN_API ArStr ar_str_to_lower(ArArena *arena, ArStr str);
+ARKIN_API ArStr ar_str_to_upper(ArArena *arena, ArStr str);
 
 // Trim both beginning and end of a string.
 ARKIN_API ArStr ar_str_trim(ArStr str);
@@ -427,6 +641,224 @@ ARKIN_API ArStr ar_str_trim_back(ArStr str);
 ARKIN_API ArStrList ar_str_split(ArArena *arena, ArStr str, ArStr delim, ArStrMatchFlag flags);
 ARKIN_API ArStrList ar_str_split_char(ArArena *arena, ArStr str, char delim, ArStrMatchFlag flags);
 
+// Lazily splits a string without allocating. Yields the same tokens as
+// ar_str_split, each being a slice of the original string.
+//
+// for (ArStrSplitIter iter = ar_str_split_iter_init(str, ar_str_lit(","), AR_STR_MATCH_FLAG_EXACT);
+//         ar_str_split_iter_valid(&iter);
+//         ar_str_split_iter_next(&iter)) {
+//     ArStr token = ar_str_split_iter_get(&iter);
+// }
+typedef struct ArStrSplitIter ArStrSplitIter;
+struct ArStrSplitIter {
+    ArStr str;
+    ArStr delim;
+    ArStrMatchFlag flags;
+    // Where the search for the next delimiter starts.
+    U64 pos;
+    // Single byte delimiters are found a block at a time. 'mask' holds the
+    // delimiters not yet consumed from the block ending at 'mask_end'.
+    U64 mask;
+    U64 mask_end;
+    ArStr token;
+    B8 valid;
+};
+
+ARKIN_API ArStrSplitIter ar_str_split_iter_init(ArStr str, ArStr delim, ArStrMatchFlag flags);
+ARKIN_API void ar_str_split_iter_next(ArStrSplitIter *iter);
+ARKIN_API B8 ar_str_split_iter_valid(const ArStrSplitIter *iter);
+ARKIN_API ArStr ar_str_split_iter_get(const ArStrSplitIter *iter);
+
+// String array
+//
+// Strings packed back to back into one byte blob, with an offset array
+// marking where each one starts. Costs the string bytes plus 4 bytes per
+// string, or 8 once the blob outgrows 4 GiB, compared to a 40 byte node per
+// string in ArStrList. Both the blob and the offsets live in 'arena' and
+// double when they run out of space.
+//
+// ArStrArray array = ar_str_array_init(arena, 0, 0);
+// ar_str_array_push(&array, ar_str_lit("foo"));
+// for (U64 i = 0; i < array.count; i++) {
+//     ArStr str = ar_str_array_get(&array, i);
+// }
+typedef struct ArStrArray ArStrArray;
+struct ArStrArray {
+    ArArena *arena;
+    U8 *data;
+    U64 len;
+    U64 capacity;
+    // 'count' + 1 offsets into 'data'. U32 until the blob outgrows 4 GiB,
+    // U64 after.
+    void *offsets;
+    U64 count;
+    U64 offset_capacity;
+    B8 wide;
+};
+
+// 'count' and 'bytes' are capacity hints and may be zero.
+ARKIN_API ArStrArray ar_str_array_init(ArArena *arena, U64 count, U64 bytes);
+// Copies 'str' into the blob.
+ARKIN_API void ar_str_array_push(ArStrArray *array, ArStr str);
+
+ARKIN_INLINE U64 _ar_str_array_offset(const ArStrArray *array, U64 index) {
+    return array->wide ? ((const U64 *) array->offsets)[index] : ((const U32 *) array->offsets)[index];
+}
+ARKIN_INLINE ArStr ar_str_array_get(const ArStrArray *array, U64 index) {
+    U64 start = _ar_str_array_offset(array, index);
+    return ar_str(array->data + start, _ar_str_array_offset(array, index + 1) - start);
+}
+
+// Copies the strings of 'list' into an array sized to fit.
+ARKIN_API ArStrArray ar_str_array_from_list(ArArena *arena, ArStrList list);
+// The list nodes point into the array's blob, no bytes are copied.
+ARKIN_API ArStrList ar_str_array_to_list(ArArena *arena, const ArStrArray *array);
+
+// Same tokens as ar_str_split, copied into an array.
+ARKIN_API ArStrArray ar_str_split_array(ArArena *arena, ArStr str, ArStr delim, ArStrMatchFlag flags);
+ARKIN_API ArStrArray ar_str_split_char_array(ArArena *arena, ArStr str, char delim, ArStrMatchFlag flags);
+
+// Same layout as struct iovec on POSIX so it can be passed to writev as is.
+typedef struct ArIoVec ArIoVec;
+struct ArIoVec {
+    void *base;
+    U64 len;
+};
+
+// Appends strings into arena allocated chunks without ever moving what has
+// already been written. Formatting goes straight into the free space of the
+// last chunk.
+typedef struct ArStrBuilderChunk ArStrBuilderChunk;
+struct ArStrBuilderChunk {
+    ArStrBuilderChunk *next;
+    U64 len;
+    U64 cap;
+    U8 *data;
+};
+
+typedef struct ArStrBuilder ArStrBuilder;
+struct ArStrBuilder {
+    ArArena *arena;
+    ArStrBuilderChunk *first;
+    ArStrBuilderChunk *last;
+    U64 len;
+    U64 chunk_count;
+    // Size of the next chunk. Grows with every chunk up to
+    // AR_STR_BUILDER_MAX_CHUNK_SIZE.
+    U64 chunk_size;
+};
+
+#define AR_STR_BUILDER_DEFAULT_CHUNK_SIZE KiB(4)
+#define AR_STR_BUILDER_MAX_CHUNK_SIZE MiB(1)
+
+// Chunk size of 0 uses AR_STR_BUILDER_DEFAULT_CHUNK_SIZE.
+ARKIN_API ArStrBuilder ar_str_builder_init(ArArena *arena, U64 chunk_size);
+ARKIN_API void ar_str_builder_push(ArStrBuilder *builder, ArStr str);
+ARKIN_API void ar_str_builder_push_char(ArStrBuilder *builder, char c);
+ARKIN_API void ar_str_builder_pushf(ArStrBuilder *builder, const char *fmt, ...) AR_FORMAT_FUNCTION(2, 3);
+ARKIN_API void ar_str_builder_pushfv(ArStrBuilder *builder, const char *fmt, va_list args);
+// Copies everything into one contiguous string. A builder with a single
+// chunk is returned without copying.
+ARKIN_API ArStr ar_str_builder_finalize(ArArena *arena, const ArStrBuilder *builder);
+// One vector per non-empty chunk, ready for writev.
+ARKIN_API ArIoVec *ar_str_builder_iovecs(ArArena *arena, const ArStrBuilder *builder, U64 *count);
+
+//
+// Formatting
+//
+
+// printf compatible formatting without going through libc's locale aware
+// machinery. On top of the standard conversions it understands:
+//   %S - ArStr, precision limits how much of it is printed.
+//   %R - F64 with the fewest digits which read back as the same value.
+// %f, %e, %g and %a are still handed to libc.
+//
+// Same return value and truncation as vsnprintf.
+ARKIN_API U64 ar_format(char *buffer, U64 size, const char *fmt, ...);
+ARKIN_API U64 ar_formatv(char *buffer, U64 size, const char *fmt, va_list args);
+
+#define AR_FORMAT_U64_MAX_LENGTH 20
+#define AR_FORMAT_I64_MAX_LENGTH 20
+#define AR_FORMAT_F64_MAX_LENGTH 32
+
+// Writes the decimal representation without a null-terminator, returning
+// its length.
+ARKIN_API U32 ar_format_u64(char *buffer, U64 value);
+ARKIN_API U32 ar_format_i64(char *buffer, I64 value);
+// Shortest representation that round-trips, same as %R.
+ARKIN_API U32 ar_format_f64(char *buffer, F64 value);
+
+// With ARKIN_FAST_FORMAT ar_str_pushf, ArStrBuilder, logging and errors are
+// formatted with ar_formatv. They keep their printf format checks, which
+// don't know about %S and %R, so use those with ar_format.
+
+//
+// Number parsing
+//
+
+// Parses the whole string as a number, no surrounding whitespace allowed.
+// Returns false if it isn't one or doesn't fit, leaving 'result' untouched.
+ARKIN_API B8 ar_str_to_u64(ArStr str, U64 *result);
+ARKIN_API B8 ar_str_to_i64(ArStr str, I64 *result);
+// Decimal with an optional exponent, inf or nan. Correctly rounded.
+ARKIN_API B8 ar_str_to_f64(ArStr str, F64 *result);
+
+// Parses a column of strings into 'values'. Returns the index of the first
+// string which failed to parse, or 'count' if all of them did.
+ARKIN_API U64 ar_str_to_u64_array(const ArStr *strs, U64 count, U64 *values);
+ARKIN_API U64 ar_str_to_i64_array(const ArStr *strs, U64 count, I64 *values);
+ARKIN_API U64 ar_str_to_f64_array(const ArStr *strs, U64 count, F64 *values);
+
+//
+// UTF-8
+//
+
+#define AR_UTF8_MAX_LENGTH 4
+
+// Decoding stands this in for every maximal invalid sequence, encoding for
+// code points that can't be encoded.
+static const U32 AR_UTF8_REPLACEMENT = 0xfffd;
+
+// Rejects overlong encodings, surrogates, code points past U+10FFFF and
+// truncated sequences.
+ARKIN_API B8 ar_str_utf8_valid(ArStr str);
+ARKIN_API B8 ar_str_is_ascii(ArStr str);
+
+// Decodes the code point at the start of 'str' and returns how many bytes
+// it took, zero only for an empty string.
+ARKIN_API U32 ar_utf8_decode(ArStr str, U32 *codepoint);
+// Writes up to AR_UTF8_MAX_LENGTH bytes and returns how many were written.
+ARKIN_API U32 ar_utf8_encode(U32 codepoint, U8 *out);
+ARKIN_API void ar_str_builder_push_codepoint(ArStrBuilder *builder, U32 codepoint);
+
+// Walks the code points of a string.
+//
+// for (ArUtf8Iter iter = ar_utf8_iter_init(str);
+//         ar_utf8_iter_valid(&iter);
+//         ar_utf8_iter_next(&iter)) {
+//     U32 codepoint = ar_utf8_iter_get(&iter);
+// }
+typedef struct ArUtf8Iter ArUtf8Iter;
+struct ArUtf8Iter {
+    ArStr str;
+    // Byte offset and length of the current code point.
+    U64 offset;
+    U32 len;
+    U32 codepoint;
+    B8 valid;
+};
+
+ARKIN_API ArUtf8Iter ar_utf8_iter_init(ArStr str);
+ARKIN_API void ar_utf8_iter_next(ArUtf8Iter *iter);
+ARKIN_API B8 ar_utf8_iter_valid(const ArUtf8Iter *iter);
+ARKIN_API U32 ar_utf8_iter_get(const ArUtf8Iter *iter);
+
+// Native endian UTF-16, null-terminated. 'len' gets the number of units
+// without the terminator and may be NULL. Invalid input becomes
+// AR_UTF8_REPLACEMENT, unpaired surrogates included.
+ARKIN_API U16 *ar_str_to_utf16(ArArena *arena, ArStr str, U64 *len);
+ARKIN_API ArStr ar_str_from_utf16(ArArena *arena, const U16 *data, U64 len);
+
 //
 // Hash map
 //
@@ -527,6 +959,235 @@ ARKIN_API B8 _ar_hash_map_has(const ArHashMap *map, const void *key);
 ARKIN_API void _ar_hash_map_get(const ArHashMap *map, const void *key, void *output);
 ARKIN_API void * _ar_hash_map_get_ptr(const ArHashMap *map, const void *key);
 
+//
+// String interning
+//
+
+// Stores each unique string once and hands out dense IDs starting from zero,
+// so comparing interned strings is comparing IDs.
+
+#define AR_STR_INTERN_DEFAULT_MAX_COUNT (1 << 24)
+
+static const U32 AR_STR_INTERN_INVALID_ID = U32_MAX;
+
+typedef struct ArStrInternDesc ArStrInternDesc;
+struct ArStrInternDesc {
+    // Expected number of unique strings, used to size the initial table.
+    U32 capacity;
+    // Most unique strings the table can hold. Only address space is reserved
+    // up front. Uses AR_STR_INTERN_DEFAULT_MAX_COUNT if zero.
+    U32 max_count;
+    // Guards adding and finding strings with a mutex taken from the pool
+    // sized by 'mutex_pool_capacity'. Getting a string by ID never locks.
+    B8 thread_safe;
+};
+
+typedef struct ArStrIntern ArStrIntern;
+
+ARKIN_API ArStrIntern *ar_str_intern_create(ArStrInternDesc desc);
+ARKIN_API void ar_str_intern_destroy(ArStrIntern **intern);
+// Returns the ID of 'str', copying it in if it's new.
+ARKIN_API U32 ar_str_intern(ArStrIntern *intern, ArStr str);
+// Returns AR_STR_INTERN_INVALID_ID if 'str' was never interned.
+ARKIN_API U32 ar_str_intern_find(const ArStrIntern *intern, ArStr str);
+// Interned strings are null-terminated. Returns an empty string for unknown
+// IDs.
+ARKIN_API ArStr ar_str_intern_get(const ArStrIntern *intern, U32 id);
+ARKIN_API U32 ar_str_intern_count(const ArStrIntern *intern);
+
+//
+// Multi-pattern matching
+//
+
+// Aho-Corasick automaton finding every occurrence of a set of patterns in a
+// single pass, no matter how many patterns there are.
+typedef struct ArStrMatcher ArStrMatcher;
+
+typedef struct ArStrMatch ArStrMatch;
+struct ArStrMatch {
+    // Index of the pattern in the list the matcher was created from.
+    U32 pattern;
+    U64 offset;
+    // Matched slice of the searched string.
+    ArStr str;
+};
+
+// Walks every match ordered by where it ends. Matches ending at the same
+// place come longest first.
+//
+// for (ArStrMatcherIter iter = ar_str_matcher_iter_init(matcher, line);
+//         ar_str_matcher_iter_valid(&iter);
+//         ar_str_matcher_iter_next(&iter)) {
+//     ArStrMatch match = ar_str_matcher_iter_get(&iter);
+// }
+typedef struct ArStrMatcherIter ArStrMatcherIter;
+struct ArStrMatcherIter {
+    const ArStrMatcher *matcher;
+    ArStr str;
+    U64 pos;
+    // Transition row of the current state.
+    U32 row;
+    // State and pattern of the next match ending at 'pos'.
+    U32 out_state;
+    U32 pattern;
+    ArStrMatch match;
+    B8 valid;
+};
+
+// Only AR_STR_MATCH_FLAG_CASE_INSENSITIVE is used from the flags. Empty
+// patterns never match. The patterns are not referenced after creation.
+//
+// The transition table takes a U32 per state and distinct byte. Returns NULL
+// if it would need 2^31 entries or more.
+ARKIN_API ArStrMatcher *ar_str_matcher_create(ArArena *arena, ArStrList patterns, ArStrMatchFlag flags);
+ARKIN_API U32 ar_str_matcher_pattern_count(const ArStrMatcher *matcher);
+ARKIN_API B8 ar_str_matcher_contains(const ArStrMatcher *matcher, ArStr str);
+
+ARKIN_API ArStrMatcherIter ar_str_matcher_iter_init(const ArStrMatcher *matcher, ArStr str);
+ARKIN_API void ar_str_matcher_iter_next(ArStrMatcherIter *iter);
+ARKIN_API B8 ar_str_matcher_iter_valid(const ArStrMatcherIter *iter);
+ARKIN_API ArStrMatch ar_str_matcher_iter_get(const ArStrMatcherIter *iter);
+
+//
+// Regular expressions
+//
+
+// Regex and glob patterns compiled to a DFA that's built lazily while
+// matching and cached, so every search is linear in the length of the string.
+//
+// Regexes support literals, '.' (any byte but newline), classes like [a-z]
+// and [^0-9], the escapes \d \w \s \D \W \S \t \n \r \f \v \0 \xHH and
+// escaped punctuation, '^' and '$' for the start and end of the string,
+// groups (...) and (?:...), '|' and the quantifiers * + ? {n} {n,} {n,m},
+// each with a lazy form ending in '?'. Matches are leftmost first like in
+// Perl or PCRE, except that a loop never repeats an iteration matching
+// nothing, like in RE2.
+//
+// Globs support '*' for any run of bytes but '/', '**' for any run of bytes,
+// '?' for any byte but '/', classes like [a-z] or [!a-z] and backslash
+// escapes. A glob always has to match the whole string.
+//
+// Matching adds states to the cache, so a regex can't be used from several
+// threads at once.
+typedef struct ArRegex ArRegex;
+
+#define AR_REGEX_DEFAULT_CACHE_SIZE MiB(1)
+
+typedef struct ArRegexDesc ArRegexDesc;
+struct ArRegexDesc {
+    ArStr pattern;
+    // Parse the pattern as a glob instead of a regex.
+    B8 glob;
+    // Only AR_STR_MATCH_FLAG_CASE_INSENSITIVE is used from the flags.
+    ArStrMatchFlag flags;
+    // Bytes of DFA states to keep before throwing them all out and starting
+    // over. Uses AR_REGEX_DEFAULT_CACHE_SIZE if zero.
+    U64 cache_size;
+};
+
+// Returns NULL and emits an error if the pattern is invalid. The pattern is
+// not referenced after creation.
+ARKIN_API ArRegex *ar_regex_create(ArRegexDesc desc);
+ARKIN_API void ar_regex_destroy(ArRegex **regex);
+// Number of capture groups, including the whole match as group zero.
+ARKIN_API U32 ar_regex_capture_count(const ArRegex *regex);
+// Checks if the whole string matches.
+ARKIN_API B8 ar_regex_match(ArRegex *regex, ArStr str);
+// Checks if any part of the string matches.
+ARKIN_API B8 ar_regex_search(ArRegex *regex, ArStr str);
+// Finds the leftmost match and fills up to 'capture_count' captures with
+// slices of 'str', the whole match first. Groups that took no part in the
+// match are left empty with a NULL data pointer.
+ARKIN_API B8 ar_regex_find(ArRegex *regex, ArStr str, ArStr *captures, U32 capture_count);
+
+//
+// Rope
+//
+
+// Text buffer for editing large strings in place. The text is a sequence of
+// pieces kept in a balanced tree ordered by position, so inserting, deleting
+// and indexing are O(log n) in the number of pieces and never copy the rest
+// of the text.
+//
+// Inserted bytes are copied into the rope's arena. The string passed to
+// ar_rope_init is not copied and has to outlive the rope. Positions past the
+// end are clamped to the length of the rope.
+//
+// for (ArRopeIter iter = ar_rope_iter_init(rope, 0, ar_rope_len(rope));
+//         ar_rope_iter_valid(&iter);
+//         ar_rope_iter_next(&iter)) {
+//     ArStr chunk = ar_rope_iter_get(&iter);
+// }
+typedef struct ArRope ArRope;
+
+ARKIN_API ArRope *ar_rope_init(ArArena *arena, ArStr str);
+ARKIN_API U64 ar_rope_len(const ArRope *rope);
+ARKIN_API void ar_rope_insert(ArRope *rope, U64 pos, ArStr str);
+ARKIN_API void ar_rope_delete(ArRope *rope, U64 pos, U64 len);
+ARKIN_API U8 ar_rope_get(const ArRope *rope, U64 index);
+// Copies the whole text into one contiguous string.
+ARKIN_API ArStr ar_rope_flatten(ArArena *arena, const ArRope *rope);
+
+// Yields the bytes of a range as the chunks they're stored in.
+typedef struct ArRopeIter ArRopeIter;
+struct ArRopeIter {
+    const ArRope *rope;
+    U64 pos;
+    U64 end;
+    ArStr chunk;
+    B8 valid;
+};
+
+ARKIN_API ArRopeIter ar_rope_iter_init(const ArRope *rope, U64 pos, U64 len);
+ARKIN_API void ar_rope_iter_next(ArRopeIter *iter);
+ARKIN_API B8 ar_rope_iter_valid(const ArRopeIter *iter);
+ARKIN_API ArStr ar_rope_iter_get(const ArRopeIter *iter);
+
+//
+// Radix tree
+//
+
+// Adaptive radix tree mapping ArStr keys to values, for exact and longest
+// prefix lookups that cost O(key length) however many keys there are. Inner
+// nodes hold 4, 16, 48 or 256 children and grow as needed. Keys are copied
+// into the arena. Values can't be NULL, NULL means not found.
+//
+// Removing a key leaves its inner nodes in place. Memory is only given back
+// when the arena is.
+//
+// for (ArRadixTreeIter iter = ar_radix_tree_iter_init(tree, ar_str_lit("/api/"));
+//         ar_radix_tree_iter_valid(&iter);
+//         ar_radix_tree_iter_next(&iter)) {
+//     ArStr key = ar_radix_tree_iter_key(&iter);
+//     void *value = ar_radix_tree_iter_value(&iter);
+// }
+typedef struct ArRadixTree ArRadixTree;
+
+ARKIN_API ArRadixTree *ar_radix_tree_init(ArArena *arena);
+ARKIN_API U64 ar_radix_tree_count(const ArRadixTree *tree);
+// Inserts the key or replaces its value.
+ARKIN_API void ar_radix_tree_set(ArRadixTree *tree, ArStr key, void *value);
+// Returns false if the key wasn't present.
+ARKIN_API B8 ar_radix_tree_remove(ArRadixTree *tree, ArStr key);
+ARKIN_API void *ar_radix_tree_get(const ArRadixTree *tree, ArStr key);
+// Value of the longest key that is a prefix of 'key'. The key itself is
+// written to 'match' if it isn't NULL.
+ARKIN_API void *ar_radix_tree_longest_prefix(const ArRadixTree *tree, ArStr key, ArStr *match);
+
+// Yields every key starting with 'prefix' in byte order, shorter keys first.
+typedef struct ArRadixTreeIter ArRadixTreeIter;
+struct ArRadixTreeIter {
+    const ArRadixTree *tree;
+    ArStr prefix;
+    const void *leaf;
+};
+
+ARKIN_API ArRadixTreeIter ar_radix_tree_iter_init(const ArRadixTree *tree, ArStr prefix);
+ARKIN_API void ar_radix_tree_iter_next(ArRadixTreeIter *iter);
+ARKIN_API B8 ar_radix_tree_iter_valid(const ArRadixTreeIter *iter);
+ARKIN_API ArStr ar_radix_tree_iter_key(const ArRadixTreeIter *iter);
+ARKIN_API void *ar_radix_tree_iter_value(const ArRadixTreeIter *iter);
+
 //
 // Pool allocator
 //
@@ -587,7 +1248,7 @@ ARKIN_API U32 ar_os_page_size(void);
 // Reserves 'size', aligned upwards to the next page boundy, of memory
 // addresses.
 //
-// It adds a size of 3 U64 to the size for the allocation header
+// It adds a size of 4 U64 to the size for the allocation header
 // used internally.
 ARKIN_API void *ar_os_mem_reserve(U64 size);
 
@@ -608,6 +1269,257 @@ ARKIN_API void ar_os_mem_decommit(void *ptr, U64 size);
 // Releases the all the reserved address space back to the OS.
 ARKIN_API void ar_os_mem_release(void *ptr);
 
+// Makes the OS back an already committed region with physical pages so the
+// first access won't page fault.
+//
+// Unlike the other memory functions 'ptr' may point anywhere inside of a
+// committed region.
+ARKIN_API void ar_os_mem_prefault(void *ptr, U64 size);
+
+// A reservation is one large mapping which smaller reservations get carved out
+// of. Compared to calling ar_os_mem_reserve for every allocation this avoids
+// a syscall per reservation and keeps the number of memory mappings down.
+//
+// Memory within a reservation is readable and writable up front, committing
+// only does bookkeeping while decommitting gives pages back to the OS. Each
+// reservation carved out of it is followed by an inaccessible guard page, and
+// released neighbours are merged back together.
+ARKIN_API ArReservation *ar_reservation_create(U64 size);
+// Releases the whole reservation. Anything carved out of it becomes invalid.
+ARKIN_API void ar_reservation_destroy(ArReservation **reservation);
+// Works like ar_os_mem_reserve but carves the memory out of the reservation.
+// The returned pointer is used with the ar_os_mem_* functions. Releasing it
+// hands the range back to the reservation.
+//
+// Returns NULL if the reservation doesn't have enough space left.
+ARKIN_API void *ar_reservation_reserve(ArReservation *reservation, U64 size);
+
+// Reads the whole file into 'arena' with a single read sized by fstat, and
+// null terminates it. Files without a known size, like pipes or the ones in
+// /proc, are read in chunks instead.
+//
+// The result has a NULL 'data' if the file can't be read.
+ARKIN_API ArStr ar_os_file_read_all(ArArena *arena, ArStr path);
+// Maps the file read-only and returns a view of its contents, valid until
+// ar_os_file_unmap. Nothing is copied, pages are loaded as they're touched.
+// Files reporting a size of zero, like the ones in /proc, are read into
+// anonymous memory instead.
+//
+// The result has a NULL 'data' if the file can't be mapped.
+ARKIN_API ArStr ar_os_file_map(ArStr path);
+ARKIN_API void ar_os_file_unmap(ArStr *view);
+// Replaces the contents of the file with the strings in 'list', written in
+// order with writev so they never have to be joined. Creates the file if it
+// doesn't exist.
+//
+// Returns false if anything couldn't be written.
+ARKIN_API B8 ar_os_file_write_all(ArStr path, ArStrList list);
+
+// Reads a file or stream one record at a time. Regular files are mapped and
+// records are slices of the mapping. Pipes and other streams are read in
+// large chunks into a buffer, with records straddling two reads moved to the
+// front of it. Memory use stays constant however long the input is.
+//
+// A record is only valid until the next call to ar_file_reader_next.
+//
+// ArStr line;
+// while (ar_file_reader_next(reader, &line)) {
+// }
+typedef struct ArFileReader ArFileReader;
+
+#define AR_FILE_READER_DEFAULT_BUFFER_SIZE MiB(1)
+#define AR_FILE_READER_DEFAULT_MAX_RECORD_SIZE MiB(256)
+
+typedef struct ArFileReaderDesc ArFileReaderDesc;
+struct ArFileReaderDesc {
+    ArStr path;
+    // Read from this descriptor instead if 'path' is empty. Zero is stdin.
+    // The descriptor isn't closed with the reader.
+    I32 fd;
+    // Separates records and isn't part of them. "\n" if empty. A delimiter
+    // at the very end doesn't start another record.
+    ArStr delim;
+    // Size of the stream buffer. Uses AR_FILE_READER_DEFAULT_BUFFER_SIZE if
+    // zero.
+    U64 buffer_size;
+    // The stream buffer grows for records longer than it, up to this.
+    // Longer records are cut. Uses AR_FILE_READER_DEFAULT_MAX_RECORD_SIZE if
+    // zero.
+    U64 max_record_size;
+    // Streams regular files too instead of mapping them.
+    B8 no_map;
+};
+
+// Returns NULL if the file can't be opened.
+ARKIN_API ArFileReader *ar_file_reader_open(ArArena *arena, ArFileReaderDesc desc);
+ARKIN_API void ar_file_reader_close(ArFileReader **reader);
+// Returns false once the input is exhausted.
+ARKIN_API B8 ar_file_reader_next(ArFileReader *reader, ArStr *record);
+
+//
+// Async I/O
+//
+
+// Keeps many reads and writes in flight from a single thread. Requests are
+// handed over in batches with ar_io_ring_submit and their completions are
+// collected with ar_io_ring_poll or ar_io_ring_wait, in the order they finish.
+//
+// Uses io_uring if the kernel supports it, otherwise a pool of worker threads
+// doing blocking pread and pwrite calls.
+//
+// Buffers belong to the caller, usually pushed on an arena, and have to stay
+// valid until their completion is collected. A ring is meant to be used from
+// one thread.
+typedef struct ArIoRing ArIoRing;
+
+#define AR_IO_RING_DEFAULT_DEPTH 64
+#define AR_IO_RING_DEFAULT_WORKER_COUNT 4
+
+typedef struct ArIoRingDesc ArIoRingDesc;
+struct ArIoRingDesc {
+    // Most requests in flight at once. Uses AR_IO_RING_DEFAULT_DEPTH if zero.
+    U32 depth;
+    // Threads to start if io_uring isn't available. Uses
+    // AR_IO_RING_DEFAULT_WORKER_COUNT if zero.
+    U32 worker_count;
+    // Uses worker threads even if io_uring is available.
+    B8 no_io_uring;
+};
+
+typedef enum {
+    AR_IO_OP_READ,
+    AR_IO_OP_WRITE,
+} ArIoOp;
+
+typedef struct ArIoRequest ArIoRequest;
+struct ArIoRequest {
+    ArIoOp op;
+    I32 fd;
+    U64 offset;
+    void *buffer;
+    U32 len;
+    // Handed back untouched with the completion.
+    void *user_data;
+};
+
+typedef struct ArIoCompletion ArIoCompletion;
+struct ArIoCompletion {
+    void *user_data;
+    // Bytes transferred, or a negative errno value on failure. Like read and
+    // write this may be less than requested.
+    I64 result;
+};
+
+// Returns NULL if io_uring isn't used and none of the worker threads start.
+ARKIN_API ArIoRing *ar_io_ring_create(ArArena *arena, ArIoRingDesc desc);
+// Waits for everything still in flight before tearing the ring down.
+ARKIN_API void ar_io_ring_destroy(ArIoRing **ring);
+ARKIN_API B8 ar_io_ring_uses_io_uring(const ArIoRing *ring);
+// Requests submitted whose completions haven't been collected yet.
+ARKIN_API U32 ar_io_ring_in_flight(const ArIoRing *ring);
+// Submits the requests with a single syscall. Stops early once 'depth'
+// requests are in flight. Returns how many were submitted.
+ARKIN_API U32 ar_io_ring_submit(ArIoRing *ring, const ArIoRequest *requests, U32 count);
+// Collects up to 'capacity' finished requests without blocking.
+ARKIN_API U32 ar_io_ring_poll(ArIoRing *ring, ArIoCompletion *completions, U32 capacity);
+// Like ar_io_ring_poll but blocks until at least 'min_count' requests have
+// finished, or everything in flight if there are fewer.
+ARKIN_API U32 ar_io_ring_wait(ArIoRing *ring, ArIoCompletion *completions, U32 capacity, U32 min_count);
+
+//
+// Directory walking
+//
+
+typedef enum {
+    AR_DIR_ENTRY_TYPE_UNKNOWN,
+    AR_DIR_ENTRY_TYPE_FILE,
+    AR_DIR_ENTRY_TYPE_DIR,
+    AR_DIR_ENTRY_TYPE_SYMLINK,
+    AR_DIR_ENTRY_TYPE_OTHER,
+} ArDirEntryType;
+
+typedef struct ArDirEntry ArDirEntry;
+struct ArDirEntry {
+    // The root joined with every directory on the way down.
+    ArStr path;
+    ArDirEntryType type;
+    // Only filled in if 'stat' is set in the walk.
+    U64 size;
+    U64 mtime_ns;
+};
+
+// Gets called with a batch of entries which, along with their paths, are only
+// valid during the call. Calls come from several threads at once.
+typedef void (*ArDirWalkFunc)(const ArDirEntry *entries, U32 count, void *args);
+
+#define AR_DIR_WALK_DEFAULT_BATCH_SIZE 1024
+#define AR_DIR_WALK_DEFAULT_BUFFER_SIZE KiB(256)
+
+typedef struct ArDirWalkDesc ArDirWalkDesc;
+struct ArDirWalkDesc {
+    ArStr root;
+    ArDirWalkFunc func;
+    void *args;
+    // Threads reading directories. The calling thread only waits for them.
+    // Uses the number of online CPUs if zero.
+    U32 thread_count;
+    // Most entries handed to 'func' at once. Uses
+    // AR_DIR_WALK_DEFAULT_BATCH_SIZE if zero.
+    U32 batch_size;
+    // Bytes of directory entries read per syscall. Uses
+    // AR_DIR_WALK_DEFAULT_BUFFER_SIZE if zero.
+    U64 buffer_size;
+    // Fills in the size and modification time of every entry with statx.
+    B8 stat;
+};
+
+// Walks everything below 'root' in no particular order, reading directories
+// with getdents64 and spreading subdirectories across threads. Symbolic
+// links aren't followed and directories that can't be opened are skipped.
+//
+// Returns false if 'root' can't be opened.
+ARKIN_API B8 ar_os_dir_walk(ArDirWalkDesc desc);
+
+//
+// Ring buffer
+//
+
+// A circular buffer whose pages are mapped twice, back to back. Whatever is
+// readable, and whatever space is free, is always one contiguous span even
+// when it wraps around the end, so records never have to be copied out to be
+// parsed.
+//
+// U64 free;
+// U8 *dst = ar_ring_buffer_write_span(ring, &free);
+// ar_ring_buffer_commit(ring, read(fd, dst, free));
+// ArStr data = ar_ring_buffer_read_span(ring);
+// ar_ring_buffer_consume(ring, parse(data));
+typedef struct ArRingBuffer ArRingBuffer;
+
+typedef struct ArRingBufferDesc ArRingBufferDesc;
+struct ArRingBufferDesc {
+    // Rounded up to a multiple of the page size.
+    U64 capacity;
+    // Lets one producer thread write while one consumer thread reads.
+    B8 spsc;
+};
+
+// Returns NULL if the memory can't be mapped.
+ARKIN_API ArRingBuffer *ar_ring_buffer_create(ArArena *arena, ArRingBufferDesc desc);
+ARKIN_API void ar_ring_buffer_destroy(ArRingBuffer **ring);
+ARKIN_API U64 ar_ring_buffer_capacity(const ArRingBuffer *ring);
+// Bytes committed but not consumed yet.
+ARKIN_API U64 ar_ring_buffer_len(const ArRingBuffer *ring);
+// Returns where to write next, with room for 'len' bytes.
+ARKIN_API U8 *ar_ring_buffer_write_span(ArRingBuffer *ring, U64 *len);
+// Makes 'len' bytes written to the write span readable.
+ARKIN_API void ar_ring_buffer_commit(ArRingBuffer *ring, U64 len);
+// Copies as much of 'data' as fits and commits it. Returns the bytes copied.
+ARKIN_API U64 ar_ring_buffer_write(ArRingBuffer *ring, ArStr data);
+// Everything readable. Stays valid until it's consumed.
+ARKIN_API ArStr ar_ring_buffer_read_span(ArRingBuffer *ring);
+ARKIN_API void ar_ring_buffer_consume(ArRingBuffer *ring, U64 len);
+
 //
 // Threads
 //
@@ -51,7 +51,11 @@ ARKIN_API void ar_log_set_no_stdout_color(B8 value);
 
 ARKIN_API void ar_log_error_callback(ArStr error);
 
+// Logs one line per live arena. Requires ARKIN_ARENA_STATS.
+#define ar_log_arena_stats(level) _ar_log_arena_stats(level, __FILE__, __LINE__)
+
 ARKIN_API void _ar_log(ArLogLevel level, const char *file, U32 line, const char *fmt, ...) AR_FORMAT_FUNCTION(4, 5);
+ARKIN_API void _ar_log_arena_stats(ArLogLevel level, const char *file, U32 line);
 
 typedef struct _ArkinLogState _ArkinLogState;
 struct _ArkinLogState {
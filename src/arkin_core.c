@@ -1,3 +1,9 @@
+// Linux specific interfaces like F_SETPIPE_SZ are only declared with
+// _GNU_SOURCE and it has to be set before the first system header.
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
 #include "arkin_core.h"
 
 #include <stdio.h>
@@ -5,13 +11,35 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <locale.h>
 
 static void _ar_os_init(U32 thread_pool_cap, U32 mutex_pool_cap);
 static void _ar_os_terminate(void);
+static void *_ar_os_shared_mem_create(ArStr name, U64 size);
+static void *_ar_os_shared_mem_open(ArStr name);
+static void _ar_os_shared_mem_release(void *ptr);
+
+static void thread_ctx_pool_init(void);
+static void thread_ctx_pool_terminate(void);
+
+#ifdef ARKIN_ALLOC_TRACE
+static void alloc_trace_record(const char *file, U32 line, U64 size);
+#endif
 
 typedef struct _ArkinCoreState _ArkinCoreState;
 struct _ArkinCoreState {
     ArThreadCtx *thread_ctx;
+    U32 scratch_arena_count;
+
+    struct {
+        ArArena *arena;
+        ArMutex mutex;
+        ArThreadCtx *free_list;
+#ifdef ARKIN_ALLOC_TRACE
+        ArThreadCtx *all;
+#endif
+    } thread_ctx_pool;
 
     struct {
         void (*callback)(ArStr error);
@@ -20,6 +48,7 @@ struct _ArkinCoreState {
     struct {
         U64 default_capacity;
         U64 default_align;
+        ArReservation *reservation;
     } arena;
 };
 static _ArkinCoreState _ar_core = {0};
@@ -36,6 +65,11 @@ void arkin_init(const ArkinCoreDesc *desc) {
     if (desc->mutex_pool_capacity == 0) {
         _desc.mutex_pool_capacity = 256;
     }
+    // Library functions taking an arena need a second scratch arena which
+    // doesn't conflict with it.
+    if (desc->scratch_arena_count < 2) {
+        _desc.scratch_arena_count = 2;
+    }
 
     if (desc->error.callback == 0) {
         _desc.error.callback = _ar_error_callback_dummy;
@@ -50,10 +84,16 @@ void arkin_init(const ArkinCoreDesc *desc) {
 
     _ar_core.arena.default_capacity = _desc.arena.default_capacity;
     _ar_core.arena.default_align = _desc.arena.default_align;
+    _ar_core.scratch_arena_count = _desc.scratch_arena_count;
 
     _ar_os_init(_desc.thread_pool_capacity, _desc.mutex_pool_capacity);
 
+    if (_desc.arena.reservation_size != 0) {
+        _ar_core.arena.reservation = ar_reservation_create(_desc.arena.reservation_size);
+    }
+
     // This has to come after OS init because we use the system page size.
+    thread_ctx_pool_init();
     _ar_core.thread_ctx = ar_thread_ctx_create();
     ar_thread_ctx_set(_ar_core.thread_ctx);
 
@@ -63,6 +103,11 @@ void arkin_init(const ArkinCoreDesc *desc) {
 void arkin_terminate(void) {
     ar_thread_ctx_set(NULL);
     ar_thread_ctx_destroy(&_ar_core.thread_ctx);
+    thread_ctx_pool_terminate();
+
+    if (_ar_core.arena.reservation != NULL) {
+        ar_reservation_destroy(&_ar_core.arena.reservation);
+    }
 
     _ar_os_terminate();
 }
@@ -76,33 +121,217 @@ static U64 align_to_value(U64 value, U64 align) {
     return value + (align - value) % align;
 }
 
+// Memory handed out starts right after the struct and the struct holds no
+// pointers into it, so an arena stays valid wherever it's mapped.
 struct ArArena {
     U64 capacity;
     U64 commited;
     U64 position;
     U64 align;
-    U8 *ptr;
+    // Backed by named shared memory that's mapped in full, commits and
+    // decommits don't do anything.
+    B8 shared;
+
+    ArArenaFlag flags;
+    // Everything below this offset has been prefaulted and won't be
+    // decommitted.
+    U64 prefaulted;
+    struct {
+        B8 running;
+        ArThread thread;
+        U8 *ptr;
+        U64 size;
+    } prefault_job;
+
+#ifdef ARKIN_ARENA_STATS
+    ArArena *stats_next;
+    ArArena *stats_prev;
+    U8 name[ARKIN_ARENA_NAME_MAX_LENGTH];
+    U64 name_len;
+    U64 peak_position;
+    U64 commit_count;
+    U64 decommit_count;
+    F64 commit_time;
+#endif
 };
 
+#ifdef ARKIN_ARENA_STATS
+// Every live arena gets linked into the registry. It's guarded by a spin lock
+// since arenas get created before the mutex pool exists.
+static struct {
+    ArArena *first;
+    ArArena *last;
+    B8 lock;
+} _ar_arena_registry = {0};
+
+static void arena_registry_lock(void) {
+    while (__atomic_test_and_set(&_ar_arena_registry.lock, __ATOMIC_ACQUIRE));
+}
+
+static void arena_registry_unlock(void) {
+    __atomic_clear(&_ar_arena_registry.lock, __ATOMIC_RELEASE);
+}
+#endif
+
+static U8 *arena_data(const ArArena *arena) {
+    return (U8 *) &arena[1];
+}
+
+static void arena_os_commit(ArArena *arena, U64 size) {
+    if (arena->shared) {
+        return;
+    }
+#ifdef ARKIN_ARENA_STATS
+    F64 start = ar_os_get_time();
+    ar_os_mem_commit(arena, size);
+    arena->commit_time += ar_os_get_time() - start;
+    arena->commit_count++;
+#else
+    ar_os_mem_commit(arena, size);
+#endif
+}
+
+static void arena_os_decommit(ArArena *arena, U64 size) {
+    if (arena->shared) {
+        return;
+    }
+    ar_os_mem_decommit(arena, size);
+#ifdef ARKIN_ARENA_STATS
+    arena->decommit_count++;
+#endif
+}
+
+static void arena_prefault_job(void *args) {
+    ArArena *arena = args;
+    ar_os_mem_prefault(arena->prefault_job.ptr, arena->prefault_job.size);
+}
+
+static void arena_prefault_wait(ArArena *arena) {
+    if (arena->prefault_job.running) {
+        ar_thread_join(arena->prefault_job.thread);
+        arena->prefault_job.running = false;
+    }
+}
+
+// Populates the committed region between 'start' and 'end', both relative to
+// the arena pointer.
+static void arena_populate(ArArena *arena, U64 start, U64 end, B8 allow_async) {
+    if (end <= start) {
+        return;
+    }
+
+    if (allow_async && arena->flags & AR_ARENA_FLAG_PREFAULT_ASYNC) {
+        arena_prefault_wait(arena);
+
+        arena->prefault_job.ptr = arena_data(arena) + start;
+        arena->prefault_job.size = end - start;
+        arena->prefault_job.thread = ar_thread_create_no_ctx(arena_prefault_job, arena);
+        if (ar_thread_valid(arena->prefault_job.thread)) {
+            arena->prefault_job.running = true;
+            return;
+        }
+    }
+
+    ar_os_mem_prefault(arena_data(arena) + start, end - start);
+}
+
+// Makes sure the first 'end' bytes after the arena pointer are committed.
+static void arena_commit(ArArena *arena, U64 end) {
+    U64 aligned = align_to_value(end, ar_os_page_size());
+    if (aligned <= arena->commited) {
+        return;
+    }
+
+    U64 prev_commited = arena->commited;
+    arena_os_commit(arena, aligned - arena->commited);
+    arena->commited = aligned;
+
+    // Pages committed during a push are about to be used so there's no point
+    // in handing them off to another thread.
+    if (arena->flags & AR_ARENA_FLAG_PREFAULT) {
+        arena_populate(arena, prev_commited, ar_min(aligned, arena->capacity), false);
+        arena->prefaulted = aligned;
+    }
+}
+
 ArArena *ar_arena_create(U64 capacity) {
-    ArArena *arena = ar_os_mem_reserve(capacity + sizeof(ArArena));
+    return ar_arena_create_desc((ArArenaDesc) {
+            .capacity = capacity,
+        });
+}
+
+ArArena *ar_arena_create_desc(ArArenaDesc desc) {
+    if (desc.capacity == 0) {
+        desc.capacity = _ar_core.arena.default_capacity;
+    }
+    if (desc.flags & AR_ARENA_FLAG_PREFAULT_ASYNC) {
+        desc.flags |= AR_ARENA_FLAG_PREFAULT;
+    }
+
+    U64 capacity = desc.capacity;
+    ArArena *arena = NULL;
+    if (desc.reservation != NULL) {
+        arena = ar_reservation_reserve(desc.reservation, capacity + sizeof(ArArena));
+    }
+    if (arena == NULL) {
+        arena = ar_os_mem_reserve(capacity + sizeof(ArArena));
+    }
     ar_os_mem_commit(arena, ar_os_page_size() + sizeof(ArArena));
     *arena = (ArArena) {
         .capacity = capacity,
         .commited = ar_os_page_size(),
         .position = 0,
         .align = _ar_core.arena.default_align,
-        .ptr = (U8 *) &arena[1],
+        .flags = desc.flags,
     };
 
 #ifdef ARKIN_SANITIZE_ADDRESSES
-    AR_ASAN_POISON_MEMORY_REGION(arena->ptr, capacity);
+    AR_ASAN_POISON_MEMORY_REGION(arena_data(arena), capacity);
     arena->position += arena->align;
 #endif
 
+#ifdef ARKIN_ARENA_STATS
+    ar_arena_set_name(arena, desc.name);
+
+    arena_registry_lock();
+    ar_dll_push_back_npz(_ar_arena_registry.first, _ar_arena_registry.last, arena, stats_next, stats_prev, ar_null_check, ar_null_set);
+    arena_registry_unlock();
+#endif
+
+    if (desc.prefault != 0) {
+        ar_arena_prefault(arena, desc.prefault);
+    }
+
+    return arena;
+}
+
+ArArena *ar_arena_create_shared(ArStr name, U64 capacity) {
+    if (capacity == 0) {
+        capacity = _ar_core.arena.default_capacity;
+    }
+
+    ArArena *arena = _ar_os_shared_mem_create(name, capacity + sizeof(ArArena));
+    if (arena == NULL) {
+        return NULL;
+    }
+    // Never poisoned, see ar_arena_push_no_zero.
+    *arena = (ArArena) {
+        .capacity = capacity,
+        .commited = capacity,
+        .align = _ar_core.arena.default_align,
+        .shared = true,
+    };
     return arena;
 }
 
+ArArena *ar_arena_attach_shared(ArStr name) {
+    return _ar_os_shared_mem_open(name);
+}
+
+void *ar_arena_shared_first(ArArena *arena) {
+    return arena_data(arena);
+}
+
 void ar_arena_set_align(ArArena *arena, U64 align) {
     arena->align = align;
 }
@@ -112,39 +341,97 @@ ArArena *ar_arena_create_default(void) {
 }
 
 void ar_arena_destroy(ArArena **arena) {
+    arena_prefault_wait(*arena);
+    if ((*arena)->shared) {
+        _ar_os_shared_mem_release(*arena);
+        *arena = NULL;
+        return;
+    }
+#ifdef ARKIN_ARENA_STATS
+    arena_registry_lock();
+    ar_dll_remove_npz(_ar_arena_registry.first, _ar_arena_registry.last, *arena, stats_next, stats_prev, ar_null_check, ar_null_set);
+    arena_registry_unlock();
+#endif
 #ifdef ARKIN_SANITIZE_ADDRESSES
-    AR_ASAN_UNPOISON_MEMORY_REGION((*arena)->ptr, (*arena)->capacity);
+    AR_ASAN_UNPOISON_MEMORY_REGION(arena_data(*arena), (*arena)->capacity);
 #endif
     ar_os_mem_release(*arena);
     *arena = NULL;
 }
 
-void *ar_arena_push(ArArena *arena, U64 size) {
-    void *result = ar_arena_push_no_zero(arena, size);
+void ar_arena_prefault(ArArena *arena, U64 bytes) {
+    U64 end = arena->position + bytes;
+    if (end > arena->capacity) {
+        end = arena->capacity;
+    }
+
+    U64 page_size = ar_os_page_size();
+    U64 start = arena->position / page_size * page_size;
+    U64 aligned = align_to_value(end, page_size);
+
+    if (aligned > arena->commited) {
+        arena_os_commit(arena, aligned - arena->commited);
+        arena->commited = aligned;
+    }
+    if (aligned > arena->prefaulted) {
+        arena->prefaulted = aligned;
+    }
+
+    arena_populate(arena, start, end, true);
+}
+
+// Push functions are wrapped in parentheses so they don't get expanded by the
+// tracing macros.
+void *(ar_arena_push)(ArArena *arena, U64 size) {
+    void *result = (ar_arena_push_no_zero)(arena, size);
     memset(result, 0, size);
     return result;
 }
 
-void *ar_arena_push_no_zero(ArArena *arena, U64 size) {
-    void *result = arena->ptr + arena->position;
+void *(ar_arena_push_no_zero)(ArArena *arena, U64 size) {
+    void *result = arena_data(arena) + arena->position;
 
     U64 aligned_size = align_to_value(size, arena->align);
     arena->position += aligned_size;
 
 #ifdef ARKIN_SANITIZE_ADDRESSES
-    AR_ASAN_UNPOISON_MEMORY_REGION(result, size);
-    arena->position += arena->align;
+    // Poisoning is per process, other processes would see memory this one
+    // pushed as poisoned, so shared arenas are left alone.
+    if (!arena->shared) {
+        AR_ASAN_UNPOISON_MEMORY_REGION(result, size);
+        arena->position += arena->align;
+    }
 #endif
 
-    U64 aligned = align_to_value(arena->position, ar_os_page_size());
-    if (aligned > arena->commited) {
-        ar_os_mem_commit(arena, aligned);
-        arena->commited = aligned;
+    arena_commit(arena, arena->position);
+
+#ifdef ARKIN_ARENA_STATS
+    if (arena->position > arena->peak_position) {
+        arena->peak_position = arena->position;
     }
+#endif
 
     return result;
 }
 
+// Pops without handing pages back to the OS, for callers that over-push and
+// give back the excess right away. Decommitting there would cost an mprotect
+// pair whenever the result lands near a page boundary.
+static void arena_pop_no_decommit(ArArena *arena, U64 size) {
+    U64 aligned_size = align_to_value(size, arena->align);
+    if (aligned_size > arena->position) {
+        aligned_size = arena->position;
+    }
+
+    arena->position -= aligned_size;
+
+#ifdef ARKIN_SANITIZE_ADDRESSES
+    if (!arena->shared) {
+        AR_ASAN_POISON_MEMORY_REGION(arena_data(arena) + arena->position, aligned_size);
+    }
+#endif
+}
+
 void ar_arena_pop(ArArena *arena, U64 size) {
     U64 aligned_size = align_to_value(size, arena->align);
 
@@ -156,12 +443,17 @@ void ar_arena_pop(ArArena *arena, U64 size) {
     arena->position -= aligned_size;
 
 #ifdef ARKIN_SANITIZE_ADDRESSES
-    AR_ASAN_POISON_MEMORY_REGION(arena->ptr + arena->position, aligned_size);
+    if (!arena->shared) {
+        AR_ASAN_POISON_MEMORY_REGION(arena_data(arena) + arena->position, aligned_size);
+    }
 #endif
 
     U64 aligned = align_to_value(arena->position, ar_os_page_size());
+    if (aligned < arena->prefaulted) {
+        aligned = arena->prefaulted;
+    }
     if (aligned < arena->commited && aligned != 0) {
-        ar_os_mem_decommit(arena, arena->commited - aligned);
+        arena_os_decommit(arena, arena->commited - aligned);
         arena->commited = aligned;
     }
 }
@@ -170,10 +462,175 @@ void ar_arena_reset(ArArena *arena) {
     ar_arena_pop(arena, arena->position);
 }
 
+// Resets the arena and hands every page but the first back to the OS,
+// including prefaulted ones. Popping to zero keeps everything committed.
+static void arena_trim(ArArena *arena) {
+    arena_prefault_wait(arena);
+    ar_arena_reset(arena);
+    arena->prefaulted = 0;
+    if (arena->commited > ar_os_page_size()) {
+        arena_os_decommit(arena, arena->commited - ar_os_page_size());
+        arena->commited = ar_os_page_size();
+    }
+}
+
 U64 ar_arena_used(const ArArena *arena) {
     return arena->position;
 }
 
+#ifdef ARKIN_ALLOC_TRACE
+void *_ar_arena_push_traced(ArArena *arena, U64 size, const char *file, U32 line) {
+    alloc_trace_record(file, line, size);
+    return (ar_arena_push)(arena, size);
+}
+
+void *_ar_arena_push_no_zero_traced(ArArena *arena, U64 size, const char *file, U32 line) {
+    alloc_trace_record(file, line, size);
+    return (ar_arena_push_no_zero)(arena, size);
+}
+#endif
+
+void ar_arena_set_name(ArArena *arena, ArStr name) {
+#ifdef ARKIN_ARENA_STATS
+    arena->name_len = ar_min(name.len, sizeof(arena->name));
+    memcpy(arena->name, name.data, arena->name_len);
+#else
+    (void) arena;
+    (void) name;
+#endif
+}
+
+ArArenaStats ar_arena_stats_get(const ArArena *arena) {
+    ArArenaStats stats = {
+        .capacity = arena->capacity,
+        .position = arena->position,
+        .commited = arena->commited,
+    };
+
+#ifdef ARKIN_ARENA_STATS
+    stats.name = ar_str(arena->name, arena->name_len);
+    stats.peak_position = arena->peak_position;
+    stats.commit_count = arena->commit_count;
+    stats.decommit_count = arena->decommit_count;
+    stats.commit_time = arena->commit_time;
+#endif
+
+    return stats;
+}
+
+#ifdef ARKIN_ARENA_STATS
+static ArStr arena_stats_json_escape(ArArena *arena, ArStr str) {
+    static const char hex[] = "0123456789abcdef";
+
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, str.len * 6);
+    U64 len = 0;
+    for (U64 i = 0; i < str.len; i++) {
+        U8 c = str.data[i];
+        if (c == '"' || c == '\\') {
+            data[len++] = '\\';
+            data[len++] = c;
+        } else if (c < 0x20) {
+            memcpy(&data[len], "\\u00", 4);
+            data[len + 4] = hex[c >> 4];
+            data[len + 5] = hex[c & 0xf];
+            len += 6;
+        } else {
+            data[len++] = c;
+        }
+    }
+
+    return ar_str(data, len);
+}
+#endif
+
+#ifdef ARKIN_ARENA_STATS
+// Copy of an arena's stats that stays valid after the registry lock is
+// released and the arena is destroyed.
+typedef struct _ArArenaStatsSnapshot _ArArenaStatsSnapshot;
+struct _ArArenaStatsSnapshot {
+    ArArenaStats stats;
+    U8 name[ARKIN_ARENA_NAME_MAX_LENGTH];
+};
+#endif
+
+ArStr ar_arena_stats_dump(ArArena *arena, ArArenaStatsFormat format) {
+#ifdef ARKIN_ARENA_STATS
+    ArTemp scratch = ar_scratch_get(&arena, 1);
+    ArArena *temp = scratch.arena != NULL ? scratch.arena : arena;
+    ArStrList list = {0};
+
+    // Only counters are copied under the spin lock, formatting happens after.
+    // Arenas created in between the two passes are left out.
+    U64 count = 0;
+    arena_registry_lock();
+    for (ArArena *curr = _ar_arena_registry.first; curr != NULL; curr = curr->stats_next) {
+        count++;
+    }
+    arena_registry_unlock();
+
+    _ArArenaStatsSnapshot *snapshots = ar_arena_push_arr_no_zero(temp, _ArArenaStatsSnapshot, count);
+    U64 taken = 0;
+    arena_registry_lock();
+    for (ArArena *curr = _ar_arena_registry.first; curr != NULL && taken < count; curr = curr->stats_next) {
+        _ArArenaStatsSnapshot *snapshot = &snapshots[taken++];
+        snapshot->stats = ar_arena_stats_get(curr);
+        memcpy(snapshot->name, snapshot->stats.name.data, snapshot->stats.name.len);
+        snapshot->stats.name.data = snapshot->name;
+    }
+    arena_registry_unlock();
+
+    if (format == AR_ARENA_STATS_FORMAT_JSON) {
+        ar_str_list_push(temp, &list, ar_str_lit("["));
+    }
+
+    for (U64 i = 0; i < taken; i++) {
+        ArArenaStats stats = snapshots[i].stats;
+        ArStr entry;
+        if (format == AR_ARENA_STATS_FORMAT_JSON) {
+            ArStr name = arena_stats_json_escape(temp, stats.name);
+            entry = ar_str_pushf(temp,
+                    "%s{\"name\":\"%.*s\",\"capacity\":%llu,\"position\":%llu,\"peak_position\":%llu,"
+                    "\"commited\":%llu,\"commit_count\":%llu,\"decommit_count\":%llu,\"commit_time\":%f}",
+                    i == 0 ? "" : ",",
+                    (I32) name.len, name.data,
+                    stats.capacity,
+                    stats.position,
+                    stats.peak_position,
+                    stats.commited,
+                    stats.commit_count,
+                    stats.decommit_count,
+                    stats.commit_time);
+        } else {
+            ArStr name = stats.name.len != 0 ? stats.name : ar_str_lit("(unnamed)");
+            entry = ar_str_pushf(temp,
+                    "%.*s: position=%llu peak=%llu commited=%llu capacity=%llu commits=%llu decommits=%llu commit_time=%.3fms\n",
+                    (I32) name.len, name.data,
+                    stats.position,
+                    stats.peak_position,
+                    stats.commited,
+                    stats.capacity,
+                    stats.commit_count,
+                    stats.decommit_count,
+                    stats.commit_time * 1000.0);
+        }
+        ar_str_list_push(temp, &list, entry);
+    }
+
+    if (format == AR_ARENA_STATS_FORMAT_JSON) {
+        ar_str_list_push(temp, &list, ar_str_lit("]"));
+    }
+
+    ArStr result = ar_str_list_join(arena, list);
+    if (scratch.arena != NULL) {
+        ar_scratch_release(&scratch);
+    }
+    return result;
+#else
+    (void) format;
+    return ar_str(ar_arena_push_no_zero(arena, 0), 0);
+#endif
+}
+
 ArTemp ar_temp_begin(ArArena *arena) {
     return (ArTemp) {
         .arena = arena,
@@ -194,8 +651,6 @@ void ar_temp_end(ArTemp *temp) {
 // Thread context
 //
 
-#define SCRATCH_ARENA_COUNT 2
-
 typedef struct _ArErrAccumulator _ArErrAccumulator;
 struct _ArErrAccumulator {
     _ArErrAccumulator *next;
@@ -209,43 +664,103 @@ struct _ArErrVars {
     _ArErrAccumulator *accum_stack;
 };
 
+// Thread contexts are never freed while arkin is running. Destroying one puts
+// it on a free list so the next thread can reuse its arenas without having to
+// map new memory.
+#ifdef ARKIN_ALLOC_TRACE
+// Only the owning thread writes to its table. Entries are claimed by storing
+// the file pointer last so readers never see a half written entry.
+typedef struct _ArAllocTraceTable _ArAllocTraceTable;
+struct _ArAllocTraceTable {
+    ArAllocSite sites[ARKIN_ALLOC_TRACE_CAPACITY];
+    ArAllocSite overflow;
+};
+#endif
+
 struct ArThreadCtx {
-    ArArena *scratch_arenas[SCRATCH_ARENA_COUNT];
+    ArThreadCtx *next;
+    // Created on first use.
+    ArArena **scratch_arenas;
+    U32 scratch_arena_count;
     _ArErrVars err;
+
+#ifdef ARKIN_ALLOC_TRACE
+    // Links every context ever created, free or not.
+    ArThreadCtx *all_next;
+    _ArAllocTraceTable *trace;
+#endif
 };
 
 ARKIN_THREAD ArThreadCtx *_ar_thread_ctx_curr = NULL;
 
-ArThreadCtx *ar_thread_ctx_create(void) {
-    ArArena *arenas[SCRATCH_ARENA_COUNT] = {0};
+static void thread_ctx_pool_init(void) {
+    _ar_core.thread_ctx_pool.arena = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(64),
+            .name = ar_str_lit("thread_ctx_pool"),
+        });
+    _ar_core.thread_ctx_pool.mutex = ar_mutex_create();
+}
 
-    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
-        arenas[i] = ar_arena_create_default();
+static void thread_ctx_pool_terminate(void) {
+    for (ArThreadCtx *ctx = _ar_core.thread_ctx_pool.free_list; ctx != NULL; ctx = ctx->next) {
+        for (U32 i = 0; i < ctx->scratch_arena_count; i++) {
+            if (ctx->scratch_arenas[i] != NULL) {
+                ar_arena_destroy(&ctx->scratch_arenas[i]);
+            }
+        }
+        if (ctx->err.arena != NULL) {
+            ar_arena_destroy(&ctx->err.arena);
+        }
     }
+    _ar_core.thread_ctx_pool.free_list = NULL;
+#ifdef ARKIN_ALLOC_TRACE
+    _ar_core.thread_ctx_pool.all = NULL;
+#endif
+
+    ar_mutex_destroy(_ar_core.thread_ctx_pool.mutex);
+    ar_arena_destroy(&_ar_core.thread_ctx_pool.arena);
+}
+
+ArThreadCtx *ar_thread_ctx_create(void) {
+    ar_mutex_lock(_ar_core.thread_ctx_pool.mutex);
 
-    ArThreadCtx *ctx = ar_arena_push_type(arenas[0], ArThreadCtx);
-    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
-        ctx->scratch_arenas[i] = arenas[i];
+    ArThreadCtx *ctx = _ar_core.thread_ctx_pool.free_list;
+    if (ctx != NULL) {
+        ar_sll_stack_pop(_ar_core.thread_ctx_pool.free_list);
+    } else {
+        ArArena *arena = _ar_core.thread_ctx_pool.arena;
+        ctx = ar_arena_push_type(arena, ArThreadCtx);
+        ctx->scratch_arena_count = _ar_core.scratch_arena_count;
+        ctx->scratch_arenas = ar_arena_push_arr(arena, ArArena *, ctx->scratch_arena_count);
+#ifdef ARKIN_ALLOC_TRACE
+        ctx->trace = ar_arena_push_type(arena, _ArAllocTraceTable);
+        ctx->all_next = _ar_core.thread_ctx_pool.all;
+        _ar_core.thread_ctx_pool.all = ctx;
+#endif
     }
 
-    ctx->err.arena = ar_arena_create(KiB(4));
+    ar_mutex_unlock(_ar_core.thread_ctx_pool.mutex);
 
+    ctx->next = NULL;
     return ctx;
 }
 
 void ar_thread_ctx_destroy(ArThreadCtx **ctx) {
-    ar_arena_destroy(&(*ctx)->err.arena);
+    ArThreadCtx *_ctx = *ctx;
 
-    // Copy arena pointers because ctx lives on the first one so if we free the
-    // first and then try to access the second one the program will segfault.
-    ArArena *arenas[SCRATCH_ARENA_COUNT] = {0};
-    for (U32 i = 0; i < ar_arrlen((*ctx)->scratch_arenas); i++) {
-        arenas[i] = (*ctx)->scratch_arenas[i];
+    for (U32 i = 0; i < _ctx->scratch_arena_count; i++) {
+        if (_ctx->scratch_arenas[i] != NULL) {
+            arena_trim(_ctx->scratch_arenas[i]);
+        }
     }
-
-    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
-        ar_arena_destroy(&arenas[i]);
+    if (_ctx->err.arena != NULL) {
+        arena_trim(_ctx->err.arena);
     }
+    _ctx->err.accum_stack = NULL;
+
+    ar_mutex_lock(_ar_core.thread_ctx_pool.mutex);
+    ar_sll_stack_push(_ar_core.thread_ctx_pool.free_list, _ctx);
+    ar_mutex_unlock(_ar_core.thread_ctx_pool.mutex);
 
     *ctx = NULL;
 }
@@ -254,116 +769,262 @@ void ar_thread_ctx_set(ArThreadCtx *ctx) {
     _ar_thread_ctx_curr = ctx;
 }
 
-static ArArena *get_non_conflicting_scratch_arena(ArArena *const *conflicting, U32 count) {
+static _ArErrVars *thread_ctx_err_vars(void) {
     if (_ar_thread_ctx_curr == NULL) {
         return NULL;
     }
 
-    if (count == 0) {
-        return _ar_thread_ctx_curr->scratch_arenas[0];
+    _ArErrVars *vars = &_ar_thread_ctx_curr->err;
+    if (vars->arena == NULL) {
+        vars->arena = ar_arena_create_desc((ArArenaDesc) {
+                .capacity = KiB(4),
+                .reservation = _ar_core.arena.reservation,
+                .name = ar_str_lit("error"),
+            });
     }
 
-    for (U8 i = 0; i < count; i++) {
-        for (U8 j = 0; j < ar_arrlen(_ar_thread_ctx_curr->scratch_arenas); j++) {
-            if (_ar_thread_ctx_curr->scratch_arenas[j] == conflicting[i]) {
-                continue;
+    return vars;
+}
+
+static ArArena *get_non_conflicting_scratch_arena(ArArena *const *conflicting, U32 count) {
+    ArThreadCtx *ctx = _ar_thread_ctx_curr;
+    if (ctx == NULL) {
+        return NULL;
+    }
+
+    for (U32 i = 0; i < ctx->scratch_arena_count; i++) {
+        ArArena *scratch = ctx->scratch_arenas[i];
+
+        // A scratch arena which hasn't been created yet can't conflict.
+        if (scratch == NULL) {
+            scratch = ar_arena_create_desc((ArArenaDesc) {
+                    .reservation = _ar_core.arena.reservation,
+                    .name = ar_str_lit("scratch"),
+                });
+            ctx->scratch_arenas[i] = scratch;
+            return scratch;
+        }
+
+        B8 conflict = false;
+        for (U32 j = 0; j < count; j++) {
+            if (scratch == conflicting[j]) {
+                conflict = true;
+                break;
             }
+        }
 
-            return _ar_thread_ctx_curr->scratch_arenas[j];
+        if (!conflict) {
+            return scratch;
         }
     }
 
     return NULL;
 }
 
-ArTemp ar_scratch_get(ArArena *const *conflicting, U32 count) {
-    ArArena *scratch = get_non_conflicting_scratch_arena(conflicting, count);
-    if (scratch == NULL) {
-        return (ArTemp) {0};
+#ifdef ARKIN_ALLOC_TRACE
+static void alloc_trace_record(const char *file, U32 line, U64 size) {
+    ArThreadCtx *ctx = _ar_thread_ctx_curr;
+    if (ctx == NULL) {
+        return;
     }
-    return ar_temp_begin(scratch);
-}
 
-//
-// Strings
-//
+    U64 hash = ((Usize) file >> 3) * 0x9e3779b97f4a7c15ull ^ line * 0xff51afd7ed558ccdull;
+    ArAllocSite *site = &ctx->trace->overflow;
+    for (U32 i = 0; i < ARKIN_ALLOC_TRACE_CAPACITY; i++) {
+        ArAllocSite *probe = &ctx->trace->sites[(hash + i) % ARKIN_ALLOC_TRACE_CAPACITY];
+        const char *probe_file = __atomic_load_n(&probe->file, __ATOMIC_RELAXED);
+        if (probe_file == file && probe->line == line) {
+            site = probe;
+            break;
+        }
+        if (probe_file == NULL) {
+            probe->line = line;
+            __atomic_store_n(&probe->file, file, __ATOMIC_RELEASE);
+            site = probe;
+            break;
+        }
+    }
 
-// Char helpers
-B8 ar_char_is_numeric(char c) {
-    return c >= '0' && c <= '9';
+    __atomic_store_n(&site->bytes, site->bytes + size, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->count, site->count + 1, __ATOMIC_RELAXED);
 }
 
-B8 ar_char_is_alpha(char c) {
-    return ar_char_is_lower(c) || ar_char_is_upper(c);
+static I32 alloc_site_cmp_location(const void *a, const void *b) {
+    const ArAllocSite *_a = a;
+    const ArAllocSite *_b = b;
+    if (_a->file != _b->file) {
+        if (_a->file == NULL || _b->file == NULL) {
+            return _a->file == NULL ? 1 : -1;
+        }
+        I32 cmp = strcmp(_a->file, _b->file);
+        if (cmp != 0) {
+            return cmp;
+        }
+    }
+    return (_a->line > _b->line) - (_a->line < _b->line);
 }
 
-B8 ar_char_is_lower(char c) {
-    return c >= 'a' && c <= 'z';
+static I32 alloc_site_cmp_bytes(const void *a, const void *b) {
+    const ArAllocSite *_a = a;
+    const ArAllocSite *_b = b;
+    return (_a->bytes < _b->bytes) - (_a->bytes > _b->bytes);
 }
+#endif
 
-B8 ar_char_is_upper(char c) {
-    return c >= 'A' && c <= 'Z';
-}
+ArAllocSite *ar_alloc_trace_collect(ArArena *arena, U32 *count) {
+    *count = 0;
 
-B8 ar_char_is_whitespace(char c) {
-    return c == ' ' ||
-        c == '\t' ||
-        c == '\n' ||
-        c == '\r' ||
-        c == '\v' ||
-        c == '\f';
-}
+#ifdef ARKIN_ALLOC_TRACE
+    ar_mutex_lock(_ar_core.thread_ctx_pool.mutex);
 
-char ar_char_to_lower(char c) {
-    if (ar_char_is_upper(c)) {
-        c += 'a' - 'A';
+    U32 capacity = 0;
+    for (ArThreadCtx *ctx = _ar_core.thread_ctx_pool.all; ctx != NULL; ctx = ctx->all_next) {
+        capacity += ARKIN_ALLOC_TRACE_CAPACITY + 1;
     }
-    return c;
-}
 
-char ar_char_to_upper(char c) {
-    if (ar_char_is_lower(c)) {
-        c -= 'a' - 'A';
+    ArAllocSite *sites = ar_arena_push_arr_no_zero(arena, ArAllocSite, capacity);
+    U32 len = 0;
+    for (ArThreadCtx *ctx = _ar_core.thread_ctx_pool.all; ctx != NULL; ctx = ctx->all_next) {
+        for (U32 i = 0; i < ARKIN_ALLOC_TRACE_CAPACITY + 1; i++) {
+            ArAllocSite *site = i < ARKIN_ALLOC_TRACE_CAPACITY ? &ctx->trace->sites[i] : &ctx->trace->overflow;
+            ArAllocSite copy = {
+                .file = __atomic_load_n(&site->file, __ATOMIC_ACQUIRE),
+                .line = site->line,
+                .bytes = __atomic_load_n(&site->bytes, __ATOMIC_RELAXED),
+                .count = __atomic_load_n(&site->count, __ATOMIC_RELAXED),
+            };
+            if (copy.count != 0) {
+                sites[len++] = copy;
+            }
+        }
     }
-    return c;
-}
 
-// String list
+    ar_mutex_unlock(_ar_core.thread_ctx_pool.mutex);
 
-void ar_str_list_push(ArArena *arena, ArStrList *list, ArStr str) {
-    ArStrListNode *node = ar_arena_push_type(arena, ArStrListNode);
-    node->str = str;
+    if (len == 0) {
+        return NULL;
+    }
 
-    ar_dll_push_back(list->first, list->last, node);
-}
+    // Merge sites recorded by multiple threads.
+    qsort(sites, len, sizeof(ArAllocSite), alloc_site_cmp_location);
+    U32 merged = 0;
+    for (U32 i = 0; i < len; i++) {
+        if (merged != 0 && alloc_site_cmp_location(&sites[merged - 1], &sites[i]) == 0) {
+            sites[merged - 1].bytes += sites[i].bytes;
+            sites[merged - 1].count += sites[i].count;
+        } else {
+            sites[merged++] = sites[i];
+        }
+    }
 
-void ar_str_list_push_front(ArArena *arena, ArStrList *list, ArStr str) {
-    ArStrListNode *node = ar_arena_push_type(arena, ArStrListNode);
-    node->str = str;
+    qsort(sites, merged, sizeof(ArAllocSite), alloc_site_cmp_bytes);
 
-    ar_dll_push_front(list->first, list->last, node);
+    *count = merged;
+    return sites;
+#else
+    (void) arena;
+    return NULL;
+#endif
 }
 
-void ar_str_list_pop(ArStrList *list) {
-    ar_dll_pop_back(list->first, list->last);
-}
+ArStr ar_alloc_trace_report(ArArena *arena, U32 max_sites) {
+    ArTemp scratch = ar_scratch_get(&arena, 1);
+    ArArena *temp = scratch.arena != NULL ? scratch.arena : arena;
 
-void ar_str_list_pop_front(ArStrList *list) {
-    ar_dll_pop_front(list->first, list->last);
-}
+    U32 count = 0;
+    ArAllocSite *sites = ar_alloc_trace_collect(temp, &count);
+    count = ar_min(count, max_sites);
 
-ArStr ar_str_list_join(ArArena *arena, ArStrList list) {
-    U64 len = 0;
-    for (ArStrListNode *curr = list.first; curr != NULL; curr = curr->next) {
-        len += curr->str.len;
+    ArStrList list = {0};
+    for (U32 i = 0; i < count; i++) {
+        ArStr line = ar_str_pushf(temp, "%16llu bytes %10llu pushes  %s:%u\n",
+                sites[i].bytes,
+                sites[i].count,
+                sites[i].file != NULL ? sites[i].file : "(other)",
+                sites[i].line);
+        ar_str_list_push(temp, &list, line);
     }
 
-    U8 *data = ar_arena_push_no_zero(arena, len);
-    U64 i = 0;
-    for (ArStrListNode *curr = list.first; curr != NULL; curr = curr->next) {
-        for (U64 j = 0; j < curr->str.len; j++) {
-            data[i + j] = curr->str.data[j];
+    ArStr result = ar_str_list_join(arena, list);
+    if (scratch.arena != NULL) {
+        ar_scratch_release(&scratch);
+    }
+    return result;
+}
+
+ArTemp ar_scratch_get(ArArena *const *conflicting, U32 count) {
+    ArArena *scratch = get_non_conflicting_scratch_arena(conflicting, count);
+    if (scratch == NULL) {
+        return (ArTemp) {0};
+    }
+    return ar_temp_begin(scratch);
+}
+
+// Like ar_scratch_get, but never fails. Threads without a context, or without
+// a scratch arena to spare, get a temporary arena which is destroyed by
+// scratch_release_any.
+static ArTemp scratch_get_any(ArArena *const *conflicting, U32 count) {
+    ArTemp scratch = ar_scratch_get(conflicting, count);
+    if (scratch.arena != NULL) {
+        return scratch;
+    }
+    return ar_temp_begin(ar_arena_create_desc((ArArenaDesc) {
+            .name = ar_str_lit("scratch_temp"),
+        }));
+}
+
+static void scratch_release_any(ArTemp *scratch) {
+    ArThreadCtx *ctx = _ar_thread_ctx_curr;
+    for (U32 i = 0; ctx != NULL && i < ctx->scratch_arena_count; i++) {
+        if (ctx->scratch_arenas[i] == scratch->arena) {
+            ar_scratch_release(scratch);
+            return;
         }
+    }
+
+    ArArena *arena = scratch->arena;
+    ar_temp_end(scratch);
+    ar_arena_destroy(&arena);
+}
+
+//
+// Strings
+//
+
+// String list
+
+void ar_str_list_push(ArArena *arena, ArStrList *list, ArStr str) {
+    ArStrListNode *node = ar_arena_push_type(arena, ArStrListNode);
+    node->str = str;
+
+    ar_dll_push_back(list->first, list->last, node);
+}
+
+void ar_str_list_push_front(ArArena *arena, ArStrList *list, ArStr str) {
+    ArStrListNode *node = ar_arena_push_type(arena, ArStrListNode);
+    node->str = str;
+
+    ar_dll_push_front(list->first, list->last, node);
+}
+
+void ar_str_list_pop(ArStrList *list) {
+    ar_dll_pop_back(list->first, list->last);
+}
+
+void ar_str_list_pop_front(ArStrList *list) {
+    ar_dll_pop_front(list->first, list->last);
+}
+
+ArStr ar_str_list_join(ArArena *arena, ArStrList list) {
+    U64 len = 0;
+    for (ArStrListNode *curr = list.first; curr != NULL; curr = curr->next) {
+        len += curr->str.len;
+    }
+
+    U8 *data = ar_arena_push_no_zero(arena, len);
+    U64 i = 0;
+    for (ArStrListNode *curr = list.first; curr != NULL; curr = curr->next) {
+        memcpy(data + i, curr->str.data, curr->str.len);
         i += curr->str.len;
     }
 
@@ -378,20 +1039,35 @@ ArStr ar_str_pushf(ArArena *arena, const char *fmt, ...) {
     return format;
 }
 
+// With ARKIN_FAST_FORMAT strings are formatted by ar_formatv instead of libc.
+#ifdef ARKIN_FAST_FORMAT
+#define str_vformat ar_formatv
+#else
+#define str_vformat vsnprintf
+#endif
+
+// Most formatted strings are short, so they're formatted into this much
+// space up front and only formatted a second time if they didn't fit.
+#define STR_PUSHF_GUESS 256
+
 ArStr ar_str_pushfv(ArArena *arena, const char *fmt, va_list args) {
-    va_list args_len;
-    va_copy(args_len, args);
-    U64 len = vsnprintf(NULL, 0, fmt, args_len);
-    va_end(args_len);
-    // Temporary length for null-terminator.
-    len++;
+    va_list args_retry;
+    va_copy(args_retry, args);
 
-    U8 *data = ar_arena_push_arr_no_zero(arena, U8, len);
+    U64 guess = align_to_value(STR_PUSHF_GUESS, arena->align);
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, guess);
+    U64 len = str_vformat((char *) data, guess, fmt, args);
 
-    vsnprintf((char *) data, len, fmt, args);
+    if (len < guess) {
+        // Give back what wasn't used, keeping the null-terminator.
+        arena_pop_no_decommit(arena, guess - align_to_value(len + 1, arena->align));
+    } else {
+        arena_pop_no_decommit(arena, guess);
+        data = ar_arena_push_arr_no_zero(arena, U8, len + 1);
+        str_vformat((char *) data, len + 1, fmt, args_retry);
+    }
+    va_end(args_retry);
 
-    // Remove null-terminator from string.
-    len--;
     return ar_str(data, len);
 }
 
@@ -401,27 +1077,6 @@ ArStr ar_str_push_copy(ArArena *arena, ArStr str) {
     return ar_str(data, str.len);
 }
 
-B8 ar_str_match(ArStr a, ArStr b, ArStrMatchFlag flags) {
-    if (a.len != b.len && !(flags & AR_STR_MATCH_FLAG_SLOPPY_LENGTH)) {
-        return false;
-    }
-    U64 len = ar_min(a.len, b.len);
-    for (U64 i = 0; i < len; i++) {
-        char _a = a.data[i];
-        char _b = b.data[i];
-        if (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
-            _a = ar_char_to_lower(_a);
-            _b = ar_char_to_lower(_b);
-        }
-
-        if (_a != _b) {
-            return false;
-        }
-    }
-
-    return true;
-}
-
 ArStr ar_str_sub(ArStr str, U64 start, U64 end) {
     if (start > end) {
         U64 temp = start;
@@ -443,695 +1098,7921 @@ ArStr ar_str_sub_len(ArStr str, U64 start, U64 len) {
     return ar_str_sub(str, start, start + len - 1);
 }
 
-U64 ar_str_find(ArStr haystack, ArStr needle, ArStrMatchFlag flags) {
-    U64 index = 0;
-    for (U64 i = 0; i < haystack.len; i++) {
-        if (flags & AR_STR_MATCH_FLAG_LAST) {
-            index = haystack.len - i - 1;
-        } else {
-            index = i;
-        }
+// String search kernels
+//
+// On x86-64 the searches run on SSE2, which is always available, or AVX2 when
+// the CPU supports it. Everything else falls back on scalar loops.
 
-        ArStr sub = ar_str_sub_len(haystack, index, needle.len);
-        if (ar_str_match(needle, sub, flags | AR_STR_MATCH_FLAG_SLOPPY_LENGTH)) {
-            return index;
-        }
+#if defined(__x86_64__) && defined(ARKIN_COMPILER_GCC)
+#define ARKIN_STR_SIMD_X86
+#include <immintrin.h>
+#endif
+
+typedef enum {
+    _AR_STR_SIMD_NONE,
+    _AR_STR_SIMD_SSE2,
+    _AR_STR_SIMD_AVX2,
+} _ArStrSimdLevel;
+
+static _ArStrSimdLevel str_simd_level(void) {
+#ifdef ARKIN_STR_SIMD_X86
+    static I32 level = -1;
+    if (level == -1) {
+        __builtin_cpu_init();
+        level = __builtin_cpu_supports("avx2") ? _AR_STR_SIMD_AVX2 : _AR_STR_SIMD_SSE2;
     }
+    return level;
+#else
+    return _AR_STR_SIMD_NONE;
+#endif
+}
 
-    return haystack.len;
+// Case mapping kernels
+//
+// A letter range check is one subtract and one signed compare: bytes in
+// 'first'..'first' + 25 end up below -128 + 26 once shifted by 'first' and
+// flipped into signed range. The case bit is then or'ed in for lower case and
+// flipped off for upper case.
+
+#ifdef ARKIN_STR_SIMD_X86
+ARKIN_INLINE __m128i str_simd_case_bit_sse2(__m128i v, char first) {
+    __m128i shifted = _mm_xor_si128(_mm_sub_epi8(v, _mm_set1_epi8(first)), _mm_set1_epi8((char) 0x80));
+    __m128i letter = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 26));
+    return _mm_and_si128(letter, _mm_set1_epi8(0x20));
 }
 
-U64 ar_str_find_char(ArStr haystack, char needle, ArStrMatchFlag flags) {
-    U64 index = 0;
-    for (U64 i = 0; i < haystack.len; i++) {
-        if (flags & AR_STR_MATCH_FLAG_LAST) {
-            index = haystack.len - i - 1;
-        } else {
-            index = i;
-        }
+ARKIN_INLINE __m128i str_simd_lower_sse2(__m128i v) {
+    return _mm_or_si128(v, str_simd_case_bit_sse2(v, 'A'));
+}
 
-        char a = needle;
-        char b = haystack.data[index];
-        if (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
-            a = ar_char_to_lower(a);
-            b = ar_char_to_lower(b);
-        }
+ARKIN_INLINE __m128i str_simd_upper_sse2(__m128i v) {
+    return _mm_xor_si128(v, str_simd_case_bit_sse2(v, 'a'));
+}
 
-        if (a == b) {
-            return index;
-        }
-    }
+__attribute__((target("avx2")))
+ARKIN_INLINE __m256i str_simd_case_bit_avx2(__m256i v, char first) {
+    __m256i shifted = _mm256_xor_si256(_mm256_sub_epi8(v, _mm256_set1_epi8(first)), _mm256_set1_epi8((char) 0x80));
+    __m256i letter = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 26), shifted);
+    return _mm256_and_si256(letter, _mm256_set1_epi8(0x20));
+}
 
-    return haystack.len;
+__attribute__((target("avx2")))
+ARKIN_INLINE __m256i str_simd_lower_avx2(__m256i v) {
+    return _mm256_or_si256(v, str_simd_case_bit_avx2(v, 'A'));
 }
 
-ArStr ar_str_trim(ArStr str) {
-    ArStr front = ar_str_trim_front(str);
-    ArStr back = ar_str_trim_back(front);
-    return back;
+__attribute__((target("avx2")))
+ARKIN_INLINE __m256i str_simd_upper_avx2(__m256i v) {
+    return _mm256_xor_si256(v, str_simd_case_bit_avx2(v, 'a'));
 }
 
-ArStr ar_str_trim_front(ArStr str) {
+static U64 str_case_map_sse2(U8 *dst, const U8 *src, U64 len, B8 upper) {
     U64 i = 0;
-    for (; i < str.len && ar_char_is_whitespace(str.data[i]); i++);
-    return ar_str_chop_start(str, i);
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (src + i));
+        v = upper ? str_simd_upper_sse2(v) : str_simd_lower_sse2(v);
+        _mm_storeu_si128((__m128i *) (dst + i), v);
+    }
+    return i;
 }
 
-ArStr ar_str_trim_back(ArStr str) {
+__attribute__((target("avx2")))
+static U64 str_case_map_avx2(U8 *dst, const U8 *src, U64 len, B8 upper) {
     U64 i = 0;
-    for (; i < str.len && ar_char_is_whitespace(str.data[str.len - i - 1]); i++);
-    return ar_str_chop_end(str, i);
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (src + i));
+        v = upper ? str_simd_upper_avx2(v) : str_simd_lower_avx2(v);
+        _mm256_storeu_si256((__m256i *) (dst + i), v);
+    }
+    return i;
 }
 
-ArStrList ar_str_split(ArArena *arena, ArStr str, ArStr delim, ArStrMatchFlag flags) {
-    ArStrList list = {0};
-
-    U64 start = 0;
-    while (start < str.len) {
-        U64 next = start + ar_str_find(ar_str_chop_start(str, start), delim, flags);
-
-        if (next == start) {
-            ar_str_list_push(arena, &list, ar_str(str.data, 0));
-        } else {
-            ar_str_list_push(arena, &list, ar_str_sub(str, start, next - 1));
+// Returns the length of the prefix known to be equal, or U64_MAX when a
+// mismatch was found.
+static U64 str_case_eq_sse2(const U8 *a, const U8 *b, U64 len) {
+    U64 i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i va = str_simd_lower_sse2(_mm_loadu_si128((const __m128i *) (a + i)));
+        __m128i vb = str_simd_lower_sse2(_mm_loadu_si128((const __m128i *) (b + i)));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)) != 0xffff) {
+            return U64_MAX;
         }
-
-        start = next + delim.len;
     }
+    return i;
+}
 
-    return list;
+__attribute__((target("avx2")))
+static U64 str_case_eq_avx2(const U8 *a, const U8 *b, U64 len) {
+    U64 i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i va = str_simd_lower_avx2(_mm256_loadu_si256((const __m256i *) (a + i)));
+        __m256i vb = str_simd_lower_avx2(_mm256_loadu_si256((const __m256i *) (b + i)));
+        if ((U32) _mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)) != U32_MAX) {
+            return U64_MAX;
+        }
+    }
+    return i;
 }
+#endif
 
-ArStrList ar_str_split_char(ArArena *arena, ArStr str, char delim, ArStrMatchFlag flags) {
-    ArStrList list = {0};
+static void str_case_map(U8 *dst, const U8 *src, U64 len, B8 upper) {
+    U64 i = 0;
+#ifdef ARKIN_STR_SIMD_X86
+    if (str_simd_level() == _AR_STR_SIMD_AVX2) {
+        i = str_case_map_avx2(dst, src, len, upper);
+    }
+    i += str_case_map_sse2(dst + i, src + i, len - i, upper);
+#endif
+    for (; i < len; i++) {
+        dst[i] = upper ? ar_char_to_upper(src[i]) : ar_char_to_lower(src[i]);
+    }
+}
 
-    U64 start = 0;
-    while (start < str.len) {
-        U64 next = start + ar_str_find_char(ar_str_chop_start(str, start), delim, flags);
+static B8 str_eq(const U8 *a, const U8 *b, U64 len, B8 case_insensitive) {
+    if (!case_insensitive) {
+        return memcmp(a, b, len) == 0;
+    }
 
-        if (next == start) {
-            ar_str_list_push(arena, &list, ar_str(str.data, 0));
-        } else {
-            ar_str_list_push(arena, &list, ar_str_sub(str, start, next - 1));
+    U64 i = 0;
+#ifdef ARKIN_STR_SIMD_X86
+    if (len >= 16) {
+        if (str_simd_level() == _AR_STR_SIMD_AVX2) {
+            i = str_case_eq_avx2(a, b, len);
+        }
+        if (i != U64_MAX) {
+            U64 j = str_case_eq_sse2(a + i, b + i, len - i);
+            i = j == U64_MAX ? j : i + j;
+        }
+        if (i == U64_MAX) {
+            return false;
         }
-
-        start = next + 1;
     }
-
-    return list;
+#endif
+    for (; i < len; i++) {
+        if (ar_char_to_lower(a[i]) != ar_char_to_lower(b[i])) {
+            return false;
+        }
+    }
+    return true;
 }
 
-//
-// Hash map
-//
+ArStr ar_str_to_lower(ArArena *arena, ArStr str) {
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, str.len);
+    str_case_map(data, str.data, str.len, false);
+    return ar_str(data, str.len);
+}
 
-B8 ar_memeq(const void *a, const void *b, U64 len) {
-    return memcmp(a, b, len) == 0;
+ArStr ar_str_to_upper(ArArena *arena, ArStr str) {
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, str.len);
+    str_case_map(data, str.data, str.len, true);
+    return ar_str(data, str.len);
 }
 
-U64 ar_fvn1a_hash(const void *data, U64 len) {
-    const U8 *_data = data;
-    U64 hash = 2166136261u;
-    for (U32 i = 0; i < len; i++) {
-        hash ^= *(_data + i);
-        hash *= 16777619;
+B8 ar_str_match(ArStr a, ArStr b, ArStrMatchFlag flags) {
+    if (a.len != b.len && !(flags & AR_STR_MATCH_FLAG_SLOPPY_LENGTH)) {
+        return false;
     }
-    return hash;
+    U64 len = ar_min(a.len, b.len);
+    if (len == 0) {
+        return true;
+    }
+    return str_eq(a.data, b.data, len, (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) != 0);
 }
 
-typedef struct ArHashMapNode ArHashMapNode;
-struct ArHashMapNode {
-    ArHashMapNode *next;
-    ArHashMapNode *prev;
-
-    void *key;
-    void *value;
-};
-
-typedef struct ArHashMapBucket ArHashMapBucket;
-struct ArHashMapBucket {
-    ArHashMapNode *first;
-    ArHashMapNode *last;
-};
-
-struct ArHashMap {
-    ArHashMapDesc desc;
+// Needles this long or longer are searched for with Horspool. Verifying false
+// positives of the vector filter gets expensive for long needles while
+// Horspool's skips grow with the needle length.
+static const U64 STR_FIND_HORSPOOL_THRESHOLD = 256;
 
-    ArHashMapBucket *buckets;
-    ArHashMapNode *free_list;
-    void *null_value;
-};
+ARKIN_INLINE U8 str_fold(U8 c, B8 case_insensitive) {
+    return case_insensitive ? (U8) ar_char_to_lower(c) : c;
+}
 
-ArHashMap *ar_hash_map_init(ArHashMapDesc desc) {
-    ArHashMap *map = ar_arena_push_type_no_zero(desc.arena, ArHashMap);
-    *map = (ArHashMap) {
-        .desc = desc,
-        .buckets = ar_arena_push_arr(desc.arena, ArHashMapBucket, desc.capacity),
-        .null_value = ar_arena_push_no_zero(desc.arena, desc.value_size),
-    };
-    memcpy(map->null_value, desc.null_value, desc.value_size);
+static U64 str_find_scalar(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    U8 first = str_fold(needle[0], ci);
+    for (U64 i = 0; i + m <= n; i++) {
+        if (str_fold(h[i], ci) == first && str_eq(h + i, needle, m, ci)) {
+            return i;
+        }
+    }
+    return n;
+}
 
-    return map;
+static U64 str_rfind_scalar(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    U8 first = str_fold(needle[0], ci);
+    for (U64 i = n - m + 1; i > 0; i--) {
+        if (str_fold(h[i - 1], ci) == first && str_eq(h + i - 1, needle, m, ci)) {
+            return i - 1;
+        }
+    }
+    return n;
 }
 
-static ArHashMapNode *hash_map_get_node(ArHashMap *map, const void *key, const void *value) {
-    ArHashMapNode *node = NULL;
-    if (map->free_list != NULL) {
-        node = map->free_list;
-        ar_sll_stack_pop(map->free_list);
+static U64 str_find_horspool(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    U64 shift[256];
+    for (U32 i = 0; i < 256; i++) {
+        shift[i] = m;
+    }
+    for (U64 i = 0; i < m - 1; i++) {
+        shift[str_fold(needle[i], ci)] = m - 1 - i;
     }
 
-    if (node == NULL) {
-        node = ar_arena_push_type(map->desc.arena, ArHashMapNode);
-        node->key = ar_arena_push_no_zero(map->desc.arena, map->desc.key_size);
-        node->value = ar_arena_push_no_zero(map->desc.arena, map->desc.value_size);
+    U8 last = str_fold(needle[m - 1], ci);
+    for (U64 i = 0; i + m <= n;) {
+        U8 c = str_fold(h[i + m - 1], ci);
+        if (c == last && str_eq(h + i, needle, m - 1, ci)) {
+            return i;
+        }
+        i += shift[c];
     }
+    return n;
+}
 
-    memcpy(node->key, key, map->desc.key_size);
-    memcpy(node->value, value, map->desc.value_size);
+// Mirror image of str_find_horspool, aligning windows at the end of the
+// haystack and skipping on the first byte of the window.
+static U64 str_rfind_horspool(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    U64 shift[256];
+    for (U32 i = 0; i < 256; i++) {
+        shift[i] = m;
+    }
+    for (U64 i = m - 1; i > 0; i--) {
+        shift[str_fold(needle[i], ci)] = i;
+    }
 
-    return node;
+    U8 first = str_fold(needle[0], ci);
+    for (U64 end = n; end >= m;) {
+        U64 i = end - m;
+        U8 c = str_fold(h[i], ci);
+        if (c == first && str_eq(h + i + 1, needle + 1, m - 1, ci)) {
+            return i;
+        }
+        if (shift[c] > i) {
+            break;
+        }
+        end -= shift[c];
+    }
+    return n;
 }
 
-static ArHashMapBucket *hash_map_get_bucket(const ArHashMap *map, const void *key) {
-    U64 hash = map->desc.hash_func(key, map->desc.key_size);
-    U32 index = hash % map->desc.capacity;
-    return &map->buckets[index];
-}
+#ifdef ARKIN_STR_SIMD_X86
+// First and last byte filter. Candidate positions get verified with a full
+// compare.
+static U64 str_find_sse2(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    __m128i first = _mm_set1_epi8(str_fold(needle[0], ci));
+    __m128i last = _mm_set1_epi8(str_fold(needle[m - 1], ci));
 
-B8 _ar_hash_map_insert(ArHashMap *map, const void *key, const void *value) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+    U64 i = 0;
+    for (; i + 16 + m - 1 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *) (h + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (h + i + m - 1));
+        if (ci) {
+            a = str_simd_lower_sse2(a);
+            b = str_simd_lower_sse2(b);
+        }
 
-    if (bucket->first != NULL) {
-        return false;
+        U32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask != 0) {
+            U32 bit = __builtin_ctz(mask);
+            if (str_eq(h + i + bit, needle, m, ci)) {
+                return i + bit;
+            }
+            mask &= mask - 1;
+        }
     }
 
-    ArHashMapNode *node = hash_map_get_node(map, key, value);
-    ar_dll_push_back(bucket->first, bucket->last, node);
-
-    return true;
+    U64 index = str_find_scalar(h + i, n - i, needle, m, ci);
+    return index == n - i ? n : i + index;
 }
 
-B8 _ar_hash_map_set(ArHashMap *map, const void *key, const void *value) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+static U64 str_rfind_sse2(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    __m128i first = _mm_set1_epi8(str_fold(needle[0], ci));
+    __m128i last = _mm_set1_epi8(str_fold(needle[m - 1], ci));
+
+    // Number of candidate positions left to check.
+    U64 end = n - m + 1;
+    for (; end >= 16; end -= 16) {
+        U64 i = end - 16;
+        __m128i a = _mm_loadu_si128((const __m128i *) (h + i));
+        __m128i b = _mm_loadu_si128((const __m128i *) (h + i + m - 1));
+        if (ci) {
+            a = str_simd_lower_sse2(a);
+            b = str_simd_lower_sse2(b);
+        }
 
-    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
-        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
-            memcpy(node->value, value, map->desc.value_size);
-            return false;
+        U32 mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+        while (mask != 0) {
+            U32 bit = 31 - __builtin_clz(mask);
+            if (str_eq(h + i + bit, needle, m, ci)) {
+                return i + bit;
+            }
+            mask &= ~(1u << bit);
         }
     }
 
-    ArHashMapNode *node = hash_map_get_node(map, key, value);
-    ar_dll_push_back(bucket->first, bucket->last, node);
-
-    return true;
+    U64 index = str_rfind_scalar(h, end + m - 1, needle, m, ci);
+    return index == end + m - 1 ? n : index;
 }
 
-B8 _ar_hash_map_remove(ArHashMap *map, const void *key) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+__attribute__((target("avx2")))
+static U64 str_find_avx2(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    __m256i first = _mm256_set1_epi8(str_fold(needle[0], ci));
+    __m256i last = _mm256_set1_epi8(str_fold(needle[m - 1], ci));
 
-    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
-        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
-            ar_sll_stack_push(map->free_list, node);
-            ar_dll_remove(bucket->first, bucket->last, node);
+    U64 i = 0;
+    for (; i + 32 + m - 1 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (h + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (h + i + m - 1));
+        if (ci) {
+            a = str_simd_lower_avx2(a);
+            b = str_simd_lower_avx2(b);
+        }
 
-            return true;
+        U32 mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask != 0) {
+            U32 bit = __builtin_ctz(mask);
+            if (str_eq(h + i + bit, needle, m, ci)) {
+                return i + bit;
+            }
+            mask &= mask - 1;
         }
     }
 
-    return false;
+    U64 index = str_find_sse2(h + i, n - i, needle, m, ci);
+    return index == n - i ? n : i + index;
 }
 
-B8 _ar_hash_map_has(const ArHashMap *map, const void *key) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+__attribute__((target("avx2")))
+static U64 str_rfind_avx2(const U8 *h, U64 n, const U8 *needle, U64 m, B8 ci) {
+    __m256i first = _mm256_set1_epi8(str_fold(needle[0], ci));
+    __m256i last = _mm256_set1_epi8(str_fold(needle[m - 1], ci));
+
+    U64 end = n - m + 1;
+    for (; end >= 32; end -= 32) {
+        U64 i = end - 32;
+        __m256i a = _mm256_loadu_si256((const __m256i *) (h + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (h + i + m - 1));
+        if (ci) {
+            a = str_simd_lower_avx2(a);
+            b = str_simd_lower_avx2(b);
+        }
 
-    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
-        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
-            return true;
+        U32 mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+        while (mask != 0) {
+            U32 bit = 31 - __builtin_clz(mask);
+            if (str_eq(h + i + bit, needle, m, ci)) {
+                return i + bit;
+            }
+            mask &= ~(1u << bit);
         }
     }
 
-    return false;
+    U64 index = str_rfind_sse2(h, end + m - 1, needle, m, ci);
+    return index == end + m - 1 ? n : index;
 }
+#endif
 
-void _ar_hash_map_get(const ArHashMap *map, const void *key, void *output) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+U64 ar_str_find(ArStr haystack, ArStr needle, ArStrMatchFlag flags) {
+    const U8 *h = haystack.data;
+    U64 n = haystack.len;
+    U64 m = needle.len;
+    B8 ci = (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) != 0;
+    B8 last = (flags & AR_STR_MATCH_FLAG_LAST) != 0;
+
+    if (m == 0) {
+        return last ? n : 0;
+    }
+    if (m > n) {
+        return n;
+    }
 
-    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
-        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
-            memcpy(output, node->value, map->desc.value_size);
-            return;
-        }
+    if (m >= STR_FIND_HORSPOOL_THRESHOLD) {
+        return last ? str_rfind_horspool(h, n, needle.data, m, ci) : str_find_horspool(h, n, needle.data, m, ci);
     }
 
-    memcpy(output, map->null_value, map->desc.value_size);
+    switch (str_simd_level()) {
+#ifdef ARKIN_STR_SIMD_X86
+        case _AR_STR_SIMD_AVX2:
+            return last ? str_rfind_avx2(h, n, needle.data, m, ci) : str_find_avx2(h, n, needle.data, m, ci);
+        case _AR_STR_SIMD_SSE2:
+            return last ? str_rfind_sse2(h, n, needle.data, m, ci) : str_find_sse2(h, n, needle.data, m, ci);
+#endif
+        default:
+            return last ? str_rfind_scalar(h, n, needle.data, m, ci) : str_find_scalar(h, n, needle.data, m, ci);
+    }
 }
 
-void *_ar_hash_map_get_ptr(const ArHashMap *map, const void *key) {
-    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+// Byte scanning kernels
+//
+// Everything is built on top of functions producing a 64-bit mask of which
+// bytes in a 64 byte block match. Scans walk the input one block at a time
+// and copy the final partial block into a padded buffer.
+
+typedef enum {
+    _AR_STR_SCAN_BYTE,
+    _AR_STR_SCAN_SET,
+    _AR_STR_SCAN_WHITESPACE,
+} _ArStrScanKind;
+
+typedef struct _ArStrScan _ArStrScan;
+struct _ArStrScan {
+    _ArStrScanKind kind;
+    // Looks for bytes that don't match instead.
+    B8 invert;
+
+    // _AR_STR_SCAN_BYTE matches either of these.
+    U8 a;
+    U8 b;
+
+    // _AR_STR_SCAN_SET
+    const U8 *set;
+    U32 set_len;
+    // Used for sets too large for the vector kernels.
+    U64 table[4];
+};
 
-    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
-        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
-            return node->value;
+// Sets with more bytes than this use the scalar lookup table.
+#define STR_SCAN_VECTOR_SET_MAX 16
+
+static U64 str_mask64_scalar(const _ArStrScan *scan, const U8 *p) {
+    U64 mask = 0;
+    for (U32 i = 0; i < 64; i++) {
+        U8 c = p[i];
+        B8 match = false;
+        switch (scan->kind) {
+            case _AR_STR_SCAN_BYTE:
+                match = c == scan->a || c == scan->b;
+                break;
+            case _AR_STR_SCAN_SET:
+                match = (scan->table[c >> 6] >> (c & 63)) & 1;
+                break;
+            case _AR_STR_SCAN_WHITESPACE:
+                match = ar_char_is_whitespace(c);
+                break;
         }
+        mask |= (U64) match << i;
     }
-
-    return NULL;
+    return mask;
 }
 
-ArArena *ar_hash_map_get_arena(const ArHashMap *map) {
-    return map->desc.arena;
+#ifdef ARKIN_STR_SIMD_X86
+static U64 str_mask64_sse2(const _ArStrScan *scan, const U8 *p) {
+    U64 mask = 0;
+    for (U32 i = 0; i < 4; i++) {
+        __m128i v = _mm_loadu_si128((const __m128i *) (p + i * 16));
+        __m128i eq = _mm_setzero_si128();
+        switch (scan->kind) {
+            case _AR_STR_SCAN_BYTE:
+                eq = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(scan->a)), _mm_cmpeq_epi8(v, _mm_set1_epi8(scan->b)));
+                break;
+            case _AR_STR_SCAN_SET:
+                for (U32 j = 0; j < scan->set_len; j++) {
+                    eq = _mm_or_si128(eq, _mm_cmpeq_epi8(v, _mm_set1_epi8(scan->set[j])));
+                }
+                break;
+            case _AR_STR_SCAN_WHITESPACE: {
+                // '\t' through '\r' are contiguous, checked by shifting them
+                // down to the bottom of the signed range.
+                __m128i shifted = _mm_xor_si128(_mm_sub_epi8(v, _mm_set1_epi8('\t')), _mm_set1_epi8((char) 0x80));
+                __m128i control = _mm_cmplt_epi8(shifted, _mm_set1_epi8(-128 + 5));
+                eq = _mm_or_si128(control, _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+            } break;
+        }
+        mask |= (U64) (U32) _mm_movemask_epi8(eq) << (i * 16);
+    }
+    return mask;
 }
 
-struct ArHashMapIter {
-    const ArHashMap *map;
-    U32 index;
-    ArHashMapNode *curr_node;
-};
+__attribute__((target("avx2")))
+static U64 str_mask64_avx2(const _ArStrScan *scan, const U8 *p) {
+    U64 mask = 0;
+    for (U32 i = 0; i < 2; i++) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (p + i * 32));
+        __m256i eq = _mm256_setzero_si256();
+        switch (scan->kind) {
+            case _AR_STR_SCAN_BYTE:
+                eq = _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(scan->a)), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(scan->b)));
+                break;
+            case _AR_STR_SCAN_SET:
+                for (U32 j = 0; j < scan->set_len; j++) {
+                    eq = _mm256_or_si256(eq, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(scan->set[j])));
+                }
+                break;
+            case _AR_STR_SCAN_WHITESPACE: {
+                __m256i shifted = _mm256_xor_si256(_mm256_sub_epi8(v, _mm256_set1_epi8('\t')), _mm256_set1_epi8((char) 0x80));
+                __m256i control = _mm256_cmpgt_epi8(_mm256_set1_epi8(-128 + 5), shifted);
+                eq = _mm256_or_si256(control, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+            } break;
+        }
+        mask |= (U64) (U32) _mm256_movemask_epi8(eq) << (i * 32);
+    }
+    return mask;
+}
+#endif
 
-ArHashMapIter *ar_hash_map_iter_init(ArArena *arena, const ArHashMap *hash_map) {
-    ArHashMapIter *iter = ar_arena_push_type(arena, ArHashMapIter);
-    iter->map = hash_map;
+typedef U64 (*_ArStrMask64Func)(const _ArStrScan *scan, const U8 *p);
 
-    for (U32 i = 0; i < hash_map->desc.capacity; i++) {
-        ArHashMapBucket bucket = hash_map->buckets[i];
-        if (bucket.first != NULL) {
-            iter->index = i;
-            iter->curr_node = bucket.first;
-            break;
-        }
+static _ArStrMask64Func str_mask64_func(const _ArStrScan *scan) {
+    if (scan->kind == _AR_STR_SCAN_SET && scan->set_len > STR_SCAN_VECTOR_SET_MAX) {
+        return str_mask64_scalar;
     }
 
-    return iter;
+    switch (str_simd_level()) {
+#ifdef ARKIN_STR_SIMD_X86
+        case _AR_STR_SIMD_AVX2:
+            return str_mask64_avx2;
+        case _AR_STR_SIMD_SSE2:
+            return str_mask64_sse2;
+#endif
+        default:
+            return str_mask64_scalar;
+    }
 }
 
-void ar_hash_map_iter_next(ArHashMapIter *iter) {
-    if (iter->curr_node->next != NULL) {
-        iter->curr_node = iter->curr_node->next;
-        return;
+// Mask of the 'len' bytes at 'p', 'len' being at most 64.
+static U64 str_scan_block(const _ArStrScan *scan, _ArStrMask64Func func, const U8 *p, U64 len) {
+    U64 mask = 0;
+    if (len == 64) {
+        mask = func(scan, p);
+    } else {
+        U8 block[64] = {0};
+        memcpy(block, p, len);
+        mask = func(scan, block);
     }
 
-    for (U32 i = iter->index + 1; i < iter->map->desc.capacity; i++) {
-        ArHashMapBucket bucket = iter->map->buckets[i];
-        if (bucket.first != NULL) {
-            iter->index = i;
-            iter->curr_node = bucket.first;
-            return;
-        }
+    if (scan->invert) {
+        mask = ~mask;
     }
-
-    iter->index = iter->map->desc.capacity;
-    iter->map = NULL;
-    iter->curr_node = NULL;
+    if (len < 64) {
+        mask &= ((U64) 1 << len) - 1;
+    }
+    return mask;
 }
 
-B8 ar_hash_map_iter_valid(const ArHashMapIter *iter) {
-    return iter->map != NULL && iter->index < iter->map->desc.capacity && iter->curr_node != NULL;
+static U64 str_scan_forward(const _ArStrScan *scan, const U8 *h, U64 n) {
+    _ArStrMask64Func func = str_mask64_func(scan);
+    for (U64 i = 0; i < n; i += 64) {
+        U64 mask = str_scan_block(scan, func, h + i, ar_min(n - i, 64));
+        if (mask != 0) {
+            return i + __builtin_ctzll(mask);
+        }
+    }
+    return n;
 }
 
-void *ar_hash_map_iter_get_key_ptr(const ArHashMapIter *iter) {
-    if (!ar_hash_map_iter_valid(iter)) {
-        return NULL;
+static U64 str_scan_backward(const _ArStrScan *scan, const U8 *h, U64 n) {
+    _ArStrMask64Func func = str_mask64_func(scan);
+    for (U64 end = n; end > 0;) {
+        U64 len = ar_min(end, 64);
+        U64 start = end - len;
+        U64 mask = str_scan_block(scan, func, h + start, len);
+        if (mask != 0) {
+            return start + 63 - __builtin_clzll(mask);
+        }
+        end = start;
     }
-
-    return iter->curr_node->key;
+    return n;
 }
 
-void *ar_hash_map_iter_get_value_ptr(const ArHashMapIter *iter) {
-    if (!ar_hash_map_iter_valid(iter)) {
-        return NULL;
+static _ArStrScan str_scan_byte(char c, ArStrMatchFlag flags) {
+    _ArStrScan scan = {
+        .kind = _AR_STR_SCAN_BYTE,
+        .a = c,
+        .b = c,
+    };
+    if (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
+        scan.a = ar_char_to_lower(c);
+        scan.b = ar_char_to_upper(c);
     }
+    return scan;
+}
 
-    return iter->curr_node->value;
+U64 ar_str_find_char(ArStr haystack, char needle, ArStrMatchFlag flags) {
+    _ArStrScan scan = str_scan_byte(needle, flags);
+    if (flags & AR_STR_MATCH_FLAG_LAST) {
+        return str_scan_backward(&scan, haystack.data, haystack.len);
+    }
+    return str_scan_forward(&scan, haystack.data, haystack.len);
 }
 
-//
-// Pool allocator
-//
+U64 ar_str_find_any_char(ArStr haystack, ArStr chars, ArStrMatchFlag flags) {
+    U8 set[STR_SCAN_VECTOR_SET_MAX];
+    _ArStrScan scan = {
+        .kind = _AR_STR_SCAN_SET,
+    };
 
-// [64-bit handle]: [32-bit generation][32-bit index]
+    for (U64 i = 0; i < chars.len; i++) {
+        U8 c = chars.data[i];
+        scan.table[c >> 6] |= (U64) 1 << (c & 63);
+        if (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
+            c = ar_char_to_upper(c);
+            scan.table[c >> 6] |= (U64) 1 << (c & 63);
+            c = ar_char_to_lower(c);
+            scan.table[c >> 6] |= (U64) 1 << (c & 63);
+        }
+    }
 
-typedef struct ArPoolFreeObject ArPoolFreeObject;
-struct ArPoolFreeObject {
-    ArPoolFreeObject *next;
-    U32 index;
-};
+    // Deduplicated set for the vector kernels.
+    for (U32 c = 0; c < 256; c++) {
+        if ((scan.table[c >> 6] >> (c & 63)) & 1) {
+            if (scan.set_len < STR_SCAN_VECTOR_SET_MAX) {
+                set[scan.set_len] = c;
+            }
+            scan.set_len++;
+        }
+    }
+    scan.set = set;
 
-struct ArPool {
-    void *pool;
-    U32 *generation;
-    B8 *used;
-    U32 *free_list;
-    U32 free_list_next;
-    U32 next_index;
-    U64 object_size;
-    U32 capacity;
-};
+    if (scan.set_len == 0) {
+        return haystack.len;
+    }
 
-ArPool *ar_pool_init(ArArena *arena, U32 capacity, U64 object_size) {
-    ArPool *pool = ar_arena_push_type_no_zero(arena, ArPool);
-    *pool = (ArPool) {
-        .pool = ar_arena_push_no_zero(arena, object_size * capacity),
-        .generation = ar_arena_push_arr(arena, U32, capacity),
-        .used = ar_arena_push_arr(arena, B8, capacity),
-        .free_list = ar_arena_push_arr(arena, U32, capacity),
-        .object_size = object_size,
-        .capacity = capacity,
-    };
+    if (flags & AR_STR_MATCH_FLAG_LAST) {
+        return str_scan_backward(&scan, haystack.data, haystack.len);
+    }
+    return str_scan_forward(&scan, haystack.data, haystack.len);
+}
 
-    return pool;
+ArStr ar_str_trim(ArStr str) {
+    ArStr front = ar_str_trim_front(str);
+    ArStr back = ar_str_trim_back(front);
+    return back;
 }
 
-ArPoolHandle ar_pool_handle_create(ArPool *pool) {
-    // Out of space.
-    if (pool->free_list_next == 0 && pool->next_index == pool->capacity) {
-        return AR_POOL_HANDLE_INVALID;
+ArStr ar_str_trim_front(ArStr str) {
+    _ArStrScan scan = {
+        .kind = _AR_STR_SCAN_WHITESPACE,
+        .invert = true,
+    };
+    U64 i = str_scan_forward(&scan, str.data, str.len);
+    return ar_str(str.data + i, str.len - i);
+}
+
+ArStr ar_str_trim_back(ArStr str) {
+    _ArStrScan scan = {
+        .kind = _AR_STR_SCAN_WHITESPACE,
+        .invert = true,
+    };
+    U64 last = str_scan_backward(&scan, str.data, str.len);
+    if (last == str.len) {
+        return ar_str(str.data, 0);
     }
+    return ar_str(str.data, last + 1);
+}
 
-    U32 index = pool->next_index;
-    if (pool->free_list_next != 0) {
-        index = pool->free_list[pool->free_list_next - 1];
-        pool->free_list_next--;
-    } else {
-        pool->next_index++;
+ArStrList ar_str_split(ArArena *arena, ArStr str, ArStr delim, ArStrMatchFlag flags) {
+    ArStrList list = {0};
+
+    for (ArStrSplitIter iter = ar_str_split_iter_init(str, delim, flags);
+            ar_str_split_iter_valid(&iter);
+            ar_str_split_iter_next(&iter)) {
+        ar_str_list_push(arena, &list, ar_str_split_iter_get(&iter));
     }
 
-    pool->used[index] = true;
-    U32 generation = pool->generation[index];
-    memset(pool->pool + index * pool->object_size, 0, pool->object_size);
+    return list;
+}
 
-    return (ArPoolHandle) {
-        .handle = ((U64) generation) << 32 | index,
+ArStrSplitIter ar_str_split_iter_init(ArStr str, ArStr delim, ArStrMatchFlag flags) {
+    ArStrSplitIter iter = {
+        .str = str,
+        .delim = delim,
+        // Tokens are always produced front to back.
+        .flags = flags & ~AR_STR_MATCH_FLAG_LAST,
     };
+    ar_str_split_iter_next(&iter);
+    return iter;
 }
 
-void ar_pool_handle_destroy(ArPool *pool, ArPoolHandle handle) {
-    if (!ar_pool_handle_valid(pool, handle)) {
+void ar_str_split_iter_next(ArStrSplitIter *iter) {
+    if (iter->pos >= iter->str.len) {
+        iter->token = ar_str(iter->str.data + iter->str.len, 0);
+        iter->valid = false;
         return;
     }
 
-    U32 index = (U32) handle.handle;
+    ArStr rest = ar_str(iter->str.data + iter->pos, iter->str.len - iter->pos);
+    U64 end = rest.len;
+    if (iter->delim.len == 1) {
+        _ArStrScan scan = str_scan_byte(iter->delim.data[0], iter->flags);
+        while (iter->mask == 0 && iter->mask_end < iter->str.len) {
+            U64 len = ar_min(iter->str.len - iter->mask_end, 64);
+            iter->mask = str_scan_block(&scan, str_mask64_func(&scan), iter->str.data + iter->mask_end, len);
+            iter->mask_end += len;
+        }
 
-    pool->used[index] = false;
-    pool->generation[index]++;
-    pool->free_list[pool->free_list_next] = index;
-    pool->free_list_next++;
+        if (iter->mask != 0) {
+            U64 block_start = (iter->mask_end - 1) & ~(U64) 63;
+            end = block_start + __builtin_ctzll(iter->mask) - iter->pos;
+            iter->mask &= iter->mask - 1;
+        }
+    } else if (iter->delim.len > 1) {
+        end = ar_str_find(rest, iter->delim, iter->flags);
+    }
+
+    iter->token = ar_str(rest.data, end);
+    iter->pos += end + ar_max(iter->delim.len, 1);
+    iter->valid = true;
 }
 
-B8 ar_pool_handle_valid(const ArPool *pool, ArPoolHandle handle) {
-    U32 generation = (U32) (handle.handle >> 32);
-    U32 index = (U32) handle.handle;
+B8 ar_str_split_iter_valid(const ArStrSplitIter *iter) {
+    return iter->valid;
+}
 
-    return handle.handle != AR_POOL_HANDLE_INVALID.handle &&
-        index < pool->next_index &&
-        generation == pool->generation[index] &&
-        pool->used[index];
+ArStr ar_str_split_iter_get(const ArStrSplitIter *iter) {
+    return iter->token;
 }
 
-void *ar_pool_handle_to_ptr(const ArPool *pool, ArPoolHandle handle) {
-    if (!ar_pool_handle_valid(pool, handle)) {
-        return NULL;
-    }
+ArStrList ar_str_split_char(ArArena *arena, ArStr str, char delim, ArStrMatchFlag flags) {
+    ArStrList list = {0};
 
-    U32 index = (U32) handle.handle;
-    return pool->pool + index * pool->object_size;
-}
+    // Walks the delimiter mask of each block directly instead of searching
+    // once per field.
+    _ArStrScan scan = str_scan_byte(delim, flags);
+    _ArStrMask64Func func = str_mask64_func(&scan);
 
-ArPoolHandle ar_pool_iter_init(const ArPool *pool) {
-    for (U32 i = 0; i < pool->capacity; i++) {
-        if (pool->used[i]) {
-            return (ArPoolHandle) {
-                .handle = (U64) pool->generation[i] << 32 | i,
-            };
+    U64 start = 0;
+    for (U64 i = 0; i < str.len; i += 64) {
+        U64 mask = str_scan_block(&scan, func, str.data + i, ar_min(str.len - i, 64));
+        while (mask != 0) {
+            U64 next = i + __builtin_ctzll(mask);
+            ar_str_list_push(arena, &list, ar_str(str.data + start, next - start));
+            start = next + 1;
+            mask &= mask - 1;
         }
     }
 
-    return AR_POOL_HANDLE_INVALID;
+    if (start < str.len) {
+        ar_str_list_push(arena, &list, ar_str(str.data + start, str.len - start));
+    }
+
+    return list;
 }
 
-B8 ar_pool_iter_valid(const ArPool *pool, ArPoolHandle iter) {
-    return ar_pool_handle_valid(pool, iter);
+//
+// String array
+//
+
+static void str_array_set_offset(ArStrArray *array, U64 index, U64 offset) {
+    if (array->wide) {
+        ((U64 *) array->offsets)[index] = offset;
+    } else {
+        ((U32 *) array->offsets)[index] = (U32) offset;
+    }
 }
 
-ArPoolHandle ar_pool_iter_next(const ArPool *pool, ArPoolHandle iter) {
-    for (U32 i = ((U32) iter.handle) + 1; i < pool->capacity; i++) {
-        if (pool->used[i]) {
-            return (ArPoolHandle) {
-                .handle = (U64) pool->generation[i] << 32 | i,
-            };
+static void str_array_grow_offsets(ArStrArray *array, U64 capacity, B8 wide) {
+    U64 size = wide ? sizeof(U64) : sizeof(U32);
+    void *offsets = ar_arena_push_arr_no_zero(array->arena, U8, (capacity + 1) * size);
+    if (wide == array->wide) {
+        memcpy(offsets, array->offsets, (array->count + 1) * size);
+    } else {
+        for (U64 i = 0; i <= array->count; i++) {
+            ((U64 *) offsets)[i] = ((const U32 *) array->offsets)[i];
         }
     }
+    array->offsets = offsets;
+    array->offset_capacity = capacity;
+    array->wide = wide;
+}
 
-    return AR_POOL_HANDLE_INVALID;
+ArStrArray ar_str_array_init(ArArena *arena, U64 count, U64 bytes) {
+    ArStrArray array = {
+        .arena = arena,
+        .capacity = bytes,
+        .offset_capacity = ar_max(count, 1),
+        .wide = bytes > U32_MAX,
+    };
+    array.data = ar_arena_push_arr_no_zero(arena, U8, bytes);
+    U64 size = array.wide ? sizeof(U64) : sizeof(U32);
+    array.offsets = ar_arena_push_arr_no_zero(arena, U8, (array.offset_capacity + 1) * size);
+    str_array_set_offset(&array, 0, 0);
+    return array;
 }
 
-//
-// Error handling
-//
+// Caller makes sure the blob and offsets have room. Bytes up to 'data_end'
+// may be read, so short strings get copied as a fixed 16 bytes when both
+// sides have the slack instead of going through memcpy's size dispatch.
+ARKIN_INLINE void str_array_push_unchecked(ArStrArray *array, const U8 *data, U64 len, const U8 *data_end) {
+    U8 *dst = array->data + array->len;
+    if (len <= 16 && data_end - data >= 16 && array->capacity - array->len >= 16) {
+        memcpy(dst, data, 16);
+    } else {
+        memcpy(dst, data, len);
+    }
+    array->len += len;
+    array->count++;
+    str_array_set_offset(array, array->count, array->len);
+}
 
-void ar_err_accum_begin(ArErrAccumType type) {
-    if (_ar_thread_ctx_curr == NULL) {
-        return;
+void ar_str_array_push(ArStrArray *array, ArStr str) {
+    U64 len = array->len + str.len;
+    if (len > array->capacity) {
+        U64 capacity = ar_max(ar_max(array->capacity * 2, len), 64);
+        U8 *data = ar_arena_push_arr_no_zero(array->arena, U8, capacity);
+        memcpy(data, array->data, array->len);
+        array->data = data;
+        array->capacity = capacity;
+    }
+    if (array->count == array->offset_capacity || (len > U32_MAX && !array->wide)) {
+        U64 capacity = array->offset_capacity;
+        if (array->count == capacity) {
+            capacity *= 2;
+        }
+        str_array_grow_offsets(array, capacity, array->wide || len > U32_MAX);
     }
 
-    _ArErrVars *vars = &_ar_thread_ctx_curr->err;
-    _ArErrAccumulator *accum = ar_arena_push_type(vars->arena, _ArErrAccumulator);
-    accum->type = type;
-    ar_sll_stack_push(vars->accum_stack, accum);
+    str_array_push_unchecked(array, str.data, str.len, str.data + str.len);
 }
 
-ArErr *ar_err_accum_end(ArArena *arena) {
-    if (_ar_thread_ctx_curr == NULL) {
-        return NULL;
+ArStrArray ar_str_array_from_list(ArArena *arena, ArStrList list) {
+    U64 count = 0;
+    U64 bytes = 0;
+    for (ArStrListNode *node = list.first; node != NULL; node = node->next) {
+        count++;
+        bytes += node->str.len;
     }
 
-    _ArErrVars *vars = &_ar_thread_ctx_curr->err;
-    _ArErrAccumulator *accum = vars->accum_stack;
-    if (accum == NULL) {
-        return NULL;
+    ArStrArray array = ar_str_array_init(arena, count, bytes);
+    for (ArStrListNode *node = list.first; node != NULL; node = node->next) {
+        ar_str_array_push(&array, node->str);
     }
+    return array;
+}
 
-    ArErr *result = NULL;
+ArStrList ar_str_array_to_list(ArArena *arena, const ArStrArray *array) {
+    ArStrList list = {0};
+    for (U64 i = 0; i < array->count; i++) {
+        ar_str_list_push(arena, &list, ar_str_array_get(array, i));
+    }
+    return list;
+}
 
-    switch (accum->type) {
+ArStrArray ar_str_split_array(ArArena *arena, ArStr str, ArStr delim, ArStrMatchFlag flags) {
+    // Tokens never add up to more than the string itself.
+    ArStrArray array = ar_str_array_init(arena, 0, str.len);
+
+    for (ArStrSplitIter iter = ar_str_split_iter_init(str, delim, flags);
+            ar_str_split_iter_valid(&iter);
+            ar_str_split_iter_next(&iter)) {
+        ar_str_array_push(&array, ar_str_split_iter_get(&iter));
+    }
+
+    return array;
+}
+
+ArStrArray ar_str_split_char_array(ArArena *arena, ArStr str, char delim, ArStrMatchFlag flags) {
+    _ArStrScan scan = str_scan_byte(delim, flags);
+    _ArStrMask64Func func = str_mask64_func(&scan);
+
+    // Counting the delimiters first is cheap next to copying. It sizes the
+    // blob and offsets exactly, so the tokens can be pushed without checks.
+    // The blob gets 16 bytes of slack for the short string copies.
+    U64 count = 0;
+    for (U64 i = 0; i < str.len; i += 64) {
+        count += __builtin_popcountll(str_scan_block(&scan, func, str.data + i, ar_min(str.len - i, 64)));
+    }
+    ArStrArray array = ar_str_array_init(arena, count + 1, str.len - count + 16);
+
+    U64 start = 0;
+    for (U64 i = 0; i < str.len; i += 64) {
+        U64 mask = str_scan_block(&scan, func, str.data + i, ar_min(str.len - i, 64));
+        while (mask != 0) {
+            U64 next = i + __builtin_ctzll(mask);
+            str_array_push_unchecked(&array, str.data + start, next - start, str.data + str.len);
+            start = next + 1;
+            mask &= mask - 1;
+        }
+    }
+
+    if (start < str.len) {
+        str_array_push_unchecked(&array, str.data + start, str.len - start, str.data + str.len);
+    }
+
+    return array;
+}
+
+//
+// String builder
+//
+
+ArStrBuilder ar_str_builder_init(ArArena *arena, U64 chunk_size) {
+    if (chunk_size == 0) {
+        chunk_size = AR_STR_BUILDER_DEFAULT_CHUNK_SIZE;
+    }
+    return (ArStrBuilder) {
+        .arena = arena,
+        .chunk_size = chunk_size,
+    };
+}
+
+// Makes sure the last chunk has at least 'size' bytes free.
+static ArStrBuilderChunk *str_builder_reserve(ArStrBuilder *builder, U64 size) {
+    ArStrBuilderChunk *chunk = builder->last;
+    if (chunk != NULL && chunk->cap - chunk->len >= size) {
+        return chunk;
+    }
+
+    U64 cap = ar_max(builder->chunk_size, size);
+    chunk = ar_arena_push_type(builder->arena, ArStrBuilderChunk);
+    chunk->data = ar_arena_push_arr_no_zero(builder->arena, U8, cap);
+    chunk->cap = cap;
+    ar_sll_queue_push(builder->first, builder->last, chunk);
+    builder->chunk_count++;
+    builder->chunk_size = ar_min(builder->chunk_size * 2, AR_STR_BUILDER_MAX_CHUNK_SIZE);
+
+    return chunk;
+}
+
+void ar_str_builder_push(ArStrBuilder *builder, ArStr str) {
+    // Fill up the current chunk before starting a new one.
+    ArStrBuilderChunk *chunk = builder->last;
+    U64 written = 0;
+    if (chunk != NULL) {
+        written = ar_min(chunk->cap - chunk->len, str.len);
+        memcpy(chunk->data + chunk->len, str.data, written);
+        chunk->len += written;
+    }
+
+    if (written < str.len) {
+        chunk = str_builder_reserve(builder, str.len - written);
+        memcpy(chunk->data, str.data + written, str.len - written);
+        chunk->len = str.len - written;
+    }
+
+    builder->len += str.len;
+}
+
+void ar_str_builder_push_char(ArStrBuilder *builder, char c) {
+    ArStrBuilderChunk *chunk = str_builder_reserve(builder, 1);
+    chunk->data[chunk->len] = c;
+    chunk->len++;
+    builder->len++;
+}
+
+void ar_str_builder_pushf(ArStrBuilder *builder, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    ar_str_builder_pushfv(builder, fmt, args);
+    va_end(args);
+}
+
+void ar_str_builder_pushfv(ArStrBuilder *builder, const char *fmt, va_list args) {
+    ArStrBuilderChunk *chunk = builder->last;
+    U64 free = chunk != NULL ? chunk->cap - chunk->len : 0;
+
+    va_list args_retry;
+    va_copy(args_retry, args);
+
+    // Formatted straight into the free space. Only when it doesn't fit, it's
+    // formatted again into a chunk big enough.
+    char dummy = 0;
+    char *dst = free != 0 ? (char *) chunk->data + chunk->len : &dummy;
+    U64 len = str_vformat(dst, ar_max(free, 1), fmt, args);
+    if (len < free) {
+        chunk->len += len;
+    } else {
+        // Null-terminator needs room too.
+        chunk = str_builder_reserve(builder, len + 1);
+        str_vformat((char *) chunk->data + chunk->len, len + 1, fmt, args_retry);
+        chunk->len += len;
+    }
+    va_end(args_retry);
+
+    builder->len += len;
+}
+
+ArStr ar_str_builder_finalize(ArArena *arena, const ArStrBuilder *builder) {
+    if (builder->chunk_count == 1) {
+        return ar_str(builder->first->data, builder->first->len);
+    }
+
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, builder->len);
+    U64 i = 0;
+    for (ArStrBuilderChunk *chunk = builder->first; chunk != NULL; chunk = chunk->next) {
+        memcpy(data + i, chunk->data, chunk->len);
+        i += chunk->len;
+    }
+
+    return ar_str(data, builder->len);
+}
+
+ArIoVec *ar_str_builder_iovecs(ArArena *arena, const ArStrBuilder *builder, U64 *count) {
+    ArIoVec *iovecs = ar_arena_push_arr_no_zero(arena, ArIoVec, builder->chunk_count);
+    U64 i = 0;
+    for (ArStrBuilderChunk *chunk = builder->first; chunk != NULL; chunk = chunk->next) {
+        if (chunk->len != 0) {
+            iovecs[i] = (ArIoVec) {
+                .base = chunk->data,
+                .len = chunk->len,
+            };
+            i++;
+        }
+    }
+
+    *count = i;
+    return iovecs;
+}
+
+//
+// Formatting
+//
+
+static const char FORMAT_DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static U32 format_decimal_length(U64 value) {
+    U32 len = 1;
+    while (value >= 10000) {
+        value /= 10000;
+        len += 4;
+    }
+    if (value >= 1000) {
+        return len + 3;
+    }
+    if (value >= 100) {
+        return len + 2;
+    }
+    if (value >= 10) {
+        return len + 1;
+    }
+    return len;
+}
+
+// Writes exactly 'len' digits, two at a time from the back. Peels off eight
+// digits at a time first so most of the work is 32-bit arithmetic.
+static void format_decimal(char *buffer, U64 value, U32 len) {
+    char *p = buffer + len;
+    while (value >= 100000000) {
+        U32 low = value % 100000000;
+        value /= 100000000;
+        for (U32 i = 0; i < 4; i++) {
+            p -= 2;
+            memcpy(p, &FORMAT_DIGIT_PAIRS[(low % 100) * 2], 2);
+            low /= 100;
+        }
+    }
+
+    U32 high = value;
+    while (high >= 100) {
+        U32 pair = high % 100;
+        high /= 100;
+        p -= 2;
+        memcpy(p, &FORMAT_DIGIT_PAIRS[pair * 2], 2);
+    }
+    if (high >= 10) {
+        p -= 2;
+        memcpy(p, &FORMAT_DIGIT_PAIRS[high * 2], 2);
+    } else {
+        p--;
+        *p = '0' + high;
+    }
+}
+
+U32 ar_format_u64(char *buffer, U64 value) {
+    U32 len = format_decimal_length(value);
+    format_decimal(buffer, value, len);
+    return len;
+}
+
+U32 ar_format_i64(char *buffer, I64 value) {
+    if (value < 0) {
+        buffer[0] = '-';
+        return ar_format_u64(buffer + 1, -(U64) value) + 1;
+    }
+    return ar_format_u64(buffer, value);
+}
+
+// Shortest round-trip float printing following Ryu by Ulf Adams.
+// https://github.com/ulfjack/ryu
+//
+// The tables hold 5^i and 2^k / 5^i scaled to 125 significant bits.
+
+#define FORMAT_POW5_INV_BITCOUNT 125
+#define FORMAT_POW5_BITCOUNT 125
+#define FORMAT_POW5_INV_TABLE_SIZE 342
+#define FORMAT_POW5_TABLE_SIZE 326
+
+static const U64 FORMAT_POW5_INV_SPLIT[FORMAT_POW5_INV_TABLE_SIZE][2] = {
+    { 1ull, 2305843009213693952ull }, { 11068046444225730970ull, 1844674407370955161ull },
+    { 5165088340638674453ull, 1475739525896764129ull }, { 7821419487252849886ull, 1180591620717411303ull },
+    { 8824922364862649494ull, 1888946593147858085ull }, { 7059937891890119595ull, 1511157274518286468ull },
+    { 13026647942995916322ull, 1208925819614629174ull }, { 9774590264567735146ull, 1934281311383406679ull },
+    { 11509021026396098440ull, 1547425049106725343ull }, { 16585914450600699399ull, 1237940039285380274ull },
+    { 15469416676735388068ull, 1980704062856608439ull }, { 16064882156130220778ull, 1584563250285286751ull },
+    { 9162556910162266299ull, 1267650600228229401ull }, { 7281393426775805432ull, 2028240960365167042ull },
+    { 16893161185646375315ull, 1622592768292133633ull }, { 2446482504291369283ull, 1298074214633706907ull },
+    { 7603720821608101175ull, 2076918743413931051ull }, { 2393627842544570617ull, 1661534994731144841ull },
+    { 16672297533003297786ull, 1329227995784915872ull }, { 11918280793837635165ull, 2126764793255865396ull },
+    { 5845275820328197809ull, 1701411834604692317ull }, { 15744267100488289217ull, 1361129467683753853ull },
+    { 3054734472329800808ull, 2177807148294006166ull }, { 17201182836831481939ull, 1742245718635204932ull },
+    { 6382248639981364905ull, 1393796574908163946ull }, { 2832900194486363201ull, 2230074519853062314ull },
+    { 5955668970331000884ull, 1784059615882449851ull }, { 1075186361522890384ull, 1427247692705959881ull },
+    { 12788344622662355584ull, 2283596308329535809ull }, { 13920024512871794791ull, 1826877046663628647ull },
+    { 3757321980813615186ull, 1461501637330902918ull }, { 10384555214134712795ull, 1169201309864722334ull },
+    { 5547241898389809503ull, 1870722095783555735ull }, { 4437793518711847602ull, 1496577676626844588ull },
+    { 10928932444453298728ull, 1197262141301475670ull }, { 17486291911125277965ull, 1915619426082361072ull },
+    { 6610335899416401726ull, 1532495540865888858ull }, { 12666966349016942027ull, 1225996432692711086ull },
+    { 12888448528943286597ull, 1961594292308337738ull }, { 17689456452638449924ull, 1569275433846670190ull },
+    { 14151565162110759939ull, 1255420347077336152ull }, { 7885109000409574610ull, 2008672555323737844ull },
+    { 9997436015069570011ull, 1606938044258990275ull }, { 7997948812055656009ull, 1285550435407192220ull },
+    { 12796718099289049614ull, 2056880696651507552ull }, { 2858676849947419045ull, 1645504557321206042ull },
+    { 13354987924183666206ull, 1316403645856964833ull }, { 17678631863951955605ull, 2106245833371143733ull },
+    { 3074859046935833515ull, 1684996666696914987ull }, { 13527933681774397782ull, 1347997333357531989ull },
+    { 10576647446613305481ull, 2156795733372051183ull }, { 15840015586774465031ull, 1725436586697640946ull },
+    { 8982663654677661702ull, 1380349269358112757ull }, { 18061610662226169046ull, 2208558830972980411ull },
+    { 10759939715039024913ull, 1766847064778384329ull }, { 12297300586773130254ull, 1413477651822707463ull },
+    { 15986332124095098083ull, 2261564242916331941ull }, { 9099716884534168143ull, 1809251394333065553ull },
+    { 14658471137111155161ull, 1447401115466452442ull }, { 4348079280205103483ull, 1157920892373161954ull },
+    { 14335624477811986218ull, 1852673427797059126ull }, { 7779150767507678651ull, 1482138742237647301ull },
+    { 2533971799264232598ull, 1185710993790117841ull }, { 15122401323048503126ull, 1897137590064188545ull },
+    { 12097921058438802501ull, 1517710072051350836ull }, { 5988988032009131678ull, 1214168057641080669ull },
+    { 16961078480698431330ull, 1942668892225729070ull }, { 13568862784558745064ull, 1554135113780583256ull },
+    { 7165741412905085728ull, 1243308091024466605ull }, { 11465186260648137165ull, 1989292945639146568ull },
+    { 16550846638002330379ull, 1591434356511317254ull }, { 16930026125143774626ull, 1273147485209053803ull },
+    { 4951948911778577463ull, 2037035976334486086ull }, { 272210314680951647ull, 1629628781067588869ull },
+    { 3907117066486671641ull, 1303703024854071095ull }, { 6251387306378674625ull, 2085924839766513752ull },
+    { 16069156289328670670ull, 1668739871813211001ull }, { 9165976216721026213ull, 1334991897450568801ull },
+    { 7286864317269821294ull, 2135987035920910082ull }, { 16897537898041588005ull, 1708789628736728065ull },
+    { 13518030318433270404ull, 1367031702989382452ull }, { 6871453250525591353ull, 2187250724783011924ull },
+    { 9186511415162383406ull, 1749800579826409539ull }, { 11038557946871817048ull, 1399840463861127631ull },
+    { 10282995085511086630ull, 2239744742177804210ull }, { 8226396068408869304ull, 1791795793742243368ull },
+    { 13959814484210916090ull, 1433436634993794694ull }, { 11267656730511734774ull, 2293498615990071511ull },
+    { 5324776569667477496ull, 1834798892792057209ull }, { 7949170070475892320ull, 1467839114233645767ull },
+    { 17427382500606444826ull, 1174271291386916613ull }, { 5747719112518849781ull, 1878834066219066582ull },
+    { 15666221734240810795ull, 1503067252975253265ull }, { 12532977387392648636ull, 1202453802380202612ull },
+    { 5295368560860596524ull, 1923926083808324180ull }, { 4236294848688477220ull, 1539140867046659344ull },
+    { 7078384693692692099ull, 1231312693637327475ull }, { 11325415509908307358ull, 1970100309819723960ull },
+    { 9060332407926645887ull, 1576080247855779168ull }, { 14626963555825137356ull, 1260864198284623334ull },
+    { 12335095245094488799ull, 2017382717255397335ull }, { 9868076196075591040ull, 1613906173804317868ull },
+    { 15273158586344293478ull, 1291124939043454294ull }, { 13369007293925138595ull, 2065799902469526871ull },
+    { 7005857020398200553ull, 1652639921975621497ull }, { 16672732060544291412ull, 1322111937580497197ull },
+    { 11918976037903224966ull, 2115379100128795516ull }, { 5845832015580669650ull, 1692303280103036413ull },
+    { 12055363241948356366ull, 1353842624082429130ull }, { 841837113407818570ull, 2166148198531886609ull },
+    { 4362818505468165179ull, 1732918558825509287ull }, { 14558301248600263113ull, 1386334847060407429ull },
+    { 12225235553534690011ull, 2218135755296651887ull }, { 2401490813343931363ull, 1774508604237321510ull },
+    { 1921192650675145090ull, 1419606883389857208ull }, { 17831303500047873437ull, 2271371013423771532ull },
+    { 6886345170554478103ull, 1817096810739017226ull }, { 1819727321701672159ull, 1453677448591213781ull },
+    { 16213177116328979020ull, 1162941958872971024ull }, { 14873036941900635463ull, 1860707134196753639ull },
+    { 15587778368262418694ull, 1488565707357402911ull }, { 8780873879868024632ull, 1190852565885922329ull },
+    { 2981351763563108441ull, 1905364105417475727ull }, { 13453127855076217722ull, 1524291284333980581ull },
+    { 7073153469319063855ull, 1219433027467184465ull }, { 11317045550910502167ull, 1951092843947495144ull },
+    { 12742985255470312057ull, 1560874275157996115ull }, { 10194388204376249646ull, 1248699420126396892ull },
+    { 1553625868034358140ull, 1997919072202235028ull }, { 8621598323911307159ull, 1598335257761788022ull },
+    { 17965325103354776697ull, 1278668206209430417ull }, { 13987124906400001422ull, 2045869129935088668ull },
+    { 121653480894270168ull, 1636695303948070935ull }, { 97322784715416134ull, 1309356243158456748ull },
+    { 14913111714512307107ull, 2094969989053530796ull }, { 8241140556867935363ull, 1675975991242824637ull },
+    { 17660958889720079260ull, 1340780792994259709ull }, { 17189487779326395846ull, 2145249268790815535ull },
+    { 13751590223461116677ull, 1716199415032652428ull }, { 18379969808252713988ull, 1372959532026121942ull },
+    { 14650556434236701088ull, 2196735251241795108ull }, { 652398703163629901ull, 1757388200993436087ull },
+    { 11589965406756634890ull, 1405910560794748869ull }, { 7475898206584884855ull, 2249456897271598191ull },
+    { 2291369750525997561ull, 1799565517817278553ull }, { 9211793429904618695ull, 1439652414253822842ull },
+    { 18428218302589300235ull, 2303443862806116547ull }, { 7363877012587619542ull, 1842755090244893238ull },
+    { 13269799239553916280ull, 1474204072195914590ull }, { 10615839391643133024ull, 1179363257756731672ull },
+    { 2227947767661371545ull, 1886981212410770676ull }, { 16539753473096738529ull, 1509584969928616540ull },
+    { 13231802778477390823ull, 1207667975942893232ull }, { 6413489186596184024ull, 1932268761508629172ull },
+    { 16198837793502678189ull, 1545815009206903337ull }, { 5580372605318321905ull, 1236652007365522670ull },
+    { 8928596168509315048ull, 1978643211784836272ull }, { 18210923379033183008ull, 1582914569427869017ull },
+    { 7190041073742725760ull, 1266331655542295214ull }, { 436019273762630246ull, 2026130648867672343ull },
+    { 7727513048493924843ull, 1620904519094137874ull }, { 9871359253537050198ull, 1296723615275310299ull },
+    { 4726128361433549347ull, 2074757784440496479ull }, { 7470251503888749801ull, 1659806227552397183ull },
+    { 13354898832594820487ull, 1327844982041917746ull }, { 13989140502667892133ull, 2124551971267068394ull },
+    { 14880661216876224029ull, 1699641577013654715ull }, { 11904528973500979224ull, 1359713261610923772ull },
+    { 4289851098633925465ull, 2175541218577478036ull }, { 18189276137874781665ull, 1740432974861982428ull },
+    { 3483374466074094362ull, 1392346379889585943ull }, { 1884050330976640656ull, 2227754207823337509ull },
+    { 5196589079523222848ull, 1782203366258670007ull }, { 15225317707844309248ull, 1425762693006936005ull },
+    { 5913764258841343181ull, 2281220308811097609ull }, { 8420360221814984868ull, 1824976247048878087ull },
+    { 17804334621677718864ull, 1459980997639102469ull }, { 17932816512084085415ull, 1167984798111281975ull },
+    { 10245762345624985047ull, 1868775676978051161ull }, { 4507261061758077715ull, 1495020541582440929ull },
+    { 7295157664148372495ull, 1196016433265952743ull }, { 7982903447895485668ull, 1913626293225524389ull },
+    { 10075671573058298858ull, 1530901034580419511ull }, { 4371188443704728763ull, 1224720827664335609ull },
+    { 14372599139411386667ull, 1959553324262936974ull }, { 15187428126271019657ull, 1567642659410349579ull },
+    { 15839291315758726049ull, 1254114127528279663ull }, { 3206773216762499739ull, 2006582604045247462ull },
+    { 13633465017635730761ull, 1605266083236197969ull }, { 14596120828850494932ull, 1284212866588958375ull },
+    { 4907049252451240275ull, 2054740586542333401ull }, { 236290587219081897ull, 1643792469233866721ull },
+    { 14946427728742906810ull, 1315033975387093376ull }, { 16535586736504830250ull, 2104054360619349402ull },
+    { 5849771759720043554ull, 1683243488495479522ull }, { 15747863852001765813ull, 1346594790796383617ull },
+    { 10439186904235184007ull, 2154551665274213788ull }, { 15730047152871967852ull, 1723641332219371030ull },
+    { 12584037722297574282ull, 1378913065775496824ull }, { 9066413911450387881ull, 2206260905240794919ull },
+    { 10942479943902220628ull, 1765008724192635935ull }, { 8753983955121776503ull, 1412006979354108748ull },
+    { 10317025513452932081ull, 2259211166966573997ull }, { 874922781278525018ull, 1807368933573259198ull },
+    { 8078635854506640661ull, 1445895146858607358ull }, { 13841606313089133175ull, 1156716117486885886ull },
+    { 14767872471458792434ull, 1850745787979017418ull }, { 746251532941302978ull, 1480596630383213935ull },
+    { 597001226353042382ull, 1184477304306571148ull }, { 15712597221132509104ull, 1895163686890513836ull },
+    { 8880728962164096960ull, 1516130949512411069ull }, { 10793931984473187891ull, 1212904759609928855ull },
+    { 17270291175157100626ull, 1940647615375886168ull }, { 2748186495899949531ull, 1552518092300708935ull },
+    { 2198549196719959625ull, 1242014473840567148ull }, { 18275073973719576693ull, 1987223158144907436ull },
+    { 10930710364233751031ull, 1589778526515925949ull }, { 12433917106128911148ull, 1271822821212740759ull },
+    { 8826220925580526867ull, 2034916513940385215ull }, { 7060976740464421494ull, 1627933211152308172ull },
+    { 16716827836597268165ull, 1302346568921846537ull }, { 11989529279587987770ull, 2083754510274954460ull },
+    { 9591623423670390216ull, 1667003608219963568ull }, { 15051996368420132820ull, 1333602886575970854ull },
+    { 13015147745246481542ull, 2133764618521553367ull }, { 3033420566713364587ull, 1707011694817242694ull },
+    { 6116085268112601993ull, 1365609355853794155ull }, { 9785736428980163188ull, 2184974969366070648ull },
+    { 15207286772667951197ull, 1747979975492856518ull }, { 1097782973908629988ull, 1398383980394285215ull },
+    { 1756452758253807981ull, 2237414368630856344ull }, { 5094511021344956708ull, 1789931494904685075ull },
+    { 4075608817075965366ull, 1431945195923748060ull }, { 6520974107321544586ull, 2291112313477996896ull },
+    { 1527430471115325346ull, 1832889850782397517ull }, { 12289990821117991246ull, 1466311880625918013ull },
+    { 17210690286378213644ull, 1173049504500734410ull }, { 9090360384495590213ull, 1876879207201175057ull },
+    { 18340334751822203140ull, 1501503365760940045ull }, { 14672267801457762512ull, 1201202692608752036ull },
+    { 16096930852848599373ull, 1921924308174003258ull }, { 1809498238053148529ull, 1537539446539202607ull },
+    { 12515645034668249793ull, 1230031557231362085ull }, { 1578287981759648052ull, 1968050491570179337ull },
+    { 12330676829633449412ull, 1574440393256143469ull }, { 13553890278448669853ull, 1259552314604914775ull },
+    { 3239480371808320148ull, 2015283703367863641ull }, { 17348979556414297411ull, 1612226962694290912ull },
+    { 6500486015647617283ull, 1289781570155432730ull }, { 10400777625036187652ull, 2063650512248692368ull },
+    { 15699319729512770768ull, 1650920409798953894ull }, { 16248804598352126938ull, 1320736327839163115ull },
+    { 7551343283653851484ull, 2113178124542660985ull }, { 6041074626923081187ull, 1690542499634128788ull },
+    { 12211557331022285596ull, 1352433999707303030ull }, { 1091747655926105338ull, 2163894399531684849ull },
+    { 4562746939482794594ull, 1731115519625347879ull }, { 7339546366328145998ull, 1384892415700278303ull },
+    { 8053925371383123274ull, 2215827865120445285ull }, { 6443140297106498619ull, 1772662292096356228ull },
+    { 12533209867169019542ull, 1418129833677084982ull }, { 5295740528502789974ull, 2269007733883335972ull },
+    { 15304638867027962949ull, 1815206187106668777ull }, { 4865013464138549713ull, 1452164949685335022ull },
+    { 14960057215536570740ull, 1161731959748268017ull }, { 9178696285890871890ull, 1858771135597228828ull },
+    { 14721654658196518159ull, 1487016908477783062ull }, { 4398626097073393881ull, 1189613526782226450ull },
+    { 7037801755317430209ull, 1903381642851562320ull }, { 5630241404253944167ull, 1522705314281249856ull },
+    { 814844308661245011ull, 1218164251424999885ull }, { 1303750893857992017ull, 1949062802279999816ull },
+    { 15800395974054034906ull, 1559250241823999852ull }, { 5261619149759407279ull, 1247400193459199882ull },
+    { 12107939454356961969ull, 1995840309534719811ull }, { 5997002748743659252ull, 1596672247627775849ull },
+    { 8486951013736837725ull, 1277337798102220679ull }, { 2511075177753209390ull, 2043740476963553087ull },
+    { 13076906586428298482ull, 1634992381570842469ull }, { 14150874083884549109ull, 1307993905256673975ull },
+    { 4194654460505726958ull, 2092790248410678361ull }, { 18113118827372222859ull, 1674232198728542688ull },
+    { 3422448617672047318ull, 1339385758982834151ull }, { 16543964232501006678ull, 2143017214372534641ull },
+    { 9545822571258895019ull, 1714413771498027713ull }, { 15015355686490936662ull, 1371531017198422170ull },
+    { 5577825024675947042ull, 2194449627517475473ull }, { 11840957649224578280ull, 1755559702013980378ull },
+    { 16851463748863483271ull, 1404447761611184302ull }, { 12204946739213931940ull, 2247116418577894884ull },
+    { 13453306206113055875ull, 1797693134862315907ull }, { 3383947335406624054ull, 1438154507889852726ull },
+    { 16482362180876329456ull, 2301047212623764361ull }, { 9496540929959153242ull, 1840837770099011489ull },
+    { 11286581558709232917ull, 1472670216079209191ull }, { 5339916432225476010ull, 1178136172863367353ull },
+    { 4854517476818851293ull, 1885017876581387765ull }, { 3883613981455081034ull, 1508014301265110212ull },
+    { 14174937629389795797ull, 1206411441012088169ull }, { 11611853762797942306ull, 1930258305619341071ull },
+    { 5600134195496443521ull, 1544206644495472857ull }, { 15548153800622885787ull, 1235365315596378285ull },
+    { 6430302007287065643ull, 1976584504954205257ull }, { 16212288050055383484ull, 1581267603963364205ull },
+    { 12969830440044306787ull, 1265014083170691364ull }, { 9683682259845159889ull, 2024022533073106183ull },
+    { 15125643437359948558ull, 1619218026458484946ull }, { 8411165935146048523ull, 1295374421166787957ull },
+    { 17147214310975587960ull, 2072599073866860731ull }, { 10028422634038560045ull, 1658079259093488585ull },
+    { 8022738107230848036ull, 1326463407274790868ull }, { 9147032156827446534ull, 2122341451639665389ull },
+    { 11006974540203867551ull, 1697873161311732311ull }, { 5116230817421183718ull, 1358298529049385849ull },
+    { 15564666937357714594ull, 2173277646479017358ull }, { 1383687105660440706ull, 1738622117183213887ull },
+    { 12174996128754083534ull, 1390897693746571109ull }, { 8411947361780802685ull, 2225436309994513775ull },
+    { 6729557889424642148ull, 1780349047995611020ull }, { 5383646311539713719ull, 1424279238396488816ull },
+    { 1235136468979721303ull, 2278846781434382106ull }, { 15745504434151418335ull, 1823077425147505684ull },
+    { 16285752362063044992ull, 1458461940118004547ull }, { 5649904260166615347ull, 1166769552094403638ull },
+    { 5350498001524674232ull, 1866831283351045821ull }, { 591049586477829062ull, 1493465026680836657ull },
+    { 11540886113407994219ull, 1194772021344669325ull }, { 18673707743239135ull, 1911635234151470921ull },
+    { 14772334225162232601ull, 1529308187321176736ull }, { 8128518565387875758ull, 1223446549856941389ull },
+    { 1937583260394870242ull, 1957514479771106223ull }, { 8928764237799716840ull, 1566011583816884978ull },
+    { 14521709019723594119ull, 1252809267053507982ull }, { 8477339172590109297ull, 2004494827285612772ull },
+    { 17849917782297818407ull, 1603595861828490217ull }, { 6901236596354434079ull, 1282876689462792174ull },
+    { 18420676183650915173ull, 2052602703140467478ull }, { 3668494502695001169ull, 1642082162512373983ull },
+    { 10313493231639821582ull, 1313665730009899186ull }, { 9122891541139893884ull, 2101865168015838698ull },
+    { 14677010862395735754ull, 1681492134412670958ull }, { 673562245690857633ull, 1345193707530136767ull },
+};
+
+static const U64 FORMAT_POW5_SPLIT[FORMAT_POW5_TABLE_SIZE][2] = {
+    { 0ull, 1152921504606846976ull }, { 0ull, 1441151880758558720ull },
+    { 0ull, 1801439850948198400ull }, { 0ull, 2251799813685248000ull },
+    { 0ull, 1407374883553280000ull }, { 0ull, 1759218604441600000ull },
+    { 0ull, 2199023255552000000ull }, { 0ull, 1374389534720000000ull },
+    { 0ull, 1717986918400000000ull }, { 0ull, 2147483648000000000ull },
+    { 0ull, 1342177280000000000ull }, { 0ull, 1677721600000000000ull },
+    { 0ull, 2097152000000000000ull }, { 0ull, 1310720000000000000ull },
+    { 0ull, 1638400000000000000ull }, { 0ull, 2048000000000000000ull },
+    { 0ull, 1280000000000000000ull }, { 0ull, 1600000000000000000ull },
+    { 0ull, 2000000000000000000ull }, { 0ull, 1250000000000000000ull },
+    { 0ull, 1562500000000000000ull }, { 0ull, 1953125000000000000ull },
+    { 0ull, 1220703125000000000ull }, { 0ull, 1525878906250000000ull },
+    { 0ull, 1907348632812500000ull }, { 0ull, 1192092895507812500ull },
+    { 0ull, 1490116119384765625ull }, { 4611686018427387904ull, 1862645149230957031ull },
+    { 9799832789158199296ull, 1164153218269348144ull }, { 12249790986447749120ull, 1455191522836685180ull },
+    { 15312238733059686400ull, 1818989403545856475ull }, { 14528612397897220096ull, 2273736754432320594ull },
+    { 13692068767113150464ull, 1421085471520200371ull }, { 12503399940464050176ull, 1776356839400250464ull },
+    { 15629249925580062720ull, 2220446049250313080ull }, { 9768281203487539200ull, 1387778780781445675ull },
+    { 7598665485932036096ull, 1734723475976807094ull }, { 274959820560269312ull, 2168404344971008868ull },
+    { 9395221924704944128ull, 1355252715606880542ull }, { 2520655369026404352ull, 1694065894508600678ull },
+    { 12374191248137781248ull, 2117582368135750847ull }, { 14651398557727195136ull, 1323488980084844279ull },
+    { 13702562178731606016ull, 1654361225106055349ull }, { 3293144668132343808ull, 2067951531382569187ull },
+    { 18199116482078572544ull, 1292469707114105741ull }, { 8913837547316051968ull, 1615587133892632177ull },
+    { 15753982952572452864ull, 2019483917365790221ull }, { 12152082354571476992ull, 1262177448353618888ull },
+    { 15190102943214346240ull, 1577721810442023610ull }, { 9764256642163156992ull, 1972152263052529513ull },
+    { 17631875447420442880ull, 1232595164407830945ull }, { 8204786253993389888ull, 1540743955509788682ull },
+    { 1032610780636961552ull, 1925929944387235853ull }, { 2951224747111794922ull, 1203706215242022408ull },
+    { 3689030933889743652ull, 1504632769052528010ull }, { 13834660704216955373ull, 1880790961315660012ull },
+    { 17870034976990372916ull, 1175494350822287507ull }, { 17725857702810578241ull, 1469367938527859384ull },
+    { 3710578054803671186ull, 1836709923159824231ull }, { 26536550077201078ull, 2295887403949780289ull },
+    { 11545800389866720434ull, 1434929627468612680ull }, { 14432250487333400542ull, 1793662034335765850ull },
+    { 8816941072311974870ull, 2242077542919707313ull }, { 17039803216263454053ull, 1401298464324817070ull },
+    { 12076381983474541759ull, 1751623080406021338ull }, { 5872105442488401391ull, 2189528850507526673ull },
+    { 15199280947623720629ull, 1368455531567204170ull }, { 9775729147674874978ull, 1710569414459005213ull },
+    { 16831347453020981627ull, 2138211768073756516ull }, { 1296220121283337709ull, 1336382355046097823ull },
+    { 15455333206886335848ull, 1670477943807622278ull }, { 10095794471753144002ull, 2088097429759527848ull },
+    { 6309871544845715001ull, 1305060893599704905ull }, { 12499025449484531656ull, 1631326116999631131ull },
+    { 11012095793428276666ull, 2039157646249538914ull }, { 11494245889320060820ull, 1274473528905961821ull },
+    { 532749306367912313ull, 1593091911132452277ull }, { 5277622651387278295ull, 1991364888915565346ull },
+    { 7910200175544436838ull, 1244603055572228341ull }, { 14499436237857933952ull, 1555753819465285426ull },
+    { 8900923260467641632ull, 1944692274331606783ull }, { 12480606065433357876ull, 1215432671457254239ull },
+    { 10989071563364309441ull, 1519290839321567799ull }, { 9124653435777998898ull, 1899113549151959749ull },
+    { 8008751406574943263ull, 1186945968219974843ull }, { 5399253239791291175ull, 1483682460274968554ull },
+    { 15972438586593889776ull, 1854603075343710692ull }, { 759402079766405302ull, 1159126922089819183ull },
+    { 14784310654990170340ull, 1448908652612273978ull }, { 9257016281882937117ull, 1811135815765342473ull },
+    { 16182956370781059300ull, 2263919769706678091ull }, { 7808504722524468110ull, 1414949856066673807ull },
+    { 5148944884728197234ull, 1768687320083342259ull }, { 1824495087482858639ull, 2210859150104177824ull },
+    { 1140309429676786649ull, 1381786968815111140ull }, { 1425386787095983311ull, 1727233711018888925ull },
+    { 6393419502297367043ull, 2159042138773611156ull }, { 13219259225790630210ull, 1349401336733506972ull },
+    { 16524074032238287762ull, 1686751670916883715ull }, { 16043406521870471799ull, 2108439588646104644ull },
+    { 803757039314269066ull, 1317774742903815403ull }, { 14839754354425000045ull, 1647218428629769253ull },
+    { 4714634887749086344ull, 2059023035787211567ull }, { 9864175832484260821ull, 1286889397367007229ull },
+    { 16941905809032713930ull, 1608611746708759036ull }, { 2730638187581340797ull, 2010764683385948796ull },
+    { 10930020904093113806ull, 1256727927116217997ull }, { 18274212148543780162ull, 1570909908895272496ull },
+    { 4396021111970173586ull, 1963637386119090621ull }, { 5053356204195052443ull, 1227273366324431638ull },
+    { 15540067292098591362ull, 1534091707905539547ull }, { 14813398096695851299ull, 1917614634881924434ull },
+    { 13870059828862294966ull, 1198509146801202771ull }, { 12725888767650480803ull, 1498136433501503464ull },
+    { 15907360959563101004ull, 1872670541876879330ull }, { 14553786618154326031ull, 1170419088673049581ull },
+    { 4357175217410743827ull, 1463023860841311977ull }, { 10058155040190817688ull, 1828779826051639971ull },
+    { 7961007781811134206ull, 2285974782564549964ull }, { 14199001900486734687ull, 1428734239102843727ull },
+    { 13137066357181030455ull, 1785917798878554659ull }, { 11809646928048900164ull, 2232397248598193324ull },
+    { 16604401366885338411ull, 1395248280373870827ull }, { 16143815690179285109ull, 1744060350467338534ull },
+    { 10956397575869330579ull, 2180075438084173168ull }, { 6847748484918331612ull, 1362547148802608230ull },
+    { 17783057643002690323ull, 1703183936003260287ull }, { 17617136035325974999ull, 2128979920004075359ull },
+    { 17928239049719816230ull, 1330612450002547099ull }, { 17798612793722382384ull, 1663265562503183874ull },
+    { 13024893955298202172ull, 2079081953128979843ull }, { 5834715712847682405ull, 1299426220705612402ull },
+    { 16516766677914378815ull, 1624282775882015502ull }, { 11422586310538197711ull, 2030353469852519378ull },
+    { 11750802462513761473ull, 1268970918657824611ull }, { 10076817059714813937ull, 1586213648322280764ull },
+    { 12596021324643517422ull, 1982767060402850955ull }, { 5566670318688504437ull, 1239229412751781847ull },
+    { 2346651879933242642ull, 1549036765939727309ull }, { 7545000868343941206ull, 1936295957424659136ull },
+    { 4715625542714963254ull, 1210184973390411960ull }, { 5894531928393704067ull, 1512731216738014950ull },
+    { 16591536947346905892ull, 1890914020922518687ull }, { 17287239619732898039ull, 1181821263076574179ull },
+    { 16997363506238734644ull, 1477276578845717724ull }, { 2799960309088866689ull, 1846595723557147156ull },
+    { 10973347230035317489ull, 1154122327223216972ull }, { 13716684037544146861ull, 1442652909029021215ull },
+    { 12534169028502795672ull, 1803316136286276519ull }, { 11056025267201106687ull, 2254145170357845649ull },
+    { 18439230838069161439ull, 1408840731473653530ull }, { 13825666510731675991ull, 1761050914342066913ull },
+    { 3447025083132431277ull, 2201313642927583642ull }, { 6766076695385157452ull, 1375821026829739776ull },
+    { 8457595869231446815ull, 1719776283537174720ull }, { 10571994836539308519ull, 2149720354421468400ull },
+    { 6607496772837067824ull, 1343575221513417750ull }, { 17482743002901110588ull, 1679469026891772187ull },
+    { 17241742735199000331ull, 2099336283614715234ull }, { 15387775227926763111ull, 1312085177259197021ull },
+    { 5399660979626290177ull, 1640106471573996277ull }, { 11361262242960250625ull, 2050133089467495346ull },
+    { 11712474920277544544ull, 1281333180917184591ull }, { 10028907631919542777ull, 1601666476146480739ull },
+    { 7924448521472040567ull, 2002083095183100924ull }, { 14176152362774801162ull, 1251301934489438077ull },
+    { 3885132398186337741ull, 1564127418111797597ull }, { 9468101516160310080ull, 1955159272639746996ull },
+    { 15140935484454969608ull, 1221974545399841872ull }, { 479425281859160394ull, 1527468181749802341ull },
+    { 5210967620751338397ull, 1909335227187252926ull }, { 17091912818251750210ull, 1193334516992033078ull },
+    { 12141518985959911954ull, 1491668146240041348ull }, { 15176898732449889943ull, 1864585182800051685ull },
+    { 11791404716994875166ull, 1165365739250032303ull }, { 10127569877816206054ull, 1456707174062540379ull },
+    { 8047776328842869663ull, 1820883967578175474ull }, { 836348374198811271ull, 2276104959472719343ull },
+    { 7440246761515338900ull, 1422565599670449589ull }, { 13911994470321561530ull, 1778206999588061986ull },
+    { 8166621051047176104ull, 2222758749485077483ull }, { 2798295147690791113ull, 1389224218428173427ull },
+    { 17332926989895652603ull, 1736530273035216783ull }, { 17054472718942177850ull, 2170662841294020979ull },
+    { 8353202440125167204ull, 1356664275808763112ull }, { 10441503050156459005ull, 1695830344760953890ull },
+    { 3828506775840797949ull, 2119787930951192363ull }, { 86973725686804766ull, 1324867456844495227ull },
+    { 13943775212390669669ull, 1656084321055619033ull }, { 3594660960206173375ull, 2070105401319523792ull },
+    { 2246663100128858359ull, 1293815875824702370ull }, { 12031700912015848757ull, 1617269844780877962ull },
+    { 5816254103165035138ull, 2021587305976097453ull }, { 5941001823691840913ull, 1263492066235060908ull },
+    { 7426252279614801142ull, 1579365082793826135ull }, { 4671129331091113523ull, 1974206353492282669ull },
+    { 5225298841145639904ull, 1233878970932676668ull }, { 6531623551432049880ull, 1542348713665845835ull },
+    { 3552843420862674446ull, 1927935892082307294ull }, { 16055585193321335241ull, 1204959932551442058ull },
+    { 10846109454796893243ull, 1506199915689302573ull }, { 18169322836923504458ull, 1882749894611628216ull },
+    { 11355826773077190286ull, 1176718684132267635ull }, { 9583097447919099954ull, 1470898355165334544ull },
+    { 11978871809898874942ull, 1838622943956668180ull }, { 14973589762373593678ull, 2298278679945835225ull },
+    { 2440964573842414192ull, 1436424174966147016ull }, { 3051205717303017741ull, 1795530218707683770ull },
+    { 13037379183483547984ull, 2244412773384604712ull }, { 8148361989677217490ull, 1402757983365377945ull },
+    { 14797138505523909766ull, 1753447479206722431ull }, { 13884737113477499304ull, 2191809349008403039ull },
+    { 15595489723564518921ull, 1369880843130251899ull }, { 14882676136028260747ull, 1712351053912814874ull },
+    { 9379973133180550126ull, 2140438817391018593ull }, { 17391698254306313589ull, 1337774260869386620ull },
+    { 3292878744173340370ull, 1672217826086733276ull }, { 4116098430216675462ull, 2090272282608416595ull },
+    { 266718509671728212ull, 1306420176630260372ull }, { 333398137089660265ull, 1633025220787825465ull },
+    { 5028433689789463235ull, 2041281525984781831ull }, { 10060300083759496378ull, 1275800953740488644ull },
+    { 12575375104699370472ull, 1594751192175610805ull }, { 1884160825592049379ull, 1993438990219513507ull },
+    { 17318501580490888525ull, 1245899368887195941ull }, { 7813068920331446945ull, 1557374211108994927ull },
+    { 5154650131986920777ull, 1946717763886243659ull }, { 915813323278131534ull, 1216698602428902287ull },
+    { 14979824709379828129ull, 1520873253036127858ull }, { 9501408849870009354ull, 1901091566295159823ull },
+    { 12855909558809837702ull, 1188182228934474889ull }, { 2234828893230133415ull, 1485227786168093612ull },
+    { 2793536116537666769ull, 1856534732710117015ull }, { 8663489100477123587ull, 1160334207943823134ull },
+    { 1605989338741628675ull, 1450417759929778918ull }, { 11230858710281811652ull, 1813022199912223647ull },
+    { 9426887369424876662ull, 2266277749890279559ull }, { 12809333633531629769ull, 1416423593681424724ull },
+    { 16011667041914537212ull, 1770529492101780905ull }, { 6179525747111007803ull, 2213161865127226132ull },
+    { 13085575628799155685ull, 1383226165704516332ull }, { 16356969535998944606ull, 1729032707130645415ull },
+    { 15834525901571292854ull, 2161290883913306769ull }, { 2979049660840976177ull, 1350806802445816731ull },
+    { 17558870131333383934ull, 1688508503057270913ull }, { 8113529608884566205ull, 2110635628821588642ull },
+    { 9682642023980241782ull, 1319147268013492901ull }, { 16714988548402690132ull, 1648934085016866126ull },
+    { 11670363648648586857ull, 2061167606271082658ull }, { 11905663298832754689ull, 1288229753919426661ull },
+    { 1047021068258779650ull, 1610287192399283327ull }, { 15143834390605638274ull, 2012858990499104158ull },
+    { 4853210475701136017ull, 1258036869061940099ull }, { 1454827076199032118ull, 1572546086327425124ull },
+    { 1818533845248790147ull, 1965682607909281405ull }, { 3442426662494187794ull, 1228551629943300878ull },
+    { 13526405364972510550ull, 1535689537429126097ull }, { 3072948650933474476ull, 1919611921786407622ull },
+    { 15755650962115585259ull, 1199757451116504763ull }, { 15082877684217093670ull, 1499696813895630954ull },
+    { 9630225068416591280ull, 1874621017369538693ull }, { 8324733676974063502ull, 1171638135855961683ull },
+    { 5794231077790191473ull, 1464547669819952104ull }, { 7242788847237739342ull, 1830684587274940130ull },
+    { 18276858095901949986ull, 2288355734093675162ull }, { 16034722328366106645ull, 1430222333808546976ull },
+    { 1596658836748081690ull, 1787777917260683721ull }, { 6607509564362490017ull, 2234722396575854651ull },
+    { 1823850468512862308ull, 1396701497859909157ull }, { 6891499104068465790ull, 1745876872324886446ull },
+    { 17837745916940358045ull, 2182346090406108057ull }, { 4231062170446641922ull, 1363966306503817536ull },
+    { 5288827713058302403ull, 1704957883129771920ull }, { 6611034641322878003ull, 2131197353912214900ull },
+    { 13355268687681574560ull, 1331998346195134312ull }, { 16694085859601968200ull, 1664997932743917890ull },
+    { 11644235287647684442ull, 2081247415929897363ull }, { 4971804045566108824ull, 1300779634956185852ull },
+    { 6214755056957636030ull, 1625974543695232315ull }, { 3156757802769657134ull, 2032468179619040394ull },
+    { 6584659645158423613ull, 1270292612261900246ull }, { 17454196593302805324ull, 1587865765327375307ull },
+    { 17206059723201118751ull, 1984832206659219134ull }, { 6142101308573311315ull, 1240520129162011959ull },
+    { 3065940617289251240ull, 1550650161452514949ull }, { 8444111790038951954ull, 1938312701815643686ull },
+    { 665883850346957067ull, 1211445438634777304ull }, { 832354812933696334ull, 1514306798293471630ull },
+    { 10263815553021896226ull, 1892883497866839537ull }, { 17944099766707154901ull, 1183052186166774710ull },
+    { 13206752671529167818ull, 1478815232708468388ull }, { 16508440839411459773ull, 1848519040885585485ull },
+    { 12623618533845856310ull, 1155324400553490928ull }, { 15779523167307320387ull, 1444155500691863660ull },
+    { 1277659885424598868ull, 1805194375864829576ull }, { 1597074856780748586ull, 2256492969831036970ull },
+    { 5609857803915355770ull, 1410308106144398106ull }, { 16235694291748970521ull, 1762885132680497632ull },
+    { 1847873790976661535ull, 2203606415850622041ull }, { 12684136165428883219ull, 1377254009906638775ull },
+    { 11243484188358716120ull, 1721567512383298469ull }, { 219297180166231438ull, 2151959390479123087ull },
+    { 7054589765244976505ull, 1344974619049451929ull }, { 13429923224983608535ull, 1681218273811814911ull },
+    { 12175718012802122765ull, 2101522842264768639ull }, { 14527352785642408584ull, 1313451776415480399ull },
+    { 13547504963625622826ull, 1641814720519350499ull }, { 12322695186104640628ull, 2052268400649188124ull },
+    { 16925056528170176201ull, 1282667750405742577ull }, { 7321262604930556539ull, 1603334688007178222ull },
+    { 18374950293017971482ull, 2004168360008972777ull }, { 4566814905495150320ull, 1252605225005607986ull },
+    { 14931890668723713708ull, 1565756531257009982ull }, { 9441491299049866327ull, 1957195664071262478ull },
+    { 1289246043478778550ull, 1223247290044539049ull }, { 6223243572775861092ull, 1529059112555673811ull },
+    { 3167368447542438461ull, 1911323890694592264ull }, { 1979605279714024038ull, 1194577431684120165ull },
+    { 7086192618069917952ull, 1493221789605150206ull }, { 18081112809442173248ull, 1866527237006437757ull },
+    { 13606538515115052232ull, 1166579523129023598ull }, { 7784801107039039482ull, 1458224403911279498ull },
+    { 507629346944023544ull, 1822780504889099373ull }, { 5246222702107417334ull, 2278475631111374216ull },
+    { 3278889188817135834ull, 1424047269444608885ull }, { 8710297504448807696ull, 1780059086805761106ull },
+};
+
+typedef unsigned __int128 _ArFormatU128;
+
+// ceil(log2(5^e)), or 1 for e == 0.
+static U32 format_pow5_bits(I32 e) {
+    return (U32) (((e * 1217359) >> 19) + 1);
+}
+
+// floor(log10(2^e))
+static U32 format_log10_pow2(I32 e) {
+    return (U32) ((e * 78913) >> 18);
+}
+
+// floor(log10(5^e))
+static U32 format_log10_pow5(I32 e) {
+    return (U32) ((e * 732923) >> 20);
+}
+
+static B8 format_multiple_of_pow5(U64 value, U32 p) {
+    U32 count = 0;
+    while (value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static B8 format_multiple_of_pow2(U64 value, U32 p) {
+    return (value & (((U64) 1 << p) - 1)) == 0;
+}
+
+static U64 format_mul_shift(U64 m, const U64 *mul, I32 j) {
+    _ArFormatU128 b0 = (_ArFormatU128) m * mul[0];
+    _ArFormatU128 b2 = (_ArFormatU128) m * mul[1];
+    return (U64) (((b0 >> 64) + b2) >> (j - 64));
+}
+
+// Decimal digits and exponent of the shortest representation of a finite,
+// positive double given its raw mantissa and exponent bits.
+static void format_f64_shortest(U64 ieee_mantissa, U32 ieee_exponent, U64 *digits, I32 *exponent) {
+    I32 e2 = 0;
+    U64 m2 = 0;
+    if (ieee_exponent == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (I32) ieee_exponent - 1023 - 52 - 2;
+        m2 = ((U64) 1 << 52) | ieee_mantissa;
+    }
+    B8 accept_bounds = (m2 & 1) == 0;
+
+    // Interval of values rounding to this double, scaled by 4.
+    U64 mv = 4 * m2;
+    U32 mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    U64 vr = 0;
+    U64 vp = 0;
+    U64 vm = 0;
+    I32 e10 = 0;
+    B8 vm_trailing_zeros = false;
+    B8 vr_trailing_zeros = false;
+
+    if (e2 >= 0) {
+        U32 q = format_log10_pow2(e2) - (e2 > 3);
+        e10 = (I32) q;
+        I32 k = FORMAT_POW5_INV_BITCOUNT + format_pow5_bits(q) - 1;
+        I32 i = -e2 + (I32) q + k;
+        vr = format_mul_shift(4 * m2, FORMAT_POW5_INV_SPLIT[q], i);
+        vp = format_mul_shift(4 * m2 + 2, FORMAT_POW5_INV_SPLIT[q], i);
+        vm = format_mul_shift(4 * m2 - 1 - mm_shift, FORMAT_POW5_INV_SPLIT[q], i);
+        if (q <= 21) {
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = format_multiple_of_pow5(mv, q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = format_multiple_of_pow5(mv - 1 - mm_shift, q);
+            } else {
+                vp -= format_multiple_of_pow5(mv + 2, q);
+            }
+        }
+    } else {
+        U32 q = format_log10_pow5(-e2) - (-e2 > 1);
+        e10 = (I32) q + e2;
+        I32 i = -e2 - (I32) q;
+        I32 k = format_pow5_bits(i) - FORMAT_POW5_BITCOUNT;
+        I32 j = (I32) q - k;
+        vr = format_mul_shift(4 * m2, FORMAT_POW5_SPLIT[i], j);
+        vp = format_mul_shift(4 * m2 + 2, FORMAT_POW5_SPLIT[i], j);
+        vm = format_mul_shift(4 * m2 - 1 - mm_shift, FORMAT_POW5_SPLIT[i], j);
+        if (q <= 1) {
+            vr_trailing_zeros = true;
+            if (accept_bounds) {
+                vm_trailing_zeros = mm_shift == 1;
+            } else {
+                vp--;
+            }
+        } else if (q < 63) {
+            vr_trailing_zeros = format_multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Drop digits while the interval still holds more than one value.
+    I32 removed = 0;
+    U8 last_removed_digit = 0;
+    U64 output = 0;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed_digit == 0;
+            last_removed_digit = vr % 10;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed_digit == 0;
+                last_removed_digit = vr % 10;
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if (vr_trailing_zeros && last_removed_digit == 5 && vr % 2 == 0) {
+            // Exactly halfway, round to even.
+            last_removed_digit = 4;
+        }
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed_digit >= 5);
+    } else {
+        B8 round_up = false;
+        while (vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+
+    *digits = output;
+    *exponent = e10 + removed;
+}
+
+U32 ar_format_f64(char *buffer, F64 value) {
+    U64 bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    B8 sign = bits >> 63;
+    U64 ieee_mantissa = bits & (((U64) 1 << 52) - 1);
+    U32 ieee_exponent = (bits >> 52) & 0x7ff;
+
+    char *p = buffer;
+    if (ieee_exponent == 0x7ff && ieee_mantissa != 0) {
+        memcpy(p, "nan", 3);
+        return 3;
+    }
+    if (sign) {
+        *p = '-';
+        p++;
+    }
+    if (ieee_exponent == 0x7ff) {
+        memcpy(p, "inf", 3);
+        return p - buffer + 3;
+    }
+    if (ieee_exponent == 0 && ieee_mantissa == 0) {
+        *p = '0';
+        return p - buffer + 1;
+    }
+
+    U64 digits = 0;
+    I32 exponent = 0;
+    format_f64_shortest(ieee_mantissa, ieee_exponent, &digits, &exponent);
+
+    U32 len = format_decimal_length(digits);
+    // Exponent of the first digit in scientific notation.
+    I32 sci = exponent + (I32) len - 1;
+
+    // Same switch over to scientific notation as %.17g.
+    if (sci < -4 || sci >= 17) {
+        format_decimal(p + 1, digits, len);
+        p[0] = p[1];
+        if (len > 1) {
+            p[1] = '.';
+            p += len + 1;
+        } else {
+            p++;
+        }
+        *p = 'e';
+        p++;
+        if (sci < 0) {
+            *p = '-';
+            sci = -sci;
+        } else {
+            *p = '+';
+        }
+        p++;
+        if (sci >= 100) {
+            *p = '0' + sci / 100;
+            p++;
+            sci %= 100;
+        }
+        memcpy(p, &FORMAT_DIGIT_PAIRS[sci * 2], 2);
+        p += 2;
+    } else if (sci < 0) {
+        U32 zeros = -sci - 1;
+        memcpy(p, "0.", 2);
+        memset(p + 2, '0', zeros);
+        format_decimal(p + 2 + zeros, digits, len);
+        p += 2 + zeros + len;
+    } else if ((U32) sci + 1 >= len) {
+        U32 zeros = sci + 1 - len;
+        format_decimal(p, digits, len);
+        memset(p + len, '0', zeros);
+        p += len + zeros;
+    } else {
+        // Decimal point lands inside the digits.
+        format_decimal(p + 1, digits, len);
+        memmove(p, p + 1, sci + 1);
+        p[sci + 1] = '.';
+        p += len + 1;
+    }
+
+    return p - buffer;
+}
+
+typedef struct _ArFormatOut _ArFormatOut;
+struct _ArFormatOut {
+    char *buffer;
+    U64 size;
+    // Length of the whole output, even the parts not fitting the buffer.
+    U64 len;
+};
+
+static void format_out(_ArFormatOut *out, const void *data, U64 len) {
+    if (out->len < out->size) {
+        memcpy(out->buffer + out->len, data, ar_min(len, out->size - out->len));
+    }
+    out->len += len;
+}
+
+static void format_out_fill(_ArFormatOut *out, char c, U64 count) {
+    if (out->len < out->size) {
+        memset(out->buffer + out->len, c, ar_min(count, out->size - out->len));
+    }
+    out->len += count;
+}
+
+typedef enum {
+    _AR_FORMAT_FLAG_LEFT = 1 << 0,
+    _AR_FORMAT_FLAG_PLUS = 1 << 1,
+    _AR_FORMAT_FLAG_SPACE = 1 << 2,
+    _AR_FORMAT_FLAG_ALT = 1 << 3,
+    _AR_FORMAT_FLAG_ZERO = 1 << 4,
+} _ArFormatFlag;
+
+typedef enum {
+    _AR_FORMAT_LENGTH_NONE,
+    _AR_FORMAT_LENGTH_HH,
+    _AR_FORMAT_LENGTH_H,
+    _AR_FORMAT_LENGTH_L,
+    _AR_FORMAT_LENGTH_LL,
+    _AR_FORMAT_LENGTH_J,
+    _AR_FORMAT_LENGTH_Z,
+    _AR_FORMAT_LENGTH_T,
+    _AR_FORMAT_LENGTH_LONG_DOUBLE,
+} _ArFormatLength;
+
+typedef struct _ArFormatSpec _ArFormatSpec;
+struct _ArFormatSpec {
+    _ArFormatFlag flags;
+    U32 width;
+    // Negative when not specified.
+    I32 precision;
+    _ArFormatLength length;
+};
+
+// Writes 'prefix', 'zeros' zeros and 'body' padded out to the spec's width.
+static void format_out_padded(_ArFormatOut *out, const _ArFormatSpec *spec, B8 zero_pad, const char *prefix, U32 prefix_len, U64 zeros, const char *body, U64 body_len) {
+    U64 total = prefix_len + zeros + body_len;
+    U64 pad = spec->width > total ? spec->width - total : 0;
+    B8 left = spec->flags & _AR_FORMAT_FLAG_LEFT;
+
+    if (!left && !zero_pad) {
+        format_out_fill(out, ' ', pad);
+    }
+    format_out(out, prefix, prefix_len);
+    if (!left && zero_pad) {
+        format_out_fill(out, '0', pad);
+    }
+    format_out_fill(out, '0', zeros);
+    format_out(out, body, body_len);
+    if (left) {
+        format_out_fill(out, ' ', pad);
+    }
+}
+
+static void format_integer(_ArFormatOut *out, const _ArFormatSpec *spec, U64 value, B8 negative, char conv) {
+    // Plain %d and %u with room left are written in place.
+    B8 plain = spec->flags == 0 && spec->width == 0 && spec->precision < 0;
+    if (plain && (conv == 'd' || conv == 'i' || conv == 'u') && out->size - ar_min(out->len, out->size) > AR_FORMAT_I64_MAX_LENGTH) {
+        char *dst = out->buffer + out->len;
+        if (negative) {
+            *dst = '-';
+            dst++;
+            out->len++;
+        }
+        out->len += ar_format_u64(dst, value);
+        return;
+    }
+
+    char digits[24];
+    U32 len = 0;
+    switch (conv) {
+        case 'x':
+        case 'X':
+        case 'p': {
+            const char *hex = conv == 'X' ? "0123456789ABCDEF" : "0123456789abcdef";
+            char *p = digits + sizeof(digits);
+            do {
+                p--;
+                *p = hex[value & 15];
+                value >>= 4;
+                len++;
+            } while (value != 0);
+            memmove(digits, p, len);
+        } break;
+        case 'o': {
+            char *p = digits + sizeof(digits);
+            do {
+                p--;
+                *p = '0' + (value & 7);
+                value >>= 3;
+                len++;
+            } while (value != 0);
+            memmove(digits, p, len);
+        } break;
+        default:
+            len = ar_format_u64(digits, value);
+            break;
+    }
+
+    B8 is_zero = len == 1 && digits[0] == '0';
+    if (spec->precision == 0 && is_zero) {
+        len = 0;
+    }
+
+    U64 zeros = spec->precision > (I32) len ? spec->precision - len : 0;
+
+    char prefix[2];
+    U32 prefix_len = 0;
+    if (negative) {
+        prefix[prefix_len++] = '-';
+    } else if (conv == 'd' || conv == 'i') {
+        if (spec->flags & _AR_FORMAT_FLAG_PLUS) {
+            prefix[prefix_len++] = '+';
+        } else if (spec->flags & _AR_FORMAT_FLAG_SPACE) {
+            prefix[prefix_len++] = ' ';
+        }
+    }
+    if (spec->flags & _AR_FORMAT_FLAG_ALT) {
+        if (conv == 'o' && zeros == 0 && (len == 0 || digits[0] != '0')) {
+            zeros = 1;
+        } else if ((conv == 'x' || conv == 'X') && !is_zero) {
+            prefix[prefix_len++] = '0';
+            prefix[prefix_len++] = conv;
+        }
+    }
+    if (conv == 'p') {
+        prefix[prefix_len++] = '0';
+        prefix[prefix_len++] = 'x';
+    }
+
+    B8 zero_pad = (spec->flags & _AR_FORMAT_FLAG_ZERO) && spec->precision < 0;
+    format_out_padded(out, spec, zero_pad, prefix, prefix_len, zeros, digits, len);
+}
+
+// Conversions not worth reimplementing are handed to libc one at a time.
+static void format_libc_float(_ArFormatOut *out, const _ArFormatSpec *spec, char conv, va_list *args) {
+    char fmt[48];
+    U32 len = 0;
+    fmt[len++] = '%';
+    if (spec->flags & _AR_FORMAT_FLAG_LEFT) { fmt[len++] = '-'; }
+    if (spec->flags & _AR_FORMAT_FLAG_PLUS) { fmt[len++] = '+'; }
+    if (spec->flags & _AR_FORMAT_FLAG_SPACE) { fmt[len++] = ' '; }
+    if (spec->flags & _AR_FORMAT_FLAG_ALT) { fmt[len++] = '#'; }
+    if (spec->flags & _AR_FORMAT_FLAG_ZERO) { fmt[len++] = '0'; }
+    len += ar_format_u64(fmt + len, spec->width);
+    if (spec->precision >= 0) {
+        fmt[len++] = '.';
+        len += ar_format_u64(fmt + len, spec->precision);
+    }
+    if (spec->length == _AR_FORMAT_LENGTH_LONG_DOUBLE) {
+        fmt[len++] = 'L';
+    }
+    fmt[len++] = conv;
+    fmt[len] = 0;
+
+    U64 avail = out->len < out->size ? out->size - out->len : 0;
+    char *dst = avail != 0 ? out->buffer + out->len : NULL;
+    I32 written = 0;
+    if (spec->length == _AR_FORMAT_LENGTH_LONG_DOUBLE) {
+        written = snprintf(dst, avail, fmt, va_arg(*args, long double));
+    } else {
+        written = snprintf(dst, avail, fmt, va_arg(*args, double));
+    }
+    if (written > 0) {
+        out->len += written;
+    }
+}
+
+U64 ar_format(char *buffer, U64 size, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    U64 len = ar_formatv(buffer, size, fmt, args);
+    va_end(args);
+    return len;
+}
+
+U64 ar_formatv(char *buffer, U64 size, const char *fmt, va_list args) {
+    _ArFormatOut out = {
+        .buffer = buffer,
+        .size = size,
+    };
+
+    // Helpers take the arguments by pointer, which a va_list parameter can't
+    // portably be.
+    va_list ap;
+    va_copy(ap, args);
+
+    const char *p = fmt;
+    while (*p != 0) {
+        const char *percent = strchr(p, '%');
+        if (percent == NULL) {
+            format_out(&out, p, strlen(p));
+            break;
+        }
+        format_out(&out, p, percent - p);
+
+        const char *spec_start = percent;
+        p = percent + 1;
+        _ArFormatSpec spec = {
+            .precision = -1,
+        };
+
+        for (B8 parsing = true; parsing;) {
+            switch (*p) {
+                case '-': spec.flags |= _AR_FORMAT_FLAG_LEFT; p++; break;
+                case '+': spec.flags |= _AR_FORMAT_FLAG_PLUS; p++; break;
+                case ' ': spec.flags |= _AR_FORMAT_FLAG_SPACE; p++; break;
+                case '#': spec.flags |= _AR_FORMAT_FLAG_ALT; p++; break;
+                case '0': spec.flags |= _AR_FORMAT_FLAG_ZERO; p++; break;
+                default: parsing = false; break;
+            }
+        }
+
+        if (*p == '*') {
+            I32 width = va_arg(ap, int);
+            if (width < 0) {
+                spec.flags |= _AR_FORMAT_FLAG_LEFT;
+                width = -width;
+            }
+            spec.width = width;
+            p++;
+        } else {
+            while (ar_char_is_numeric(*p)) {
+                spec.width = spec.width * 10 + (*p - '0');
+                p++;
+            }
+        }
+
+        if (*p == '.') {
+            p++;
+            spec.precision = 0;
+            if (*p == '*') {
+                spec.precision = va_arg(ap, int);
+                if (spec.precision < 0) {
+                    spec.precision = -1;
+                }
+                p++;
+            } else {
+                while (ar_char_is_numeric(*p)) {
+                    spec.precision = spec.precision * 10 + (*p - '0');
+                    p++;
+                }
+            }
+        }
+
+        switch (*p) {
+            case 'h':
+                p++;
+                spec.length = _AR_FORMAT_LENGTH_H;
+                if (*p == 'h') {
+                    p++;
+                    spec.length = _AR_FORMAT_LENGTH_HH;
+                }
+                break;
+            case 'l':
+                p++;
+                spec.length = _AR_FORMAT_LENGTH_L;
+                if (*p == 'l') {
+                    p++;
+                    spec.length = _AR_FORMAT_LENGTH_LL;
+                }
+                break;
+            case 'j': p++; spec.length = _AR_FORMAT_LENGTH_J; break;
+            case 'z': p++; spec.length = _AR_FORMAT_LENGTH_Z; break;
+            case 't': p++; spec.length = _AR_FORMAT_LENGTH_T; break;
+            case 'L': p++; spec.length = _AR_FORMAT_LENGTH_LONG_DOUBLE; break;
+        }
+
+        char conv = *p;
+        if (conv == 0) {
+            format_out(&out, spec_start, p - spec_start);
+            break;
+        }
+        p++;
+
+        switch (conv) {
+            case 'd':
+            case 'i': {
+                I64 value = 0;
+                switch (spec.length) {
+                    case _AR_FORMAT_LENGTH_HH: value = (signed char) va_arg(ap, int); break;
+                    case _AR_FORMAT_LENGTH_H: value = (short) va_arg(ap, int); break;
+                    case _AR_FORMAT_LENGTH_L: value = va_arg(ap, long); break;
+                    case _AR_FORMAT_LENGTH_LL: value = va_arg(ap, long long); break;
+                    case _AR_FORMAT_LENGTH_J: value = va_arg(ap, long long); break;
+                    case _AR_FORMAT_LENGTH_Z: value = va_arg(ap, Isize); break;
+                    case _AR_FORMAT_LENGTH_T: value = va_arg(ap, ptrdiff_t); break;
+                    default: value = va_arg(ap, int); break;
+                }
+                format_integer(&out, &spec, value < 0 ? -(U64) value : (U64) value, value < 0, conv);
+            } break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o': {
+                U64 value = 0;
+                switch (spec.length) {
+                    case _AR_FORMAT_LENGTH_HH: value = (unsigned char) va_arg(ap, unsigned int); break;
+                    case _AR_FORMAT_LENGTH_H: value = (unsigned short) va_arg(ap, unsigned int); break;
+                    case _AR_FORMAT_LENGTH_L: value = va_arg(ap, unsigned long); break;
+                    case _AR_FORMAT_LENGTH_LL: value = va_arg(ap, unsigned long long); break;
+                    case _AR_FORMAT_LENGTH_J: value = va_arg(ap, unsigned long long); break;
+                    case _AR_FORMAT_LENGTH_Z: value = va_arg(ap, Usize); break;
+                    case _AR_FORMAT_LENGTH_T: value = va_arg(ap, ptrdiff_t); break;
+                    default: value = va_arg(ap, unsigned int); break;
+                }
+                format_integer(&out, &spec, value, false, conv);
+            } break;
+            case 'p': {
+                void *ptr = va_arg(ap, void *);
+                if (ptr == NULL) {
+                    format_out_padded(&out, &spec, false, NULL, 0, 0, "(nil)", 5);
+                } else {
+                    format_integer(&out, &spec, (Usize) ptr, false, conv);
+                }
+            } break;
+            case 'c': {
+                char c = va_arg(ap, int);
+                format_out_padded(&out, &spec, false, NULL, 0, 0, &c, 1);
+            } break;
+            case 's': {
+                const char *str = va_arg(ap, const char *);
+                if (str == NULL) {
+                    str = "(null)";
+                }
+                U64 len = spec.precision >= 0 ? strnlen(str, spec.precision) : strlen(str);
+                format_out_padded(&out, &spec, false, NULL, 0, 0, str, len);
+            } break;
+            case 'S': {
+                ArStr str = va_arg(ap, ArStr);
+                U64 len = spec.precision >= 0 ? ar_min(str.len, (U64) spec.precision) : str.len;
+                format_out_padded(&out, &spec, false, NULL, 0, 0, (const char *) str.data, len);
+            } break;
+            case 'R': {
+                char digits[AR_FORMAT_F64_MAX_LENGTH];
+                U32 len = ar_format_f64(digits, va_arg(ap, double));
+                const char *body = digits;
+                char prefix = 0;
+                if (digits[0] == '-') {
+                    prefix = '-';
+                    body++;
+                    len--;
+                } else if (digits[0] != 'n' && spec.flags & _AR_FORMAT_FLAG_PLUS) {
+                    prefix = '+';
+                } else if (digits[0] != 'n' && spec.flags & _AR_FORMAT_FLAG_SPACE) {
+                    prefix = ' ';
+                }
+                B8 zero_pad = (spec.flags & _AR_FORMAT_FLAG_ZERO) && ar_char_is_numeric(body[0]);
+                format_out_padded(&out, &spec, zero_pad, &prefix, prefix != 0, 0, body, len);
+            } break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                format_libc_float(&out, &spec, conv, &ap);
+                break;
+            case 'n':
+                switch (spec.length) {
+                    case _AR_FORMAT_LENGTH_HH: *va_arg(ap, signed char *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_H: *va_arg(ap, short *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_L: *va_arg(ap, long *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_LL: *va_arg(ap, long long *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_J: *va_arg(ap, intmax_t *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_Z: *va_arg(ap, Usize *) = out.len; break;
+                    case _AR_FORMAT_LENGTH_T: *va_arg(ap, ptrdiff_t *) = out.len; break;
+                    default: *va_arg(ap, int *) = out.len; break;
+                }
+                break;
+            case '%':
+                format_out(&out, "%", 1);
+                break;
+            default:
+                // Unknown conversions are printed as is.
+                format_out(&out, spec_start, p - spec_start);
+                break;
+        }
+    }
+    va_end(ap);
+
+    if (size != 0) {
+        buffer[ar_min(out.len, size - 1)] = 0;
+    }
+
+    return out.len;
+}
+
+//
+// Number parsing
+//
+
+// Eight ASCII digits loaded little endian are parsed at once with SWAR,
+// see http://0x80.pl/articles/swar-digits-tonumber.html
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define ARKIN_PARSE_SWAR
+#endif
+
+static B8 parse_is_eight_digits(U64 chunk) {
+    return ((chunk + 0x4646464646464646ull) | (chunk - 0x3030303030303030ull)) & 0x8080808080808080ull ? false : true;
+}
+
+static U32 parse_eight_digits(U64 chunk) {
+    chunk -= 0x3030303030303030ull;
+    chunk = chunk * 10 + (chunk >> 8);
+    chunk = (((chunk & 0x000000ff000000ffull) * (100 + (1000000ull << 32))) +
+        (((chunk >> 16) & 0x000000ff000000ffull) * (1 + (10000ull << 32)))) >> 32;
+    return (U32) chunk;
+}
+
+// Accumulates the digits at the start of 'str' into 'value'. Returns how
+// many digits were consumed, stopping early on overflow.
+static U64 parse_digits_u64(ArStr str, U64 *value, B8 *overflow) {
+    U64 i = 0;
+    U64 result = *value;
+#ifdef ARKIN_PARSE_SWAR
+    while (i + 8 <= str.len) {
+        U64 chunk = 0;
+        memcpy(&chunk, str.data + i, 8);
+        if (!parse_is_eight_digits(chunk)) {
+            break;
+        }
+        if (__builtin_mul_overflow(result, 100000000ull, &result) ||
+                __builtin_add_overflow(result, parse_eight_digits(chunk), &result)) {
+            *overflow = true;
+            return i;
+        }
+        i += 8;
+    }
+#endif
+    while (i < str.len && ar_char_is_numeric(str.data[i])) {
+        if (__builtin_mul_overflow(result, 10ull, &result) ||
+                __builtin_add_overflow(result, (U64) (str.data[i] - '0'), &result)) {
+            *overflow = true;
+            return i;
+        }
+        i++;
+    }
+    *value = result;
+    return i;
+}
+
+B8 ar_str_to_u64(ArStr str, U64 *result) {
+    ArStr digits = str;
+    if (digits.len > 0 && digits.data[0] == '+') {
+        digits = ar_str(digits.data + 1, digits.len - 1);
+    }
+    if (digits.len == 0) {
+        return false;
+    }
+
+    U64 value = 0;
+    B8 overflow = false;
+    if (parse_digits_u64(digits, &value, &overflow) != digits.len || overflow) {
+        return false;
+    }
+
+    *result = value;
+    return true;
+}
+
+B8 ar_str_to_i64(ArStr str, I64 *result) {
+    B8 negative = str.len > 0 && str.data[0] == '-';
+    ArStr digits = str;
+    if (negative) {
+        digits = ar_str(digits.data + 1, digits.len - 1);
+    }
+
+    // Stops '-+1' from parsing.
+    if (negative && digits.len > 0 && digits.data[0] == '+') {
+        return false;
+    }
+
+    U64 value = 0;
+    if (!ar_str_to_u64(digits, &value)) {
+        return false;
+    }
+
+    if (negative) {
+        if (value > (U64) I64_MAX + 1) {
+            return false;
+        }
+        *result = (I64) (0 - value);
+    } else {
+        if (value > (U64) I64_MAX) {
+            return false;
+        }
+        *result = (I64) value;
+    }
+    return true;
+}
+
+// Floats are parsed with the Eisel-Lemire algorithm, see
+// https://arxiv.org/abs/2101.11408 and https://github.com/fastfloat/fast_float
+//
+// The table holds 5^q for q in [-342, 308] normalized and truncated to 128
+// bits, high half first.
+
+#define PARSE_SMALLEST_POW10 -342
+#define PARSE_LARGEST_POW10 308
+#define PARSE_POW5_TABLE_SIZE 651
+
+static const U64 PARSE_POW5_128[PARSE_POW5_TABLE_SIZE][2] = {
+    { 0xeef453d6923bd65aull, 0x113faa2906a13b3full }, { 0x9558b4661b6565f8ull, 0x4ac7ca59a424c507ull },
+    { 0xbaaee17fa23ebf76ull, 0x5d79bcf00d2df649ull }, { 0xe95a99df8ace6f53ull, 0xf4d82c2c107973dcull },
+    { 0x91d8a02bb6c10594ull, 0x79071b9b8a4be869ull }, { 0xb64ec836a47146f9ull, 0x9748e2826cdee284ull },
+    { 0xe3e27a444d8d98b7ull, 0xfd1b1b2308169b25ull }, { 0x8e6d8c6ab0787f72ull, 0xfe30f0f5e50e20f7ull },
+    { 0xb208ef855c969f4full, 0xbdbd2d335e51a935ull }, { 0xde8b2b66b3bc4723ull, 0xad2c788035e61382ull },
+    { 0x8b16fb203055ac76ull, 0x4c3bcb5021afcc31ull }, { 0xaddcb9e83c6b1793ull, 0xdf4abe242a1bbf3dull },
+    { 0xd953e8624b85dd78ull, 0xd71d6dad34a2af0dull }, { 0x87d4713d6f33aa6bull, 0x8672648c40e5ad68ull },
+    { 0xa9c98d8ccb009506ull, 0x680efdaf511f18c2ull }, { 0xd43bf0effdc0ba48ull, 0x0212bd1b2566def2ull },
+    { 0x84a57695fe98746dull, 0x014bb630f7604b57ull }, { 0xa5ced43b7e3e9188ull, 0x419ea3bd35385e2dull },
+    { 0xcf42894a5dce35eaull, 0x52064cac828675b9ull }, { 0x818995ce7aa0e1b2ull, 0x7343efebd1940993ull },
+    { 0xa1ebfb4219491a1full, 0x1014ebe6c5f90bf8ull }, { 0xca66fa129f9b60a6ull, 0xd41a26e077774ef6ull },
+    { 0xfd00b897478238d0ull, 0x8920b098955522b4ull }, { 0x9e20735e8cb16382ull, 0x55b46e5f5d5535b0ull },
+    { 0xc5a890362fddbc62ull, 0xeb2189f734aa831dull }, { 0xf712b443bbd52b7bull, 0xa5e9ec7501d523e4ull },
+    { 0x9a6bb0aa55653b2dull, 0x47b233c92125366eull }, { 0xc1069cd4eabe89f8ull, 0x999ec0bb696e840aull },
+    { 0xf148440a256e2c76ull, 0xc00670ea43ca250dull }, { 0x96cd2a865764dbcaull, 0x380406926a5e5728ull },
+    { 0xbc807527ed3e12bcull, 0xc605083704f5ecf2ull }, { 0xeba09271e88d976bull, 0xf7864a44c633682eull },
+    { 0x93445b8731587ea3ull, 0x7ab3ee6afbe0211dull }, { 0xb8157268fdae9e4cull, 0x5960ea05bad82964ull },
+    { 0xe61acf033d1a45dfull, 0x6fb92487298e33bdull }, { 0x8fd0c16206306babull, 0xa5d3b6d479f8e056ull },
+    { 0xb3c4f1ba87bc8696ull, 0x8f48a4899877186cull }, { 0xe0b62e2929aba83cull, 0x331acdabfe94de87ull },
+    { 0x8c71dcd9ba0b4925ull, 0x9ff0c08b7f1d0b14ull }, { 0xaf8e5410288e1b6full, 0x07ecf0ae5ee44dd9ull },
+    { 0xdb71e91432b1a24aull, 0xc9e82cd9f69d6150ull }, { 0x892731ac9faf056eull, 0xbe311c083a225cd2ull },
+    { 0xab70fe17c79ac6caull, 0x6dbd630a48aaf406ull }, { 0xd64d3d9db981787dull, 0x092cbbccdad5b108ull },
+    { 0x85f0468293f0eb4eull, 0x25bbf56008c58ea5ull }, { 0xa76c582338ed2621ull, 0xaf2af2b80af6f24eull },
+    { 0xd1476e2c07286faaull, 0x1af5af660db4aee1ull }, { 0x82cca4db847945caull, 0x50d98d9fc890ed4dull },
+    { 0xa37fce126597973cull, 0xe50ff107bab528a0ull }, { 0xcc5fc196fefd7d0cull, 0x1e53ed49a96272c8ull },
+    { 0xff77b1fcbebcdc4full, 0x25e8e89c13bb0f7aull }, { 0x9faacf3df73609b1ull, 0x77b191618c54e9acull },
+    { 0xc795830d75038c1dull, 0xd59df5b9ef6a2417ull }, { 0xf97ae3d0d2446f25ull, 0x4b0573286b44ad1dull },
+    { 0x9becce62836ac577ull, 0x4ee367f9430aec32ull }, { 0xc2e801fb244576d5ull, 0x229c41f793cda73full },
+    { 0xf3a20279ed56d48aull, 0x6b43527578c1110full }, { 0x9845418c345644d6ull, 0x830a13896b78aaa9ull },
+    { 0xbe5691ef416bd60cull, 0x23cc986bc656d553ull }, { 0xedec366b11c6cb8full, 0x2cbfbe86b7ec8aa8ull },
+    { 0x94b3a202eb1c3f39ull, 0x7bf7d71432f3d6a9ull }, { 0xb9e08a83a5e34f07ull, 0xdaf5ccd93fb0cc53ull },
+    { 0xe858ad248f5c22c9ull, 0xd1b3400f8f9cff68ull }, { 0x91376c36d99995beull, 0x23100809b9c21fa1ull },
+    { 0xb58547448ffffb2dull, 0xabd40a0c2832a78aull }, { 0xe2e69915b3fff9f9ull, 0x16c90c8f323f516cull },
+    { 0x8dd01fad907ffc3bull, 0xae3da7d97f6792e3ull }, { 0xb1442798f49ffb4aull, 0x99cd11cfdf41779cull },
+    { 0xdd95317f31c7fa1dull, 0x40405643d711d583ull }, { 0x8a7d3eef7f1cfc52ull, 0x482835ea666b2572ull },
+    { 0xad1c8eab5ee43b66ull, 0xda3243650005eecfull }, { 0xd863b256369d4a40ull, 0x90bed43e40076a82ull },
+    { 0x873e4f75e2224e68ull, 0x5a7744a6e804a291ull }, { 0xa90de3535aaae202ull, 0x711515d0a205cb36ull },
+    { 0xd3515c2831559a83ull, 0x0d5a5b44ca873e03ull }, { 0x8412d9991ed58091ull, 0xe858790afe9486c2ull },
+    { 0xa5178fff668ae0b6ull, 0x626e974dbe39a872ull }, { 0xce5d73ff402d98e3ull, 0xfb0a3d212dc8128full },
+    { 0x80fa687f881c7f8eull, 0x7ce66634bc9d0b99ull }, { 0xa139029f6a239f72ull, 0x1c1fffc1ebc44e80ull },
+    { 0xc987434744ac874eull, 0xa327ffb266b56220ull }, { 0xfbe9141915d7a922ull, 0x4bf1ff9f0062baa8ull },
+    { 0x9d71ac8fada6c9b5ull, 0x6f773fc3603db4a9ull }, { 0xc4ce17b399107c22ull, 0xcb550fb4384d21d3ull },
+    { 0xf6019da07f549b2bull, 0x7e2a53a146606a48ull }, { 0x99c102844f94e0fbull, 0x2eda7444cbfc426dull },
+    { 0xc0314325637a1939ull, 0xfa911155fefb5308ull }, { 0xf03d93eebc589f88ull, 0x793555ab7eba27caull },
+    { 0x96267c7535b763b5ull, 0x4bc1558b2f3458deull }, { 0xbbb01b9283253ca2ull, 0x9eb1aaedfb016f16ull },
+    { 0xea9c227723ee8bcbull, 0x465e15a979c1cadcull }, { 0x92a1958a7675175full, 0x0bfacd89ec191ec9ull },
+    { 0xb749faed14125d36ull, 0xcef980ec671f667bull }, { 0xe51c79a85916f484ull, 0x82b7e12780e7401aull },
+    { 0x8f31cc0937ae58d2ull, 0xd1b2ecb8b0908810ull }, { 0xb2fe3f0b8599ef07ull, 0x861fa7e6dcb4aa15ull },
+    { 0xdfbdcece67006ac9ull, 0x67a791e093e1d49aull }, { 0x8bd6a141006042bdull, 0xe0c8bb2c5c6d24e0ull },
+    { 0xaecc49914078536dull, 0x58fae9f773886e18ull }, { 0xda7f5bf590966848ull, 0xaf39a475506a899eull },
+    { 0x888f99797a5e012dull, 0x6d8406c952429603ull }, { 0xaab37fd7d8f58178ull, 0xc8e5087ba6d33b83ull },
+    { 0xd5605fcdcf32e1d6ull, 0xfb1e4a9a90880a64ull }, { 0x855c3be0a17fcd26ull, 0x5cf2eea09a55067full },
+    { 0xa6b34ad8c9dfc06full, 0xf42faa48c0ea481eull }, { 0xd0601d8efc57b08bull, 0xf13b94daf124da26ull },
+    { 0x823c12795db6ce57ull, 0x76c53d08d6b70858ull }, { 0xa2cb1717b52481edull, 0x54768c4b0c64ca6eull },
+    { 0xcb7ddcdda26da268ull, 0xa9942f5dcf7dfd09ull }, { 0xfe5d54150b090b02ull, 0xd3f93b35435d7c4cull },
+    { 0x9efa548d26e5a6e1ull, 0xc47bc5014a1a6dafull }, { 0xc6b8e9b0709f109aull, 0x359ab6419ca1091bull },
+    { 0xf867241c8cc6d4c0ull, 0xc30163d203c94b62ull }, { 0x9b407691d7fc44f8ull, 0x79e0de63425dcf1dull },
+    { 0xc21094364dfb5636ull, 0x985915fc12f542e4ull }, { 0xf294b943e17a2bc4ull, 0x3e6f5b7b17b2939dull },
+    { 0x979cf3ca6cec5b5aull, 0xa705992ceecf9c42ull }, { 0xbd8430bd08277231ull, 0x50c6ff782a838353ull },
+    { 0xece53cec4a314ebdull, 0xa4f8bf5635246428ull }, { 0x940f4613ae5ed136ull, 0x871b7795e136be99ull },
+    { 0xb913179899f68584ull, 0x28e2557b59846e3full }, { 0xe757dd7ec07426e5ull, 0x331aeada2fe589cfull },
+    { 0x9096ea6f3848984full, 0x3ff0d2c85def7621ull }, { 0xb4bca50b065abe63ull, 0x0fed077a756b53a9ull },
+    { 0xe1ebce4dc7f16dfbull, 0xd3e8495912c62894ull }, { 0x8d3360f09cf6e4bdull, 0x64712dd7abbbd95cull },
+    { 0xb080392cc4349decull, 0xbd8d794d96aacfb3ull }, { 0xdca04777f541c567ull, 0xecf0d7a0fc5583a0ull },
+    { 0x89e42caaf9491b60ull, 0xf41686c49db57244ull }, { 0xac5d37d5b79b6239ull, 0x311c2875c522ced5ull },
+    { 0xd77485cb25823ac7ull, 0x7d633293366b828bull }, { 0x86a8d39ef77164bcull, 0xae5dff9c02033197ull },
+    { 0xa8530886b54dbdebull, 0xd9f57f830283fdfcull }, { 0xd267caa862a12d66ull, 0xd072df63c324fd7bull },
+    { 0x8380dea93da4bc60ull, 0x4247cb9e59f71e6dull }, { 0xa46116538d0deb78ull, 0x52d9be85f074e608ull },
+    { 0xcd795be870516656ull, 0x67902e276c921f8bull }, { 0x806bd9714632dff6ull, 0x00ba1cd8a3db53b6ull },
+    { 0xa086cfcd97bf97f3ull, 0x80e8a40eccd228a4ull }, { 0xc8a883c0fdaf7df0ull, 0x6122cd128006b2cdull },
+    { 0xfad2a4b13d1b5d6cull, 0x796b805720085f81ull }, { 0x9cc3a6eec6311a63ull, 0xcbe3303674053bb0ull },
+    { 0xc3f490aa77bd60fcull, 0xbedbfc4411068a9cull }, { 0xf4f1b4d515acb93bull, 0xee92fb5515482d44ull },
+    { 0x991711052d8bf3c5ull, 0x751bdd152d4d1c4aull }, { 0xbf5cd54678eef0b6ull, 0xd262d45a78a0635dull },
+    { 0xef340a98172aace4ull, 0x86fb897116c87c34ull }, { 0x9580869f0e7aac0eull, 0xd45d35e6ae3d4da0ull },
+    { 0xbae0a846d2195712ull, 0x8974836059cca109ull }, { 0xe998d258869facd7ull, 0x2bd1a438703fc94bull },
+    { 0x91ff83775423cc06ull, 0x7b6306a34627ddcfull }, { 0xb67f6455292cbf08ull, 0x1a3bc84c17b1d542ull },
+    { 0xe41f3d6a7377eecaull, 0x20caba5f1d9e4a93ull }, { 0x8e938662882af53eull, 0x547eb47b7282ee9cull },
+    { 0xb23867fb2a35b28dull, 0xe99e619a4f23aa43ull }, { 0xdec681f9f4c31f31ull, 0x6405fa00e2ec94d4ull },
+    { 0x8b3c113c38f9f37eull, 0xde83bc408dd3dd04ull }, { 0xae0b158b4738705eull, 0x9624ab50b148d445ull },
+    { 0xd98ddaee19068c76ull, 0x3badd624dd9b0957ull }, { 0x87f8a8d4cfa417c9ull, 0xe54ca5d70a80e5d6ull },
+    { 0xa9f6d30a038d1dbcull, 0x5e9fcf4ccd211f4cull }, { 0xd47487cc8470652bull, 0x7647c3200069671full },
+    { 0x84c8d4dfd2c63f3bull, 0x29ecd9f40041e073ull }, { 0xa5fb0a17c777cf09ull, 0xf468107100525890ull },
+    { 0xcf79cc9db955c2ccull, 0x7182148d4066eeb4ull }, { 0x81ac1fe293d599bfull, 0xc6f14cd848405530ull },
+    { 0xa21727db38cb002full, 0xb8ada00e5a506a7cull }, { 0xca9cf1d206fdc03bull, 0xa6d90811f0e4851cull },
+    { 0xfd442e4688bd304aull, 0x908f4a166d1da663ull }, { 0x9e4a9cec15763e2eull, 0x9a598e4e043287feull },
+    { 0xc5dd44271ad3cdbaull, 0x40eff1e1853f29fdull }, { 0xf7549530e188c128ull, 0xd12bee59e68ef47cull },
+    { 0x9a94dd3e8cf578b9ull, 0x82bb74f8301958ceull }, { 0xc13a148e3032d6e7ull, 0xe36a52363c1faf01ull },
+    { 0xf18899b1bc3f8ca1ull, 0xdc44e6c3cb279ac1ull }, { 0x96f5600f15a7b7e5ull, 0x29ab103a5ef8c0b9ull },
+    { 0xbcb2b812db11a5deull, 0x7415d448f6b6f0e7ull }, { 0xebdf661791d60f56ull, 0x111b495b3464ad21ull },
+    { 0x936b9fcebb25c995ull, 0xcab10dd900beec34ull }, { 0xb84687c269ef3bfbull, 0x3d5d514f40eea742ull },
+    { 0xe65829b3046b0afaull, 0x0cb4a5a3112a5112ull }, { 0x8ff71a0fe2c2e6dcull, 0x47f0e785eaba72abull },
+    { 0xb3f4e093db73a093ull, 0x59ed216765690f56ull }, { 0xe0f218b8d25088b8ull, 0x306869c13ec3532cull },
+    { 0x8c974f7383725573ull, 0x1e414218c73a13fbull }, { 0xafbd2350644eeacfull, 0xe5d1929ef90898faull },
+    { 0xdbac6c247d62a583ull, 0xdf45f746b74abf39ull }, { 0x894bc396ce5da772ull, 0x6b8bba8c328eb783ull },
+    { 0xab9eb47c81f5114full, 0x066ea92f3f326564ull }, { 0xd686619ba27255a2ull, 0xc80a537b0efefebdull },
+    { 0x8613fd0145877585ull, 0xbd06742ce95f5f36ull }, { 0xa798fc4196e952e7ull, 0x2c48113823b73704ull },
+    { 0xd17f3b51fca3a7a0ull, 0xf75a15862ca504c5ull }, { 0x82ef85133de648c4ull, 0x9a984d73dbe722fbull },
+    { 0xa3ab66580d5fdaf5ull, 0xc13e60d0d2e0ebbaull }, { 0xcc963fee10b7d1b3ull, 0x318df905079926a8ull },
+    { 0xffbbcfe994e5c61full, 0xfdf17746497f7052ull }, { 0x9fd561f1fd0f9bd3ull, 0xfeb6ea8bedefa633ull },
+    { 0xc7caba6e7c5382c8ull, 0xfe64a52ee96b8fc0ull }, { 0xf9bd690a1b68637bull, 0x3dfdce7aa3c673b0ull },
+    { 0x9c1661a651213e2dull, 0x06bea10ca65c084eull }, { 0xc31bfa0fe5698db8ull, 0x486e494fcff30a62ull },
+    { 0xf3e2f893dec3f126ull, 0x5a89dba3c3efccfaull }, { 0x986ddb5c6b3a76b7ull, 0xf89629465a75e01cull },
+    { 0xbe89523386091465ull, 0xf6bbb397f1135823ull }, { 0xee2ba6c0678b597full, 0x746aa07ded582e2cull },
+    { 0x94db483840b717efull, 0xa8c2a44eb4571cdcull }, { 0xba121a4650e4ddebull, 0x92f34d62616ce413ull },
+    { 0xe896a0d7e51e1566ull, 0x77b020baf9c81d17ull }, { 0x915e2486ef32cd60ull, 0x0ace1474dc1d122eull },
+    { 0xb5b5ada8aaff80b8ull, 0x0d819992132456baull }, { 0xe3231912d5bf60e6ull, 0x10e1fff697ed6c69ull },
+    { 0x8df5efabc5979c8full, 0xca8d3ffa1ef463c1ull }, { 0xb1736b96b6fd83b3ull, 0xbd308ff8a6b17cb2ull },
+    { 0xddd0467c64bce4a0ull, 0xac7cb3f6d05ddbdeull }, { 0x8aa22c0dbef60ee4ull, 0x6bcdf07a423aa96bull },
+    { 0xad4ab7112eb3929dull, 0x86c16c98d2c953c6ull }, { 0xd89d64d57a607744ull, 0xe871c7bf077ba8b7ull },
+    { 0x87625f056c7c4a8bull, 0x11471cd764ad4972ull }, { 0xa93af6c6c79b5d2dull, 0xd598e40d3dd89bcfull },
+    { 0xd389b47879823479ull, 0x4aff1d108d4ec2c3ull }, { 0x843610cb4bf160cbull, 0xcedf722a585139baull },
+    { 0xa54394fe1eedb8feull, 0xc2974eb4ee658828ull }, { 0xce947a3da6a9273eull, 0x733d226229feea32ull },
+    { 0x811ccc668829b887ull, 0x0806357d5a3f525full }, { 0xa163ff802a3426a8ull, 0xca07c2dcb0cf26f7ull },
+    { 0xc9bcff6034c13052ull, 0xfc89b393dd02f0b5ull }, { 0xfc2c3f3841f17c67ull, 0xbbac2078d443ace2ull },
+    { 0x9d9ba7832936edc0ull, 0xd54b944b84aa4c0dull }, { 0xc5029163f384a931ull, 0x0a9e795e65d4df11ull },
+    { 0xf64335bcf065d37dull, 0x4d4617b5ff4a16d5ull }, { 0x99ea0196163fa42eull, 0x504bced1bf8e4e45ull },
+    { 0xc06481fb9bcf8d39ull, 0xe45ec2862f71e1d6ull }, { 0xf07da27a82c37088ull, 0x5d767327bb4e5a4cull },
+    { 0x964e858c91ba2655ull, 0x3a6a07f8d510f86full }, { 0xbbe226efb628afeaull, 0x890489f70a55368bull },
+    { 0xeadab0aba3b2dbe5ull, 0x2b45ac74ccea842eull }, { 0x92c8ae6b464fc96full, 0x3b0b8bc90012929dull },
+    { 0xb77ada0617e3bbcbull, 0x09ce6ebb40173744ull }, { 0xe55990879ddcaabdull, 0xcc420a6a101d0515ull },
+    { 0x8f57fa54c2a9eab6ull, 0x9fa946824a12232dull }, { 0xb32df8e9f3546564ull, 0x47939822dc96abf9ull },
+    { 0xdff9772470297ebdull, 0x59787e2b93bc56f7ull }, { 0x8bfbea76c619ef36ull, 0x57eb4edb3c55b65aull },
+    { 0xaefae51477a06b03ull, 0xede622920b6b23f1ull }, { 0xdab99e59958885c4ull, 0xe95fab368e45ecedull },
+    { 0x88b402f7fd75539bull, 0x11dbcb0218ebb414ull }, { 0xaae103b5fcd2a881ull, 0xd652bdc29f26a119ull },
+    { 0xd59944a37c0752a2ull, 0x4be76d3346f0495full }, { 0x857fcae62d8493a5ull, 0x6f70a4400c562ddbull },
+    { 0xa6dfbd9fb8e5b88eull, 0xcb4ccd500f6bb952ull }, { 0xd097ad07a71f26b2ull, 0x7e2000a41346a7a7ull },
+    { 0x825ecc24c873782full, 0x8ed400668c0c28c8ull }, { 0xa2f67f2dfa90563bull, 0x728900802f0f32faull },
+    { 0xcbb41ef979346bcaull, 0x4f2b40a03ad2ffb9ull }, { 0xfea126b7d78186bcull, 0xe2f610c84987bfa8ull },
+    { 0x9f24b832e6b0f436ull, 0x0dd9ca7d2df4d7c9ull }, { 0xc6ede63fa05d3143ull, 0x91503d1c79720dbbull },
+    { 0xf8a95fcf88747d94ull, 0x75a44c6397ce912aull }, { 0x9b69dbe1b548ce7cull, 0xc986afbe3ee11abaull },
+    { 0xc24452da229b021bull, 0xfbe85badce996168ull }, { 0xf2d56790ab41c2a2ull, 0xfae27299423fb9c3ull },
+    { 0x97c560ba6b0919a5ull, 0xdccd879fc967d41aull }, { 0xbdb6b8e905cb600full, 0x5400e987bbc1c920ull },
+    { 0xed246723473e3813ull, 0x290123e9aab23b68ull }, { 0x9436c0760c86e30bull, 0xf9a0b6720aaf6521ull },
+    { 0xb94470938fa89bceull, 0xf808e40e8d5b3e69ull }, { 0xe7958cb87392c2c2ull, 0xb60b1d1230b20e04ull },
+    { 0x90bd77f3483bb9b9ull, 0xb1c6f22b5e6f48c2ull }, { 0xb4ecd5f01a4aa828ull, 0x1e38aeb6360b1af3ull },
+    { 0xe2280b6c20dd5232ull, 0x25c6da63c38de1b0ull }, { 0x8d590723948a535full, 0x579c487e5a38ad0eull },
+    { 0xb0af48ec79ace837ull, 0x2d835a9df0c6d851ull }, { 0xdcdb1b2798182244ull, 0xf8e431456cf88e65ull },
+    { 0x8a08f0f8bf0f156bull, 0x1b8e9ecb641b58ffull }, { 0xac8b2d36eed2dac5ull, 0xe272467e3d222f3full },
+    { 0xd7adf884aa879177ull, 0x5b0ed81dcc6abb0full }, { 0x86ccbb52ea94baeaull, 0x98e947129fc2b4e9ull },
+    { 0xa87fea27a539e9a5ull, 0x3f2398d747b36224ull }, { 0xd29fe4b18e88640eull, 0x8eec7f0d19a03aadull },
+    { 0x83a3eeeef9153e89ull, 0x1953cf68300424acull }, { 0xa48ceaaab75a8e2bull, 0x5fa8c3423c052dd7ull },
+    { 0xcdb02555653131b6ull, 0x3792f412cb06794dull }, { 0x808e17555f3ebf11ull, 0xe2bbd88bbee40bd0ull },
+    { 0xa0b19d2ab70e6ed6ull, 0x5b6aceaeae9d0ec4ull }, { 0xc8de047564d20a8bull, 0xf245825a5a445275ull },
+    { 0xfb158592be068d2eull, 0xeed6e2f0f0d56712ull }, { 0x9ced737bb6c4183dull, 0x55464dd69685606bull },
+    { 0xc428d05aa4751e4cull, 0xaa97e14c3c26b886ull }, { 0xf53304714d9265dfull, 0xd53dd99f4b3066a8ull },
+    { 0x993fe2c6d07b7fabull, 0xe546a8038efe4029ull }, { 0xbf8fdb78849a5f96ull, 0xde98520472bdd033ull },
+    { 0xef73d256a5c0f77cull, 0x963e66858f6d4440ull }, { 0x95a8637627989aadull, 0xdde7001379a44aa8ull },
+    { 0xbb127c53b17ec159ull, 0x5560c018580d5d52ull }, { 0xe9d71b689dde71afull, 0xaab8f01e6e10b4a6ull },
+    { 0x9226712162ab070dull, 0xcab3961304ca70e8ull }, { 0xb6b00d69bb55c8d1ull, 0x3d607b97c5fd0d22ull },
+    { 0xe45c10c42a2b3b05ull, 0x8cb89a7db77c506aull }, { 0x8eb98a7a9a5b04e3ull, 0x77f3608e92adb242ull },
+    { 0xb267ed1940f1c61cull, 0x55f038b237591ed3ull }, { 0xdf01e85f912e37a3ull, 0x6b6c46dec52f6688ull },
+    { 0x8b61313bbabce2c6ull, 0x2323ac4b3b3da015ull }, { 0xae397d8aa96c1b77ull, 0xabec975e0a0d081aull },
+    { 0xd9c7dced53c72255ull, 0x96e7bd358c904a21ull }, { 0x881cea14545c7575ull, 0x7e50d64177da2e54ull },
+    { 0xaa242499697392d2ull, 0xdde50bd1d5d0b9e9ull }, { 0xd4ad2dbfc3d07787ull, 0x955e4ec64b44e864ull },
+    { 0x84ec3c97da624ab4ull, 0xbd5af13bef0b113eull }, { 0xa6274bbdd0fadd61ull, 0xecb1ad8aeacdd58eull },
+    { 0xcfb11ead453994baull, 0x67de18eda5814af2ull }, { 0x81ceb32c4b43fcf4ull, 0x80eacf948770ced7ull },
+    { 0xa2425ff75e14fc31ull, 0xa1258379a94d028dull }, { 0xcad2f7f5359a3b3eull, 0x096ee45813a04330ull },
+    { 0xfd87b5f28300ca0dull, 0x8bca9d6e188853fcull }, { 0x9e74d1b791e07e48ull, 0x775ea264cf55347eull },
+    { 0xc612062576589ddaull, 0x95364afe032a819eull }, { 0xf79687aed3eec551ull, 0x3a83ddbd83f52205ull },
+    { 0x9abe14cd44753b52ull, 0xc4926a9672793543ull }, { 0xc16d9a0095928a27ull, 0x75b7053c0f178294ull },
+    { 0xf1c90080baf72cb1ull, 0x5324c68b12dd6339ull }, { 0x971da05074da7beeull, 0xd3f6fc16ebca5e04ull },
+    { 0xbce5086492111aeaull, 0x88f4bb1ca6bcf585ull }, { 0xec1e4a7db69561a5ull, 0x2b31e9e3d06c32e6ull },
+    { 0x9392ee8e921d5d07ull, 0x3aff322e62439fd0ull }, { 0xb877aa3236a4b449ull, 0x09befeb9fad487c3ull },
+    { 0xe69594bec44de15bull, 0x4c2ebe687989a9b4ull }, { 0x901d7cf73ab0acd9ull, 0x0f9d37014bf60a11ull },
+    { 0xb424dc35095cd80full, 0x538484c19ef38c95ull }, { 0xe12e13424bb40e13ull, 0x2865a5f206b06fbaull },
+    { 0x8cbccc096f5088cbull, 0xf93f87b7442e45d4ull }, { 0xafebff0bcb24aafeull, 0xf78f69a51539d749ull },
+    { 0xdbe6fecebdedd5beull, 0xb573440e5a884d1cull }, { 0x89705f4136b4a597ull, 0x31680a88f8953031ull },
+    { 0xabcc77118461cefcull, 0xfdc20d2b36ba7c3eull }, { 0xd6bf94d5e57a42bcull, 0x3d32907604691b4dull },
+    { 0x8637bd05af6c69b5ull, 0xa63f9a49c2c1b110ull }, { 0xa7c5ac471b478423ull, 0x0fcf80dc33721d54ull },
+    { 0xd1b71758e219652bull, 0xd3c36113404ea4a9ull }, { 0x83126e978d4fdf3bull, 0x645a1cac083126eaull },
+    { 0xa3d70a3d70a3d70aull, 0x3d70a3d70a3d70a4ull }, { 0xccccccccccccccccull, 0xcccccccccccccccdull },
+    { 0x8000000000000000ull, 0x0000000000000000ull }, { 0xa000000000000000ull, 0x0000000000000000ull },
+    { 0xc800000000000000ull, 0x0000000000000000ull }, { 0xfa00000000000000ull, 0x0000000000000000ull },
+    { 0x9c40000000000000ull, 0x0000000000000000ull }, { 0xc350000000000000ull, 0x0000000000000000ull },
+    { 0xf424000000000000ull, 0x0000000000000000ull }, { 0x9896800000000000ull, 0x0000000000000000ull },
+    { 0xbebc200000000000ull, 0x0000000000000000ull }, { 0xee6b280000000000ull, 0x0000000000000000ull },
+    { 0x9502f90000000000ull, 0x0000000000000000ull }, { 0xba43b74000000000ull, 0x0000000000000000ull },
+    { 0xe8d4a51000000000ull, 0x0000000000000000ull }, { 0x9184e72a00000000ull, 0x0000000000000000ull },
+    { 0xb5e620f480000000ull, 0x0000000000000000ull }, { 0xe35fa931a0000000ull, 0x0000000000000000ull },
+    { 0x8e1bc9bf04000000ull, 0x0000000000000000ull }, { 0xb1a2bc2ec5000000ull, 0x0000000000000000ull },
+    { 0xde0b6b3a76400000ull, 0x0000000000000000ull }, { 0x8ac7230489e80000ull, 0x0000000000000000ull },
+    { 0xad78ebc5ac620000ull, 0x0000000000000000ull }, { 0xd8d726b7177a8000ull, 0x0000000000000000ull },
+    { 0x878678326eac9000ull, 0x0000000000000000ull }, { 0xa968163f0a57b400ull, 0x0000000000000000ull },
+    { 0xd3c21bcecceda100ull, 0x0000000000000000ull }, { 0x84595161401484a0ull, 0x0000000000000000ull },
+    { 0xa56fa5b99019a5c8ull, 0x0000000000000000ull }, { 0xcecb8f27f4200f3aull, 0x0000000000000000ull },
+    { 0x813f3978f8940984ull, 0x4000000000000000ull }, { 0xa18f07d736b90be5ull, 0x5000000000000000ull },
+    { 0xc9f2c9cd04674edeull, 0xa400000000000000ull }, { 0xfc6f7c4045812296ull, 0x4d00000000000000ull },
+    { 0x9dc5ada82b70b59dull, 0xf020000000000000ull }, { 0xc5371912364ce305ull, 0x6c28000000000000ull },
+    { 0xf684df56c3e01bc6ull, 0xc732000000000000ull }, { 0x9a130b963a6c115cull, 0x3c7f400000000000ull },
+    { 0xc097ce7bc90715b3ull, 0x4b9f100000000000ull }, { 0xf0bdc21abb48db20ull, 0x1e86d40000000000ull },
+    { 0x96769950b50d88f4ull, 0x1314448000000000ull }, { 0xbc143fa4e250eb31ull, 0x17d955a000000000ull },
+    { 0xeb194f8e1ae525fdull, 0x5dcfab0800000000ull }, { 0x92efd1b8d0cf37beull, 0x5aa1cae500000000ull },
+    { 0xb7abc627050305adull, 0xf14a3d9e40000000ull }, { 0xe596b7b0c643c719ull, 0x6d9ccd05d0000000ull },
+    { 0x8f7e32ce7bea5c6full, 0xe4820023a2000000ull }, { 0xb35dbf821ae4f38bull, 0xdda2802c8a800000ull },
+    { 0xe0352f62a19e306eull, 0xd50b2037ad200000ull }, { 0x8c213d9da502de45ull, 0x4526f422cc340000ull },
+    { 0xaf298d050e4395d6ull, 0x9670b12b7f410000ull }, { 0xdaf3f04651d47b4cull, 0x3c0cdd765f114000ull },
+    { 0x88d8762bf324cd0full, 0xa5880a69fb6ac800ull }, { 0xab0e93b6efee0053ull, 0x8eea0d047a457a00ull },
+    { 0xd5d238a4abe98068ull, 0x72a4904598d6d880ull }, { 0x85a36366eb71f041ull, 0x47a6da2b7f864750ull },
+    { 0xa70c3c40a64e6c51ull, 0x999090b65f67d924ull }, { 0xd0cf4b50cfe20765ull, 0xfff4b4e3f741cf6dull },
+    { 0x82818f1281ed449full, 0xbff8f10e7a8921a4ull }, { 0xa321f2d7226895c7ull, 0xaff72d52192b6a0dull },
+    { 0xcbea6f8ceb02bb39ull, 0x9bf4f8a69f764490ull }, { 0xfee50b7025c36a08ull, 0x02f236d04753d5b4ull },
+    { 0x9f4f2726179a2245ull, 0x01d762422c946590ull }, { 0xc722f0ef9d80aad6ull, 0x424d3ad2b7b97ef5ull },
+    { 0xf8ebad2b84e0d58bull, 0xd2e0898765a7deb2ull }, { 0x9b934c3b330c8577ull, 0x63cc55f49f88eb2full },
+    { 0xc2781f49ffcfa6d5ull, 0x3cbf6b71c76b25fbull }, { 0xf316271c7fc3908aull, 0x8bef464e3945ef7aull },
+    { 0x97edd871cfda3a56ull, 0x97758bf0e3cbb5acull }, { 0xbde94e8e43d0c8ecull, 0x3d52eeed1cbea317ull },
+    { 0xed63a231d4c4fb27ull, 0x4ca7aaa863ee4bddull }, { 0x945e455f24fb1cf8ull, 0x8fe8caa93e74ef6aull },
+    { 0xb975d6b6ee39e436ull, 0xb3e2fd538e122b44ull }, { 0xe7d34c64a9c85d44ull, 0x60dbbca87196b616ull },
+    { 0x90e40fbeea1d3a4aull, 0xbc8955e946fe31cdull }, { 0xb51d13aea4a488ddull, 0x6babab6398bdbe41ull },
+    { 0xe264589a4dcdab14ull, 0xc696963c7eed2dd1ull }, { 0x8d7eb76070a08aecull, 0xfc1e1de5cf543ca2ull },
+    { 0xb0de65388cc8ada8ull, 0x3b25a55f43294bcbull }, { 0xdd15fe86affad912ull, 0x49ef0eb713f39ebeull },
+    { 0x8a2dbf142dfcc7abull, 0x6e3569326c784337ull }, { 0xacb92ed9397bf996ull, 0x49c2c37f07965404ull },
+    { 0xd7e77a8f87daf7fbull, 0xdc33745ec97be906ull }, { 0x86f0ac99b4e8dafdull, 0x69a028bb3ded71a3ull },
+    { 0xa8acd7c0222311bcull, 0xc40832ea0d68ce0cull }, { 0xd2d80db02aabd62bull, 0xf50a3fa490c30190ull },
+    { 0x83c7088e1aab65dbull, 0x792667c6da79e0faull }, { 0xa4b8cab1a1563f52ull, 0x577001b891185938ull },
+    { 0xcde6fd5e09abcf26ull, 0xed4c0226b55e6f86ull }, { 0x80b05e5ac60b6178ull, 0x544f8158315b05b4ull },
+    { 0xa0dc75f1778e39d6ull, 0x696361ae3db1c721ull }, { 0xc913936dd571c84cull, 0x03bc3a19cd1e38e9ull },
+    { 0xfb5878494ace3a5full, 0x04ab48a04065c723ull }, { 0x9d174b2dcec0e47bull, 0x62eb0d64283f9c76ull },
+    { 0xc45d1df942711d9aull, 0x3ba5d0bd324f8394ull }, { 0xf5746577930d6500ull, 0xca8f44ec7ee36479ull },
+    { 0x9968bf6abbe85f20ull, 0x7e998b13cf4e1ecbull }, { 0xbfc2ef456ae276e8ull, 0x9e3fedd8c321a67eull },
+    { 0xefb3ab16c59b14a2ull, 0xc5cfe94ef3ea101eull }, { 0x95d04aee3b80ece5ull, 0xbba1f1d158724a12ull },
+    { 0xbb445da9ca61281full, 0x2a8a6e45ae8edc97ull }, { 0xea1575143cf97226ull, 0xf52d09d71a3293bdull },
+    { 0x924d692ca61be758ull, 0x593c2626705f9c56ull }, { 0xb6e0c377cfa2e12eull, 0x6f8b2fb00c77836cull },
+    { 0xe498f455c38b997aull, 0x0b6dfb9c0f956447ull }, { 0x8edf98b59a373fecull, 0x4724bd4189bd5eacull },
+    { 0xb2977ee300c50fe7ull, 0x58edec91ec2cb657ull }, { 0xdf3d5e9bc0f653e1ull, 0x2f2967b66737e3edull },
+    { 0x8b865b215899f46cull, 0xbd79e0d20082ee74ull }, { 0xae67f1e9aec07187ull, 0xecd8590680a3aa11ull },
+    { 0xda01ee641a708de9ull, 0xe80e6f4820cc9495ull }, { 0x884134fe908658b2ull, 0x3109058d147fdcddull },
+    { 0xaa51823e34a7eedeull, 0xbd4b46f0599fd415ull }, { 0xd4e5e2cdc1d1ea96ull, 0x6c9e18ac7007c91aull },
+    { 0x850fadc09923329eull, 0x03e2cf6bc604ddb0ull }, { 0xa6539930bf6bff45ull, 0x84db8346b786151cull },
+    { 0xcfe87f7cef46ff16ull, 0xe612641865679a63ull }, { 0x81f14fae158c5f6eull, 0x4fcb7e8f3f60c07eull },
+    { 0xa26da3999aef7749ull, 0xe3be5e330f38f09dull }, { 0xcb090c8001ab551cull, 0x5cadf5bfd3072cc5ull },
+    { 0xfdcb4fa002162a63ull, 0x73d9732fc7c8f7f6ull }, { 0x9e9f11c4014dda7eull, 0x2867e7fddcdd9afaull },
+    { 0xc646d63501a1511dull, 0xb281e1fd541501b8ull }, { 0xf7d88bc24209a565ull, 0x1f225a7ca91a4226ull },
+    { 0x9ae757596946075full, 0x3375788de9b06958ull }, { 0xc1a12d2fc3978937ull, 0x0052d6b1641c83aeull },
+    { 0xf209787bb47d6b84ull, 0xc0678c5dbd23a49aull }, { 0x9745eb4d50ce6332ull, 0xf840b7ba963646e0ull },
+    { 0xbd176620a501fbffull, 0xb650e5a93bc3d898ull }, { 0xec5d3fa8ce427affull, 0xa3e51f138ab4cebeull },
+    { 0x93ba47c980e98cdfull, 0xc66f336c36b10137ull }, { 0xb8a8d9bbe123f017ull, 0xb80b0047445d4184ull },
+    { 0xe6d3102ad96cec1dull, 0xa60dc059157491e5ull }, { 0x9043ea1ac7e41392ull, 0x87c89837ad68db2full },
+    { 0xb454e4a179dd1877ull, 0x29babe4598c311fbull }, { 0xe16a1dc9d8545e94ull, 0xf4296dd6fef3d67aull },
+    { 0x8ce2529e2734bb1dull, 0x1899e4a65f58660cull }, { 0xb01ae745b101e9e4ull, 0x5ec05dcff72e7f8full },
+    { 0xdc21a1171d42645dull, 0x76707543f4fa1f73ull }, { 0x899504ae72497ebaull, 0x6a06494a791c53a8ull },
+    { 0xabfa45da0edbde69ull, 0x0487db9d17636892ull }, { 0xd6f8d7509292d603ull, 0x45a9d2845d3c42b6ull },
+    { 0x865b86925b9bc5c2ull, 0x0b8a2392ba45a9b2ull }, { 0xa7f26836f282b732ull, 0x8e6cac7768d7141eull },
+    { 0xd1ef0244af2364ffull, 0x3207d795430cd926ull }, { 0x8335616aed761f1full, 0x7f44e6bd49e807b8ull },
+    { 0xa402b9c5a8d3a6e7ull, 0x5f16206c9c6209a6ull }, { 0xcd036837130890a1ull, 0x36dba887c37a8c0full },
+    { 0x802221226be55a64ull, 0xc2494954da2c9789ull }, { 0xa02aa96b06deb0fdull, 0xf2db9baa10b7bd6cull },
+    { 0xc83553c5c8965d3dull, 0x6f92829494e5acc7ull }, { 0xfa42a8b73abbf48cull, 0xcb772339ba1f17f9ull },
+    { 0x9c69a97284b578d7ull, 0xff2a760414536efbull }, { 0xc38413cf25e2d70dull, 0xfef5138519684abaull },
+    { 0xf46518c2ef5b8cd1ull, 0x7eb258665fc25d69ull }, { 0x98bf2f79d5993802ull, 0xef2f773ffbd97a61ull },
+    { 0xbeeefb584aff8603ull, 0xaafb550ffacfd8faull }, { 0xeeaaba2e5dbf6784ull, 0x95ba2a53f983cf38ull },
+    { 0x952ab45cfa97a0b2ull, 0xdd945a747bf26183ull }, { 0xba756174393d88dfull, 0x94f971119aeef9e4ull },
+    { 0xe912b9d1478ceb17ull, 0x7a37cd5601aab85dull }, { 0x91abb422ccb812eeull, 0xac62e055c10ab33aull },
+    { 0xb616a12b7fe617aaull, 0x577b986b314d6009ull }, { 0xe39c49765fdf9d94ull, 0xed5a7e85fda0b80bull },
+    { 0x8e41ade9fbebc27dull, 0x14588f13be847307ull }, { 0xb1d219647ae6b31cull, 0x596eb2d8ae258fc8ull },
+    { 0xde469fbd99a05fe3ull, 0x6fca5f8ed9aef3bbull }, { 0x8aec23d680043beeull, 0x25de7bb9480d5854ull },
+    { 0xada72ccc20054ae9ull, 0xaf561aa79a10ae6aull }, { 0xd910f7ff28069da4ull, 0x1b2ba1518094da04ull },
+    { 0x87aa9aff79042286ull, 0x90fb44d2f05d0842ull }, { 0xa99541bf57452b28ull, 0x353a1607ac744a53ull },
+    { 0xd3fa922f2d1675f2ull, 0x42889b8997915ce8ull }, { 0x847c9b5d7c2e09b7ull, 0x69956135febada11ull },
+    { 0xa59bc234db398c25ull, 0x43fab9837e699095ull }, { 0xcf02b2c21207ef2eull, 0x94f967e45e03f4bbull },
+    { 0x8161afb94b44f57dull, 0x1d1be0eebac278f5ull }, { 0xa1ba1ba79e1632dcull, 0x6462d92a69731732ull },
+    { 0xca28a291859bbf93ull, 0x7d7b8f7503cfdcfeull }, { 0xfcb2cb35e702af78ull, 0x5cda735244c3d43eull },
+    { 0x9defbf01b061adabull, 0x3a0888136afa64a7ull }, { 0xc56baec21c7a1916ull, 0x088aaa1845b8fdd0ull },
+    { 0xf6c69a72a3989f5bull, 0x8aad549e57273d45ull }, { 0x9a3c2087a63f6399ull, 0x36ac54e2f678864bull },
+    { 0xc0cb28a98fcf3c7full, 0x84576a1bb416a7ddull }, { 0xf0fdf2d3f3c30b9full, 0x656d44a2a11c51d5ull },
+    { 0x969eb7c47859e743ull, 0x9f644ae5a4b1b325ull }, { 0xbc4665b596706114ull, 0x873d5d9f0dde1feeull },
+    { 0xeb57ff22fc0c7959ull, 0xa90cb506d155a7eaull }, { 0x9316ff75dd87cbd8ull, 0x09a7f12442d588f2ull },
+    { 0xb7dcbf5354e9beceull, 0x0c11ed6d538aeb2full }, { 0xe5d3ef282a242e81ull, 0x8f1668c8a86da5faull },
+    { 0x8fa475791a569d10ull, 0xf96e017d694487bcull }, { 0xb38d92d760ec4455ull, 0x37c981dcc395a9acull },
+    { 0xe070f78d3927556aull, 0x85bbe253f47b1417ull }, { 0x8c469ab843b89562ull, 0x93956d7478ccec8eull },
+    { 0xaf58416654a6babbull, 0x387ac8d1970027b2ull }, { 0xdb2e51bfe9d0696aull, 0x06997b05fcc0319eull },
+    { 0x88fcf317f22241e2ull, 0x441fece3bdf81f03ull }, { 0xab3c2fddeeaad25aull, 0xd527e81cad7626c3ull },
+    { 0xd60b3bd56a5586f1ull, 0x8a71e223d8d3b074ull }, { 0x85c7056562757456ull, 0xf6872d5667844e49ull },
+    { 0xa738c6bebb12d16cull, 0xb428f8ac016561dbull }, { 0xd106f86e69d785c7ull, 0xe13336d701beba52ull },
+    { 0x82a45b450226b39cull, 0xecc0024661173473ull }, { 0xa34d721642b06084ull, 0x27f002d7f95d0190ull },
+    { 0xcc20ce9bd35c78a5ull, 0x31ec038df7b441f4ull }, { 0xff290242c83396ceull, 0x7e67047175a15271ull },
+    { 0x9f79a169bd203e41ull, 0x0f0062c6e984d386ull }, { 0xc75809c42c684dd1ull, 0x52c07b78a3e60868ull },
+    { 0xf92e0c3537826145ull, 0xa7709a56ccdf8a82ull }, { 0x9bbcc7a142b17ccbull, 0x88a66076400bb691ull },
+    { 0xc2abf989935ddbfeull, 0x6acff893d00ea435ull }, { 0xf356f7ebf83552feull, 0x0583f6b8c4124d43ull },
+    { 0x98165af37b2153deull, 0xc3727a337a8b704aull }, { 0xbe1bf1b059e9a8d6ull, 0x744f18c0592e4c5cull },
+    { 0xeda2ee1c7064130cull, 0x1162def06f79df73ull }, { 0x9485d4d1c63e8be7ull, 0x8addcb5645ac2ba8ull },
+    { 0xb9a74a0637ce2ee1ull, 0x6d953e2bd7173692ull }, { 0xe8111c87c5c1ba99ull, 0xc8fa8db6ccdd0437ull },
+    { 0x910ab1d4db9914a0ull, 0x1d9c9892400a22a2ull }, { 0xb54d5e4a127f59c8ull, 0x2503beb6d00cab4bull },
+    { 0xe2a0b5dc971f303aull, 0x2e44ae64840fd61dull }, { 0x8da471a9de737e24ull, 0x5ceaecfed289e5d2ull },
+    { 0xb10d8e1456105dadull, 0x7425a83e872c5f47ull }, { 0xdd50f1996b947518ull, 0xd12f124e28f77719ull },
+    { 0x8a5296ffe33cc92full, 0x82bd6b70d99aaa6full }, { 0xace73cbfdc0bfb7bull, 0x636cc64d1001550bull },
+    { 0xd8210befd30efa5aull, 0x3c47f7e05401aa4eull }, { 0x8714a775e3e95c78ull, 0x65acfaec34810a71ull },
+    { 0xa8d9d1535ce3b396ull, 0x7f1839a741a14d0dull }, { 0xd31045a8341ca07cull, 0x1ede48111209a050ull },
+    { 0x83ea2b892091e44dull, 0x934aed0aab460432ull }, { 0xa4e4b66b68b65d60ull, 0xf81da84d5617853full },
+    { 0xce1de40642e3f4b9ull, 0x36251260ab9d668eull }, { 0x80d2ae83e9ce78f3ull, 0xc1d72b7c6b426019ull },
+    { 0xa1075a24e4421730ull, 0xb24cf65b8612f81full }, { 0xc94930ae1d529cfcull, 0xdee033f26797b627ull },
+    { 0xfb9b7cd9a4a7443cull, 0x169840ef017da3b1ull }, { 0x9d412e0806e88aa5ull, 0x8e1f289560ee864eull },
+    { 0xc491798a08a2ad4eull, 0xf1a6f2bab92a27e2ull }, { 0xf5b5d7ec8acb58a2ull, 0xae10af696774b1dbull },
+    { 0x9991a6f3d6bf1765ull, 0xacca6da1e0a8ef29ull }, { 0xbff610b0cc6edd3full, 0x17fd090a58d32af3ull },
+    { 0xeff394dcff8a948eull, 0xddfc4b4cef07f5b0ull }, { 0x95f83d0a1fb69cd9ull, 0x4abdaf101564f98eull },
+    { 0xbb764c4ca7a4440full, 0x9d6d1ad41abe37f1ull }, { 0xea53df5fd18d5513ull, 0x84c86189216dc5edull },
+    { 0x92746b9be2f8552cull, 0x32fd3cf5b4e49bb4ull }, { 0xb7118682dbb66a77ull, 0x3fbc8c33221dc2a1ull },
+    { 0xe4d5e82392a40515ull, 0x0fabaf3feaa5334aull }, { 0x8f05b1163ba6832dull, 0x29cb4d87f2a7400eull },
+    { 0xb2c71d5bca9023f8ull, 0x743e20e9ef511012ull }, { 0xdf78e4b2bd342cf6ull, 0x914da9246b255416ull },
+    { 0x8bab8eefb6409c1aull, 0x1ad089b6c2f7548eull }, { 0xae9672aba3d0c320ull, 0xa184ac2473b529b1ull },
+    { 0xda3c0f568cc4f3e8ull, 0xc9e5d72d90a2741eull }, { 0x8865899617fb1871ull, 0x7e2fa67c7a658892ull },
+    { 0xaa7eebfb9df9de8dull, 0xddbb901b98feeab7ull }, { 0xd51ea6fa85785631ull, 0x552a74227f3ea565ull },
+    { 0x8533285c936b35deull, 0xd53a88958f87275full }, { 0xa67ff273b8460356ull, 0x8a892abaf368f137ull },
+    { 0xd01fef10a657842cull, 0x2d2b7569b0432d85ull }, { 0x8213f56a67f6b29bull, 0x9c3b29620e29fc73ull },
+    { 0xa298f2c501f45f42ull, 0x8349f3ba91b47b8full }, { 0xcb3f2f7642717713ull, 0x241c70a936219a73ull },
+    { 0xfe0efb53d30dd4d7ull, 0xed238cd383aa0110ull }, { 0x9ec95d1463e8a506ull, 0xf4363804324a40aaull },
+    { 0xc67bb4597ce2ce48ull, 0xb143c6053edcd0d5ull }, { 0xf81aa16fdc1b81daull, 0xdd94b7868e94050aull },
+    { 0x9b10a4e5e9913128ull, 0xca7cf2b4191c8326ull }, { 0xc1d4ce1f63f57d72ull, 0xfd1c2f611f63a3f0ull },
+    { 0xf24a01a73cf2dccfull, 0xbc633b39673c8cecull }, { 0x976e41088617ca01ull, 0xd5be0503e085d813ull },
+    { 0xbd49d14aa79dbc82ull, 0x4b2d8644d8a74e18ull }, { 0xec9c459d51852ba2ull, 0xddf8e7d60ed1219eull },
+    { 0x93e1ab8252f33b45ull, 0xcabb90e5c942b503ull }, { 0xb8da1662e7b00a17ull, 0x3d6a751f3b936243ull },
+    { 0xe7109bfba19c0c9dull, 0x0cc512670a783ad4ull }, { 0x906a617d450187e2ull, 0x27fb2b80668b24c5ull },
+    { 0xb484f9dc9641e9daull, 0xb1f9f660802dedf6ull }, { 0xe1a63853bbd26451ull, 0x5e7873f8a0396973ull },
+    { 0x8d07e33455637eb2ull, 0xdb0b487b6423e1e8ull }, { 0xb049dc016abc5e5full, 0x91ce1a9a3d2cda62ull },
+    { 0xdc5c5301c56b75f7ull, 0x7641a140cc7810fbull }, { 0x89b9b3e11b6329baull, 0xa9e904c87fcb0a9dull },
+    { 0xac2820d9623bf429ull, 0x546345fa9fbdcd44ull }, { 0xd732290fbacaf133ull, 0xa97c177947ad4095ull },
+    { 0x867f59a9d4bed6c0ull, 0x49ed8eabcccc485dull }, { 0xa81f301449ee8c70ull, 0x5c68f256bfff5a74ull },
+    { 0xd226fc195c6a2f8cull, 0x73832eec6fff3111ull }, { 0x83585d8fd9c25db7ull, 0xc831fd53c5ff7eabull },
+    { 0xa42e74f3d032f525ull, 0xba3e7ca8b77f5e55ull }, { 0xcd3a1230c43fb26full, 0x28ce1bd2e55f35ebull },
+    { 0x80444b5e7aa7cf85ull, 0x7980d163cf5b81b3ull }, { 0xa0555e361951c366ull, 0xd7e105bcc332621full },
+    { 0xc86ab5c39fa63440ull, 0x8dd9472bf3fefaa7ull }, { 0xfa856334878fc150ull, 0xb14f98f6f0feb951ull },
+    { 0x9c935e00d4b9d8d2ull, 0x6ed1bf9a569f33d3ull }, { 0xc3b8358109e84f07ull, 0x0a862f80ec4700c8ull },
+    { 0xf4a642e14c6262c8ull, 0xcd27bb612758c0faull }, { 0x98e7e9cccfbd7dbdull, 0x8038d51cb897789cull },
+    { 0xbf21e44003acdd2cull, 0xe0470a63e6bd56c3ull }, { 0xeeea5d5004981478ull, 0x1858ccfce06cac74ull },
+    { 0x95527a5202df0ccbull, 0x0f37801e0c43ebc8ull }, { 0xbaa718e68396cffdull, 0xd30560258f54e6baull },
+    { 0xe950df20247c83fdull, 0x47c6b82ef32a2069ull }, { 0x91d28b7416cdd27eull, 0x4cdc331d57fa5441ull },
+    { 0xb6472e511c81471dull, 0xe0133fe4adf8e952ull }, { 0xe3d8f9e563a198e5ull, 0x58180fddd97723a6ull },
+    { 0x8e679c2f5e44ff8full, 0x570f09eaa7ea7648ull },
+};
+
+typedef unsigned __int128 _ArParseU128;
+
+// Computes the bits of w * 10^q rounded to nearest. Returns false in the
+// rare cases where 128 bits of the power of five aren't enough to tell
+// which way to round.
+static B8 parse_eisel_lemire(U64 w, I64 q, U64 *bits) {
+    if (w == 0 || q < PARSE_SMALLEST_POW10) {
+        *bits = 0;
+        return true;
+    }
+    if (q > PARSE_LARGEST_POW10) {
+        *bits = (U64) 0x7ff << 52;
+        return true;
+    }
+
+    I32 lz = __builtin_clzll(w);
+    w <<= lz;
+
+    const U64 *pow5 = PARSE_POW5_128[q - PARSE_SMALLEST_POW10];
+    _ArParseU128 first = (_ArParseU128) w * pow5[0];
+    U64 high = first >> 64;
+    U64 low = (U64) first;
+
+    // 52 explicit mantissa bits, one implicit, one to round and one for the
+    // possible leading zero of the product.
+    const U64 precision_mask = U64_MAX >> 55;
+    if ((high & precision_mask) == precision_mask) {
+        _ArParseU128 second = (_ArParseU128) w * pow5[1];
+        U64 second_high = second >> 64;
+        low += second_high;
+        if (second_high > low) {
+            high++;
+        }
+    }
+    if (low == U64_MAX && (q < -27 || q > 55)) {
+        return false;
+    }
+
+    U32 upper_bit = high >> 63;
+    U32 shift = upper_bit + 64 - 52 - 3;
+    U64 mantissa = high >> shift;
+    // floor(log2(10^q)) + 63 is the exponent of the product.
+    I32 power2 = (I32) ((((152170 + 65536) * q) >> 16) + 63) + upper_bit - lz + 1023;
+
+    if (power2 <= 0) {
+        // Subnormal.
+        if (-power2 + 1 >= 64) {
+            *bits = 0;
+            return true;
+        }
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        power2 = mantissa < ((U64) 1 << 52) ? 0 : 1;
+        *bits = (mantissa & (((U64) 1 << 52) - 1)) | ((U64) power2 << 52);
+        return true;
+    }
+
+    // Exactly halfway between two doubles is only possible for these
+    // exponents. Ties round to even.
+    if (low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high) {
+        mantissa &= ~(U64) 1;
+    }
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= ((U64) 2 << 52)) {
+        mantissa = (U64) 1 << 52;
+        power2++;
+    }
+    mantissa &= ~((U64) 1 << 52);
+
+    if (power2 >= 0x7ff) {
+        *bits = (U64) 0x7ff << 52;
+        return true;
+    }
+
+    *bits = mantissa | ((U64) power2 << 52);
+    return true;
+}
+
+static const F64 PARSE_EXACT_POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// strtod follows LC_NUMERIC, which may use a comma as the decimal point. The
+// C locale is created on first use and kept for the life of the process.
+static locale_t parse_c_locale(void) {
+    static locale_t c_locale = 0;
+    locale_t curr = __atomic_load_n(&c_locale, __ATOMIC_ACQUIRE);
+    if (curr == 0) {
+        locale_t created = newlocale(LC_ALL_MASK, "C", 0);
+        if (__atomic_compare_exchange_n(&c_locale, &curr, created, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            curr = created;
+        } else {
+            freelocale(created);
+        }
+    }
+    return curr;
+}
+
+// Only called for the handful of inputs Eisel-Lemire can't decide on. Most
+// fit the stack buffer, longer ones are copied into scratch.
+static F64 parse_f64_slow(ArStr str) {
+    char buffer[128];
+    if (str.len < sizeof(buffer)) {
+        memcpy(buffer, str.data, str.len);
+        buffer[str.len] = 0;
+        return strtod_l(buffer, NULL, parse_c_locale());
+    }
+
+    ArTemp scratch = scratch_get_any(NULL, 0);
+    char *cstr = ar_arena_push_arr_no_zero(scratch.arena, char, str.len + 1);
+    memcpy(cstr, str.data, str.len);
+    cstr[str.len] = 0;
+    F64 result = strtod_l(cstr, NULL, parse_c_locale());
+    scratch_release_any(&scratch);
+    return result;
+}
+
+B8 ar_str_to_f64(ArStr str, F64 *result) {
+    U64 i = 0;
+    B8 negative = false;
+    if (i < str.len && (str.data[i] == '-' || str.data[i] == '+')) {
+        negative = str.data[i] == '-';
+        i++;
+    }
+
+    ArStr rest = ar_str(str.data + i, str.len - i);
+    B8 special = rest.len > 0 && (rest.data[0] == 'i' || rest.data[0] == 'I' || rest.data[0] == 'n' || rest.data[0] == 'N');
+    if (special && (ar_str_match(rest, ar_str_lit("inf"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE) ||
+            ar_str_match(rest, ar_str_lit("infinity"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE))) {
+        *result = negative ? -__builtin_inf() : __builtin_inf();
+        return true;
+    }
+    if (special && ar_str_match(rest, ar_str_lit("nan"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE)) {
+        *result = negative ? -__builtin_nan("") : __builtin_nan("");
+        return true;
+    }
+
+    // Up to 19 significant digits fit into w. The rest are only tracked to
+    // know whether they were all zeros.
+    U64 w = 0;
+    U32 significant = 0;
+    I64 q = 0;
+    B8 truncated = false;
+    U64 digit_count = 0;
+
+    for (U32 part = 0; part < 2; part++) {
+        if (part == 1) {
+            if (i >= str.len || str.data[i] != '.') {
+                break;
+            }
+            i++;
+        }
+
+        // Leading zeros aren't significant.
+        if (significant == 0) {
+            while (i < str.len && str.data[i] == '0') {
+                if (part == 1) {
+                    q--;
+                }
+                i++;
+                digit_count++;
+            }
+        }
+
+#ifdef ARKIN_PARSE_SWAR
+        while (significant + 8 <= 19 && i + 8 <= str.len) {
+            U64 chunk = 0;
+            memcpy(&chunk, str.data + i, 8);
+            if (!parse_is_eight_digits(chunk)) {
+                break;
+            }
+            w = w * 100000000 + parse_eight_digits(chunk);
+            if (w != 0) {
+                significant += 8;
+            }
+            if (part == 1) {
+                q -= 8;
+            }
+            i += 8;
+            digit_count += 8;
+        }
+#endif
+        while (i < str.len && ar_char_is_numeric(str.data[i])) {
+            U8 digit = str.data[i] - '0';
+            if (significant < 19) {
+                w = w * 10 + digit;
+                if (w != 0) {
+                    significant++;
+                }
+                if (part == 1) {
+                    q--;
+                }
+            } else {
+                truncated |= digit != 0;
+                if (part == 0) {
+                    q++;
+                }
+            }
+            i++;
+            digit_count++;
+        }
+    }
+
+    if (digit_count == 0) {
+        return false;
+    }
+
+    if (i < str.len && (str.data[i] == 'e' || str.data[i] == 'E')) {
+        i++;
+        B8 exp_negative = false;
+        if (i < str.len && (str.data[i] == '-' || str.data[i] == '+')) {
+            exp_negative = str.data[i] == '-';
+            i++;
+        }
+        if (i >= str.len || !ar_char_is_numeric(str.data[i])) {
+            return false;
+        }
+        I64 exp = 0;
+        while (i < str.len && ar_char_is_numeric(str.data[i])) {
+            // Anything this large is zero or infinity anyway.
+            if (exp < 100000) {
+                exp = exp * 10 + (str.data[i] - '0');
+            }
+            i++;
+        }
+        q += exp_negative ? -exp : exp;
+    }
+
+    if (i != str.len) {
+        return false;
+    }
+
+    F64 value = 0.0;
+    U64 bits = 0;
+    if (!truncated && q >= -22 && q <= 22 && w <= ((U64) 1 << 53)) {
+        // Both w and the power of ten are exact, so is the single rounding.
+        value = q < 0 ? (F64) w / PARSE_EXACT_POW10[-q] : (F64) w * PARSE_EXACT_POW10[q];
+    } else if (!parse_eisel_lemire(w, q, &bits)) {
+        value = parse_f64_slow(str);
+        negative = false;
+    } else if (truncated) {
+        // The dropped digits put the value between w and w + 1.
+        U64 bits_up = 0;
+        if (parse_eisel_lemire(w + 1, q, &bits_up) && bits_up == bits) {
+            memcpy(&value, &bits, sizeof(value));
+        } else {
+            value = parse_f64_slow(str);
+            negative = false;
+        }
+    } else {
+        memcpy(&value, &bits, sizeof(value));
+    }
+
+    *result = negative ? -value : value;
+    return true;
+}
+
+U64 ar_str_to_u64_array(const ArStr *strs, U64 count, U64 *values) {
+    for (U64 i = 0; i < count; i++) {
+        if (!ar_str_to_u64(strs[i], &values[i])) {
+            return i;
+        }
+    }
+    return count;
+}
+
+U64 ar_str_to_i64_array(const ArStr *strs, U64 count, I64 *values) {
+    for (U64 i = 0; i < count; i++) {
+        if (!ar_str_to_i64(strs[i], &values[i])) {
+            return i;
+        }
+    }
+    return count;
+}
+
+U64 ar_str_to_f64_array(const ArStr *strs, U64 count, F64 *values) {
+    for (U64 i = 0; i < count; i++) {
+        if (!ar_str_to_f64(strs[i], &values[i])) {
+            return i;
+        }
+    }
+    return count;
+}
+
+//
+// UTF-8
+//
+
+static B8 utf8_is_ascii8(const U8 *p) {
+    U64 word;
+    memcpy(&word, p, sizeof(word));
+    return (word & 0x8080808080808080ull) == 0;
+}
+
+// Decodes a single code point, stopping at the first byte that can't
+// continue the sequence so each maximal invalid prefix is consumed as a
+// unit.
+static U32 utf8_decode(const U8 *p, U64 len, U32 *codepoint, B8 *valid) {
+    U8 c = p[0];
+    if (c < 0x80) {
+        *codepoint = c;
+        *valid = true;
+        return 1;
+    }
+
+    U32 n;
+    U32 value;
+    // Range of the second byte, narrower after leads that could otherwise
+    // start overlong, surrogate or too large sequences.
+    U8 lo = 0x80;
+    U8 hi = 0xbf;
+    if (c >= 0xc2 && c <= 0xdf) {
+        n = 2;
+        value = c & 0x1f;
+    } else if (c >= 0xe0 && c <= 0xef) {
+        n = 3;
+        value = c & 0x0f;
+        if (c == 0xe0) {
+            lo = 0xa0;
+        } else if (c == 0xed) {
+            hi = 0x9f;
+        }
+    } else if (c >= 0xf0 && c <= 0xf4) {
+        n = 4;
+        value = c & 0x07;
+        if (c == 0xf0) {
+            lo = 0x90;
+        } else if (c == 0xf4) {
+            hi = 0x8f;
+        }
+    } else {
+        *codepoint = AR_UTF8_REPLACEMENT;
+        *valid = false;
+        return 1;
+    }
+
+    for (U32 i = 1; i < n; i++) {
+        if (i >= len || p[i] < lo || p[i] > hi) {
+            *codepoint = AR_UTF8_REPLACEMENT;
+            *valid = false;
+            return i;
+        }
+        value = value << 6 | (p[i] & 0x3f);
+        lo = 0x80;
+        hi = 0xbf;
+    }
+    *codepoint = value;
+    *valid = true;
+    return n;
+}
+
+static B8 utf8_valid_scalar(const U8 *p, U64 n) {
+    U64 i = 0;
+    while (i < n) {
+        if (i + 8 <= n && utf8_is_ascii8(p + i)) {
+            i += 8;
+            continue;
+        }
+        U32 codepoint;
+        B8 valid;
+        i += utf8_decode(p + i, n - i, &codepoint, &valid);
+        if (!valid) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#ifdef ARKIN_STR_SIMD_X86
+// Lookup table validation by John Keiser and Daniel Lemire, see
+// https://arxiv.org/abs/2010.03090. Each pair of adjacent bytes is
+// classified by three nibble lookups which only share a bit when the pair
+// is invalid. Third and fourth bytes of sequences are checked separately by
+// looking two and three bytes back.
+#define UTF8_TOO_SHORT (1 << 0)
+#define UTF8_TOO_LONG (1 << 1)
+#define UTF8_OVERLONG_3 (1 << 2)
+#define UTF8_TOO_LARGE (1 << 3)
+#define UTF8_SURROGATE (1 << 4)
+#define UTF8_OVERLONG_2 (1 << 5)
+#define UTF8_TOO_LARGE_1000 (1 << 6)
+#define UTF8_OVERLONG_4 (1 << 6)
+#define UTF8_TWO_CONTS (1 << 7)
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+#define utf8_lookup_avx2(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+// The last 'n' bytes of 'prev' followed by all but the last 'n' of 'input'.
+#define utf8_prev_avx2(input, prev, n) \
+    _mm256_alignr_epi8((input), _mm256_permute2x128_si256((prev), (input), 0x21), 16 - (n))
+
+__attribute__((target("avx2")))
+static __m256i utf8_errors_avx2(__m256i input, __m256i prev_input) {
+    const __m256i byte_1_high_table = utf8_lookup_avx2(
+        // 0_______ ________
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+        // 10______ ________
+        UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+        // 1100____ ________
+        UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+        // 1101____ ________
+        UTF8_TOO_SHORT,
+        // 1110____ ________
+        UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE,
+        // 1111____ ________
+        UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4);
+    const __m256i byte_1_low_table = utf8_lookup_avx2(
+        // ____0000 ________
+        UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4,
+        // ____0001 ________
+        UTF8_CARRY | UTF8_OVERLONG_2,
+        // ____001_ ________
+        UTF8_CARRY,
+        UTF8_CARRY,
+        // ____0100 ________
+        UTF8_CARRY | UTF8_TOO_LARGE,
+        // ____0101 ________ and up
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        // ____1101 ________
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000,
+        UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000);
+    const __m256i byte_2_high_table = utf8_lookup_avx2(
+        // ________ 0_______
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+        // ________ 1000____
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4,
+        // ________ 1001____
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE,
+        // ________ 101_____
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE,
+        // ________ 11______
+        UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT);
+
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    __m256i prev1 = utf8_prev_avx2(input, prev_input, 1);
+    __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Only 111_____ two bytes back or 1111____ three bytes back end up with
+    // the high bit set, and exactly those bytes have to be continuations.
+    __m256i third = _mm256_subs_epu8(utf8_prev_avx2(input, prev_input, 2), _mm256_set1_epi8((char) (0xe0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(utf8_prev_avx2(input, prev_input, 3), _mm256_set1_epi8((char) (0xf0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char) 0x80));
+    return _mm256_xor_si256(must_continue, special);
+}
+
+// Non-zero where the block ends in the middle of a sequence.
+__attribute__((target("avx2")))
+static __m256i utf8_incomplete_avx2(__m256i input) {
+    const __m256i max = _mm256_setr_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        (char) (0xf0 - 1), (char) (0xe0 - 1), (char) (0xc0 - 1));
+    return _mm256_subs_epu8(input, max);
+}
+
+__attribute__((target("avx2")))
+static B8 utf8_valid_avx2(const U8 *p, U64 n) {
+    __m256i error = _mm256_setzero_si256();
+    __m256i prev_input = _mm256_setzero_si256();
+    __m256i prev_incomplete = _mm256_setzero_si256();
+    U64 i = 0;
+    for (; i + 64 <= n; i += 64) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (p + i + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(a, b)) == 0) {
+            // ASCII can't finish a sequence the last block started.
+            error = _mm256_or_si256(error, prev_incomplete);
+            prev_incomplete = _mm256_setzero_si256();
+        } else {
+            error = _mm256_or_si256(error, utf8_errors_avx2(a, prev_input));
+            error = _mm256_or_si256(error, utf8_errors_avx2(b, a));
+            prev_incomplete = utf8_incomplete_avx2(b);
+        }
+        prev_input = b;
+    }
+
+    // The rest goes through a zero padded copy, a sequence cut off by the
+    // padding is flagged as too short.
+    for (; i < n; i += 32) {
+        U8 block[32] = {0};
+        memcpy(block, p + i, ar_min(n - i, 32));
+        __m256i input = _mm256_loadu_si256((const __m256i *) block);
+        error = _mm256_or_si256(error, utf8_errors_avx2(input, prev_input));
+        prev_incomplete = utf8_incomplete_avx2(input);
+        prev_input = input;
+    }
+    error = _mm256_or_si256(error, prev_incomplete);
+    return _mm256_testz_si256(error, error);
+}
+
+__attribute__((target("avx2")))
+static B8 utf8_is_ascii_avx2(const U8 *p, U64 n) {
+    U64 i = 0;
+    for (; i + 128 <= n; i += 128) {
+        __m256i a = _mm256_loadu_si256((const __m256i *) (p + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *) (p + i + 32));
+        __m256i c = _mm256_loadu_si256((const __m256i *) (p + i + 64));
+        __m256i d = _mm256_loadu_si256((const __m256i *) (p + i + 96));
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(a, b), _mm256_or_si256(c, d))) != 0) {
+            return false;
+        }
+    }
+    for (; i + 32 <= n; i += 32) {
+        if (_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i *) (p + i))) != 0) {
+            return false;
+        }
+    }
+    U8 bits = 0;
+    for (; i < n; i++) {
+        bits |= p[i];
+    }
+    return bits < 0x80;
+}
+#endif
+
+B8 ar_str_utf8_valid(ArStr str) {
+#ifdef ARKIN_STR_SIMD_X86
+    if (str_simd_level() == _AR_STR_SIMD_AVX2) {
+        return utf8_valid_avx2(str.data, str.len);
+    }
+#endif
+    return utf8_valid_scalar(str.data, str.len);
+}
+
+B8 ar_str_is_ascii(ArStr str) {
+#ifdef ARKIN_STR_SIMD_X86
+    if (str_simd_level() == _AR_STR_SIMD_AVX2) {
+        return utf8_is_ascii_avx2(str.data, str.len);
+    }
+#endif
+    U64 i = 0;
+    U64 bits = 0;
+    for (; i + 8 <= str.len; i += 8) {
+        U64 word;
+        memcpy(&word, str.data + i, sizeof(word));
+        bits |= word;
+    }
+    for (; i < str.len; i++) {
+        bits |= str.data[i];
+    }
+    return (bits & 0x8080808080808080ull) == 0;
+}
+
+U32 ar_utf8_decode(ArStr str, U32 *codepoint) {
+    if (str.len == 0) {
+        *codepoint = 0;
+        return 0;
+    }
+    B8 valid;
+    return utf8_decode(str.data, str.len, codepoint, &valid);
+}
+
+U32 ar_utf8_encode(U32 codepoint, U8 *out) {
+    if (codepoint < 0x80) {
+        out[0] = codepoint;
+        return 1;
+    }
+    if (codepoint < 0x800) {
+        out[0] = 0xc0 | codepoint >> 6;
+        out[1] = 0x80 | (codepoint & 0x3f);
+        return 2;
+    }
+    if ((codepoint >= 0xd800 && codepoint <= 0xdfff) || codepoint > 0x10ffff) {
+        codepoint = AR_UTF8_REPLACEMENT;
+    }
+    if (codepoint < 0x10000) {
+        out[0] = 0xe0 | codepoint >> 12;
+        out[1] = 0x80 | (codepoint >> 6 & 0x3f);
+        out[2] = 0x80 | (codepoint & 0x3f);
+        return 3;
+    }
+    out[0] = 0xf0 | codepoint >> 18;
+    out[1] = 0x80 | (codepoint >> 12 & 0x3f);
+    out[2] = 0x80 | (codepoint >> 6 & 0x3f);
+    out[3] = 0x80 | (codepoint & 0x3f);
+    return 4;
+}
+
+void ar_str_builder_push_codepoint(ArStrBuilder *builder, U32 codepoint) {
+    U8 buffer[AR_UTF8_MAX_LENGTH];
+    U32 len = ar_utf8_encode(codepoint, buffer);
+    ar_str_builder_push(builder, ar_str(buffer, len));
+}
+
+ArUtf8Iter ar_utf8_iter_init(ArStr str) {
+    ArUtf8Iter iter = {
+        .str = str,
+    };
+    ar_utf8_iter_next(&iter);
+    return iter;
+}
+
+void ar_utf8_iter_next(ArUtf8Iter *iter) {
+    // The first call comes from init with nothing consumed yet.
+    iter->offset += iter->len;
+    iter->len = ar_utf8_decode(ar_str(iter->str.data + iter->offset, iter->str.len - iter->offset), &iter->codepoint);
+    iter->valid = iter->len != 0;
+}
+
+B8 ar_utf8_iter_valid(const ArUtf8Iter *iter) {
+    return iter->valid;
+}
+
+U32 ar_utf8_iter_get(const ArUtf8Iter *iter) {
+    return iter->codepoint;
+}
+
+U16 *ar_str_to_utf16(ArArena *arena, ArStr str, U64 *len) {
+    // Never more units than bytes.
+    U64 cap = align_to_value((str.len + 1) * sizeof(U16), arena->align);
+    U16 *data = ar_arena_push_no_zero(arena, cap);
+    const U8 *p = str.data;
+    U64 i = 0;
+    U64 out = 0;
+    while (i < str.len) {
+#ifdef ARKIN_STR_SIMD_X86
+        if (i + 16 <= str.len) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (p + i));
+            if (_mm_movemask_epi8(v) == 0) {
+                _mm_storeu_si128((__m128i *) (data + out), _mm_unpacklo_epi8(v, _mm_setzero_si128()));
+                _mm_storeu_si128((__m128i *) (data + out + 8), _mm_unpackhi_epi8(v, _mm_setzero_si128()));
+                i += 16;
+                out += 16;
+                continue;
+            }
+        }
+#endif
+        if (p[i] < 0x80) {
+            data[out++] = p[i++];
+            continue;
+        }
+
+        U32 codepoint;
+        B8 valid;
+        i += utf8_decode(p + i, str.len - i, &codepoint, &valid);
+        if (codepoint >= 0x10000) {
+            codepoint -= 0x10000;
+            data[out++] = 0xd800 | codepoint >> 10;
+            data[out++] = 0xdc00 | (codepoint & 0x3ff);
+        } else {
+            data[out++] = codepoint;
+        }
+    }
+    data[out] = 0;
+
+    arena_pop_no_decommit(arena, cap - align_to_value((out + 1) * sizeof(U16), arena->align));
+    if (len != NULL) {
+        *len = out;
+    }
+    return data;
+}
+
+ArStr ar_str_from_utf16(ArArena *arena, const U16 *data, U64 len) {
+    // A unit takes at most three bytes, pairs take four for two units.
+    U64 cap = align_to_value(len * 3 + 1, arena->align);
+    U8 *out = ar_arena_push_no_zero(arena, cap);
+    U64 i = 0;
+    U64 n = 0;
+    while (i < len) {
+#ifdef ARKIN_STR_SIMD_X86
+        if (i + 8 <= len) {
+            __m128i v = _mm_loadu_si128((const __m128i *) (data + i));
+            __m128i high = _mm_and_si128(v, _mm_set1_epi16((I16) 0xff80));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi16(high, _mm_setzero_si128())) == 0xffff) {
+                _mm_storel_epi64((__m128i *) (out + n), _mm_packus_epi16(v, v));
+                i += 8;
+                n += 8;
+                continue;
+            }
+        }
+#endif
+        U32 codepoint = data[i++];
+        if (codepoint >= 0xd800 && codepoint <= 0xdfff) {
+            if (codepoint <= 0xdbff && i < len && data[i] >= 0xdc00 && data[i] <= 0xdfff) {
+                codepoint = 0x10000 + ((codepoint - 0xd800) << 10) + (data[i] - 0xdc00);
+                i++;
+            } else {
+                codepoint = AR_UTF8_REPLACEMENT;
+            }
+        }
+        n += ar_utf8_encode(codepoint, out + n);
+    }
+    out[n] = '\0';
+
+    arena_pop_no_decommit(arena, cap - align_to_value(n + 1, arena->align));
+    return ar_str(out, n);
+}
+
+//
+// Hash map
+//
+
+B8 ar_memeq(const void *a, const void *b, U64 len) {
+    return memcmp(a, b, len) == 0;
+}
+
+U64 ar_fvn1a_hash(const void *data, U64 len) {
+    const U8 *_data = data;
+    U64 hash = 2166136261u;
+    for (U32 i = 0; i < len; i++) {
+        hash ^= *(_data + i);
+        hash *= 16777619;
+    }
+    return hash;
+}
+
+typedef struct ArHashMapNode ArHashMapNode;
+struct ArHashMapNode {
+    ArHashMapNode *next;
+    ArHashMapNode *prev;
+
+    void *key;
+    void *value;
+};
+
+typedef struct ArHashMapBucket ArHashMapBucket;
+struct ArHashMapBucket {
+    ArHashMapNode *first;
+    ArHashMapNode *last;
+};
+
+struct ArHashMap {
+    ArHashMapDesc desc;
+
+    ArHashMapBucket *buckets;
+    ArHashMapNode *free_list;
+    void *null_value;
+};
+
+ArHashMap *ar_hash_map_init(ArHashMapDesc desc) {
+    ArHashMap *map = ar_arena_push_type_no_zero(desc.arena, ArHashMap);
+    *map = (ArHashMap) {
+        .desc = desc,
+        .buckets = ar_arena_push_arr(desc.arena, ArHashMapBucket, desc.capacity),
+        .null_value = ar_arena_push_no_zero(desc.arena, desc.value_size),
+    };
+    memcpy(map->null_value, desc.null_value, desc.value_size);
+
+    return map;
+}
+
+static ArHashMapNode *hash_map_get_node(ArHashMap *map, const void *key, const void *value) {
+    ArHashMapNode *node = NULL;
+    if (map->free_list != NULL) {
+        node = map->free_list;
+        ar_sll_stack_pop(map->free_list);
+    }
+
+    if (node == NULL) {
+        node = ar_arena_push_type(map->desc.arena, ArHashMapNode);
+        node->key = ar_arena_push_no_zero(map->desc.arena, map->desc.key_size);
+        node->value = ar_arena_push_no_zero(map->desc.arena, map->desc.value_size);
+    }
+
+    memcpy(node->key, key, map->desc.key_size);
+    memcpy(node->value, value, map->desc.value_size);
+
+    return node;
+}
+
+static ArHashMapBucket *hash_map_get_bucket(const ArHashMap *map, const void *key) {
+    U64 hash = map->desc.hash_func(key, map->desc.key_size);
+    U32 index = hash % map->desc.capacity;
+    return &map->buckets[index];
+}
+
+B8 _ar_hash_map_insert(ArHashMap *map, const void *key, const void *value) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    if (bucket->first != NULL) {
+        return false;
+    }
+
+    ArHashMapNode *node = hash_map_get_node(map, key, value);
+    ar_dll_push_back(bucket->first, bucket->last, node);
+
+    return true;
+}
+
+B8 _ar_hash_map_set(ArHashMap *map, const void *key, const void *value) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
+        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
+            memcpy(node->value, value, map->desc.value_size);
+            return false;
+        }
+    }
+
+    ArHashMapNode *node = hash_map_get_node(map, key, value);
+    ar_dll_push_back(bucket->first, bucket->last, node);
+
+    return true;
+}
+
+B8 _ar_hash_map_remove(ArHashMap *map, const void *key) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
+        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
+            ar_sll_stack_push(map->free_list, node);
+            ar_dll_remove(bucket->first, bucket->last, node);
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+B8 _ar_hash_map_has(const ArHashMap *map, const void *key) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
+        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void _ar_hash_map_get(const ArHashMap *map, const void *key, void *output) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
+        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
+            memcpy(output, node->value, map->desc.value_size);
+            return;
+        }
+    }
+
+    memcpy(output, map->null_value, map->desc.value_size);
+}
+
+void *_ar_hash_map_get_ptr(const ArHashMap *map, const void *key) {
+    ArHashMapBucket *bucket = hash_map_get_bucket(map, key);
+
+    for (ArHashMapNode *node = bucket->first; node != NULL; node = node->next) {
+        if (map->desc.eq_func(key, node->key, map->desc.key_size)) {
+            return node->value;
+        }
+    }
+
+    return NULL;
+}
+
+ArArena *ar_hash_map_get_arena(const ArHashMap *map) {
+    return map->desc.arena;
+}
+
+struct ArHashMapIter {
+    const ArHashMap *map;
+    U32 index;
+    ArHashMapNode *curr_node;
+};
+
+ArHashMapIter *ar_hash_map_iter_init(ArArena *arena, const ArHashMap *hash_map) {
+    ArHashMapIter *iter = ar_arena_push_type(arena, ArHashMapIter);
+    iter->map = hash_map;
+
+    for (U32 i = 0; i < hash_map->desc.capacity; i++) {
+        ArHashMapBucket bucket = hash_map->buckets[i];
+        if (bucket.first != NULL) {
+            iter->index = i;
+            iter->curr_node = bucket.first;
+            break;
+        }
+    }
+
+    return iter;
+}
+
+void ar_hash_map_iter_next(ArHashMapIter *iter) {
+    if (iter->curr_node->next != NULL) {
+        iter->curr_node = iter->curr_node->next;
+        return;
+    }
+
+    for (U32 i = iter->index + 1; i < iter->map->desc.capacity; i++) {
+        ArHashMapBucket bucket = iter->map->buckets[i];
+        if (bucket.first != NULL) {
+            iter->index = i;
+            iter->curr_node = bucket.first;
+            return;
+        }
+    }
+
+    iter->index = iter->map->desc.capacity;
+    iter->map = NULL;
+    iter->curr_node = NULL;
+}
+
+B8 ar_hash_map_iter_valid(const ArHashMapIter *iter) {
+    return iter->map != NULL && iter->index < iter->map->desc.capacity && iter->curr_node != NULL;
+}
+
+void *ar_hash_map_iter_get_key_ptr(const ArHashMapIter *iter) {
+    if (!ar_hash_map_iter_valid(iter)) {
+        return NULL;
+    }
+
+    return iter->curr_node->key;
+}
+
+void *ar_hash_map_iter_get_value_ptr(const ArHashMapIter *iter) {
+    if (!ar_hash_map_iter_valid(iter)) {
+        return NULL;
+    }
+
+    return iter->curr_node->value;
+}
+
+//
+// String interning
+//
+
+typedef struct _ArStrInternEntry _ArStrInternEntry;
+struct _ArStrInternEntry {
+    ArStr str;
+    U64 hash;
+};
+
+typedef struct _ArStrInternSlot _ArStrInternSlot;
+struct _ArStrInternSlot {
+    // Low bits of the hash, checked before touching the entry.
+    U32 hash;
+    // Zero for empty slots.
+    U32 id_plus_one;
+};
+
+struct ArStrIntern {
+    // String bytes, null-terminated.
+    ArArena *arena;
+    // Entries indexed by ID. Live in their own reservation, committed as
+    // they're added, so they never move and can be read without the lock.
+    _ArStrInternEntry *entries;
+    U32 count;
+    U32 max_count;
+
+    // Open addressing table, rebuilt from the entries when it grows.
+    ArArena *table_arena;
+    _ArStrInternSlot *slots;
+    U32 slot_count;
+
+    B8 thread_safe;
+    ArMutex mutex;
+};
+
+static void str_intern_table_build(ArStrIntern *intern, U32 slot_count) {
+    ar_arena_reset(intern->table_arena);
+    intern->slots = ar_arena_push_arr(intern->table_arena, _ArStrInternSlot, slot_count);
+    intern->slot_count = slot_count;
+
+    U32 mask = slot_count - 1;
+    for (U32 id = 0; id < intern->count; id++) {
+        U64 hash = intern->entries[id].hash;
+        U32 i = hash & mask;
+        while (intern->slots[i].id_plus_one != 0) {
+            i = (i + 1) & mask;
+        }
+        intern->slots[i] = (_ArStrInternSlot) {
+            .hash = hash,
+            .id_plus_one = id + 1,
+        };
+    }
+}
+
+ArStrIntern *ar_str_intern_create(ArStrInternDesc desc) {
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+        .name = ar_str_lit("str_intern"),
+    });
+    ArStrIntern *intern = ar_arena_push_type(arena, ArStrIntern);
+    intern->arena = arena;
+    intern->max_count = desc.max_count != 0 ? desc.max_count : AR_STR_INTERN_DEFAULT_MAX_COUNT;
+    intern->entries = ar_os_mem_reserve((U64) intern->max_count * sizeof(_ArStrInternEntry));
+    intern->table_arena = ar_arena_create_desc((ArArenaDesc) {
+        .name = ar_str_lit("str_intern_table"),
+    });
+
+    U32 slot_count = 16;
+    while (slot_count < desc.capacity * 2) {
+        slot_count *= 2;
+    }
+    str_intern_table_build(intern, slot_count);
+
+    intern->thread_safe = desc.thread_safe;
+    if (desc.thread_safe) {
+        intern->mutex = ar_mutex_create();
+    }
+
+    return intern;
+}
+
+void ar_str_intern_destroy(ArStrIntern **intern) {
+    if (*intern == NULL) {
+        return;
+    }
+
+    if ((*intern)->thread_safe) {
+        ar_mutex_destroy((*intern)->mutex);
+    }
+    ar_arena_destroy(&(*intern)->table_arena);
+    ar_os_mem_release((*intern)->entries);
+    // The intern itself lives in this arena.
+    ArArena *arena = (*intern)->arena;
+    ar_arena_destroy(&arena);
+    *intern = NULL;
+}
+
+// Slot holding 'str' or the empty slot it would go into.
+static _ArStrInternSlot *str_intern_probe(const ArStrIntern *intern, ArStr str, U64 hash) {
+    U32 mask = intern->slot_count - 1;
+    U32 i = hash & mask;
+    for (;;) {
+        _ArStrInternSlot *slot = &intern->slots[i];
+        if (slot->id_plus_one == 0) {
+            return slot;
+        }
+        if (slot->hash == (U32) hash) {
+            const _ArStrInternEntry *entry = &intern->entries[slot->id_plus_one - 1];
+            if (entry->hash == hash && entry->str.len == str.len && ar_memeq(entry->str.data, str.data, str.len)) {
+                return slot;
+            }
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+U32 ar_str_intern(ArStrIntern *intern, ArStr str) {
+    U64 hash = ar_fvn1a_hash(str.data, str.len);
+
+    if (intern->thread_safe) {
+        ar_mutex_lock(intern->mutex);
+    }
+
+    _ArStrInternSlot *slot = str_intern_probe(intern, str, hash);
+    U32 id = slot->id_plus_one - 1;
+    if (slot->id_plus_one == 0 && intern->count == intern->max_count) {
+        ar_err_emitf("String intern table is full, increase 'max_count' from %u.", intern->max_count);
+    } else if (slot->id_plus_one == 0) {
+        id = intern->count;
+
+        U8 *data = ar_arena_push_arr_no_zero(intern->arena, U8, str.len + 1);
+        memcpy(data, str.data, str.len);
+        data[str.len] = 0;
+
+        ar_os_mem_commit(intern->entries, sizeof(_ArStrInternEntry));
+        intern->entries[id] = (_ArStrInternEntry) {
+            .str = ar_str(data, str.len),
+            .hash = hash,
+        };
+        *slot = (_ArStrInternSlot) {
+            .hash = hash,
+            .id_plus_one = id + 1,
+        };
+        // Published last so lock free readers never see a half written entry.
+        __atomic_store_n(&intern->count, id + 1, __ATOMIC_RELEASE);
+
+        // Kept at most half full.
+        if (intern->count * 2 > intern->slot_count) {
+            str_intern_table_build(intern, intern->slot_count * 2);
+        }
+    }
+
+    if (intern->thread_safe) {
+        ar_mutex_unlock(intern->mutex);
+    }
+
+    return id;
+}
+
+U32 ar_str_intern_find(const ArStrIntern *intern, ArStr str) {
+    U64 hash = ar_fvn1a_hash(str.data, str.len);
+
+    if (intern->thread_safe) {
+        ar_mutex_lock(intern->mutex);
+    }
+
+    U32 id = str_intern_probe(intern, str, hash)->id_plus_one - 1;
+
+    if (intern->thread_safe) {
+        ar_mutex_unlock(intern->mutex);
+    }
+
+    return id;
+}
+
+ArStr ar_str_intern_get(const ArStrIntern *intern, U32 id) {
+    if (id >= __atomic_load_n(&intern->count, __ATOMIC_ACQUIRE)) {
+        return ar_str(NULL, 0);
+    }
+    return intern->entries[id].str;
+}
+
+U32 ar_str_intern_count(const ArStrIntern *intern) {
+    return __atomic_load_n(&intern->count, __ATOMIC_ACQUIRE);
+}
+
+//
+// Multi-pattern matching
+//
+
+// Transitions into states where some pattern ends are tagged with this bit,
+// keeping the output check out of the way of the hot loop.
+#define STR_MATCHER_OUTPUT_BIT ((U32) 1 << 31)
+#define STR_MATCHER_NONE U32_MAX
+
+struct ArStrMatcher {
+    ArStrMatchFlag flags;
+    // Bytes are mapped to classes first, bytes not in any pattern share
+    // class zero.
+    U16 class_map[256];
+    U32 class_count;
+
+    U32 state_count;
+    // state_count * class_count transitions, with failures already folded in
+    // so every byte is a single lookup.
+    U32 *transitions;
+    // First pattern ending in each state.
+    U32 *state_output;
+    // Closest state down the failure chain with patterns ending in it.
+    U32 *state_dict;
+
+    U32 pattern_count;
+    U64 *pattern_len;
+    // Next pattern ending in the same state.
+    U32 *pattern_next;
+};
+
+static U8 str_matcher_fold(const ArStrMatcher *matcher, U8 c) {
+    if (matcher->flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
+        return ar_char_to_lower(c);
+    }
+    return c;
+}
+
+ArStrMatcher *ar_str_matcher_create(ArArena *arena, ArStrList patterns, ArStrMatchFlag flags) {
+    ArStrMatcher *matcher = ar_arena_push_type(arena, ArStrMatcher);
+    matcher->flags = flags;
+
+    U64 total_len = 0;
+    for (ArStrListNode *node = patterns.first; node != NULL; node = node->next) {
+        matcher->pattern_count++;
+        total_len += node->str.len;
+        for (U64 i = 0; i < node->str.len; i++) {
+            matcher->class_map[str_matcher_fold(matcher, node->str.data[i])] = 1;
+        }
+    }
+
+    U32 class_count = 1;
+    for (U32 c = 0; c < 256; c++) {
+        if (matcher->class_map[c]) {
+            matcher->class_map[c] = class_count;
+            class_count++;
+        }
+    }
+    if (flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) {
+        for (U32 c = 0; c < 256; c++) {
+            matcher->class_map[c] = matcher->class_map[(U8) ar_char_to_lower(c)];
+        }
+    }
+    matcher->class_count = class_count;
+
+    matcher->pattern_len = ar_arena_push_arr_no_zero(arena, U64, matcher->pattern_count);
+    matcher->pattern_next = ar_arena_push_arr_no_zero(arena, U32, matcher->pattern_count);
+
+    // The trie is built with sibling lists first, which only needs space per
+    // state. The dense table is allocated once the number of states is known.
+    ArTemp scratch = scratch_get_any(&arena, 1);
+    U64 max_states = total_len + 1;
+    U32 *first_child = ar_arena_push_arr_no_zero(scratch.arena, U32, max_states);
+    U32 *next_sibling = ar_arena_push_arr_no_zero(scratch.arena, U32, max_states);
+    U16 *state_class = ar_arena_push_arr_no_zero(scratch.arena, U16, max_states);
+    U32 *state_output = ar_arena_push_arr_no_zero(scratch.arena, U32, max_states);
+    first_child[0] = STR_MATCHER_NONE;
+    state_output[0] = STR_MATCHER_NONE;
+    U32 state_count = 1;
+
+    U32 pattern = 0;
+    for (ArStrListNode *node = patterns.first; node != NULL; node = node->next, pattern++) {
+        matcher->pattern_len[pattern] = node->str.len;
+        matcher->pattern_next[pattern] = STR_MATCHER_NONE;
+        if (node->str.len == 0) {
+            continue;
+        }
+
+        U32 state = 0;
+        for (U64 i = 0; i < node->str.len; i++) {
+            U16 c = matcher->class_map[node->str.data[i]];
+            U32 child = first_child[state];
+            while (child != STR_MATCHER_NONE && state_class[child] != c) {
+                child = next_sibling[child];
+            }
+            if (child == STR_MATCHER_NONE) {
+                // Premultiplied targets have to stay clear of the output bit.
+                if (((U64) state_count + 1) * class_count > STR_MATCHER_OUTPUT_BIT) {
+                    ar_err_emitf("Too many patterns for a matcher, %u states with %u byte classes don't fit.", state_count + 1, class_count);
+                    scratch_release_any(&scratch);
+                    return NULL;
+                }
+                child = state_count++;
+                first_child[child] = STR_MATCHER_NONE;
+                next_sibling[child] = first_child[state];
+                first_child[state] = child;
+                state_class[child] = c;
+                state_output[child] = STR_MATCHER_NONE;
+            }
+            state = child;
+        }
+
+        // Keeps the patterns of each state in list order.
+        U32 *tail = &state_output[state];
+        while (*tail != STR_MATCHER_NONE) {
+            tail = &matcher->pattern_next[*tail];
+        }
+        *tail = pattern;
+    }
+
+    // Zero means no edge, nothing points back at the root yet.
+    U32 *transitions = ar_arena_push_arr(arena, U32, (U64) state_count * class_count);
+    for (U32 state = 0; state < state_count; state++) {
+        for (U32 child = first_child[state]; child != STR_MATCHER_NONE; child = next_sibling[child]) {
+            transitions[state * class_count + state_class[child]] = child;
+        }
+    }
+    U32 *fail = ar_arena_push_arr(scratch.arena, U32, state_count);
+
+    // Breadth first, so failure targets are always finished before the
+    // states pointing at them.
+    U32 *state_dict = ar_arena_push_arr_no_zero(scratch.arena, U32, state_count);
+    U32 *queue = ar_arena_push_arr_no_zero(scratch.arena, U32, state_count);
+    U32 head = 0;
+    U32 tail = 0;
+    state_dict[0] = STR_MATCHER_NONE;
+    for (U32 c = 0; c < class_count; c++) {
+        U32 next = transitions[c];
+        if (next != 0) {
+            fail[next] = 0;
+            queue[tail++] = next;
+        }
+    }
+    while (head < tail) {
+        U32 state = queue[head++];
+        U32 f = fail[state];
+        state_dict[state] = state_output[f] != STR_MATCHER_NONE ? f : state_dict[f];
+
+        for (U32 c = 0; c < class_count; c++) {
+            U32 *edge = &transitions[state * class_count + c];
+            U32 fallback = transitions[f * class_count + c] & ~STR_MATCHER_OUTPUT_BIT;
+            if (*edge == 0) {
+                *edge = fallback;
+            } else {
+                fail[*edge] = fallback;
+                queue[tail++] = *edge;
+            }
+        }
+    }
+
+    // Every state's outputs are known now, tag the transitions into them.
+    // Targets are stored premultiplied by the class count so following a
+    // transition doesn't wait on a multiply.
+    for (U64 i = 0; i < (U64) state_count * class_count; i++) {
+        U32 target = transitions[i];
+        transitions[i] = target * class_count;
+        if (state_output[target] != STR_MATCHER_NONE || state_dict[target] != STR_MATCHER_NONE) {
+            transitions[i] |= STR_MATCHER_OUTPUT_BIT;
+        }
+    }
+
+    matcher->state_count = state_count;
+    matcher->transitions = transitions;
+    matcher->state_output = ar_arena_push_arr_no_zero(arena, U32, state_count);
+    memcpy(matcher->state_output, state_output, state_count * sizeof(U32));
+    matcher->state_dict = ar_arena_push_arr_no_zero(arena, U32, state_count);
+    memcpy(matcher->state_dict, state_dict, state_count * sizeof(U32));
+
+    scratch_release_any(&scratch);
+
+    return matcher;
+}
+
+U32 ar_str_matcher_pattern_count(const ArStrMatcher *matcher) {
+    return matcher->pattern_count;
+}
+
+// Emits the pending pattern and moves on to the next one ending at the same
+// position.
+static void str_matcher_iter_emit(ArStrMatcherIter *iter) {
+    const ArStrMatcher *matcher = iter->matcher;
+    U32 pattern = iter->pattern;
+    U64 len = matcher->pattern_len[pattern];
+    iter->match = (ArStrMatch) {
+        .pattern = pattern,
+        .offset = iter->pos - len,
+        .str = ar_str(iter->str.data + iter->pos - len, len),
+    };
+    iter->valid = true;
+
+    iter->pattern = matcher->pattern_next[pattern];
+    if (iter->pattern == STR_MATCHER_NONE) {
+        iter->out_state = matcher->state_dict[iter->out_state];
+        if (iter->out_state != STR_MATCHER_NONE) {
+            iter->pattern = matcher->state_output[iter->out_state];
+        }
+    }
+}
+
+ArStrMatcherIter ar_str_matcher_iter_init(const ArStrMatcher *matcher, ArStr str) {
+    ArStrMatcherIter iter = {
+        .matcher = matcher,
+        .str = str,
+        .pattern = STR_MATCHER_NONE,
+    };
+    ar_str_matcher_iter_next(&iter);
+    return iter;
+}
+
+void ar_str_matcher_iter_next(ArStrMatcherIter *iter) {
+    if (iter->pattern != STR_MATCHER_NONE) {
+        str_matcher_iter_emit(iter);
+        return;
+    }
+
+    const ArStrMatcher *matcher = iter->matcher;
+    const U32 *transitions = matcher->transitions;
+    const U16 *class_map = matcher->class_map;
+    const U8 *data = iter->str.data;
+    U64 len = iter->str.len;
+    U32 row = iter->row;
+    for (U64 pos = iter->pos; pos < len; pos++) {
+        row = transitions[row + class_map[data[pos]]];
+        if (row & STR_MATCHER_OUTPUT_BIT) {
+            row &= ~STR_MATCHER_OUTPUT_BIT;
+            iter->row = row;
+            iter->pos = pos + 1;
+            U32 state = row / matcher->class_count;
+            iter->out_state = matcher->state_output[state] != STR_MATCHER_NONE ? state : matcher->state_dict[state];
+            iter->pattern = matcher->state_output[iter->out_state];
+            str_matcher_iter_emit(iter);
+            return;
+        }
+    }
+
+    iter->row = row;
+    iter->pos = len;
+    iter->valid = false;
+}
+
+B8 ar_str_matcher_iter_valid(const ArStrMatcherIter *iter) {
+    return iter->valid;
+}
+
+ArStrMatch ar_str_matcher_iter_get(const ArStrMatcherIter *iter) {
+    return iter->match;
+}
+
+B8 ar_str_matcher_contains(const ArStrMatcher *matcher, ArStr str) {
+    ArStrMatcherIter iter = ar_str_matcher_iter_init(matcher, str);
+    return ar_str_matcher_iter_valid(&iter);
+}
+
+//
+// Regular expressions
+//
+
+// Patterns are parsed into a tree, then compiled twice: forwards for finding
+// where matches end and backwards for finding where they start. DFA states
+// are sets of program positions built the first time a transition is taken.
+
+#define REGEX_MAX_INSTS (1 << 16)
+#define REGEX_MAX_DEPTH 256
+#define REGEX_MAX_REPEAT 1000
+#define REGEX_REPEAT_INF U32_MAX
+#define REGEX_NO_POS U64_MAX
+#define REGEX_BUCKET_COUNT 4096
+// Transitions known to lead nowhere point here.
+#define REGEX_DEAD_STATE ((_ArRegexState *) 1)
+
+typedef enum {
+    REGEX_NODE_EMPTY,
+    REGEX_NODE_SET,
+    REGEX_NODE_CONCAT,
+    REGEX_NODE_ALT,
+    REGEX_NODE_REPEAT,
+    REGEX_NODE_CAPTURE,
+    REGEX_NODE_BEGIN,
+    REGEX_NODE_END,
+} _ArRegexNodeType;
+
+typedef struct _ArRegexNode _ArRegexNode;
+struct _ArRegexNode {
+    _ArRegexNodeType type;
+    // Set index for sets, group index for captures.
+    U32 index;
+    U32 min;
+    U32 max;
+    B8 greedy;
+    _ArRegexNode *first;
+    _ArRegexNode *last;
+    _ArRegexNode *next;
+    _ArRegexNode *prev;
+};
+
+typedef struct _ArRegexSet _ArRegexSet;
+struct _ArRegexSet {
+    U64 bits[4];
+};
+
+typedef enum {
+    // Consumes a byte in sets[y].
+    REGEX_OP_SET,
+    // Continues at x, then at y.
+    REGEX_OP_SPLIT,
+    REGEX_OP_JMP,
+    // Stores the position in capture slot y.
+    REGEX_OP_SAVE,
+    REGEX_OP_ASSERT_BEGIN,
+    REGEX_OP_ASSERT_END,
+    REGEX_OP_MATCH,
+} _ArRegexOp;
+
+typedef struct _ArRegexInst _ArRegexInst;
+struct _ArRegexInst {
+    _ArRegexOp op;
+    U32 x;
+    U32 y;
+};
+
+typedef struct _ArRegexProg _ArRegexProg;
+struct _ArRegexProg {
+    _ArRegexInst *insts;
+    U32 count;
+    // Start with and without the lazy '.*' in front.
+    U32 anchored_start;
+    U32 unanchored_start;
+};
+
+typedef struct _ArRegexState _ArRegexState;
+struct _ArRegexState {
+    _ArRegexState *hash_next;
+    U64 hash;
+    // SET and pending ASSERT_END instructions, highest priority first.
+    U32 *pcs;
+    U32 pc_count;
+    // A match ends right before the byte leading out of this state.
+    B8 match;
+    // Whether a match ends here if the string does: 0 unknown, 1 no, 2 yes.
+    U8 end_match;
+    // One per byte class, NULL until first taken.
+    _ArRegexState *next[];
+};
+
+typedef enum {
+    // Unanchored, stops threads below a match so the end found is the end
+    // of the leftmost first match.
+    REGEX_DFA_FORWARD,
+    // Anchored at the start, keeps every thread.
+    REGEX_DFA_ANCHORED,
+    // Runs the reversed program backwards from the end of a match.
+    REGEX_DFA_REVERSE,
+
+    REGEX_DFA_COUNT,
+} _ArRegexDfaKind;
+
+typedef struct _ArRegexDfa _ArRegexDfa;
+struct _ArRegexDfa {
+    const _ArRegexProg *prog;
+    U32 start_pc;
+    B8 longest;
+    // Start states when starting at the beginning of the string and not.
+    _ArRegexState *start[2];
+    _ArRegexState **buckets;
+};
+
+// Sparse set of program positions, iterated in insertion order.
+typedef struct _ArRegexSparse _ArRegexSparse;
+struct _ArRegexSparse {
+    U32 *dense;
+    U32 *sparse;
+    U32 count;
+};
+
+struct ArRegex {
+    ArArena *arena;
+    // DFA states, reset whenever they grow past 'cache_size'.
+    ArArena *cache;
+    U64 cache_size;
+    U64 cache_base;
+    U64 cache_reset_count;
+
+    U16 class_map[256];
+    U32 class_count;
+    // A byte from each class.
+    U8 class_byte[256];
+
+    _ArRegexSet *sets;
+    U32 capture_count;
+    _ArRegexProg forward;
+    _ArRegexProg reverse;
+    _ArRegexDfa dfas[REGEX_DFA_COUNT];
+
+    // Closure work space, sized for the larger program.
+    _ArRegexSparse visited;
+    U32 *stack;
+    U32 *pcs;
+};
+
+static B8 regex_set_has(const _ArRegexSet *set, U8 c) {
+    return (set->bits[c >> 6] >> (c & 63)) & 1;
+}
+
+static void regex_set_add(_ArRegexSet *set, U8 c) {
+    set->bits[c >> 6] |= (U64) 1 << (c & 63);
+}
+
+static void regex_set_add_range(_ArRegexSet *set, U8 first, U8 last) {
+    for (U32 c = first; c <= last; c++) {
+        regex_set_add(set, c);
+    }
+}
+
+static void regex_set_invert(_ArRegexSet *set) {
+    for (U32 i = 0; i < 4; i++) {
+        set->bits[i] = ~set->bits[i];
+    }
+}
+
+static void regex_set_merge(_ArRegexSet *set, const _ArRegexSet *other) {
+    for (U32 i = 0; i < 4; i++) {
+        set->bits[i] |= other->bits[i];
+    }
+}
+
+static void regex_set_fold(_ArRegexSet *set) {
+    for (U8 c = 'a'; c <= 'z'; c++) {
+        U8 upper = c - 'a' + 'A';
+        if (regex_set_has(set, c) || regex_set_has(set, upper)) {
+            regex_set_add(set, c);
+            regex_set_add(set, upper);
+        }
+    }
+}
+
+//
+// Parsing
+//
+
+typedef struct _ArRegexParser _ArRegexParser;
+struct _ArRegexParser {
+    ArArena *arena;
+    ArStr pattern;
+    U64 pos;
+    B8 case_insensitive;
+    U32 depth;
+    U32 capture_count;
+    _ArRegexSet *sets;
+    U32 set_count;
+    U32 set_capacity;
+    const char *error;
+};
+
+static _ArRegexNode *regex_node(_ArRegexParser *parser, _ArRegexNodeType type) {
+    _ArRegexNode *node = ar_arena_push_type(parser->arena, _ArRegexNode);
+    node->type = type;
+    return node;
+}
+
+static void regex_node_append(_ArRegexNode *parent, _ArRegexNode *child) {
+    child->prev = parent->last;
+    if (parent->last != NULL) {
+        parent->last->next = child;
+    } else {
+        parent->first = child;
+    }
+    parent->last = child;
+}
+
+static _ArRegexNode *regex_node_set(_ArRegexParser *parser, _ArRegexSet set) {
+    if (parser->case_insensitive) {
+        regex_set_fold(&set);
+    }
+    if (parser->set_count == parser->set_capacity) {
+        U32 capacity = parser->set_capacity * 2;
+        _ArRegexSet *sets = ar_arena_push_arr_no_zero(parser->arena, _ArRegexSet, capacity);
+        memcpy(sets, parser->sets, parser->set_count * sizeof(_ArRegexSet));
+        parser->sets = sets;
+        parser->set_capacity = capacity;
+    }
+    _ArRegexNode *node = regex_node(parser, REGEX_NODE_SET);
+    node->index = parser->set_count;
+    parser->sets[parser->set_count++] = set;
+    return node;
+}
+
+static B8 regex_parser_done(const _ArRegexParser *parser) {
+    return parser->pos >= parser->pattern.len;
+}
+
+static U8 regex_parser_peek(const _ArRegexParser *parser) {
+    return parser->pattern.data[parser->pos];
+}
+
+static I32 regex_hex_digit(U8 c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+// Parses the escape after a backslash. Shorthand classes are merged into
+// 'set', anything else is returned as a literal byte.
+static B8 regex_parse_escape(_ArRegexParser *parser, _ArRegexSet *set, B8 *is_class, U8 *literal) {
+    if (regex_parser_done(parser)) {
+        parser->error = "trailing backslash";
+        return false;
+    }
+    U8 c = parser->pattern.data[parser->pos++];
+    _ArRegexSet class = {0};
+    *is_class = true;
+    switch (c) {
+        case 'd':
+        case 'D':
+            regex_set_add_range(&class, '0', '9');
+            break;
+        case 'w':
+        case 'W':
+            regex_set_add_range(&class, '0', '9');
+            regex_set_add_range(&class, 'a', 'z');
+            regex_set_add_range(&class, 'A', 'Z');
+            regex_set_add(&class, '_');
+            break;
+        case 's':
+        case 'S':
+            regex_set_add_range(&class, '\t', '\r');
+            regex_set_add(&class, ' ');
+            break;
+        default:
+            *is_class = false;
+            break;
+    }
+    if (*is_class) {
+        if (c >= 'A' && c <= 'Z') {
+            regex_set_invert(&class);
+        }
+        regex_set_merge(set, &class);
+        return true;
+    }
+
+    switch (c) {
+        case 't': *literal = '\t'; return true;
+        case 'n': *literal = '\n'; return true;
+        case 'r': *literal = '\r'; return true;
+        case 'f': *literal = '\f'; return true;
+        case 'v': *literal = '\v'; return true;
+        case '0': *literal = '\0'; return true;
+        case 'x': {
+            I32 high = parser->pos + 1 < parser->pattern.len ? regex_hex_digit(parser->pattern.data[parser->pos]) : -1;
+            I32 low = high >= 0 ? regex_hex_digit(parser->pattern.data[parser->pos + 1]) : -1;
+            if (low < 0) {
+                parser->error = "expected two hex digits after \\x";
+                return false;
+            }
+            parser->pos += 2;
+            *literal = high << 4 | low;
+            return true;
+        }
+    }
+
+    if (ar_char_is_alpha(c) || ar_char_is_numeric(c)) {
+        parser->error = "unknown escape";
+        return false;
+    }
+    *literal = c;
+    return true;
+}
+
+static _ArRegexNode *regex_parse_class(_ArRegexParser *parser, B8 glob) {
+    _ArRegexSet set = {0};
+    B8 negate = false;
+    if (!regex_parser_done(parser) && (regex_parser_peek(parser) == '^' || (glob && regex_parser_peek(parser) == '!'))) {
+        negate = true;
+        parser->pos++;
+    }
+
+    B8 first = true;
+    for (;;) {
+        if (regex_parser_done(parser)) {
+            parser->error = "missing ]";
+            return NULL;
+        }
+        U8 c = parser->pattern.data[parser->pos++];
+        if (c == ']' && !first) {
+            break;
+        }
+        first = false;
+
+        if (c == '\\') {
+            B8 is_class;
+            if (!regex_parse_escape(parser, &set, &is_class, &c)) {
+                return NULL;
+            }
+            if (is_class) {
+                continue;
+            }
+        }
+
+        U8 last = c;
+        if (parser->pos + 1 < parser->pattern.len && regex_parser_peek(parser) == '-' && parser->pattern.data[parser->pos + 1] != ']') {
+            parser->pos++;
+            last = parser->pattern.data[parser->pos++];
+            if (last == '\\') {
+                B8 is_class;
+                if (!regex_parse_escape(parser, &set, &is_class, &last) || is_class) {
+                    parser->error = parser->error != NULL ? parser->error : "class shorthand used as a range end";
+                    return NULL;
+                }
+            }
+            if (last < c) {
+                parser->error = "range out of order";
+                return NULL;
+            }
+        }
+        regex_set_add_range(&set, c, last);
+    }
+
+    if (parser->case_insensitive) {
+        regex_set_fold(&set);
+    }
+    if (negate) {
+        regex_set_invert(&set);
+    }
+    // Glob classes stop at path separators like the wildcards do.
+    if (glob) {
+        set.bits['/' >> 6] &= ~((U64) 1 << ('/' & 63));
+    }
+    return regex_node_set(parser, set);
+}
+
+static _ArRegexNode *regex_parse_alt(_ArRegexParser *parser);
+
+// Parses the digits of a {n,m} repeat. Leaves 'pos' alone and returns false
+// if it isn't one, so the brace is taken literally.
+static B8 regex_parse_repeat(_ArRegexParser *parser, U32 *min, U32 *max) {
+    U64 pos = parser->pos + 1;
+    ArStr pattern = parser->pattern;
+    U64 values[2] = {0, 0};
+    U32 digits[2] = {0, 0};
+    U32 part = 0;
+    for (; pos < pattern.len; pos++) {
+        U8 c = pattern.data[pos];
+        if (c >= '0' && c <= '9') {
+            values[part] = ar_min(values[part] * 10 + (c - '0'), (U64) REGEX_MAX_REPEAT + 1);
+            digits[part]++;
+        } else if (c == ',' && part == 0) {
+            part = 1;
+        } else {
+            break;
+        }
+    }
+    if (pos >= pattern.len || pattern.data[pos] != '}' || digits[0] == 0) {
+        return false;
+    }
+
+    *min = values[0];
+    *max = part == 0 ? values[0] : (digits[1] == 0 ? REGEX_REPEAT_INF : values[1]);
+    parser->pos = pos + 1;
+    return true;
+}
+
+static _ArRegexNode *regex_parse_atom(_ArRegexParser *parser) {
+    U8 c = parser->pattern.data[parser->pos++];
+    _ArRegexSet set = {0};
+    switch (c) {
+        case '(': {
+            if (parser->depth++ == REGEX_MAX_DEPTH) {
+                parser->error = "groups nested too deeply";
+                return NULL;
+            }
+            _ArRegexNode *group = NULL;
+            if (!regex_parser_done(parser) && regex_parser_peek(parser) == '?') {
+                if (parser->pos + 1 >= parser->pattern.len || parser->pattern.data[parser->pos + 1] != ':') {
+                    parser->error = "unknown group type";
+                    return NULL;
+                }
+                parser->pos += 2;
+            } else {
+                group = regex_node(parser, REGEX_NODE_CAPTURE);
+                group->index = parser->capture_count++;
+            }
+            _ArRegexNode *node = regex_parse_alt(parser);
+            if (node == NULL) {
+                return NULL;
+            }
+            if (regex_parser_done(parser) || regex_parser_peek(parser) != ')') {
+                parser->error = "missing )";
+                return NULL;
+            }
+            parser->pos++;
+            parser->depth--;
+            if (group != NULL) {
+                regex_node_append(group, node);
+                return group;
+            }
+            return node;
+        }
+        case '[':
+            return regex_parse_class(parser, false);
+        case '.':
+            regex_set_invert(&set);
+            set.bits[0] &= ~((U64) 1 << '\n');
+            return regex_node_set(parser, set);
+        case '^':
+            return regex_node(parser, REGEX_NODE_BEGIN);
+        case '$':
+            return regex_node(parser, REGEX_NODE_END);
+        case '\\': {
+            B8 is_class;
+            if (!regex_parse_escape(parser, &set, &is_class, &c)) {
+                return NULL;
+            }
+            if (!is_class) {
+                regex_set_add(&set, c);
+            }
+            return regex_node_set(parser, set);
+        }
+        case '*':
+        case '+':
+        case '?':
+            parser->error = "nothing to repeat";
+            return NULL;
+        default:
+            regex_set_add(&set, c);
+            return regex_node_set(parser, set);
+    }
+}
+
+// Parses a quantifier if there is one.
+static B8 regex_parse_quantifier(_ArRegexParser *parser, U32 *min, U32 *max) {
+    if (regex_parser_done(parser)) {
+        return false;
+    }
+    switch (regex_parser_peek(parser)) {
+        case '*':
+            *min = 0;
+            *max = REGEX_REPEAT_INF;
+            break;
+        case '+':
+            *min = 1;
+            *max = REGEX_REPEAT_INF;
+            break;
+        case '?':
+            *min = 0;
+            *max = 1;
+            break;
+        case '{':
+            return regex_parse_repeat(parser, min, max);
+        default:
+            return false;
+    }
+    parser->pos++;
+    return true;
+}
+
+static _ArRegexNode *regex_parse_concat(_ArRegexParser *parser) {
+    _ArRegexNode *concat = regex_node(parser, REGEX_NODE_CONCAT);
+    while (!regex_parser_done(parser)) {
+        U8 c = regex_parser_peek(parser);
+        if (c == '|' || c == ')') {
+            break;
+        }
+
+        U32 min;
+        U32 max;
+        if (regex_parse_quantifier(parser, &min, &max)) {
+            parser->error = "nothing to repeat";
+            return NULL;
+        }
+        _ArRegexNode *atom = regex_parse_atom(parser);
+        if (atom == NULL) {
+            return NULL;
+        }
+
+        if (regex_parse_quantifier(parser, &min, &max)) {
+            if (min > REGEX_MAX_REPEAT || (max != REGEX_REPEAT_INF && max > REGEX_MAX_REPEAT)) {
+                parser->error = "repeat count too large";
+                return NULL;
+            }
+            if (max < min) {
+                parser->error = "repeat range out of order";
+                return NULL;
+            }
+            if (atom->type == REGEX_NODE_BEGIN || atom->type == REGEX_NODE_END) {
+                parser->error = "nothing to repeat";
+                return NULL;
+            }
+
+            _ArRegexNode *repeat = regex_node(parser, REGEX_NODE_REPEAT);
+            repeat->min = min;
+            repeat->max = max;
+            repeat->greedy = true;
+            if (!regex_parser_done(parser) && regex_parser_peek(parser) == '?') {
+                repeat->greedy = false;
+                parser->pos++;
+            }
+            regex_node_append(repeat, atom);
+            atom = repeat;
+
+            if (regex_parse_quantifier(parser, &min, &max)) {
+                parser->error = "multiple repeat";
+                return NULL;
+            }
+        }
+
+        regex_node_append(concat, atom);
+    }
+    return concat;
+}
+
+static _ArRegexNode *regex_parse_alt(_ArRegexParser *parser) {
+    _ArRegexNode *alt = regex_node(parser, REGEX_NODE_ALT);
+    for (;;) {
+        _ArRegexNode *concat = regex_parse_concat(parser);
+        if (concat == NULL) {
+            return NULL;
+        }
+        regex_node_append(alt, concat);
+        if (regex_parser_done(parser) || regex_parser_peek(parser) != '|') {
+            break;
+        }
+        parser->pos++;
+    }
+    return alt->first == alt->last ? alt->first : alt;
+}
+
+static _ArRegexNode *regex_parse_glob(_ArRegexParser *parser) {
+    _ArRegexNode *concat = regex_node(parser, REGEX_NODE_CONCAT);
+    regex_node_append(concat, regex_node(parser, REGEX_NODE_BEGIN));
+    while (!regex_parser_done(parser)) {
+        U8 c = parser->pattern.data[parser->pos++];
+        _ArRegexSet set = {0};
+        _ArRegexNode *node;
+        switch (c) {
+            case '*': {
+                regex_set_invert(&set);
+                if (!regex_parser_done(parser) && regex_parser_peek(parser) == '*') {
+                    while (!regex_parser_done(parser) && regex_parser_peek(parser) == '*') {
+                        parser->pos++;
+                    }
+                } else {
+                    set.bits['/' >> 6] &= ~((U64) 1 << ('/' & 63));
+                }
+                node = regex_node(parser, REGEX_NODE_REPEAT);
+                node->max = REGEX_REPEAT_INF;
+                node->greedy = true;
+                regex_node_append(node, regex_node_set(parser, set));
+            } break;
+            case '?':
+                regex_set_invert(&set);
+                set.bits['/' >> 6] &= ~((U64) 1 << ('/' & 63));
+                node = regex_node_set(parser, set);
+                break;
+            case '[':
+                node = regex_parse_class(parser, true);
+                break;
+            case '\\':
+                if (!regex_parser_done(parser)) {
+                    c = parser->pattern.data[parser->pos++];
+                }
+                regex_set_add(&set, c);
+                node = regex_node_set(parser, set);
+                break;
+            default:
+                regex_set_add(&set, c);
+                node = regex_node_set(parser, set);
+                break;
+        }
+        if (node == NULL) {
+            return NULL;
+        }
+        regex_node_append(concat, node);
+    }
+    regex_node_append(concat, regex_node(parser, REGEX_NODE_END));
+    return concat;
+}
+
+//
+// Compiling
+//
+
+// Instructions needed for 'node', saturating just past REGEX_MAX_INSTS so
+// nested repeats can't overflow.
+static U64 regex_node_size(const _ArRegexNode *node, B8 reverse) {
+    U64 size = 0;
+    switch (node->type) {
+        case REGEX_NODE_EMPTY:
+            break;
+        case REGEX_NODE_SET:
+        case REGEX_NODE_BEGIN:
+        case REGEX_NODE_END:
+            size = 1;
+            break;
+        case REGEX_NODE_CONCAT:
+            for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                size += regex_node_size(child, reverse);
+            }
+            break;
+        case REGEX_NODE_ALT:
+            for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                size += regex_node_size(child, reverse) + (child->next != NULL ? 2 : 0);
+            }
+            break;
+        case REGEX_NODE_CAPTURE:
+            size = regex_node_size(node->first, reverse) + (reverse ? 0 : 2);
+            break;
+        case REGEX_NODE_REPEAT: {
+            U64 child = regex_node_size(node->first, reverse);
+            if (node->max == REGEX_REPEAT_INF) {
+                size = node->min == 0 ? child + 2 : node->min * child + 1;
+            } else {
+                size = node->min * child + (U64) (node->max - node->min) * (child + 1);
+            }
+        } break;
+    }
+    return ar_min(size, (U64) REGEX_MAX_INSTS + 1);
+}
+
+// Whether 'node' can match without consuming anything.
+static B8 regex_node_nullable(const _ArRegexNode *node) {
+    switch (node->type) {
+        case REGEX_NODE_SET:
+            return false;
+        case REGEX_NODE_CONCAT:
+            for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                if (!regex_node_nullable(child)) {
+                    return false;
+                }
+            }
+            return true;
+        case REGEX_NODE_ALT:
+            for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                if (regex_node_nullable(child)) {
+                    return true;
+                }
+            }
+            return false;
+        case REGEX_NODE_CAPTURE:
+            return regex_node_nullable(node->first);
+        case REGEX_NODE_REPEAT:
+            return node->min == 0 || regex_node_nullable(node->first);
+        default:
+            return true;
+    }
+}
+
+typedef struct _ArRegexCompiler _ArRegexCompiler;
+struct _ArRegexCompiler {
+    _ArRegexInst *insts;
+    U32 count;
+    B8 reverse;
+};
+
+static U32 regex_emit(_ArRegexCompiler *compiler, _ArRegexOp op, U32 y) {
+    U32 pc = compiler->count++;
+    compiler->insts[pc] = (_ArRegexInst) {
+        .op = op,
+        .x = pc + 1,
+        .y = y,
+    };
+    return pc;
+}
+
+static void regex_compile_node(_ArRegexCompiler *compiler, const _ArRegexNode *node) {
+    _ArRegexInst *insts = compiler->insts;
+    switch (node->type) {
+        case REGEX_NODE_EMPTY:
+            break;
+        case REGEX_NODE_SET:
+            regex_emit(compiler, REGEX_OP_SET, node->index);
+            break;
+        // Running backwards the start of the string is where the scan ends.
+        case REGEX_NODE_BEGIN:
+            regex_emit(compiler, compiler->reverse ? REGEX_OP_ASSERT_END : REGEX_OP_ASSERT_BEGIN, 0);
+            break;
+        case REGEX_NODE_END:
+            regex_emit(compiler, compiler->reverse ? REGEX_OP_ASSERT_BEGIN : REGEX_OP_ASSERT_END, 0);
+            break;
+        case REGEX_NODE_CONCAT:
+            if (compiler->reverse) {
+                for (const _ArRegexNode *child = node->last; child != NULL; child = child->prev) {
+                    regex_compile_node(compiler, child);
+                }
+            } else {
+                for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                    regex_compile_node(compiler, child);
+                }
+            }
+            break;
+        case REGEX_NODE_ALT: {
+            // Jumps out of each branch are chained through 'y' and patched
+            // once the end is known.
+            U32 jumps = U32_MAX;
+            for (const _ArRegexNode *child = node->first; child != NULL; child = child->next) {
+                if (child->next == NULL) {
+                    regex_compile_node(compiler, child);
+                    break;
+                }
+                U32 split = regex_emit(compiler, REGEX_OP_SPLIT, 0);
+                regex_compile_node(compiler, child);
+                U32 jump = regex_emit(compiler, REGEX_OP_JMP, jumps);
+                jumps = jump;
+                insts[split].y = compiler->count;
+            }
+            while (jumps != U32_MAX) {
+                U32 next = insts[jumps].y;
+                insts[jumps].x = compiler->count;
+                insts[jumps].y = 0;
+                jumps = next;
+            }
+        } break;
+        case REGEX_NODE_CAPTURE:
+            if (compiler->reverse) {
+                regex_compile_node(compiler, node->first);
+            } else {
+                regex_emit(compiler, REGEX_OP_SAVE, node->index * 2);
+                regex_compile_node(compiler, node->first);
+                regex_emit(compiler, REGEX_OP_SAVE, node->index * 2 + 1);
+            }
+            break;
+        case REGEX_NODE_REPEAT: {
+            const _ArRegexNode *child = node->first;
+            // A nullable body looping straight back to the split would see
+            // its empty iteration die on the visited split and let a later
+            // alternative win, so compile it as (?:x+)? instead.
+            if (node->max == REGEX_REPEAT_INF && node->min == 0 && regex_node_nullable(child)) {
+                U32 split = regex_emit(compiler, REGEX_OP_SPLIT, 0);
+                U32 loop = compiler->count;
+                regex_compile_node(compiler, child);
+                U32 again = regex_emit(compiler, REGEX_OP_SPLIT, 0);
+                insts[again].x = node->greedy ? loop : again + 1;
+                insts[again].y = node->greedy ? again + 1 : loop;
+                insts[split].x = node->greedy ? loop : compiler->count;
+                insts[split].y = node->greedy ? compiler->count : loop;
+                break;
+            }
+            if (node->max == REGEX_REPEAT_INF && node->min == 0) {
+                U32 split = regex_emit(compiler, REGEX_OP_SPLIT, 0);
+                regex_compile_node(compiler, child);
+                U32 jump = regex_emit(compiler, REGEX_OP_JMP, 0);
+                insts[jump].x = split;
+                insts[split].x = node->greedy ? split + 1 : compiler->count;
+                insts[split].y = node->greedy ? compiler->count : split + 1;
+                break;
+            }
+
+            U32 copies = node->max == REGEX_REPEAT_INF ? node->min - 1 : node->min;
+            for (U32 i = 0; i < copies; i++) {
+                regex_compile_node(compiler, child);
+            }
+
+            if (node->max == REGEX_REPEAT_INF) {
+                U32 loop = compiler->count;
+                regex_compile_node(compiler, child);
+                U32 split = regex_emit(compiler, REGEX_OP_SPLIT, 0);
+                insts[split].x = node->greedy ? loop : split + 1;
+                insts[split].y = node->greedy ? split + 1 : loop;
+                break;
+            }
+
+            // Optional copies nest, skipping one skips the rest. The splits
+            // are chained through 'y' until the end is known.
+            U32 splits = U32_MAX;
+            for (U32 i = node->min; i < node->max; i++) {
+                U32 split = regex_emit(compiler, REGEX_OP_SPLIT, splits);
+                splits = split;
+                regex_compile_node(compiler, child);
+            }
+            while (splits != U32_MAX) {
+                U32 next = insts[splits].y;
+                insts[splits].x = node->greedy ? splits + 1 : compiler->count;
+                insts[splits].y = node->greedy ? compiler->count : splits + 1;
+                splits = next;
+            }
+        } break;
+    }
+}
+
+//
+// Matching
+//
+
+static void regex_sparse_clear(_ArRegexSparse *set) {
+    set->count = 0;
+}
+
+static B8 regex_sparse_has(const _ArRegexSparse *set, U32 value) {
+    U32 index = set->sparse[value];
+    return index < set->count && set->dense[index] == value;
+}
+
+static U32 regex_sparse_add(_ArRegexSparse *set, U32 value) {
+    set->sparse[value] = set->count;
+    set->dense[set->count] = value;
+    return set->count++;
+}
+
+static void regex_dfa_reset(ArRegex *regex) {
+    regex->cache_reset_count++;
+    ar_arena_pop(regex->cache, ar_arena_used(regex->cache) - regex->cache_base);
+    for (U32 i = 0; i < REGEX_DFA_COUNT; i++) {
+        _ArRegexDfa *dfa = &regex->dfas[i];
+        dfa->start[0] = NULL;
+        dfa->start[1] = NULL;
+        memset(dfa->buckets, 0, REGEX_BUCKET_COUNT * sizeof(_ArRegexState *));
+    }
+}
+
+// Follows empty transitions from 'pc', adding the SET and pending
+// ASSERT_END instructions reached to regex->pcs. Returns true if the match
+// instruction was reached. With 'cut' nothing below the match is followed.
+static B8 regex_closure(ArRegex *regex, const _ArRegexProg *prog, U32 pc, B8 at_begin, B8 at_end, B8 cut, U32 *pc_count) {
+    B8 matched = false;
+    U32 top = 0;
+    regex->stack[top++] = pc;
+    while (top > 0) {
+        pc = regex->stack[--top];
+        if (regex_sparse_has(&regex->visited, pc)) {
+            continue;
+        }
+        regex_sparse_add(&regex->visited, pc);
+
+        const _ArRegexInst *inst = &prog->insts[pc];
+        switch (inst->op) {
+            case REGEX_OP_SET:
+                regex->pcs[(*pc_count)++] = pc;
+                break;
+            case REGEX_OP_SPLIT:
+                regex->stack[top++] = inst->y;
+                regex->stack[top++] = inst->x;
+                break;
+            case REGEX_OP_JMP:
+            case REGEX_OP_SAVE:
+                regex->stack[top++] = inst->x;
+                break;
+            case REGEX_OP_ASSERT_BEGIN:
+                if (at_begin) {
+                    regex->stack[top++] = inst->x;
+                }
+                break;
+            case REGEX_OP_ASSERT_END:
+                if (at_end) {
+                    regex->stack[top++] = inst->x;
+                } else {
+                    regex->pcs[(*pc_count)++] = pc;
+                }
+                break;
+            case REGEX_OP_MATCH:
+                matched = true;
+                if (cut) {
+                    top = 0;
+                }
+                break;
+        }
+    }
+    return matched;
+}
+
+static _ArRegexState *regex_dfa_state(ArRegex *regex, _ArRegexDfa *dfa, U32 pc_count, B8 match) {
+    if (pc_count == 0 && !match) {
+        return REGEX_DEAD_STATE;
+    }
+
+    U64 hash = ar_fvn1a_hash(regex->pcs, pc_count * sizeof(U32)) ^ match;
+    _ArRegexState **bucket = &dfa->buckets[hash % REGEX_BUCKET_COUNT];
+    for (_ArRegexState *state = *bucket; state != NULL; state = state->hash_next) {
+        if (state->hash == hash && state->match == match && state->pc_count == pc_count &&
+                memcmp(state->pcs, regex->pcs, pc_count * sizeof(U32)) == 0) {
+            return state;
+        }
+    }
+
+    U64 size = sizeof(_ArRegexState) + regex->class_count * sizeof(_ArRegexState *) + pc_count * sizeof(U32);
+    if (ar_arena_used(regex->cache) - regex->cache_base + size > regex->cache_size) {
+        regex_dfa_reset(regex);
+    }
+
+    _ArRegexState *state = ar_arena_push(regex->cache, size);
+    state->hash = hash;
+    state->match = match;
+    state->pc_count = pc_count;
+    state->pcs = (U32 *) &state->next[regex->class_count];
+    memcpy(state->pcs, regex->pcs, pc_count * sizeof(U32));
+    state->hash_next = *bucket;
+    *bucket = state;
+    return state;
+}
+
+static _ArRegexState *regex_dfa_start(ArRegex *regex, _ArRegexDfa *dfa, B8 at_begin) {
+    if (dfa->start[at_begin] == NULL) {
+        regex_sparse_clear(&regex->visited);
+        U32 pc_count = 0;
+        B8 match = regex_closure(regex, dfa->prog, dfa->start_pc, at_begin, false, !dfa->longest, &pc_count);
+        dfa->start[at_begin] = regex_dfa_state(regex, dfa, pc_count, match);
+    }
+    return dfa->start[at_begin];
+}
+
+// Builds the state reached from 'state' on a byte of class 'c'.
+static _ArRegexState *regex_dfa_step(ArRegex *regex, _ArRegexDfa *dfa, _ArRegexState *state, U32 c) {
+    const _ArRegexProg *prog = dfa->prog;
+    U8 byte = regex->class_byte[c];
+    regex_sparse_clear(&regex->visited);
+    U32 pc_count = 0;
+    B8 match = false;
+    for (U32 i = 0; i < state->pc_count; i++) {
+        const _ArRegexInst *inst = &prog->insts[state->pcs[i]];
+        if (inst->op != REGEX_OP_SET || !regex_set_has(&regex->sets[inst->y], byte)) {
+            continue;
+        }
+        // Threads below a match are lower priority than it, so with leftmost
+        // first matching they are dropped.
+        if (regex_closure(regex, prog, inst->x, false, false, !dfa->longest, &pc_count)) {
+            match = true;
+            if (!dfa->longest) {
+                break;
+            }
+        }
+    }
+
+    U64 reset_count = regex->cache_reset_count;
+    _ArRegexState *next = regex_dfa_state(regex, dfa, pc_count, match);
+    // A reset frees 'state' along with everything else.
+    if (regex->cache_reset_count == reset_count) {
+        state->next[c] = next;
+    }
+    return next;
+}
+
+static B8 regex_dfa_end_match(ArRegex *regex, _ArRegexDfa *dfa, _ArRegexState *state) {
+    if (state->end_match == 0) {
+        B8 match = state->match;
+        regex_sparse_clear(&regex->visited);
+        U32 pc_count = 0;
+        for (U32 i = 0; i < state->pc_count && !match; i++) {
+            if (dfa->prog->insts[state->pcs[i]].op == REGEX_OP_ASSERT_END) {
+                match = regex_closure(regex, dfa->prog, state->pcs[i], false, true, false, &pc_count);
+            }
+        }
+        state->end_match = match ? 2 : 1;
+    }
+    return state->end_match == 2;
+}
+
+#define regex_dfa_next(regex, dfa, state, byte) ({ \
+    U32 _c = (regex)->class_map[(byte)]; \
+    _ArRegexState *_next = (state)->next[_c]; \
+    if (_next == NULL) { \
+        _next = regex_dfa_step((regex), (dfa), (state), _c); \
+    } \
+    _next; \
+})
+
+// End of the leftmost first match, or REGEX_NO_POS. With 'first' it stops
+// at the first match seen.
+static U64 regex_dfa_forward(ArRegex *regex, ArStr str, B8 first) {
+    _ArRegexDfa *dfa = &regex->dfas[REGEX_DFA_FORWARD];
+    _ArRegexState *state = regex_dfa_start(regex, dfa, true);
+    U64 end = REGEX_NO_POS;
+    if (state->match) {
+        end = 0;
+        if (first) {
+            return end;
+        }
+    }
+    for (U64 pos = 0; pos < str.len; pos++) {
+        state = regex_dfa_next(regex, dfa, state, str.data[pos]);
+        if (state == REGEX_DEAD_STATE) {
+            return end;
+        }
+        if (state->match) {
+            end = pos + 1;
+            if (first) {
+                return end;
+            }
+        }
+    }
+    if (regex_dfa_end_match(regex, dfa, state)) {
+        end = str.len;
+    }
+    return end;
+}
+
+// Start of the longest match ending at 'end'.
+static U64 regex_dfa_reverse(ArRegex *regex, ArStr str, U64 end) {
+    _ArRegexDfa *dfa = &regex->dfas[REGEX_DFA_REVERSE];
+    _ArRegexState *state = regex_dfa_start(regex, dfa, end == str.len);
+    U64 start = state->match ? end : REGEX_NO_POS;
+    for (U64 pos = end; pos > 0; pos--) {
+        state = regex_dfa_next(regex, dfa, state, str.data[pos - 1]);
+        if (state == REGEX_DEAD_STATE) {
+            return start;
+        }
+        if (state->match) {
+            start = pos - 1;
+        }
+    }
+    if (regex_dfa_end_match(regex, dfa, state)) {
+        start = 0;
+    }
+    return start;
+}
+
+// Pike VM over the forward program, only run for the captures of a match
+// already found by the DFAs.
+typedef struct _ArRegexThreads _ArRegexThreads;
+struct _ArRegexThreads {
+    _ArRegexSparse set;
+    U64 *slots;
+};
+
+static void regex_pike_add(ArRegex *regex, _ArRegexThreads *threads, U32 pc, U64 *slots, U64 pos, U64 len) {
+    const _ArRegexProg *prog = &regex->forward;
+    U32 slot_count = regex->capture_count * 2;
+    // Entries are a position, or a slot to restore with the high bit set
+    // followed by its old value split in two.
+    U32 *stack = regex->stack;
+    U32 top = 0;
+    stack[top++] = pc;
+    while (top > 0) {
+        U32 entry = stack[--top];
+        if (entry & ((U32) 1 << 31)) {
+            top -= 2;
+            slots[entry & ~((U32) 1 << 31)] = (U64) stack[top] << 32 | stack[top + 1];
+            continue;
+        }
+        pc = entry;
+        if (regex_sparse_has(&threads->set, pc)) {
+            continue;
+        }
+        U32 index = regex_sparse_add(&threads->set, pc);
+
+        const _ArRegexInst *inst = &prog->insts[pc];
+        switch (inst->op) {
+            case REGEX_OP_SET:
+            case REGEX_OP_MATCH:
+                memcpy(&threads->slots[(U64) index * slot_count], slots, slot_count * sizeof(U64));
+                break;
+            case REGEX_OP_SPLIT:
+                stack[top++] = inst->y;
+                stack[top++] = inst->x;
+                break;
+            case REGEX_OP_JMP:
+                stack[top++] = inst->x;
+                break;
+            case REGEX_OP_SAVE:
+                stack[top++] = slots[inst->y] >> 32;
+                stack[top++] = (U32) slots[inst->y];
+                stack[top++] = inst->y | ((U32) 1 << 31);
+                slots[inst->y] = pos;
+                stack[top++] = inst->x;
+                break;
+            case REGEX_OP_ASSERT_BEGIN:
+                if (pos == 0) {
+                    stack[top++] = inst->x;
+                }
+                break;
+            case REGEX_OP_ASSERT_END:
+                if (pos == len) {
+                    stack[top++] = inst->x;
+                }
+                break;
+        }
+    }
+}
+
+static void regex_pike(ArRegex *regex, ArStr str, U64 start, U64 *result) {
+    const _ArRegexProg *prog = &regex->forward;
+    U32 slot_count = regex->capture_count * 2;
+
+    ArTemp scratch = scratch_get_any(NULL, 0);
+    _ArRegexThreads lists[2];
+    for (U32 i = 0; i < 2; i++) {
+        lists[i].set.dense = ar_arena_push_arr_no_zero(scratch.arena, U32, prog->count);
+        lists[i].set.sparse = ar_arena_push_arr(scratch.arena, U32, prog->count);
+        lists[i].set.count = 0;
+        lists[i].slots = ar_arena_push_arr_no_zero(scratch.arena, U64, (U64) prog->count * slot_count);
+    }
+    U64 *slots = ar_arena_push_arr_no_zero(scratch.arena, U64, slot_count);
+    for (U32 i = 0; i < slot_count; i++) {
+        slots[i] = REGEX_NO_POS;
+        result[i] = REGEX_NO_POS;
+    }
+
+    _ArRegexThreads *current = &lists[0];
+    _ArRegexThreads *next = &lists[1];
+    regex_pike_add(regex, current, prog->anchored_start, slots, start, str.len);
+    for (U64 pos = start; current->set.count > 0; pos++) {
+        regex_sparse_clear(&next->set);
+        for (U32 i = 0; i < current->set.count; i++) {
+            const _ArRegexInst *inst = &prog->insts[current->set.dense[i]];
+            U64 *thread_slots = &current->slots[(U64) i * slot_count];
+            if (inst->op == REGEX_OP_MATCH) {
+                memcpy(result, thread_slots, slot_count * sizeof(U64));
+                break;
+            }
+            if (inst->op == REGEX_OP_SET && pos < str.len && regex_set_has(&regex->sets[inst->y], str.data[pos])) {
+                regex_pike_add(regex, next, inst->x, thread_slots, pos + 1, str.len);
+            }
+        }
+        _ArRegexThreads *temp = current;
+        current = next;
+        next = temp;
+    }
+
+    scratch_release_any(&scratch);
+}
+
+ArRegex *ar_regex_create(ArRegexDesc desc) {
+    ArTemp scratch = scratch_get_any(NULL, 0);
+    _ArRegexParser parser = {
+        .arena = scratch.arena,
+        .pattern = desc.pattern,
+        .case_insensitive = (desc.flags & AR_STR_MATCH_FLAG_CASE_INSENSITIVE) != 0,
+        .capture_count = 1,
+        .set_capacity = 16,
+    };
+    parser.sets = ar_arena_push_arr_no_zero(scratch.arena, _ArRegexSet, parser.set_capacity);
+    // Set zero is any byte, used by the unanchored prefix.
+    _ArRegexSet any;
+    memset(&any, 0xff, sizeof(any));
+    regex_node_set(&parser, any);
+
+    _ArRegexNode *root = desc.glob ? regex_parse_glob(&parser) : regex_parse_alt(&parser);
+    if (root != NULL && !regex_parser_done(&parser)) {
+        parser.error = "unmatched )";
+    }
+    U64 forward_size = 0;
+    U64 reverse_size = 0;
+    if (parser.error == NULL) {
+        // Forward adds the unanchored prefix, capture zero and the match,
+        // reverse only the match.
+        forward_size = regex_node_size(root, false) + 6;
+        reverse_size = regex_node_size(root, true) + 1;
+        if (forward_size > REGEX_MAX_INSTS) {
+            parser.error = "pattern too large";
+        }
+    }
+    if (parser.error != NULL) {
+        ar_err_emitf("Invalid %s '%.*s' at offset %llu: %s.", desc.glob ? "glob" : "regex",
+                (int) desc.pattern.len, desc.pattern.data, (unsigned long long) parser.pos, parser.error);
+        scratch_release_any(&scratch);
+        return NULL;
+    }
+
+    // Sized up front, arenas under ASAN poison their whole capacity.
+    U64 max_count = ar_max(forward_size, reverse_size);
+    U64 capacity = sizeof(ArRegex) + parser.set_count * sizeof(_ArRegexSet) +
+        (forward_size + reverse_size) * sizeof(_ArRegexInst) + (max_count * 7 + 1) * sizeof(U32) + KiB(4);
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+        .capacity = capacity,
+        .name = ar_str_lit("regex"),
+    });
+    ArRegex *regex = ar_arena_push_type(arena, ArRegex);
+    regex->arena = arena;
+    regex->capture_count = parser.capture_count;
+    regex->sets = ar_arena_push_arr_no_zero(arena, _ArRegexSet, parser.set_count);
+    memcpy(regex->sets, parser.sets, parser.set_count * sizeof(_ArRegexSet));
+
+    // Bytes no set tells apart share a class.
+    regex->class_count = 1;
+    for (U32 c = 1; c < 256; c++) {
+        for (U32 i = 0; i < parser.set_count; i++) {
+            if (regex_set_has(&parser.sets[i], c) != regex_set_has(&parser.sets[i], c - 1)) {
+                regex->class_byte[regex->class_count++] = c;
+                break;
+            }
+        }
+        regex->class_map[c] = regex->class_count - 1;
+    }
+
+    // Forward program: a lazy '.*' loop, the pattern wrapped in capture
+    // zero, then the match.
+    _ArRegexCompiler compiler = {
+        .insts = ar_arena_push_arr_no_zero(arena, _ArRegexInst, forward_size),
+    };
+    regex_emit(&compiler, REGEX_OP_SPLIT, 1);
+    compiler.insts[0].x = 3;
+    regex_emit(&compiler, REGEX_OP_SET, 0);
+    regex_emit(&compiler, REGEX_OP_JMP, 0);
+    compiler.insts[2].x = 0;
+    regex_emit(&compiler, REGEX_OP_SAVE, 0);
+    regex_compile_node(&compiler, root);
+    regex_emit(&compiler, REGEX_OP_SAVE, 1);
+    regex_emit(&compiler, REGEX_OP_MATCH, 0);
+    regex->forward = (_ArRegexProg) {
+        .insts = compiler.insts,
+        .count = compiler.count,
+        .anchored_start = 3,
+        .unanchored_start = 0,
+    };
+
+    compiler = (_ArRegexCompiler) {
+        .insts = ar_arena_push_arr_no_zero(arena, _ArRegexInst, reverse_size),
+        .reverse = true,
+    };
+    regex_compile_node(&compiler, root);
+    regex_emit(&compiler, REGEX_OP_MATCH, 0);
+    regex->reverse = (_ArRegexProg) {
+        .insts = compiler.insts,
+        .count = compiler.count,
+    };
+    scratch_release_any(&scratch);
+
+    // Every instruction can be visited once per closure and splits push two
+    // entries, captures push four.
+    regex->visited.dense = ar_arena_push_arr_no_zero(arena, U32, max_count);
+    regex->visited.sparse = ar_arena_push_arr(arena, U32, max_count);
+    regex->stack = ar_arena_push_arr_no_zero(arena, U32, max_count * 4 + 1);
+    regex->pcs = ar_arena_push_arr_no_zero(arena, U32, max_count);
+
+    regex->dfas[REGEX_DFA_FORWARD] = (_ArRegexDfa) {
+        .prog = &regex->forward,
+        .start_pc = regex->forward.unanchored_start,
+    };
+    regex->dfas[REGEX_DFA_ANCHORED] = (_ArRegexDfa) {
+        .prog = &regex->forward,
+        .start_pc = regex->forward.anchored_start,
+        .longest = true,
+    };
+    regex->dfas[REGEX_DFA_REVERSE] = (_ArRegexDfa) {
+        .prog = &regex->reverse,
+        .start_pc = 0,
+        .longest = true,
+    };
+
+    // Room for the buckets, a full cache and the state that didn't fit.
+    regex->cache_size = desc.cache_size != 0 ? desc.cache_size : AR_REGEX_DEFAULT_CACHE_SIZE;
+    U64 max_state_size = sizeof(_ArRegexState) + regex->class_count * sizeof(_ArRegexState *) + max_count * sizeof(U32);
+    regex->cache = ar_arena_create_desc((ArArenaDesc) {
+        .capacity = REGEX_DFA_COUNT * REGEX_BUCKET_COUNT * sizeof(_ArRegexState *) + regex->cache_size + max_state_size + KiB(4),
+        .name = ar_str_lit("regex_cache"),
+    });
+    for (U32 i = 0; i < REGEX_DFA_COUNT; i++) {
+        regex->dfas[i].buckets = ar_arena_push_arr(regex->cache, _ArRegexState *, REGEX_BUCKET_COUNT);
+    }
+    regex->cache_base = ar_arena_used(regex->cache);
+
+    return regex;
+}
+
+void ar_regex_destroy(ArRegex **regex) {
+    if (*regex == NULL) {
+        return;
+    }
+
+    ar_arena_destroy(&(*regex)->cache);
+    // The regex itself lives in this arena.
+    ArArena *arena = (*regex)->arena;
+    ar_arena_destroy(&arena);
+    *regex = NULL;
+}
+
+U32 ar_regex_capture_count(const ArRegex *regex) {
+    return regex->capture_count;
+}
+
+B8 ar_regex_match(ArRegex *regex, ArStr str) {
+    _ArRegexDfa *dfa = &regex->dfas[REGEX_DFA_ANCHORED];
+    _ArRegexState *state = regex_dfa_start(regex, dfa, true);
+    for (U64 pos = 0; pos < str.len; pos++) {
+        state = regex_dfa_next(regex, dfa, state, str.data[pos]);
+        if (state == REGEX_DEAD_STATE) {
+            return false;
+        }
+    }
+    return regex_dfa_end_match(regex, dfa, state);
+}
+
+B8 ar_regex_search(ArRegex *regex, ArStr str) {
+    return regex_dfa_forward(regex, str, true) != REGEX_NO_POS;
+}
+
+B8 ar_regex_find(ArRegex *regex, ArStr str, ArStr *captures, U32 capture_count) {
+    U64 end = regex_dfa_forward(regex, str, false);
+    if (end == REGEX_NO_POS) {
+        return false;
+    }
+    U64 start = regex_dfa_reverse(regex, str, end);
+    if (capture_count == 0) {
+        return true;
+    }
+
+    captures[0] = ar_str(str.data + start, end - start);
+    if (capture_count > 1 && regex->capture_count > 1) {
+        ArTemp scratch = scratch_get_any(NULL, 0);
+        U64 *slots = ar_arena_push_arr_no_zero(scratch.arena, U64, regex->capture_count * 2);
+        regex_pike(regex, str, start, slots);
+        for (U32 i = 1; i < capture_count && i < regex->capture_count; i++) {
+            U64 first = slots[i * 2];
+            U64 last = slots[i * 2 + 1];
+            captures[i] = first != REGEX_NO_POS && last != REGEX_NO_POS ? ar_str(str.data + first, last - first) : (ArStr) {0};
+        }
+        scratch_release_any(&scratch);
+    }
+    for (U32 i = regex->capture_count; i < capture_count; i++) {
+        captures[i] = (ArStr) {0};
+    }
+    return true;
+}
+
+//
+// Rope
+//
+// The tree is a treap keyed implicitly by position: every node holds one
+// piece of text and the byte length of its subtree, and node priorities are
+// random so the expected depth stays logarithmic. Edits split the tree at a
+// byte position and merge the parts back together.
+//
+
+typedef struct _ArRopeNode _ArRopeNode;
+struct _ArRopeNode {
+    _ArRopeNode *left;
+    _ArRopeNode *right;
+    ArStr piece;
+    // Bytes in this subtree.
+    U64 len;
+    U32 priority;
+};
+
+struct ArRope {
+    ArArena *arena;
+    _ArRopeNode *root;
+    _ArRopeNode *free_nodes;
+    // Inserted bytes are appended to the current chunk. An insert right
+    // after the previous one extends its piece instead of adding a node, so
+    // typing doesn't grow the tree.
+    U8 *add;
+    U64 add_len;
+    U64 add_capacity;
+    U32 rng;
+};
+
+#define ROPE_ADD_CHUNK_SIZE KiB(16)
+
+static U64 rope_node_len(const _ArRopeNode *node) {
+    return node != NULL ? node->len : 0;
+}
+
+static void rope_node_update(_ArRopeNode *node) {
+    node->len = rope_node_len(node->left) + node->piece.len + rope_node_len(node->right);
+}
+
+static _ArRopeNode *rope_node_create(ArRope *rope, ArStr piece) {
+    _ArRopeNode *node = rope->free_nodes;
+    if (node != NULL) {
+        rope->free_nodes = node->left;
+    } else {
+        node = ar_arena_push_type_no_zero(rope->arena, _ArRopeNode);
+    }
+
+    // xorshift32
+    rope->rng ^= rope->rng << 13;
+    rope->rng ^= rope->rng >> 17;
+    rope->rng ^= rope->rng << 5;
+    *node = (_ArRopeNode) {
+        .piece = piece,
+        .len = piece.len,
+        .priority = rope->rng,
+    };
+    return node;
+}
+
+static void rope_node_free(ArRope *rope, _ArRopeNode *node) {
+    if (node == NULL) {
+        return;
+    }
+    rope_node_free(rope, node->right);
+    _ArRopeNode *left = node->left;
+    node->left = rope->free_nodes;
+    rope->free_nodes = node;
+    rope_node_free(rope, left);
+}
+
+// Splits 'node' into the first 'pos' bytes and the rest. A piece straddling
+// 'pos' gets cut in two.
+static void rope_split(ArRope *rope, _ArRopeNode *node, U64 pos, _ArRopeNode **left, _ArRopeNode **right) {
+    if (node == NULL) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+
+    U64 left_len = rope_node_len(node->left);
+    if (pos <= left_len) {
+        rope_split(rope, node->left, pos, left, &node->left);
+        rope_node_update(node);
+        *right = node;
+    } else if (pos >= left_len + node->piece.len) {
+        rope_split(rope, node->right, pos - left_len - node->piece.len, &node->right, right);
+        rope_node_update(node);
+        *left = node;
+    } else {
+        U64 offset = pos - left_len;
+        _ArRopeNode *tail = rope_node_create(rope, ar_str(node->piece.data + offset, node->piece.len - offset));
+        // Taking over the priority keeps the heap order with the right subtree.
+        tail->priority = node->priority;
+        tail->right = node->right;
+        rope_node_update(tail);
+
+        node->piece.len = offset;
+        node->right = NULL;
+        rope_node_update(node);
+        *left = node;
+        *right = tail;
+    }
+}
+
+static _ArRopeNode *rope_merge(_ArRopeNode *left, _ArRopeNode *right) {
+    if (left == NULL) {
+        return right;
+    }
+    if (right == NULL) {
+        return left;
+    }
+
+    if (left->priority >= right->priority) {
+        left->right = rope_merge(left->right, right);
+        rope_node_update(left);
+        return left;
+    }
+    right->left = rope_merge(left, right->left);
+    rope_node_update(right);
+    return right;
+}
+
+// Node holding byte 'pos', with 'pos' made relative to its piece.
+static const _ArRopeNode *rope_find(const _ArRopeNode *node, U64 *pos) {
+    while (node != NULL) {
+        U64 left_len = rope_node_len(node->left);
+        if (*pos < left_len) {
+            node = node->left;
+        } else if (*pos < left_len + node->piece.len) {
+            *pos -= left_len;
+            return node;
+        } else {
+            *pos -= left_len + node->piece.len;
+            node = node->right;
+        }
+    }
+    return NULL;
+}
+
+ArRope *ar_rope_init(ArArena *arena, ArStr str) {
+    ArRope *rope = ar_arena_push_type(arena, ArRope);
+    rope->arena = arena;
+    rope->rng = 0x9e3779b9;
+    if (str.len > 0) {
+        rope->root = rope_node_create(rope, str);
+    }
+    return rope;
+}
+
+U64 ar_rope_len(const ArRope *rope) {
+    return rope_node_len(rope->root);
+}
+
+void ar_rope_insert(ArRope *rope, U64 pos, ArStr str) {
+    if (str.len == 0) {
+        return;
+    }
+
+    _ArRopeNode *left;
+    _ArRopeNode *right;
+    rope_split(rope, rope->root, ar_min(pos, ar_rope_len(rope)), &left, &right);
+
+    // The piece ending right before 'pos' is the last one in 'left'.
+    _ArRopeNode *last = left;
+    while (last != NULL && last->right != NULL) {
+        last = last->right;
+    }
+
+    B8 fits = rope->add_capacity - rope->add_len >= str.len;
+    if (last != NULL && fits && last->piece.data + last->piece.len == rope->add + rope->add_len) {
+        memcpy(rope->add + rope->add_len, str.data, str.len);
+        rope->add_len += str.len;
+        last->piece.len += str.len;
+        for (_ArRopeNode *node = left; node != NULL; node = node->right) {
+            node->len += str.len;
+        }
+        rope->root = rope_merge(left, right);
+        return;
+    }
+
+    if (!fits) {
+        // Big inserts get their own allocation rather than a mostly unused
+        // chunk.
+        if (str.len > ROPE_ADD_CHUNK_SIZE / 4) {
+            U8 *data = ar_arena_push_arr_no_zero(rope->arena, U8, str.len);
+            memcpy(data, str.data, str.len);
+            _ArRopeNode *node = rope_node_create(rope, ar_str(data, str.len));
+            rope->root = rope_merge(rope_merge(left, node), right);
+            return;
+        }
+        rope->add = ar_arena_push_arr_no_zero(rope->arena, U8, ROPE_ADD_CHUNK_SIZE);
+        rope->add_len = 0;
+        rope->add_capacity = ROPE_ADD_CHUNK_SIZE;
+    }
+
+    U8 *data = rope->add + rope->add_len;
+    memcpy(data, str.data, str.len);
+    rope->add_len += str.len;
+    _ArRopeNode *node = rope_node_create(rope, ar_str(data, str.len));
+    rope->root = rope_merge(rope_merge(left, node), right);
+}
+
+void ar_rope_delete(ArRope *rope, U64 pos, U64 len) {
+    U64 rope_len = ar_rope_len(rope);
+    pos = ar_min(pos, rope_len);
+    len = ar_min(len, rope_len - pos);
+    if (len == 0) {
+        return;
+    }
+
+    _ArRopeNode *left;
+    _ArRopeNode *rest;
+    _ArRopeNode *middle;
+    _ArRopeNode *right;
+    rope_split(rope, rope->root, pos, &left, &rest);
+    rope_split(rope, rest, len, &middle, &right);
+    rope_node_free(rope, middle);
+    rope->root = rope_merge(left, right);
+}
+
+U8 ar_rope_get(const ArRope *rope, U64 index) {
+    U64 pos = index;
+    const _ArRopeNode *node = rope_find(rope->root, &pos);
+    return node != NULL ? node->piece.data[pos] : 0;
+}
+
+static U8 *rope_flatten(const _ArRopeNode *node, U8 *out) {
+    while (node != NULL) {
+        out = rope_flatten(node->left, out);
+        memcpy(out, node->piece.data, node->piece.len);
+        out += node->piece.len;
+        node = node->right;
+    }
+    return out;
+}
+
+ArStr ar_rope_flatten(ArArena *arena, const ArRope *rope) {
+    U64 len = ar_rope_len(rope);
+    U8 *data = ar_arena_push_arr_no_zero(arena, U8, len);
+    rope_flatten(rope->root, data);
+    return ar_str(data, len);
+}
+
+ArRopeIter ar_rope_iter_init(const ArRope *rope, U64 pos, U64 len) {
+    U64 rope_len = ar_rope_len(rope);
+    pos = ar_min(pos, rope_len);
+    ArRopeIter iter = {
+        .rope = rope,
+        .pos = pos,
+        .end = pos + ar_min(len, rope_len - pos),
+    };
+    ar_rope_iter_next(&iter);
+    return iter;
+}
+
+void ar_rope_iter_next(ArRopeIter *iter) {
+    if (iter->pos >= iter->end) {
+        iter->chunk = (ArStr) {0};
+        iter->valid = false;
+        return;
+    }
+
+    U64 offset = iter->pos;
+    const _ArRopeNode *node = rope_find(iter->rope->root, &offset);
+    U64 len = ar_min(node->piece.len - offset, iter->end - iter->pos);
+    iter->chunk = ar_str(node->piece.data + offset, len);
+    iter->pos += len;
+    iter->valid = true;
+}
+
+B8 ar_rope_iter_valid(const ArRopeIter *iter) {
+    return iter->valid;
+}
+
+ArStr ar_rope_iter_get(const ArRopeIter *iter) {
+    return iter->chunk;
+}
+
+//
+// Radix tree
+//
+// Children are tagged pointers, leaves having the low bit set. Every inner
+// node keeps its whole compressed path as a slice of some leaf's key, and a
+// key ending right at a node sits in the node's leaf slot instead of a child.
+//
+
+typedef struct _ArRadixLeaf _ArRadixLeaf;
+struct _ArRadixLeaf {
+    ArStr key;
+    void *value;
+};
+
+typedef enum {
+    _AR_RADIX_NODE4,
+    _AR_RADIX_NODE16,
+    _AR_RADIX_NODE48,
+    _AR_RADIX_NODE256,
+} _ArRadixNodeType;
+
+typedef struct _ArRadixNode _ArRadixNode;
+struct _ArRadixNode {
+    _ArRadixNodeType type;
+    U32 count;
+    // Bytes shared by every key below the node, after the byte leading to it.
+    ArStr prefix;
+    _ArRadixLeaf *leaf;
+};
+
+// Node4 and node16 keep their keys sorted.
+typedef struct _ArRadixNode4 _ArRadixNode4;
+struct _ArRadixNode4 {
+    _ArRadixNode base;
+    U8 keys[4];
+    void *children[4];
+};
+
+typedef struct _ArRadixNode16 _ArRadixNode16;
+struct _ArRadixNode16 {
+    _ArRadixNode base;
+    U8 keys[16];
+    void *children[16];
+};
+
+typedef struct _ArRadixNode48 _ArRadixNode48;
+struct _ArRadixNode48 {
+    _ArRadixNode base;
+    // Child slot + 1 for every byte, 0 if there's no child. Slots are kept
+    // packed at the front.
+    U8 index[256];
+    void *children[48];
+};
+
+typedef struct _ArRadixNode256 _ArRadixNode256;
+struct _ArRadixNode256 {
+    _ArRadixNode base;
+    void *children[256];
+};
+
+struct ArRadixTree {
+    ArArena *arena;
+    void *root;
+    U64 count;
+};
+
+ARKIN_INLINE B8 radix_is_leaf(const void *child) {
+    return ((U64) child & 1) != 0;
+}
+
+ARKIN_INLINE _ArRadixLeaf *radix_leaf(const void *child) {
+    return (_ArRadixLeaf *) ((U64) child & ~(U64) 1);
+}
+
+ARKIN_INLINE void *radix_leaf_tag(_ArRadixLeaf *leaf) {
+    return (void *) ((U64) leaf | 1);
+}
+
+static _ArRadixLeaf *radix_leaf_create(ArRadixTree *tree, ArStr key, void *value) {
+    _ArRadixLeaf *leaf = ar_arena_push_type_no_zero(tree->arena, _ArRadixLeaf);
+    leaf->key = ar_str_push_copy(tree->arena, key);
+    leaf->value = value;
+    tree->count++;
+    return leaf;
+}
+
+static _ArRadixNode *radix_node_create(ArRadixTree *tree, ArStr prefix) {
+    _ArRadixNode *node = ar_arena_push_type(tree->arena, _ArRadixNode4);
+    node->type = _AR_RADIX_NODE4;
+    node->prefix = prefix;
+    return node;
+}
+
+// Number of leading bytes 'a' and 'b' have in common.
+static U64 radix_common_len(const U8 *a, U64 a_len, const U8 *b, U64 b_len) {
+    U64 len = ar_min(a_len, b_len);
+    U64 i = 0;
+    while (i < len && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+static B8 radix_has_prefix(ArStr str, ArStr prefix) {
+    return str.len >= prefix.len && (prefix.len == 0 || memcmp(str.data, prefix.data, prefix.len) == 0);
+}
+
+static void **radix_find_child(const _ArRadixNode *node, U8 byte) {
+    switch (node->type) {
+        case _AR_RADIX_NODE4: {
+            _ArRadixNode4 *n = (_ArRadixNode4 *) node;
+            for (U32 i = 0; i < node->count; i++) {
+                if (n->keys[i] == byte) {
+                    return &n->children[i];
+                }
+            }
+            return NULL;
+        }
+        case _AR_RADIX_NODE16: {
+            _ArRadixNode16 *n = (_ArRadixNode16 *) node;
+#ifdef ARKIN_STR_SIMD_X86
+            __m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8(byte), _mm_loadu_si128((const __m128i *) n->keys));
+            U32 mask = _mm_movemask_epi8(eq) & ((1u << node->count) - 1);
+            return mask != 0 ? &n->children[__builtin_ctz(mask)] : NULL;
+#else
+            for (U32 i = 0; i < node->count; i++) {
+                if (n->keys[i] == byte) {
+                    return &n->children[i];
+                }
+            }
+            return NULL;
+#endif
+        }
+        case _AR_RADIX_NODE48: {
+            _ArRadixNode48 *n = (_ArRadixNode48 *) node;
+            U8 slot = n->index[byte];
+            return slot != 0 ? &n->children[slot - 1] : NULL;
+        }
+        case _AR_RADIX_NODE256: {
+            _ArRadixNode256 *n = (_ArRadixNode256 *) node;
+            return n->children[byte] != NULL ? &n->children[byte] : NULL;
+        }
+    }
+    return NULL;
+}
+
+// First child with a byte of 'from' or above, in byte order.
+static void *radix_next_child(const _ArRadixNode *node, U32 from, U8 *byte) {
+    const U8 *keys = NULL;
+    void *const *children = NULL;
+    switch (node->type) {
+        case _AR_RADIX_NODE4:
+            keys = ((const _ArRadixNode4 *) node)->keys;
+            children = ((const _ArRadixNode4 *) node)->children;
+            break;
+        case _AR_RADIX_NODE16:
+            keys = ((const _ArRadixNode16 *) node)->keys;
+            children = ((const _ArRadixNode16 *) node)->children;
+            break;
+        case _AR_RADIX_NODE48: {
+            const _ArRadixNode48 *n = (const _ArRadixNode48 *) node;
+            for (U32 b = from; b < 256; b++) {
+                if (n->index[b] != 0) {
+                    *byte = b;
+                    return n->children[n->index[b] - 1];
+                }
+            }
+            return NULL;
+        }
+        case _AR_RADIX_NODE256: {
+            const _ArRadixNode256 *n = (const _ArRadixNode256 *) node;
+            for (U32 b = from; b < 256; b++) {
+                if (n->children[b] != NULL) {
+                    *byte = b;
+                    return n->children[b];
+                }
+            }
+            return NULL;
+        }
+    }
+
+    for (U32 i = 0; i < node->count; i++) {
+        if (keys[i] >= from) {
+            *byte = keys[i];
+            return children[i];
+        }
+    }
+    return NULL;
+}
+
+// Replaces the full node at 'ref' with one of the next size up.
+static _ArRadixNode *radix_node_grow(ArRadixTree *tree, void **ref) {
+    _ArRadixNode *node = *ref;
+    _ArRadixNode *grown = NULL;
+    switch (node->type) {
+        case _AR_RADIX_NODE4: {
+            _ArRadixNode4 *old = (_ArRadixNode4 *) node;
+            _ArRadixNode16 *n = ar_arena_push_type(tree->arena, _ArRadixNode16);
+            memcpy(n->keys, old->keys, sizeof(old->keys));
+            memcpy(n->children, old->children, sizeof(old->children));
+            grown = &n->base;
+            *grown = *node;
+            grown->type = _AR_RADIX_NODE16;
+        } break;
+        case _AR_RADIX_NODE16: {
+            _ArRadixNode16 *old = (_ArRadixNode16 *) node;
+            _ArRadixNode48 *n = ar_arena_push_type(tree->arena, _ArRadixNode48);
+            for (U32 i = 0; i < node->count; i++) {
+                n->index[old->keys[i]] = i + 1;
+                n->children[i] = old->children[i];
+            }
+            grown = &n->base;
+            *grown = *node;
+            grown->type = _AR_RADIX_NODE48;
+        } break;
+        case _AR_RADIX_NODE48: {
+            _ArRadixNode48 *old = (_ArRadixNode48 *) node;
+            _ArRadixNode256 *n = ar_arena_push_type(tree->arena, _ArRadixNode256);
+            for (U32 b = 0; b < 256; b++) {
+                if (old->index[b] != 0) {
+                    n->children[b] = old->children[old->index[b] - 1];
+                }
+            }
+            grown = &n->base;
+            *grown = *node;
+            grown->type = _AR_RADIX_NODE256;
+        } break;
+        case _AR_RADIX_NODE256:
+            return node;
+    }
+    *ref = grown;
+    return grown;
+}
+
+static void radix_sorted_insert(U8 *keys, void **children, U32 count, U8 byte, void *child) {
+    U32 i = count;
+    while (i > 0 && keys[i - 1] > byte) {
+        keys[i] = keys[i - 1];
+        children[i] = children[i - 1];
+        i--;
+    }
+    keys[i] = byte;
+    children[i] = child;
+}
+
+static void radix_add_child(ArRadixTree *tree, void **ref, U8 byte, void *child) {
+    _ArRadixNode *node = *ref;
+    static const U32 capacities[] = {4, 16, 48, 256};
+    if (node->count == capacities[node->type]) {
+        node = radix_node_grow(tree, ref);
+    }
+
+    switch (node->type) {
+        case _AR_RADIX_NODE4: {
+            _ArRadixNode4 *n = (_ArRadixNode4 *) node;
+            radix_sorted_insert(n->keys, n->children, node->count, byte, child);
+        } break;
+        case _AR_RADIX_NODE16: {
+            _ArRadixNode16 *n = (_ArRadixNode16 *) node;
+            radix_sorted_insert(n->keys, n->children, node->count, byte, child);
+        } break;
+        case _AR_RADIX_NODE48: {
+            _ArRadixNode48 *n = (_ArRadixNode48 *) node;
+            n->children[node->count] = child;
+            n->index[byte] = node->count + 1;
+        } break;
+        case _AR_RADIX_NODE256: {
+            _ArRadixNode256 *n = (_ArRadixNode256 *) node;
+            n->children[byte] = child;
+        } break;
+    }
+    node->count++;
+}
+
+static void radix_remove_child(_ArRadixNode *node, U8 byte) {
+    U8 *keys = NULL;
+    void **children = NULL;
+    switch (node->type) {
+        case _AR_RADIX_NODE4:
+            keys = ((_ArRadixNode4 *) node)->keys;
+            children = ((_ArRadixNode4 *) node)->children;
+            break;
+        case _AR_RADIX_NODE16:
+            keys = ((_ArRadixNode16 *) node)->keys;
+            children = ((_ArRadixNode16 *) node)->children;
+            break;
+        case _AR_RADIX_NODE48: {
+            _ArRadixNode48 *n = (_ArRadixNode48 *) node;
+            // Moves the last slot into the freed one to keep them packed.
+            U32 slot = n->index[byte] - 1;
+            U32 last = node->count - 1;
+            if (slot != last) {
+                for (U32 b = 0; b < 256; b++) {
+                    if (n->index[b] == last + 1) {
+                        n->index[b] = slot + 1;
+                        break;
+                    }
+                }
+                n->children[slot] = n->children[last];
+            }
+            n->index[byte] = 0;
+            n->children[last] = NULL;
+            node->count--;
+            return;
+        }
+        case _AR_RADIX_NODE256:
+            ((_ArRadixNode256 *) node)->children[byte] = NULL;
+            node->count--;
+            return;
+    }
+
+    U32 i = 0;
+    while (keys[i] != byte) {
+        i++;
+    }
+    memmove(keys + i, keys + i + 1, node->count - i - 1);
+    memmove(children + i, children + i + 1, (node->count - i - 1) * sizeof(void *));
+    node->count--;
+}
+
+// Puts 'leaf' below the node at 'ref', whose path is 'depth' bytes long.
+static void radix_place(ArRadixTree *tree, void **ref, _ArRadixLeaf *leaf, U64 depth) {
+    _ArRadixNode *node = *ref;
+    if (leaf->key.len == depth) {
+        node->leaf = leaf;
+    } else {
+        radix_add_child(tree, ref, leaf->key.data[depth], radix_leaf_tag(leaf));
+    }
+}
+
+static _ArRadixLeaf *radix_find_leaf(const ArRadixTree *tree, ArStr key) {
+    const void *child = tree->root;
+    U64 depth = 0;
+    while (child != NULL) {
+        if (radix_is_leaf(child)) {
+            _ArRadixLeaf *leaf = radix_leaf(child);
+            return ar_str_match(leaf->key, key, AR_STR_MATCH_FLAG_EXACT) ? leaf : NULL;
+        }
+
+        const _ArRadixNode *node = child;
+        if (key.len - depth < node->prefix.len || !ar_memeq(node->prefix.data, key.data + depth, node->prefix.len)) {
+            return NULL;
+        }
+        depth += node->prefix.len;
+        if (depth == key.len) {
+            return node->leaf;
+        }
+
+        void **next = radix_find_child(node, key.data[depth]);
+        child = next != NULL ? *next : NULL;
+        depth++;
+    }
+    return NULL;
+}
+
+static const _ArRadixLeaf *radix_minimum_from(const _ArRadixNode *node, U32 from);
+
+// Smallest key below 'child'.
+static const _ArRadixLeaf *radix_minimum(const void *child) {
+    if (radix_is_leaf(child)) {
+        return radix_leaf(child);
+    }
+    const _ArRadixNode *node = child;
+    if (node->leaf != NULL) {
+        return node->leaf;
+    }
+    return radix_minimum_from(node, 0);
+}
+
+// Smallest key below the children of 'node' with a byte of 'from' or above.
+// Removals can leave nodes without any keys, so those get skipped.
+static const _ArRadixLeaf *radix_minimum_from(const _ArRadixNode *node, U32 from) {
+    U8 byte;
+    for (void *child = radix_next_child(node, from, &byte);
+            child != NULL;
+            child = byte < 255 ? radix_next_child(node, byte + 1, &byte) : NULL) {
+        const _ArRadixLeaf *leaf = radix_minimum(child);
+        if (leaf != NULL) {
+            return leaf;
+        }
+    }
+    return NULL;
+}
+
+// Smallest key below 'child' that sorts after 'key'.
+static const _ArRadixLeaf *radix_first_after(const void *child, ArStr key, U64 depth) {
+    if (child == NULL) {
+        return NULL;
+    }
+    if (radix_is_leaf(child)) {
+        const _ArRadixLeaf *leaf = radix_leaf(child);
+        U64 common = radix_common_len(leaf->key.data, leaf->key.len, key.data, key.len);
+        B8 after = common == key.len ? leaf->key.len > key.len : common < leaf->key.len && leaf->key.data[common] > key.data[common];
+        return after ? leaf : NULL;
+    }
+
+    const _ArRadixNode *node = child;
+    U64 rest = key.len - depth;
+    U64 common = radix_common_len(node->prefix.data, node->prefix.len, key.data + depth, rest);
+    if (common < node->prefix.len) {
+        // Either the key ran out and everything below is longer, or the
+        // first differing byte decides for the whole subtree.
+        if (common == rest || node->prefix.data[common] > key.data[depth + common]) {
+            return radix_minimum(child);
+        }
+        return NULL;
+    }
+
+    depth += node->prefix.len;
+    // The node's own key is either 'key' itself or a prefix of it, neither
+    // sorts after it.
+    if (depth == key.len) {
+        return radix_minimum_from(node, 0);
+    }
+    U8 byte = key.data[depth];
+    void **next = radix_find_child(node, byte);
+    if (next != NULL) {
+        const _ArRadixLeaf *leaf = radix_first_after(*next, key, depth + 1);
+        if (leaf != NULL) {
+            return leaf;
+        }
+    }
+    return radix_minimum_from(node, (U32) byte + 1);
+}
+
+ArRadixTree *ar_radix_tree_init(ArArena *arena) {
+    ArRadixTree *tree = ar_arena_push_type(arena, ArRadixTree);
+    tree->arena = arena;
+    return tree;
+}
+
+U64 ar_radix_tree_count(const ArRadixTree *tree) {
+    return tree->count;
+}
+
+void ar_radix_tree_set(ArRadixTree *tree, ArStr key, void *value) {
+    void **ref = &tree->root;
+    U64 depth = 0;
+    for (;;) {
+        void *child = *ref;
+        if (child == NULL) {
+            *ref = radix_leaf_tag(radix_leaf_create(tree, key, value));
+            return;
+        }
+
+        if (radix_is_leaf(child)) {
+            _ArRadixLeaf *leaf = radix_leaf(child);
+            if (ar_str_match(leaf->key, key, AR_STR_MATCH_FLAG_EXACT)) {
+                leaf->value = value;
+                return;
+            }
+
+            // Both keys go below a new node holding the rest of their common
+            // prefix.
+            _ArRadixLeaf *new_leaf = radix_leaf_create(tree, key, value);
+            U64 common = radix_common_len(leaf->key.data + depth, leaf->key.len - depth, key.data + depth, key.len - depth);
+            *ref = radix_node_create(tree, ar_str(new_leaf->key.data + depth, common));
+            radix_place(tree, ref, leaf, depth + common);
+            radix_place(tree, ref, new_leaf, depth + common);
+            return;
+        }
+
+        _ArRadixNode *node = child;
+        U64 common = radix_common_len(node->prefix.data, node->prefix.len, key.data + depth, key.len - depth);
+        if (common < node->prefix.len) {
+            // Splits the compressed path where the key leaves it.
+            U8 byte = node->prefix.data[common];
+            *ref = radix_node_create(tree, ar_str(node->prefix.data, common));
+            node->prefix = ar_str(node->prefix.data + common + 1, node->prefix.len - common - 1);
+            radix_add_child(tree, ref, byte, node);
+            radix_place(tree, ref, radix_leaf_create(tree, key, value), depth + common);
+            return;
+        }
+
+        depth += node->prefix.len;
+        if (depth == key.len) {
+            if (node->leaf != NULL) {
+                node->leaf->value = value;
+            } else {
+                node->leaf = radix_leaf_create(tree, key, value);
+            }
+            return;
+        }
+
+        void **next = radix_find_child(node, key.data[depth]);
+        if (next == NULL) {
+            radix_add_child(tree, ref, key.data[depth], radix_leaf_tag(radix_leaf_create(tree, key, value)));
+            return;
+        }
+        ref = next;
+        depth++;
+    }
+}
+
+B8 ar_radix_tree_remove(ArRadixTree *tree, ArStr key) {
+    void *child = tree->root;
+    _ArRadixNode *parent = NULL;
+    U8 byte = 0;
+    U64 depth = 0;
+    while (child != NULL) {
+        if (radix_is_leaf(child)) {
+            if (!ar_str_match(radix_leaf(child)->key, key, AR_STR_MATCH_FLAG_EXACT)) {
+                return false;
+            }
+            if (parent != NULL) {
+                radix_remove_child(parent, byte);
+            } else {
+                tree->root = NULL;
+            }
+            tree->count--;
+            return true;
+        }
+
+        _ArRadixNode *node = child;
+        if (key.len - depth < node->prefix.len || !ar_memeq(node->prefix.data, key.data + depth, node->prefix.len)) {
+            return false;
+        }
+        depth += node->prefix.len;
+        if (depth == key.len) {
+            if (node->leaf == NULL) {
+                return false;
+            }
+            node->leaf = NULL;
+            tree->count--;
+            return true;
+        }
+
+        byte = key.data[depth];
+        void **next = radix_find_child(node, byte);
+        child = next != NULL ? *next : NULL;
+        parent = node;
+        depth++;
+    }
+    return false;
+}
+
+void *ar_radix_tree_get(const ArRadixTree *tree, ArStr key) {
+    _ArRadixLeaf *leaf = radix_find_leaf(tree, key);
+    return leaf != NULL ? leaf->value : NULL;
+}
+
+void *ar_radix_tree_longest_prefix(const ArRadixTree *tree, ArStr key, ArStr *match) {
+    const _ArRadixLeaf *best = NULL;
+    const void *child = tree->root;
+    U64 depth = 0;
+    while (child != NULL) {
+        if (radix_is_leaf(child)) {
+            const _ArRadixLeaf *leaf = radix_leaf(child);
+            if (radix_has_prefix(key, leaf->key)) {
+                best = leaf;
+            }
+            break;
+        }
+
+        const _ArRadixNode *node = child;
+        if (key.len - depth < node->prefix.len || !ar_memeq(node->prefix.data, key.data + depth, node->prefix.len)) {
+            break;
+        }
+        depth += node->prefix.len;
+        if (node->leaf != NULL) {
+            best = node->leaf;
+        }
+        if (depth == key.len) {
+            break;
+        }
+
+        void **next = radix_find_child(node, key.data[depth]);
+        child = next != NULL ? *next : NULL;
+        depth++;
+    }
+
+    if (match != NULL) {
+        *match = best != NULL ? best->key : (ArStr) {0};
+    }
+    return best != NULL ? best->value : NULL;
+}
+
+static void radix_iter_check(ArRadixTreeIter *iter) {
+    const _ArRadixLeaf *leaf = iter->leaf;
+    if (leaf != NULL && !radix_has_prefix(leaf->key, iter->prefix)) {
+        iter->leaf = NULL;
+    }
+}
+
+ArRadixTreeIter ar_radix_tree_iter_init(const ArRadixTree *tree, ArStr prefix) {
+    ArRadixTreeIter iter = {
+        .tree = tree,
+        .prefix = prefix,
+    };
+    // The prefix itself sorts before every other key starting with it.
+    iter.leaf = radix_find_leaf(tree, prefix);
+    if (iter.leaf == NULL) {
+        iter.leaf = radix_first_after(tree->root, prefix, 0);
+    }
+    radix_iter_check(&iter);
+    return iter;
+}
+
+void ar_radix_tree_iter_next(ArRadixTreeIter *iter) {
+    const _ArRadixLeaf *leaf = iter->leaf;
+    iter->leaf = radix_first_after(iter->tree->root, leaf->key, 0);
+    radix_iter_check(iter);
+}
+
+B8 ar_radix_tree_iter_valid(const ArRadixTreeIter *iter) {
+    return iter->leaf != NULL;
+}
+
+ArStr ar_radix_tree_iter_key(const ArRadixTreeIter *iter) {
+    return ((const _ArRadixLeaf *) iter->leaf)->key;
+}
+
+void *ar_radix_tree_iter_value(const ArRadixTreeIter *iter) {
+    return ((const _ArRadixLeaf *) iter->leaf)->value;
+}
+
+//
+// Pool allocator
+//
+
+// [64-bit handle]: [32-bit generation][32-bit index]
+
+typedef struct ArPoolFreeObject ArPoolFreeObject;
+struct ArPoolFreeObject {
+    ArPoolFreeObject *next;
+    U32 index;
+};
+
+struct ArPool {
+    void *pool;
+    U32 *generation;
+    B8 *used;
+    U32 *free_list;
+    U32 free_list_next;
+    U32 next_index;
+    U64 object_size;
+    U32 capacity;
+};
+
+ArPool *ar_pool_init(ArArena *arena, U32 capacity, U64 object_size) {
+    ArPool *pool = ar_arena_push_type_no_zero(arena, ArPool);
+    *pool = (ArPool) {
+        .pool = ar_arena_push_no_zero(arena, object_size * capacity),
+        .generation = ar_arena_push_arr(arena, U32, capacity),
+        .used = ar_arena_push_arr(arena, B8, capacity),
+        .free_list = ar_arena_push_arr(arena, U32, capacity),
+        .object_size = object_size,
+        .capacity = capacity,
+    };
+
+    return pool;
+}
+
+ArPoolHandle ar_pool_handle_create(ArPool *pool) {
+    // Out of space.
+    if (pool->free_list_next == 0 && pool->next_index == pool->capacity) {
+        return AR_POOL_HANDLE_INVALID;
+    }
+
+    U32 index = pool->next_index;
+    if (pool->free_list_next != 0) {
+        index = pool->free_list[pool->free_list_next - 1];
+        pool->free_list_next--;
+    } else {
+        pool->next_index++;
+    }
+
+    pool->used[index] = true;
+    U32 generation = pool->generation[index];
+    memset(pool->pool + index * pool->object_size, 0, pool->object_size);
+
+    return (ArPoolHandle) {
+        .handle = ((U64) generation) << 32 | index,
+    };
+}
+
+void ar_pool_handle_destroy(ArPool *pool, ArPoolHandle handle) {
+    if (!ar_pool_handle_valid(pool, handle)) {
+        return;
+    }
+
+    U32 index = (U32) handle.handle;
+
+    pool->used[index] = false;
+    pool->generation[index]++;
+    pool->free_list[pool->free_list_next] = index;
+    pool->free_list_next++;
+}
+
+B8 ar_pool_handle_valid(const ArPool *pool, ArPoolHandle handle) {
+    U32 generation = (U32) (handle.handle >> 32);
+    U32 index = (U32) handle.handle;
+
+    return handle.handle != AR_POOL_HANDLE_INVALID.handle &&
+        index < pool->next_index &&
+        generation == pool->generation[index] &&
+        pool->used[index];
+}
+
+void *ar_pool_handle_to_ptr(const ArPool *pool, ArPoolHandle handle) {
+    if (!ar_pool_handle_valid(pool, handle)) {
+        return NULL;
+    }
+
+    U32 index = (U32) handle.handle;
+    return pool->pool + index * pool->object_size;
+}
+
+ArPoolHandle ar_pool_iter_init(const ArPool *pool) {
+    for (U32 i = 0; i < pool->capacity; i++) {
+        if (pool->used[i]) {
+            return (ArPoolHandle) {
+                .handle = (U64) pool->generation[i] << 32 | i,
+            };
+        }
+    }
+
+    return AR_POOL_HANDLE_INVALID;
+}
+
+B8 ar_pool_iter_valid(const ArPool *pool, ArPoolHandle iter) {
+    return ar_pool_handle_valid(pool, iter);
+}
+
+ArPoolHandle ar_pool_iter_next(const ArPool *pool, ArPoolHandle iter) {
+    for (U32 i = ((U32) iter.handle) + 1; i < pool->capacity; i++) {
+        if (pool->used[i]) {
+            return (ArPoolHandle) {
+                .handle = (U64) pool->generation[i] << 32 | i,
+            };
+        }
+    }
+
+    return AR_POOL_HANDLE_INVALID;
+}
+
+//
+// Error handling
+//
+
+void ar_err_accum_begin(ArErrAccumType type) {
+    _ArErrVars *vars = thread_ctx_err_vars();
+    if (vars == NULL) {
+        return;
+    }
+
+    _ArErrAccumulator *accum = ar_arena_push_type(vars->arena, _ArErrAccumulator);
+    accum->type = type;
+    ar_sll_stack_push(vars->accum_stack, accum);
+}
+
+ArErr *ar_err_accum_end(ArArena *arena) {
+    if (_ar_thread_ctx_curr == NULL) {
+        return NULL;
+    }
+
+    _ArErrVars *vars = &_ar_thread_ctx_curr->err;
+    _ArErrAccumulator *accum = vars->accum_stack;
+    if (accum == NULL) {
+        return NULL;
+    }
+
+    ArErr *result = NULL;
+
+    switch (accum->type) {
         case AR_ERR_ACCUM_TYPE_IGNORE:
             break;
-        case AR_ERR_ACCUM_TYPE_FIRST: {
-            result = ar_arena_push_type(arena, ArErr);
-            result->str = ar_str_push_copy(arena, accum->stack->str);
+        case AR_ERR_ACCUM_TYPE_FIRST: {
+            result = ar_arena_push_type(arena, ArErr);
+            result->str = ar_str_push_copy(arena, accum->stack->str);
+        }
+        case AR_ERR_ACCUM_TYPE_STACK: {
+            ArErr *stack = NULL;
+            for (ArErr *node = accum->stack; node != NULL; node = node->next) {
+                ArErr *err = ar_arena_push_type_no_zero(arena, ArErr);
+                err->str = ar_str_push_copy(arena, node->str);
+                ar_sll_stack_push(stack, err);
+            }
+            result = stack;
+        }
+    }
+
+    ar_sll_stack_pop(vars->accum_stack);
+    if (vars->accum_stack == NULL) {
+        ar_arena_reset(vars->arena);
+    }
+
+    return result;
+}
+
+void ar_err_emit(ArStr str) {
+    if (_ar_thread_ctx_curr == NULL) {
+        return;
+    }
+
+    _ArErrVars vars = _ar_thread_ctx_curr->err;
+    if (vars.accum_stack == NULL) {
+        _ar_core.error.callback(str);
+        return;
+    }
+
+    _ArErrAccumulator *accum = vars.accum_stack;
+    if (accum->type == AR_ERR_ACCUM_TYPE_IGNORE) {
+        return;
+    }
+
+    ArErr *err = ar_arena_push_type_no_zero(vars.arena, ArErr);
+    err->str = ar_str_push_copy(vars.arena, str);
+    ar_sll_stack_push(accum->stack, err);
+}
+
+void ar_err_emitf(const char *fmt, ...) {
+    _ArErrVars *vars = thread_ctx_err_vars();
+    if (vars == NULL) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, fmt);
+    ArStr formatted = ar_str_pushfv(vars->arena, fmt, args);
+    va_end(args);
+
+    if (vars->accum_stack == NULL) {
+        _ar_core.error.callback(formatted);
+        ar_arena_pop(vars->arena, formatted.len);
+        return;
+    }
+
+    _ArErrAccumulator *accum = vars->accum_stack;
+    if (accum->type == AR_ERR_ACCUM_TYPE_IGNORE) {
+        return;
+    }
+
+    ArErr *err = ar_arena_push_type_no_zero(vars->arena, ArErr);
+    err->str = formatted;
+    ar_sll_stack_push(accum->stack, err);
+}
+
+//
+// Platform
+//
+
+#ifdef ARKIN_OS_LINUX
+
+#include <unistd.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include <dirent.h>
+#include <limits.h>
+
+// ArIoVec is handed to writev as struct iovec.
+typedef char _ar_iovec_layout_check[
+    sizeof(ArIoVec) == sizeof(struct iovec) &&
+    offsetof(ArIoVec, base) == offsetof(struct iovec, iov_base) &&
+    offsetof(ArIoVec, len) == offsetof(struct iovec, iov_len) ? 1 : -1];
+
+typedef struct _ArOsAllocInfo _ArOsAllocInfo;
+struct _ArOsAllocInfo {
+    U64 size;
+    U64 requested_commited;
+    U64 commited;
+    // Reservation the allocation was carved out of. NULL if the allocation
+    // owns its own mapping.
+    ArReservation *reservation;
+};
+
+// Every slot handed out is followed by a PROT_NONE guard page, so running off
+// the end of one faults instead of corrupting its neighbour. Free blocks keep
+// the same layout, readable and writable except for the guard page they end
+// with, and their size includes it.
+typedef struct _ArReservationBlock _ArReservationBlock;
+struct _ArReservationBlock {
+    _ArReservationBlock *next;
+    U64 size;
+};
+
+struct ArReservation {
+    U8 *base;
+    U64 size;
+    U64 position;
+    // Sorted by address so neighbours can be merged on release.
+    _ArReservationBlock *free_list;
+    pthread_mutex_t mutex;
+};
+
+typedef struct _ArOsThread _ArOsThread;
+struct _ArOsThread {
+    pthread_t thread_id;
+    ArThreadFunc func;
+    void *args;
+};
+
+typedef struct _ArOsMutex _ArOsMutex;
+struct _ArOsMutex {
+    pthread_mutex_t pmutex;
+};
+
+typedef struct _ArOsState _ArOsState;
+struct _ArOsState {
+    struct {
+        U32 seconds;
+        U32 microseconds;
+    } start_time;
+    U32 page_size;
+
+    ArArena *os_arena;
+
+    ArPool *mutex_pool;
+    ArPool *thread_pool;
+
+    ArMutex mutex_pool_mutex;
+    ArMutex thread_pool_mutex;
+};
+static _ArOsState _ar_os_state = {0};
+
+// Mutexes the library takes from the pool for itself: the two pool mutexes
+// and the thread context pool's.
+#define OS_INTERNAL_MUTEX_COUNT 3
+
+static void _ar_os_init(U32 thread_pool_cap, U32 mutex_pool_cap) {
+    _ar_os_state = (_ArOsState) {0};
+
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    _ar_os_state.start_time.seconds = ts.tv_sec;
+    _ar_os_state.start_time.microseconds = ts.tv_nsec / 1000;
+
+    _ar_os_state.page_size = sysconf(_SC_PAGE_SIZE);
+
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+            .name = ar_str_lit("os"),
+        });
+    _ar_os_state.os_arena = arena;
+
+    _ar_os_state.mutex_pool = ar_pool_init(arena, mutex_pool_cap + OS_INTERNAL_MUTEX_COUNT, sizeof(_ArOsMutex));
+    _ar_os_state.thread_pool = ar_pool_init(arena, thread_pool_cap, sizeof(_ArOsThread));
+
+    _ar_os_state.mutex_pool_mutex = ar_mutex_create();
+    _ar_os_state.thread_pool_mutex = ar_mutex_create();
+}
+
+static void _ar_os_terminate(void) {
+    for (ArPoolHandle iter = ar_pool_iter_init(_ar_os_state.mutex_pool);
+        ar_pool_iter_valid(_ar_os_state.mutex_pool, iter);
+        iter = ar_pool_iter_next(_ar_os_state.mutex_pool, iter)) {
+        ar_mutex_destroy((ArMutex) { .handle = iter });
+    }
+
+    ar_arena_destroy(&_ar_os_state.os_arena);
+}
+
+F64 ar_os_get_time(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (ts.tv_sec + ts.tv_nsec * 1e-9) - (_ar_os_state.start_time.seconds + _ar_os_state.start_time.microseconds * 1e-6);
+}
+
+U64 ar_os_get_time_microseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((ts.tv_sec - _ar_os_state.start_time.seconds) * 1000000 + (ts.tv_nsec / 1000) - _ar_os_state.start_time.microseconds);
+}
+
+U32 ar_os_page_size(void) {
+    return _ar_os_state.page_size;
+}
+
+void *ar_os_mem_reserve(U64 size) {
+    U32 page_size = ar_os_page_size();
+    size = align_to_value(size + sizeof(_ArOsAllocInfo), ar_os_page_size());
+
+    _ArOsAllocInfo *info = mmap(NULL, size + sizeof(_ArOsAllocInfo), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
+    madvise((U8 *) info + page_size, size - page_size, MADV_DONTNEED);
+    mprotect(info, page_size, PROT_READ | PROT_WRITE);
+    info->size = size;
+    info->commited = page_size;
+    info->requested_commited = sizeof(_ArOsAllocInfo);
+    info->reservation = NULL;
+
+    return &info[1];
+}
+
+void ar_os_mem_commit(void *ptr, U64 size) {
+    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
+    info->requested_commited += size;
+    U64 requested = align_to_value(info->requested_commited, ar_os_page_size());
+    if (requested > info->commited) {
+        // Reservations are mapped readable and writable from the start.
+        if (info->reservation == NULL) {
+            mprotect(info, requested, PROT_READ | PROT_WRITE);
+        }
+        info->commited = requested;
+    }
+}
+
+void ar_os_mem_decommit(void *ptr, U64 size) {
+    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
+
+    if (size > info->requested_commited) {
+        size = info->requested_commited;
+    }
+
+    info->requested_commited -= size;
+    if (info->requested_commited < sizeof(_ArOsAllocInfo)) {
+        info->requested_commited = sizeof(_ArOsAllocInfo);
+    }
+
+    U64 requested = align_to_value(info->requested_commited, ar_os_page_size());
+    if (requested < info->commited) {
+        if (info->reservation == NULL) {
+            mprotect((U8 *) ptr + requested, info->commited - requested, PROT_NONE);
+        } else {
+            madvise((U8 *) info + requested, info->commited - requested, MADV_DONTNEED);
+        }
+        info->commited = requested;
+    }
+}
+
+void ar_os_mem_release(void *ptr) {
+    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
+
+    if (info->reservation == NULL) {
+        munmap(info, info->size);
+        return;
+    }
+
+    ArReservation *reservation = info->reservation;
+    U32 page_size = ar_os_page_size();
+    U64 size = info->size;
+    madvise(info, size, MADV_DONTNEED);
+
+    // Block header overwrites the allocation info in the first page.
+    _ArReservationBlock *block = (_ArReservationBlock *) info;
+    block->size = size + page_size;
+
+    pthread_mutex_lock(&reservation->mutex);
+
+    // 'link' ends up pointing at whatever links to the released block.
+    _ArReservationBlock **link = &reservation->free_list;
+    _ArReservationBlock **prev_link = NULL;
+    while (*link != NULL && *link < block) {
+        prev_link = link;
+        link = &(*link)->next;
+    }
+
+    // Merging opens up the guard page between the two blocks.
+    _ArReservationBlock *next = *link;
+    if (next != NULL && (U8 *) block + block->size == (U8 *) next) {
+        mprotect((U8 *) next - page_size, page_size, PROT_READ | PROT_WRITE);
+        block->size += next->size;
+        next = next->next;
+    }
+    block->next = next;
+    _ArReservationBlock *prev = prev_link != NULL ? *prev_link : NULL;
+    if (prev != NULL && (U8 *) prev + prev->size == (U8 *) block) {
+        mprotect((U8 *) block - page_size, page_size, PROT_READ | PROT_WRITE);
+        prev->size += block->size;
+        prev->next = next;
+        block = prev;
+        link = prev_link;
+    } else {
+        *link = block;
+    }
+
+    // A block at the end goes back to the untouched part of the range, which
+    // is the last block in the list.
+    if ((U8 *) block + block->size == reservation->base + reservation->position) {
+        mprotect((U8 *) block + block->size - page_size, page_size, PROT_READ | PROT_WRITE);
+        reservation->position = (U8 *) block - reservation->base;
+        *link = NULL;
+    }
+
+    pthread_mutex_unlock(&reservation->mutex);
+}
+
+ArReservation *ar_reservation_create(U64 size) {
+    U32 page_size = ar_os_page_size();
+    size = align_to_value(size, page_size);
+
+    // The first page holds the reservation itself.
+    // MAP_NORESERVE keeps untouched pages from counting towards the commit
+    // limit so the whole range can be readable and writable from the start.
+    U8 *base = mmap(NULL, size + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        ar_err_emit(ar_str_lit("Failed to map memory for reservation."));
+        return NULL;
+    }
+
+    ArReservation *reservation = (ArReservation *) base;
+    *reservation = (ArReservation) {
+        .base = base + page_size,
+        .size = size,
+    };
+    pthread_mutex_init(&reservation->mutex, NULL);
+
+    return reservation;
+}
+
+void ar_reservation_destroy(ArReservation **reservation) {
+    pthread_mutex_destroy(&(*reservation)->mutex);
+    munmap(*reservation, (*reservation)->size + ar_os_page_size());
+    *reservation = NULL;
+}
+
+void *ar_reservation_reserve(ArReservation *reservation, U64 size) {
+    U32 page_size = ar_os_page_size();
+    size = align_to_value(size + sizeof(_ArOsAllocInfo), page_size);
+    U64 slot = size + page_size;
+
+    _ArOsAllocInfo *info = NULL;
+
+    pthread_mutex_lock(&reservation->mutex);
+
+    // First fit from previously released ranges, splitting off whatever is
+    // left over. A leftover too small to hold anything besides its guard page
+    // stays with the slot.
+    _ArReservationBlock *prev = NULL;
+    for (_ArReservationBlock *block = reservation->free_list; block != NULL; block = block->next) {
+        if (block->size < slot) {
+            prev = block;
+            continue;
+        }
+
+        _ArReservationBlock *next = block->next;
+        if (block->size - slot >= 2 * page_size) {
+            mprotect((U8 *) block + size, page_size, PROT_NONE);
+            _ArReservationBlock *rest = (_ArReservationBlock *) ((U8 *) block + slot);
+            rest->size = block->size - slot;
+            rest->next = next;
+            next = rest;
+        } else {
+            size = block->size - page_size;
+        }
+
+        if (prev == NULL) {
+            reservation->free_list = next;
+        } else {
+            prev->next = next;
+        }
+
+        info = (_ArOsAllocInfo *) block;
+        break;
+    }
+
+    if (info == NULL && reservation->size - reservation->position >= slot) {
+        info = (_ArOsAllocInfo *) (reservation->base + reservation->position);
+        mprotect((U8 *) info + size, page_size, PROT_NONE);
+        reservation->position += slot;
+    }
+
+    pthread_mutex_unlock(&reservation->mutex);
+
+    if (info == NULL) {
+        return NULL;
+    }
+
+    *info = (_ArOsAllocInfo) {
+        .size = size,
+        .requested_commited = sizeof(_ArOsAllocInfo),
+        .commited = page_size,
+        .reservation = reservation,
+    };
+
+    return &info[1];
+}
+
+void ar_os_mem_prefault(void *ptr, U64 size) {
+    U32 page_size = ar_os_page_size();
+    U8 *start = (U8 *) ((Usize) ptr / page_size * page_size);
+    U8 *end = (U8 *) ptr + size;
+
+#ifdef MADV_POPULATE_WRITE
+    if (madvise(start, end - start, MADV_POPULATE_WRITE) == 0) {
+        return;
+    }
+#endif
+
+    // Older kernels don't support populating through madvise so fall back on
+    // touching every page. Adding zero atomically keeps the contents intact
+    // even if another thread is writing to the same page.
+    for (U8 *page = start; page < end; page += page_size) {
+        __atomic_fetch_add(page, 0, __ATOMIC_RELAXED);
+    }
+}
+
+// Sits in front of named shared memory, like _ArOsAllocInfo does for private
+// memory.
+typedef struct _ArOsSharedInfo _ArOsSharedInfo;
+struct _ArOsSharedInfo {
+    U64 size;
+    // The creator removes the name when it lets go of the memory. Processes
+    // still attached keep their mapping. This header is shared too, so the
+    // creating mapping is told apart from attached ones in the same process,
+    // and from forked copies, by its address together with the pid.
+    I32 owner_pid;
+    void *owner_base;
+    char name[NAME_MAX + 1];
+};
+
+// Shared memory names have to start with a slash, one is added if missing.
+// Returns false if the name is too long.
+static B8 os_shared_mem_name(ArStr name, char *out) {
+    B8 slash = name.len > 0 && name.data[0] == '/';
+    if (name.len + !slash > NAME_MAX) {
+        return false;
+    }
+    out[0] = '/';
+    memcpy(out + !slash, name.data, name.len);
+    out[name.len + !slash] = 0;
+    return true;
+}
+
+static void *_ar_os_shared_mem_create(ArStr name, U64 size) {
+    char cname[NAME_MAX + 1];
+    if (!os_shared_mem_name(name, cname)) {
+        ar_err_emitf("Shared memory name '%.*s' is too long.", (I32) name.len, name.data);
+        return NULL;
+    }
+
+    I32 fd = shm_open(cname, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        ar_err_emitf("Failed to create shared memory '%s': %s.", cname, strerror(errno));
+        return NULL;
+    }
+
+    // Pages get allocated as they're touched so sizing it up front is cheap.
+    size += sizeof(_ArOsSharedInfo);
+    _ArOsSharedInfo *info = MAP_FAILED;
+    if (ftruncate(fd, size) == 0) {
+        info = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (info == MAP_FAILED) {
+        ar_err_emitf("Failed to map shared memory '%s': %s.", cname, strerror(errno));
+        shm_unlink(cname);
+        return NULL;
+    }
+
+    info->size = size;
+    info->owner_pid = getpid();
+    info->owner_base = info;
+    memcpy(info->name, cname, sizeof(cname));
+    return &info[1];
+}
+
+static void *_ar_os_shared_mem_open(ArStr name) {
+    char cname[NAME_MAX + 1];
+    if (!os_shared_mem_name(name, cname)) {
+        ar_err_emitf("Shared memory name '%.*s' is too long.", (I32) name.len, name.data);
+        return NULL;
+    }
+
+    I32 fd = shm_open(cname, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        ar_err_emitf("Failed to open shared memory '%s': %s.", cname, strerror(errno));
+        return NULL;
+    }
+
+    struct stat st;
+    _ArOsSharedInfo *info = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && (U64) st.st_size > sizeof(_ArOsSharedInfo)) {
+        info = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (info == MAP_FAILED) {
+        ar_err_emitf("Failed to map shared memory '%s'.", cname);
+        return NULL;
+    }
+    return &info[1];
+}
+
+static void _ar_os_shared_mem_release(void *ptr) {
+    _ArOsSharedInfo *info = &((_ArOsSharedInfo *) ptr)[-1];
+    if (info->owner_pid == getpid() && info->owner_base == (void *) info) {
+        shm_unlink(info->name);
+    }
+    munmap(info, info->size);
+}
+
+//
+// Files
+//
+
+// Opens 'path', which doesn't have to be null terminated. Returns -1 and
+// emits an error on failure.
+static I32 os_file_open(ArStr path, I32 flags) {
+    // Longer paths can't be opened anyway.
+    char cpath[PATH_MAX];
+    I32 fd = -1;
+    if (path.len >= sizeof(cpath)) {
+        errno = ENAMETOOLONG;
+    } else {
+        memcpy(cpath, path.data, path.len);
+        cpath[path.len] = 0;
+        fd = open(cpath, flags | O_CLOEXEC, 0644);
+    }
+    if (fd < 0) {
+        ar_err_emitf("Failed to open '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+    }
+    return fd;
+}
+
+// Reads until 'size' bytes are in or the file ends. Returns the number of
+// bytes read or -1 on failure.
+static I64 os_file_read_full(I32 fd, U8 *data, U64 size) {
+    U64 total = 0;
+    while (total < size) {
+        ssize_t len = read(fd, data + total, size - total);
+        if (len < 0 && errno == EINTR) {
+            continue;
+        }
+        if (len < 0) {
+            return -1;
+        }
+        if (len == 0) {
+            break;
+        }
+        total += len;
+    }
+    return total;
+}
+
+ArStr ar_os_file_read_all(ArArena *arena, ArStr path) {
+    I32 fd = os_file_open(path, O_RDONLY);
+    if (fd < 0) {
+        return (ArStr) {0};
+    }
+
+    ArStr result = {0};
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        U8 *data = ar_arena_push_arr_no_zero(arena, U8, st.st_size + 1);
+        I64 len = os_file_read_full(fd, data, st.st_size);
+        if (len >= 0) {
+            data[len] = 0;
+            result = ar_str(data, len);
+        }
+    } else {
+        ArTemp scratch = scratch_get_any(&arena, 1);
+        ArStrList chunks = AR_STR_LIST_INIT;
+        const U64 chunk_size = KiB(64);
+        I64 len;
+        do {
+            U8 *chunk = ar_arena_push_arr_no_zero(scratch.arena, U8, chunk_size);
+            len = os_file_read_full(fd, chunk, chunk_size);
+            if (len > 0) {
+                ar_str_list_push(scratch.arena, &chunks, ar_str(chunk, len));
+            }
+        } while (len == (I64) chunk_size);
+
+        if (len >= 0) {
+            ar_str_list_push(scratch.arena, &chunks, ar_str_lit("\0"));
+            result = ar_str_list_join(arena, chunks);
+            result.len--;
+        }
+        scratch_release_any(&scratch);
+    }
+
+    if (result.data == NULL) {
+        ar_err_emitf("Failed to read '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+    }
+    close(fd);
+    return result;
+}
+
+// Reads 'fd' to the end into anonymous memory, so the result can be released
+// with ar_os_file_unmap like a mapped file.
+static ArStr os_file_read_anon(I32 fd, ArStr path) {
+    U64 page_size = ar_os_page_size();
+    U64 capacity = page_size;
+    U8 *data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        ar_err_emitf("Failed to read '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+        return (ArStr) {0};
+    }
+
+    U64 len = 0;
+    B8 failed = false;
+    while (true) {
+        if (len == capacity) {
+            U8 *grown = mremap(data, capacity, capacity * 2, MREMAP_MAYMOVE);
+            if (grown == MAP_FAILED) {
+                failed = true;
+                break;
+            }
+            data = grown;
+            capacity *= 2;
+        }
+        ssize_t count = read(fd, data + len, capacity - len);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            failed = count < 0;
+            break;
+        }
+        len += count;
+    }
+
+    if (failed) {
+        ar_err_emitf("Failed to read '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+        munmap(data, capacity);
+        return (ArStr) {0};
+    }
+    if (len == 0) {
+        munmap(data, capacity);
+        return ar_str_lit("");
+    }
+    // Unmapping only knows the length, so drop the pages past it.
+    U64 used = align_to_value(len, page_size);
+    if (used < capacity) {
+        munmap(data + used, capacity - used);
+    }
+    return ar_str(data, len);
+}
+
+ArStr ar_os_file_map(ArStr path) {
+    I32 fd = os_file_open(path, O_RDONLY);
+    if (fd < 0) {
+        return (ArStr) {0};
+    }
+
+    ArStr view = {0};
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ar_err_emitf("Failed to stat '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+    } else if (st.st_size == 0) {
+        // Files in /proc and /sys report a size of zero but still have
+        // contents, those can't be mapped and get read instead.
+        view = os_file_read_anon(fd, path);
+    } else {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            ar_err_emitf("Failed to map '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+        } else {
+            view = ar_str(map, st.st_size);
+        }
+    }
+
+    // The mapping keeps its own reference to the file.
+    close(fd);
+    return view;
+}
+
+void ar_os_file_unmap(ArStr *view) {
+    if (view->len > 0) {
+        munmap((void *) view->data, view->len);
+    }
+    *view = (ArStr) {0};
+}
+
+// Most iovecs a single writev call accepts.
+#define OS_FILE_IOV_MAX 1024
+
+B8 ar_os_file_write_all(ArStr path, ArStrList list) {
+    I32 fd = os_file_open(path, O_WRONLY | O_CREAT | O_TRUNC);
+    if (fd < 0) {
+        return false;
+    }
+
+    ArIoVec iovecs[OS_FILE_IOV_MAX];
+    ArStrListNode *node = list.first;
+    B8 success = true;
+    while (success && node != NULL) {
+        U32 count = 0;
+        for (; node != NULL && count < OS_FILE_IOV_MAX; node = node->next) {
+            if (node->str.len > 0) {
+                iovecs[count++] = (ArIoVec) {.base = (void *) node->str.data, .len = node->str.len};
+            }
+        }
+
+        ArIoVec *iov = iovecs;
+        while (count > 0) {
+            ssize_t len = writev(fd, (const struct iovec *) iov, count);
+            if (len < 0 && errno == EINTR) {
+                continue;
+            }
+            if (len < 0) {
+                success = false;
+                break;
+            }
+
+            // A short write can stop in the middle of a string.
+            while (count > 0 && (U64) len >= iov->len) {
+                len -= iov->len;
+                iov++;
+                count--;
+            }
+            if (count > 0) {
+                iov->base = (U8 *) iov->base + len;
+                iov->len -= len;
+            }
+        }
+    }
+
+    if (close(fd) != 0) {
+        success = false;
+    }
+    if (!success) {
+        ar_err_emitf("Failed to write '%.*s': %s.", (I32) path.len, path.data, strerror(errno));
+    }
+    return success;
+}
+
+struct ArFileReader {
+    I32 fd;
+    B8 owns_fd;
+    ArStr delim;
+
+    // Regular files are read straight out of the mapping, everything else
+    // goes through 'buffer'.
+    U8 *map;
+    U64 map_len;
+    // Mapped pages below this were already given back.
+    U64 released;
+
+    U8 *buffer;
+    U64 buffer_capacity;
+    U64 max_record_size;
+
+    // Unconsumed bytes are 'start' to 'end' of the mapping or buffer. Bytes
+    // before 'scanned' are known not to start a delimiter.
+    U64 start;
+    U64 end;
+    U64 scanned;
+    B8 eof;
+};
+
+// Pages a mapped reader has moved past are dropped once this many pile up.
+// Touching them again reads them back from the page cache.
+#define FILE_READER_RELEASE_SIZE MiB(64)
+
+ArFileReader *ar_file_reader_open(ArArena *arena, ArFileReaderDesc desc) {
+    I32 fd = desc.path.len > 0 ? os_file_open(desc.path, O_RDONLY) : desc.fd;
+    if (fd < 0) {
+        return NULL;
+    }
+
+    ArFileReader *reader = ar_arena_push_type(arena, ArFileReader);
+    reader->fd = fd;
+    reader->owns_fd = desc.path.len > 0;
+    reader->delim = desc.delim.len > 0 ? ar_str_push_copy(arena, desc.delim) : ar_str_lit("\n");
+    reader->max_record_size = desc.max_record_size != 0 ? desc.max_record_size : AR_FILE_READER_DEFAULT_MAX_RECORD_SIZE;
+
+    struct stat st;
+    B8 regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    // Files reporting a size of zero, like the ones in /proc, still have
+    // contents, so only non-empty files get mapped.
+    if (regular && st.st_size > 0 && !desc.no_map) {
+        void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            reader->map = map;
+            reader->map_len = st.st_size;
+            reader->end = st.st_size;
+            reader->eof = true;
+            return reader;
+        }
+    }
+
+    if (regular) {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    } else if (S_ISFIFO(st.st_mode)) {
+        // A bigger pipe lets the writer run further ahead of us. Best effort,
+        // unprivileged processes are capped by /proc/sys/fs/pipe-max-size.
+        fcntl(fd, F_SETPIPE_SZ, MiB(1));
+    }
+
+    U64 buffer_size = desc.buffer_size != 0 ? desc.buffer_size : AR_FILE_READER_DEFAULT_BUFFER_SIZE;
+    reader->max_record_size = ar_max(reader->max_record_size, buffer_size);
+    reader->buffer = ar_os_mem_reserve(reader->max_record_size);
+    ar_os_mem_commit(reader->buffer, buffer_size);
+    reader->buffer_capacity = buffer_size;
+    return reader;
+}
+
+void ar_file_reader_close(ArFileReader **reader) {
+    if (*reader == NULL) {
+        return;
+    }
+
+    if ((*reader)->map != NULL) {
+        munmap((*reader)->map, (*reader)->map_len);
+    }
+    if ((*reader)->buffer != NULL) {
+        ar_os_mem_release((*reader)->buffer);
+    }
+    if ((*reader)->owns_fd) {
+        close((*reader)->fd);
+    }
+    *reader = NULL;
+}
+
+// Moves what's left to the front of the buffer and reads more after it.
+// Returns false if the buffer is full and can't grow any further.
+static B8 file_reader_fill(ArFileReader *reader) {
+    U64 pending = reader->end - reader->start;
+    memmove(reader->buffer, reader->buffer + reader->start, pending);
+    reader->scanned -= reader->start;
+    reader->start = 0;
+    reader->end = pending;
+
+    if (reader->end == reader->buffer_capacity) {
+        U64 capacity = ar_min(reader->buffer_capacity * 2, reader->max_record_size);
+        if (capacity == reader->buffer_capacity) {
+            ar_err_emitf("Record longer than the maximum of %llu bytes, cutting it.", reader->max_record_size);
+            return false;
+        }
+        ar_os_mem_commit(reader->buffer, capacity - reader->buffer_capacity);
+        reader->buffer_capacity = capacity;
+    }
+
+    ssize_t len;
+    do {
+        len = read(reader->fd, reader->buffer + reader->end, reader->buffer_capacity - reader->end);
+    } while (len < 0 && errno == EINTR);
+
+    if (len < 0) {
+        ar_err_emitf("Failed to read: %s.", strerror(errno));
+    }
+    if (len <= 0) {
+        reader->eof = true;
+    } else {
+        reader->end += len;
+    }
+    return true;
+}
+
+B8 ar_file_reader_next(ArFileReader *reader, ArStr *record) {
+    if (reader->map != NULL && reader->start - reader->released >= FILE_READER_RELEASE_SIZE) {
+        U64 release_end = reader->start / ar_os_page_size() * ar_os_page_size();
+        madvise(reader->map + reader->released, release_end - reader->released, MADV_DONTNEED);
+        reader->released = release_end;
+    }
+
+    for (;;) {
+        const U8 *data = reader->map != NULL ? reader->map : reader->buffer;
+
+        ArStr rest = ar_str(data + reader->scanned, reader->end - reader->scanned);
+        U64 index = reader->delim.len == 1
+            ? ar_str_find_char(rest, reader->delim.data[0], AR_STR_MATCH_FLAG_EXACT)
+            : ar_str_find(rest, reader->delim, AR_STR_MATCH_FLAG_EXACT);
+        if (index < rest.len) {
+            U64 record_end = reader->scanned + index;
+            *record = ar_str(data + reader->start, record_end - reader->start);
+            reader->start = record_end + reader->delim.len;
+            reader->scanned = reader->start;
+            return true;
+        }
+
+        // A delimiter may start in the last few bytes and end in the next
+        // read.
+        U64 keep = ar_min(reader->delim.len - 1, rest.len);
+        reader->scanned = reader->end - keep;
+
+        if (reader->eof && reader->start == reader->end) {
+            return false;
+        }
+        // Without a delimiter the rest of the input, or a record cut at the
+        // size limit, is the last record.
+        if (reader->eof || !file_reader_fill(reader)) {
+            *record = ar_str(data + reader->start, reader->end - reader->start);
+            reader->start = reader->end;
+            reader->scanned = reader->end;
+            return true;
+        }
+    }
+}
+
+//
+// Async I/O
+//
+
+struct ArIoRing {
+    U32 depth;
+    U32 in_flight;
+    B8 io_uring;
+
+    struct {
+        I32 fd;
+        U8 *sq_map;
+        U64 sq_map_size;
+        U8 *cq_map;
+        U64 cq_map_size;
+        struct io_uring_sqe *sqes;
+        U64 sqes_size;
+
+        U32 *sq_tail;
+        U32 *sq_array;
+        U32 sq_mask;
+        U32 *cq_head;
+        U32 *cq_tail;
+        U32 cq_mask;
+        struct io_uring_cqe *cqes;
+
+        // Queued entries the kernel hasn't taken yet.
+        U32 unsubmitted;
+    } uring;
+
+    // Both queues hold at most 'depth' entries since that's all that can be
+    // in flight.
+    struct {
+        pthread_mutex_t mutex;
+        pthread_cond_t request_cond;
+        pthread_cond_t completion_cond;
+        ArIoRequest *requests;
+        U32 request_head;
+        U32 request_count;
+        ArIoCompletion *completions;
+        U32 completion_head;
+        U32 completion_count;
+        ArThread *workers;
+        U32 worker_count;
+        B8 shutdown;
+    } pool;
+};
+
+static I32 io_ring_sys_enter(I32 fd, U32 to_submit, U32 min_complete, U32 flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static B8 io_ring_uring_init(ArIoRing *ring) {
+    struct io_uring_params params = {0};
+    I32 fd = syscall(__NR_io_uring_setup, ring->depth, &params);
+    if (fd < 0) {
+        return false;
+    }
+    // IORING_OP_READ and IORING_OP_WRITE came with the same kernel as this
+    // feature flag.
+    if (!(params.features & IORING_FEAT_CUR_PERSONALITY)) {
+        close(fd);
+        return false;
+    }
+
+    ring->uring.fd = fd;
+    ring->uring.sq_map_size = params.sq_off.array + params.sq_entries * sizeof(U32);
+    ring->uring.cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    ring->uring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    B8 single_map = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_map) {
+        ring->uring.sq_map_size = ar_max(ring->uring.sq_map_size, ring->uring.cq_map_size);
+        ring->uring.cq_map_size = ring->uring.sq_map_size;
+    }
+
+    void *sq_map = mmap(NULL, ring->uring.sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    void *cq_map = sq_map;
+    if (!single_map && sq_map != MAP_FAILED) {
+        cq_map = mmap(NULL, ring->uring.cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    }
+    void *sqes = MAP_FAILED;
+    if (cq_map != MAP_FAILED) {
+        sqes = mmap(NULL, ring->uring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    }
+    if (sqes == MAP_FAILED) {
+        if (cq_map != MAP_FAILED && cq_map != sq_map) {
+            munmap(cq_map, ring->uring.cq_map_size);
         }
-        case AR_ERR_ACCUM_TYPE_STACK: {
-            ArErr *stack = NULL;
-            for (ArErr *node = accum->stack; node != NULL; node = node->next) {
-                ArErr *err = ar_arena_push_type_no_zero(arena, ArErr);
-                err->str = ar_str_push_copy(arena, node->str);
-                ar_sll_stack_push(stack, err);
-            }
-            result = stack;
+        if (sq_map != MAP_FAILED) {
+            munmap(sq_map, ring->uring.sq_map_size);
         }
+        close(fd);
+        return false;
     }
 
-    ar_sll_stack_pop(vars->accum_stack);
-    if (vars->accum_stack == NULL) {
-        ar_arena_reset(vars->arena);
+    ring->uring.sq_map = sq_map;
+    ring->uring.cq_map = cq_map;
+    ring->uring.sqes = sqes;
+    ring->uring.sq_tail = (U32 *) (ring->uring.sq_map + params.sq_off.tail);
+    ring->uring.sq_array = (U32 *) (ring->uring.sq_map + params.sq_off.array);
+    ring->uring.sq_mask = *(U32 *) (ring->uring.sq_map + params.sq_off.ring_mask);
+    ring->uring.cq_head = (U32 *) (ring->uring.cq_map + params.cq_off.head);
+    ring->uring.cq_tail = (U32 *) (ring->uring.cq_map + params.cq_off.tail);
+    ring->uring.cq_mask = *(U32 *) (ring->uring.cq_map + params.cq_off.ring_mask);
+    ring->uring.cqes = (struct io_uring_cqe *) (ring->uring.cq_map + params.cq_off.cqes);
+    return true;
+}
+
+// Hands queued entries to the kernel and optionally waits for completions.
+// Returns false if the kernel refused.
+static B8 io_ring_uring_enter(ArIoRing *ring, U32 min_complete) {
+    U32 flags = min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+    if (ring->uring.unsubmitted == 0 && flags == 0) {
+        return true;
     }
 
-    return result;
+    I32 result;
+    do {
+        result = io_ring_sys_enter(ring->uring.fd, ring->uring.unsubmitted, min_complete, flags);
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        ar_err_emitf("io_uring_enter failed: %s.", strerror(errno));
+        return false;
+    }
+    ring->uring.unsubmitted -= result;
+    return true;
 }
 
-void ar_err_emit(ArStr str) {
-    if (_ar_thread_ctx_curr == NULL) {
-        return;
+static U32 io_ring_uring_reap(ArIoRing *ring, ArIoCompletion *completions, U32 capacity) {
+    U32 head = *ring->uring.cq_head;
+    U32 tail = __atomic_load_n(ring->uring.cq_tail, __ATOMIC_ACQUIRE);
+    U32 count = 0;
+    for (; head != tail && count < capacity; head++, count++) {
+        const struct io_uring_cqe *cqe = &ring->uring.cqes[head & ring->uring.cq_mask];
+        completions[count] = (ArIoCompletion) {
+            .user_data = (void *) (U64) cqe->user_data,
+            .result = cqe->res,
+        };
     }
+    __atomic_store_n(ring->uring.cq_head, head, __ATOMIC_RELEASE);
+    return count;
+}
 
-    _ArErrVars vars = _ar_thread_ctx_curr->err;
-    if (vars.accum_stack == NULL) {
-        _ar_core.error.callback(str);
-        return;
+static void io_ring_worker(void *args) {
+    ArIoRing *ring = args;
+
+    pthread_mutex_lock(&ring->pool.mutex);
+    for (;;) {
+        while (ring->pool.request_count == 0 && !ring->pool.shutdown) {
+            pthread_cond_wait(&ring->pool.request_cond, &ring->pool.mutex);
+        }
+        if (ring->pool.request_count == 0) {
+            break;
+        }
+
+        ArIoRequest request = ring->pool.requests[ring->pool.request_head];
+        ring->pool.request_head = (ring->pool.request_head + 1) % ring->depth;
+        ring->pool.request_count--;
+        pthread_mutex_unlock(&ring->pool.mutex);
+
+        ssize_t len;
+        do {
+            len = request.op == AR_IO_OP_READ
+                ? pread(request.fd, request.buffer, request.len, request.offset)
+                : pwrite(request.fd, request.buffer, request.len, request.offset);
+        } while (len < 0 && errno == EINTR);
+        I64 result = len < 0 ? -errno : len;
+
+        pthread_mutex_lock(&ring->pool.mutex);
+        U32 tail = (ring->pool.completion_head + ring->pool.completion_count) % ring->depth;
+        ring->pool.completions[tail] = (ArIoCompletion) {
+            .user_data = request.user_data,
+            .result = result,
+        };
+        ring->pool.completion_count++;
+        pthread_cond_signal(&ring->pool.completion_cond);
     }
+    pthread_mutex_unlock(&ring->pool.mutex);
+}
 
-    _ArErrAccumulator *accum = vars.accum_stack;
-    if (accum->type == AR_ERR_ACCUM_TYPE_IGNORE) {
-        return;
+// Expects the pool mutex to be held.
+static U32 io_ring_pool_reap(ArIoRing *ring, ArIoCompletion *completions, U32 capacity) {
+    U32 count = 0;
+    for (; ring->pool.completion_count > 0 && count < capacity; count++) {
+        completions[count] = ring->pool.completions[ring->pool.completion_head];
+        ring->pool.completion_head = (ring->pool.completion_head + 1) % ring->depth;
+        ring->pool.completion_count--;
     }
+    return count;
+}
 
-    ArErr *err = ar_arena_push_type_no_zero(vars.arena, ArErr);
-    err->str = ar_str_push_copy(vars.arena, str);
-    ar_sll_stack_push(accum->stack, err);
+ArIoRing *ar_io_ring_create(ArArena *arena, ArIoRingDesc desc) {
+    ArIoRing *ring = ar_arena_push_type(arena, ArIoRing);
+    ring->depth = desc.depth != 0 ? desc.depth : AR_IO_RING_DEFAULT_DEPTH;
+
+    if (!desc.no_io_uring && io_ring_uring_init(ring)) {
+        ring->io_uring = true;
+        return ring;
+    }
+
+    pthread_mutex_init(&ring->pool.mutex, NULL);
+    pthread_cond_init(&ring->pool.request_cond, NULL);
+    pthread_cond_init(&ring->pool.completion_cond, NULL);
+    ring->pool.requests = ar_arena_push_arr_no_zero(arena, ArIoRequest, ring->depth);
+    ring->pool.completions = ar_arena_push_arr_no_zero(arena, ArIoCompletion, ring->depth);
+    ring->pool.worker_count = desc.worker_count != 0 ? desc.worker_count : AR_IO_RING_DEFAULT_WORKER_COUNT;
+    ring->pool.workers = ar_arena_push_arr_no_zero(arena, ArThread, ring->pool.worker_count);
+    U32 running = 0;
+    for (U32 i = 0; i < ring->pool.worker_count; i++) {
+        // Workers never touch scratch arenas.
+        ring->pool.workers[i] = ar_thread_create_no_ctx(io_ring_worker, ring);
+        running += ar_thread_valid(ring->pool.workers[i]);
+    }
+    // Requests would never complete and waiting on them would block forever.
+    if (running == 0) {
+        ar_err_emit(ar_str_lit("Failed to start any I/O workers."));
+        pthread_cond_destroy(&ring->pool.completion_cond);
+        pthread_cond_destroy(&ring->pool.request_cond);
+        pthread_mutex_destroy(&ring->pool.mutex);
+        return NULL;
+    }
+    return ring;
 }
 
-void ar_err_emitf(const char *fmt, ...) {
-    if (_ar_thread_ctx_curr == NULL) {
+void ar_io_ring_destroy(ArIoRing **ring) {
+    if (*ring == NULL) {
         return;
     }
 
-    _ArErrVars *vars = &_ar_thread_ctx_curr->err;
+    ArIoRing *r = *ring;
+    ArIoCompletion completions[64];
+    while (r->in_flight > 0 && ar_io_ring_wait(r, completions, ar_arrlen(completions), r->in_flight) > 0);
 
-    va_list args;
-    va_start(args, fmt);
-    ArStr formatted = ar_str_pushfv(vars->arena, fmt, args);
-    va_end(args);
+    if (r->io_uring) {
+        munmap(r->uring.sqes, r->uring.sqes_size);
+        if (r->uring.cq_map != r->uring.sq_map) {
+            munmap(r->uring.cq_map, r->uring.cq_map_size);
+        }
+        munmap(r->uring.sq_map, r->uring.sq_map_size);
+        close(r->uring.fd);
+    } else {
+        pthread_mutex_lock(&r->pool.mutex);
+        r->pool.shutdown = true;
+        pthread_cond_broadcast(&r->pool.request_cond);
+        pthread_mutex_unlock(&r->pool.mutex);
+        for (U32 i = 0; i < r->pool.worker_count; i++) {
+            if (ar_thread_valid(r->pool.workers[i])) {
+                ar_thread_join(r->pool.workers[i]);
+            }
+        }
+        pthread_cond_destroy(&r->pool.completion_cond);
+        pthread_cond_destroy(&r->pool.request_cond);
+        pthread_mutex_destroy(&r->pool.mutex);
+    }
+    *ring = NULL;
+}
 
-    if (vars->accum_stack == NULL) {
-        _ar_core.error.callback(formatted);
-        ar_arena_pop(vars->arena, formatted.len);
-        return;
+B8 ar_io_ring_uses_io_uring(const ArIoRing *ring) {
+    return ring->io_uring;
+}
+
+U32 ar_io_ring_in_flight(const ArIoRing *ring) {
+    return ring->in_flight;
+}
+
+U32 ar_io_ring_submit(ArIoRing *ring, const ArIoRequest *requests, U32 count) {
+    count = ar_min(count, ring->depth - ring->in_flight);
+    if (count == 0) {
+        return 0;
     }
 
-    _ArErrAccumulator *accum = vars->accum_stack;
-    if (accum->type == AR_ERR_ACCUM_TYPE_IGNORE) {
-        return;
+    if (ring->io_uring) {
+        U32 tail = *ring->uring.sq_tail;
+        for (U32 i = 0; i < count; i++, tail++) {
+            U32 index = tail & ring->uring.sq_mask;
+            struct io_uring_sqe *sqe = &ring->uring.sqes[index];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = requests[i].op == AR_IO_OP_READ ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->fd = requests[i].fd;
+            sqe->off = requests[i].offset;
+            sqe->addr = (U64) requests[i].buffer;
+            sqe->len = requests[i].len;
+            sqe->user_data = (U64) requests[i].user_data;
+            ring->uring.sq_array[index] = index;
+        }
+        __atomic_store_n(ring->uring.sq_tail, tail, __ATOMIC_RELEASE);
+        ring->uring.unsubmitted += count;
+        ring->in_flight += count;
+        io_ring_uring_enter(ring, 0);
+        return count;
     }
 
-    ArErr *err = ar_arena_push_type_no_zero(vars->arena, ArErr);
-    err->str = formatted;
-    ar_sll_stack_push(accum->stack, err);
+    pthread_mutex_lock(&ring->pool.mutex);
+    for (U32 i = 0; i < count; i++) {
+        U32 tail = (ring->pool.request_head + ring->pool.request_count) % ring->depth;
+        ring->pool.requests[tail] = requests[i];
+        ring->pool.request_count++;
+    }
+    if (count == 1) {
+        pthread_cond_signal(&ring->pool.request_cond);
+    } else {
+        pthread_cond_broadcast(&ring->pool.request_cond);
+    }
+    pthread_mutex_unlock(&ring->pool.mutex);
+    ring->in_flight += count;
+    return count;
+}
+
+U32 ar_io_ring_poll(ArIoRing *ring, ArIoCompletion *completions, U32 capacity) {
+    return ar_io_ring_wait(ring, completions, capacity, 0);
+}
+
+U32 ar_io_ring_wait(ArIoRing *ring, ArIoCompletion *completions, U32 capacity, U32 min_count) {
+    min_count = ar_min(min_count, ar_min(capacity, ring->in_flight));
+
+    U32 count = 0;
+    if (ring->io_uring) {
+        io_ring_uring_enter(ring, 0);
+        count = io_ring_uring_reap(ring, completions, capacity);
+        while (count < min_count && io_ring_uring_enter(ring, min_count - count)) {
+            count += io_ring_uring_reap(ring, completions + count, capacity - count);
+        }
+    } else {
+        pthread_mutex_lock(&ring->pool.mutex);
+        count = io_ring_pool_reap(ring, completions, capacity);
+        while (count < min_count) {
+            pthread_cond_wait(&ring->pool.completion_cond, &ring->pool.mutex);
+            count += io_ring_pool_reap(ring, completions + count, capacity - count);
+        }
+        pthread_mutex_unlock(&ring->pool.mutex);
+    }
+
+    ring->in_flight -= count;
+    return count;
 }
 
 //
-// Platform
+// Directory walking
 //
 
-#ifdef ARKIN_OS_LINUX
-
-#include <unistd.h>
-#include <time.h>
-#include <sys/mman.h>
-#include <pthread.h>
+// Layout of the records getdents64 fills the buffer with.
+typedef struct _ArLinuxDirent64 _ArLinuxDirent64;
+struct _ArLinuxDirent64 {
+    U64 d_ino;
+    I64 d_off;
+    U16 d_reclen;
+    U8 d_type;
+    char d_name[];
+};
 
-typedef struct _ArOsAllocInfo _ArOsAllocInfo;
-struct _ArOsAllocInfo {
-    U64 size;
-    U64 requested_commited;
-    U64 commited;
+typedef struct _ArDirWalkNode _ArDirWalkNode;
+struct _ArDirWalkNode {
+    _ArDirWalkNode *next;
+    ArStr path;
 };
 
-typedef struct _ArOsThread _ArOsThread;
-struct _ArOsThread {
-    pthread_t thread_id;
-    ArThreadFunc func;
-    void *args;
+typedef struct _ArDirWalk _ArDirWalk;
+struct _ArDirWalk {
+    ArDirWalkDesc desc;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    _ArDirWalkNode *stack;
+    // Directories waiting or being read. The walk is done when it hits zero.
+    U64 pending;
+    // Holds the queued directories, pushed to under 'mutex'. Lives as long as
+    // the walk so nodes stay valid for whoever picks them up.
+    ArArena *node_arena;
 };
 
-typedef struct _ArOsMutex _ArOsMutex;
-struct _ArOsMutex {
-    pthread_mutex_t pmutex;
+typedef struct _ArDirWalkWorker _ArDirWalkWorker;
+struct _ArDirWalkWorker {
+    _ArDirWalk *walk;
+    U8 *buffer;
+    // Paths of the current batch are pushed past 'batch_start'.
+    ArArena *arena;
+    U64 batch_start;
+    ArDirEntry *entries;
+    U32 count;
+    // Indices of directories in 'entries' not handed to the other threads yet.
+    U32 *subdirs;
+    U32 subdir_count;
 };
 
-typedef struct _ArOsState _ArOsState;
-struct _ArOsState {
-    struct {
-        U32 seconds;
-        U32 microseconds;
-    } start_time;
-    U32 page_size;
+// Queues the directories found since the last call. One finished directory
+// is taken off 'pending' at the same time.
+static void dir_walk_share(_ArDirWalkWorker *worker, U32 finished) {
+    _ArDirWalk *walk = worker->walk;
+    if (worker->subdir_count == 0 && finished == 0) {
+        return;
+    }
 
-    ArArena *os_arena;
+    pthread_mutex_lock(&walk->mutex);
+    for (U32 i = 0; i < worker->subdir_count; i++) {
+        _ArDirWalkNode *node = ar_arena_push_type_no_zero(walk->node_arena, _ArDirWalkNode);
+        node->path = ar_str_push_copy(walk->node_arena, worker->entries[worker->subdirs[i]].path);
+        node->next = walk->stack;
+        walk->stack = node;
+    }
+    walk->pending += worker->subdir_count;
+    walk->pending -= finished;
+    if (worker->subdir_count > 1 || walk->pending == 0) {
+        pthread_cond_broadcast(&walk->cond);
+    } else if (worker->subdir_count == 1) {
+        pthread_cond_signal(&walk->cond);
+    }
+    pthread_mutex_unlock(&walk->mutex);
+    worker->subdir_count = 0;
+}
 
-    ArPool *mutex_pool;
-    ArPool *thread_pool;
+static void dir_walk_flush(_ArDirWalkWorker *worker) {
+    dir_walk_share(worker, 0);
+    if (worker->count > 0) {
+        worker->walk->desc.func(worker->entries, worker->count, worker->walk->desc.args);
+    }
+    worker->count = 0;
+    ar_arena_pop(worker->arena, ar_arena_used(worker->arena) - worker->batch_start);
+}
 
-    ArMutex mutex_pool_mutex;
-    ArMutex thread_pool_mutex;
-};
-static _ArOsState _ar_os_state = {0};
+static ArDirEntryType dir_walk_type_from_mode(U32 mode) {
+    switch (mode & S_IFMT) {
+        case S_IFREG: return AR_DIR_ENTRY_TYPE_FILE;
+        case S_IFDIR: return AR_DIR_ENTRY_TYPE_DIR;
+        case S_IFLNK: return AR_DIR_ENTRY_TYPE_SYMLINK;
+        default: return AR_DIR_ENTRY_TYPE_OTHER;
+    }
+}
 
-static void _ar_os_init(U32 thread_pool_cap, U32 mutex_pool_cap) {
-    _ar_os_state = (_ArOsState) {0};
+// Opens the directory at 'path', which doesn't have to be null terminated.
+static I32 dir_walk_open(ArStr path) {
+    // Longer paths can't be opened anyway.
+    char cpath[PATH_MAX];
+    if (path.len >= sizeof(cpath)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memcpy(cpath, path.data, path.len);
+    cpath[path.len] = 0;
+    return open(cpath, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+}
 
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    _ar_os_state.start_time.seconds = ts.tv_sec;
-    _ar_os_state.start_time.microseconds = ts.tv_nsec / 1000;
+static void dir_walk_read(_ArDirWalkWorker *worker, ArStr dir) {
+    const ArDirWalkDesc *desc = &worker->walk->desc;
 
-    _ar_os_state.page_size = sysconf(_SC_PAGE_SIZE);
+    I32 fd = dir_walk_open(dir);
+    if (fd < 0) {
+        return;
+    }
 
-    ArArena *arena = ar_arena_create_default();
-    _ar_os_state.os_arena = arena;
+    B8 separator = dir.len == 0 || dir.data[dir.len - 1] != '/';
+    for (;;) {
+        I64 len = syscall(SYS_getdents64, fd, worker->buffer, desc->buffer_size);
+        if (len <= 0) {
+            break;
+        }
 
-    _ar_os_state.mutex_pool = ar_pool_init(arena, mutex_pool_cap + 2, sizeof(_ArOsMutex));
-    _ar_os_state.thread_pool = ar_pool_init(arena, thread_pool_cap, sizeof(_ArOsThread));
+        for (I64 offset = 0; offset < len;) {
+            const _ArLinuxDirent64 *dirent = (const _ArLinuxDirent64 *) (worker->buffer + offset);
+            offset += dirent->d_reclen;
 
-    _ar_os_state.mutex_pool_mutex = ar_mutex_create();
-    _ar_os_state.thread_pool_mutex = ar_mutex_create();
+            const char *name = dirent->d_name;
+            if (name[0] == '.' && (name[1] == 0 || (name[1] == '.' && name[2] == 0))) {
+                continue;
+            }
+            if (worker->count == desc->batch_size) {
+                dir_walk_flush(worker);
+            }
+
+            U64 name_len = strlen(name);
+            U64 path_len = dir.len + separator + name_len;
+            U8 *path = ar_arena_push_arr_no_zero(worker->arena, U8, path_len);
+            memcpy(path, dir.data, dir.len);
+            path[dir.len] = '/';
+            memcpy(path + dir.len + separator, name, name_len);
+
+            ArDirEntry *entry = &worker->entries[worker->count++];
+            *entry = (ArDirEntry) {.path = ar_str(path, path_len)};
+            switch (dirent->d_type) {
+                case DT_REG: entry->type = AR_DIR_ENTRY_TYPE_FILE; break;
+                case DT_DIR: entry->type = AR_DIR_ENTRY_TYPE_DIR; break;
+                case DT_LNK: entry->type = AR_DIR_ENTRY_TYPE_SYMLINK; break;
+                case DT_UNKNOWN: entry->type = AR_DIR_ENTRY_TYPE_UNKNOWN; break;
+                default: entry->type = AR_DIR_ENTRY_TYPE_OTHER; break;
+            }
+
+            // Some file systems don't report types, those need a statx too.
+            if (desc->stat || entry->type == AR_DIR_ENTRY_TYPE_UNKNOWN) {
+                struct statx stx;
+                U32 mask = desc->stat ? STATX_TYPE | STATX_SIZE | STATX_MTIME : STATX_TYPE;
+                if (statx(fd, name, AT_SYMLINK_NOFOLLOW | AT_NO_AUTOMOUNT, mask, &stx) == 0) {
+                    entry->type = dir_walk_type_from_mode(stx.stx_mode);
+                    entry->size = stx.stx_size;
+                    entry->mtime_ns = stx.stx_mtime.tv_sec * 1000000000ull + stx.stx_mtime.tv_nsec;
+                }
+            }
+
+            if (entry->type == AR_DIR_ENTRY_TYPE_DIR) {
+                worker->subdirs[worker->subdir_count++] = worker->count - 1;
+            }
+        }
+    }
+    close(fd);
 }
 
-static void _ar_os_terminate(void) {
-    for (ArPoolHandle iter = ar_pool_iter_init(_ar_os_state.mutex_pool);
-        ar_pool_iter_valid(_ar_os_state.mutex_pool, iter);
-        iter = ar_pool_iter_next(_ar_os_state.mutex_pool, iter)) {
-        ar_mutex_destroy((ArMutex) { .handle = iter });
+static void dir_walk_thread(void *args) {
+    _ArDirWalk *walk = args;
+    const ArDirWalkDesc *desc = &walk->desc;
+
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+    _ArDirWalkWorker worker = {
+        .walk = walk,
+        .buffer = ar_arena_push_arr_no_zero(scratch.arena, U8, desc->buffer_size),
+        .entries = ar_arena_push_arr_no_zero(scratch.arena, ArDirEntry, desc->batch_size),
+        .subdirs = ar_arena_push_arr_no_zero(scratch.arena, U32, desc->batch_size),
+        .arena = scratch.arena,
+    };
+    worker.batch_start = ar_arena_used(scratch.arena);
+
+    pthread_mutex_lock(&walk->mutex);
+    for (;;) {
+        while (walk->stack == NULL && walk->pending > 0) {
+            pthread_cond_wait(&walk->cond, &walk->mutex);
+        }
+        if (walk->stack == NULL) {
+            break;
+        }
+        _ArDirWalkNode *node = walk->stack;
+        walk->stack = node->next;
+        pthread_mutex_unlock(&walk->mutex);
+
+        dir_walk_read(&worker, node->path);
+        dir_walk_share(&worker, 1);
+
+        pthread_mutex_lock(&walk->mutex);
     }
+    pthread_mutex_unlock(&walk->mutex);
 
-    ar_arena_destroy(&_ar_os_state.os_arena);
+    dir_walk_flush(&worker);
+    ar_scratch_release(&scratch);
 }
 
-F64 ar_os_get_time(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
+B8 ar_os_dir_walk(ArDirWalkDesc desc) {
+    I32 fd = dir_walk_open(desc.root);
+    if (fd < 0) {
+        ar_err_emitf("Failed to open directory '%.*s': %s.", (I32) desc.root.len, desc.root.data, strerror(errno));
+        return false;
+    }
+    close(fd);
 
-    return (ts.tv_sec + ts.tv_nsec * 1e-9) - (_ar_os_state.start_time.seconds + _ar_os_state.start_time.microseconds * 1e-6);
-}
+    if (desc.thread_count == 0) {
+        desc.thread_count = ar_clamp(sysconf(_SC_NPROCESSORS_ONLN), 1, 64);
+    }
+    desc.batch_size = desc.batch_size != 0 ? desc.batch_size : AR_DIR_WALK_DEFAULT_BATCH_SIZE;
+    desc.buffer_size = desc.buffer_size != 0 ? desc.buffer_size : AR_DIR_WALK_DEFAULT_BUFFER_SIZE;
 
-U64 ar_os_get_time_microseconds(void) {
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
+    // The walk runs on its own threads so 'func' is free to use the calling
+    // thread's scratch arenas.
+    _ArDirWalkNode root = {.path = desc.root};
+    _ArDirWalk walk = {
+        .desc = desc,
+        .stack = &root,
+        .pending = 1,
+        .node_arena = ar_arena_create_desc((ArArenaDesc) {
+                .name = ar_str_lit("dir_walk_nodes"),
+            }),
+    };
+    pthread_mutex_init(&walk.mutex, NULL);
+    pthread_cond_init(&walk.cond, NULL);
 
-    return ((ts.tv_sec - _ar_os_state.start_time.seconds) * 1000000 + (ts.tv_nsec / 1000) - _ar_os_state.start_time.microseconds);
-}
+    ArThread threads[64];
+    U32 thread_count = ar_min(desc.thread_count, ar_arrlen(threads));
+    for (U32 i = 0; i < thread_count; i++) {
+        threads[i] = ar_thread_create(dir_walk_thread, &walk);
+    }
+    for (U32 i = 0; i < thread_count; i++) {
+        if (ar_thread_valid(threads[i])) {
+            ar_thread_join(threads[i]);
+        }
+    }
 
-U32 ar_os_page_size(void) {
-    return _ar_os_state.page_size;
+    ar_arena_destroy(&walk.node_arena);
+    pthread_cond_destroy(&walk.cond);
+    pthread_mutex_destroy(&walk.mutex);
+    return true;
 }
 
-void *ar_os_mem_reserve(U64 size) {
-    U32 page_size = ar_os_page_size();
-    size = align_to_value(size + sizeof(_ArOsAllocInfo), ar_os_page_size());
+//
+// Ring buffer
+//
 
-    _ArOsAllocInfo *info = mmap(NULL, size + sizeof(_ArOsAllocInfo), PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, 0, 0);
-    madvise((U8 *) info + page_size, size - page_size, MADV_DONTNEED);
-    mprotect(info, page_size, PROT_READ | PROT_WRITE);
-    info->size = size;
-    info->commited = page_size;
-    info->requested_commited = sizeof(_ArOsAllocInfo);
+struct ArRingBuffer {
+    // Start of the first mapping, the second one follows right after it.
+    U8 *data;
+    U64 capacity;
+    // Address space both mappings were placed in.
+    void *reserved;
+    B8 spsc;
+
+    // Positions only ever grow. The padding keeps the consumer and producer
+    // positions on different cache lines.
+    U8 _pad0[64];
+    U64 read_pos;
+    U8 _pad1[64];
+    U64 write_pos;
+    U8 _pad2[64];
+};
 
-    return &info[1];
+static U64 ring_buffer_load(const U64 *pos, B8 spsc) {
+    return spsc ? __atomic_load_n(pos, __ATOMIC_ACQUIRE) : *pos;
 }
 
-void ar_os_mem_commit(void *ptr, U64 size) {
-    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
-    info->requested_commited += size;
-    U64 requested = align_to_value(info->requested_commited, ar_os_page_size());
-    if (requested > info->commited) {
-        info->commited = requested;
-        mprotect(info, info->commited, PROT_READ | PROT_WRITE);
+static void ring_buffer_store(U64 *pos, U64 value, B8 spsc) {
+    if (spsc) {
+        __atomic_store_n(pos, value, __ATOMIC_RELEASE);
+    } else {
+        *pos = value;
     }
 }
 
-void ar_os_mem_decommit(void *ptr, U64 size) {
-    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
+ArRingBuffer *ar_ring_buffer_create(ArArena *arena, ArRingBufferDesc desc) {
+    U32 page_size = ar_os_page_size();
+    U64 capacity = align_to_value(ar_max(desc.capacity, 1), page_size);
 
-    if (size > info->requested_commited) {
-        size = info->requested_commited;
+    I32 fd = memfd_create("arkin_ring_buffer", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, capacity) != 0) {
+        ar_err_emitf("Failed to create the ring buffer memory: %s.", strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
     }
 
-    info->requested_commited -= size;
-    if (info->requested_commited < sizeof(_ArOsAllocInfo)) {
-        info->requested_commited = sizeof(_ArOsAllocInfo);
+    // The reservation starts with a page of bookkeeping, so the two
+    // mappings go in the page aligned range after it.
+    void *reserved = ar_os_mem_reserve(capacity * 2 + page_size);
+    U8 *data = (U8 *) align_to_value((U64) reserved, page_size);
+    B8 mapped = mmap(data, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED &&
+        mmap(data + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED;
+    // The mappings keep the memory alive.
+    close(fd);
+    if (!mapped) {
+        ar_err_emitf("Failed to map the ring buffer: %s.", strerror(errno));
+        ar_os_mem_release(reserved);
+        return NULL;
     }
 
-    U64 requested = align_to_value(info->requested_commited, ar_os_page_size());
-    if (requested < info->commited) {
-        mprotect((U8 *) ptr + requested, info->commited - requested, PROT_NONE);
-        info->commited = requested;
+    ArRingBuffer *ring = ar_arena_push_type(arena, ArRingBuffer);
+    ring->data = data;
+    ring->capacity = capacity;
+    ring->reserved = reserved;
+    ring->spsc = desc.spsc;
+    return ring;
+}
+
+void ar_ring_buffer_destroy(ArRingBuffer **ring) {
+    if (*ring == NULL) {
+        return;
     }
+
+    // Unmaps the memfd mappings along with the rest of the reservation.
+    ar_os_mem_release((*ring)->reserved);
+    *ring = NULL;
 }
 
-void ar_os_mem_release(void *ptr) {
-    _ArOsAllocInfo *info = &((_ArOsAllocInfo *) ptr)[-1];
+U64 ar_ring_buffer_capacity(const ArRingBuffer *ring) {
+    return ring->capacity;
+}
 
-    munmap(info, info->size);
+U64 ar_ring_buffer_len(const ArRingBuffer *ring) {
+    U64 read_pos = ring_buffer_load(&ring->read_pos, ring->spsc);
+    return ring_buffer_load(&ring->write_pos, ring->spsc) - read_pos;
+}
+
+U8 *ar_ring_buffer_write_span(ArRingBuffer *ring, U64 *len) {
+    U64 read_pos = ring_buffer_load(&ring->read_pos, ring->spsc);
+    *len = ring->capacity - (ring->write_pos - read_pos);
+    return ring->data + ring->write_pos % ring->capacity;
+}
+
+void ar_ring_buffer_commit(ArRingBuffer *ring, U64 len) {
+    ring_buffer_store(&ring->write_pos, ring->write_pos + len, ring->spsc);
+}
+
+U64 ar_ring_buffer_write(ArRingBuffer *ring, ArStr data) {
+    U64 free;
+    U8 *dst = ar_ring_buffer_write_span(ring, &free);
+    U64 len = ar_min(free, data.len);
+    memcpy(dst, data.data, len);
+    ar_ring_buffer_commit(ring, len);
+    return len;
+}
+
+ArStr ar_ring_buffer_read_span(ArRingBuffer *ring) {
+    U64 write_pos = ring_buffer_load(&ring->write_pos, ring->spsc);
+    return ar_str(ring->data + ring->read_pos % ring->capacity, write_pos - ring->read_pos);
+}
+
+void ar_ring_buffer_consume(ArRingBuffer *ring, U64 len) {
+    ring_buffer_store(&ring->read_pos, ring->read_pos + len, ring->spsc);
 }
 
 //
@@ -64,7 +64,11 @@ void _ar_log(ArLogLevel level, const char *file, U32 line, const char *fmt, ...)
 
     va_list args;
     va_start(args, fmt);
+#ifdef ARKIN_FAST_FORMAT
+    ar_formatv(event.message, ar_arrlen(event.message), fmt, args);
+#else
     vsnprintf(event.message, ar_arrlen(event.message), fmt, args);
+#endif
     va_end(args);
 
     if (!_ar_state.no_stdout) {
@@ -105,3 +109,27 @@ void ar_log_set_no_stdout_color(B8 value) {
 void ar_log_error_callback(ArStr error) {
     ar_error("%.*s", (I32) error.len, error.data);
 }
+
+void _ar_log_arena_stats(ArLogLevel level, const char *file, U32 line) {
+    // Threads without a context have no scratch arenas, those get a
+    // temporary arena instead.
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+    ArArena *arena = scratch.arena;
+    if (arena == NULL) {
+        arena = ar_arena_create_default();
+    }
+
+    ArStr dump = ar_arena_stats_dump(arena, AR_ARENA_STATS_FORMAT_TEXT);
+    ArStrList lines = ar_str_split_char(arena, dump, '\n', AR_STR_MATCH_FLAG_EXACT);
+    for (ArStrListNode *node = lines.first; node != NULL; node = node->next) {
+        if (node->str.len != 0) {
+            _ar_log(level, file, line, "%.*s", (I32) node->str.len, node->str.data);
+        }
+    }
+
+    if (scratch.arena != NULL) {
+        ar_scratch_release(&scratch);
+    } else {
+        ar_arena_destroy(&arena);
+    }
+}
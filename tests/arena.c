@@ -0,0 +1,460 @@
+#include "arkin_core.h"
+#include "arkin_test.h"
+#include "test.h"
+
+#ifdef ARKIN_OS_LINUX
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static B8 pages_resident(const void *ptr, U64 size) {
+    U64 page_size = ar_os_page_size();
+    U8 *start = (U8 *) ((Usize) ptr / page_size * page_size);
+    U64 len = (U8 *) ptr + size - start;
+    U8 vec[64] = {0};
+    if (len / page_size > ar_arrlen(vec) || mincore(start, len, vec) != 0) {
+        return false;
+    }
+
+    for (U64 i = 0; i < (len + page_size - 1) / page_size; i++) {
+        if (!(vec[i] & 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+#endif
+
+ArTestCaseResult test_arena_push_pop(void) {
+    ArArena *arena = ar_arena_create(MiB(1));
+
+    U64 start = ar_arena_used(arena);
+    U8 *data = ar_arena_push(arena, KiB(64));
+    for (U32 i = 0; i < KiB(64); i++) {
+        AR_ASSERT(data[i] == 0);
+        data[i] = 0xff;
+    }
+    AR_ASSERT(ar_arena_used(arena) > start);
+
+    ar_arena_reset(arena);
+    AR_ASSERT(ar_arena_used(arena) == 0);
+
+    ar_arena_destroy(&arena);
+    AR_ASSERT(arena == NULL);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_arena_prefault(void) {
+#ifdef ARKIN_OS_LINUX
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(1),
+            .prefault = KiB(128),
+        });
+
+    U8 *data = ar_arena_push_no_zero(arena, KiB(128));
+    AR_ASSERT(pages_resident(data, KiB(128)));
+
+    ar_arena_reset(arena);
+    data = ar_arena_push_no_zero(arena, KiB(128));
+    AR_ASSERT_MSG(pages_resident(data, KiB(128)), "Prefaulted pages should survive a reset.");
+
+    ar_arena_destroy(&arena);
+
+    AR_SUCCESS();
+#endif
+
+    AR_ASSERT_MSG(false, "OS not supported.");
+}
+
+ArTestCaseResult test_arena_prefault_flag(void) {
+#ifdef ARKIN_OS_LINUX
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(1),
+            .flags = AR_ARENA_FLAG_PREFAULT_ASYNC,
+        });
+
+    U8 *data = ar_arena_push_no_zero(arena, KiB(64));
+    AR_ASSERT(pages_resident(data, KiB(64)));
+
+    ar_arena_prefault(arena, KiB(64));
+    ar_arena_reset(arena);
+
+    // Destroying must wait for the background prefault to finish.
+    ar_arena_destroy(&arena);
+
+    AR_SUCCESS();
+#endif
+
+    AR_ASSERT_MSG(false, "OS not supported.");
+}
+
+ArTestCaseResult test_arena_reservation(void) {
+    ArReservation *reservation = ar_reservation_create(MiB(8));
+    AR_ASSERT(reservation != NULL);
+
+    ArArena *arenas[4] = {0};
+    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
+        arenas[i] = ar_arena_create_desc((ArArenaDesc) {
+                .capacity = MiB(1),
+                .reservation = reservation,
+            });
+
+        U8 *data = ar_arena_push(arenas[i], KiB(256));
+        memset(data, i, KiB(256));
+    }
+
+    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
+        // Arenas carved from the same reservation must not overlap.
+        AR_ASSERT(i == 0 || (U8 *) arenas[i] >= (U8 *) arenas[i - 1] + MiB(1));
+        ar_arena_reset(arenas[i]);
+    }
+
+    ArArena *released = arenas[1];
+    ar_arena_destroy(&arenas[1]);
+
+    ArArena *reused = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(1),
+            .reservation = reservation,
+        });
+    AR_ASSERT_MSG(reused == released, "Released range should be handed out again.");
+    U8 *data = ar_arena_push(reused, KiB(4));
+    AR_ASSERT(data[0] == 0);
+
+    // Doesn't fit, falls back to mapping its own memory.
+    ArArena *big = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(16),
+            .reservation = reservation,
+        });
+    AR_ASSERT(big != NULL);
+    ar_arena_push(big, MiB(9));
+    ar_arena_destroy(&big);
+
+    ar_arena_destroy(&reused);
+    for (U32 i = 0; i < ar_arrlen(arenas); i++) {
+        if (arenas[i] != NULL) {
+            ar_arena_destroy(&arenas[i]);
+        }
+    }
+    ar_reservation_destroy(&reservation);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_arena_scratch(void) {
+    ArTemp a = ar_scratch_get(NULL, 0);
+    AR_ASSERT(a.arena != NULL);
+
+    ArTemp b = ar_scratch_get(&a.arena, 1);
+    AR_ASSERT(b.arena != NULL);
+    AR_ASSERT_MSG(b.arena != a.arena, "Scratch arena conflicts with the one passed in.");
+
+    ArArena *conflicting[] = { a.arena, b.arena };
+    ArTemp c = ar_scratch_get(conflicting, ar_arrlen(conflicting));
+    AR_ASSERT_MSG(c.arena == NULL, "Only two scratch arenas exist by default.");
+
+    ar_scratch_release(&b);
+    ar_scratch_release(&a);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_thread_ctx_reuse(void) {
+    ArThreadCtx *prev = NULL;
+    {
+        ArThreadCtx *ctx = ar_thread_ctx_create();
+        prev = ctx;
+        ar_thread_ctx_destroy(&ctx);
+        AR_ASSERT(ctx == NULL);
+    }
+
+    ArThreadCtx *ctx = ar_thread_ctx_create();
+    AR_ASSERT_MSG(ctx == prev, "Destroyed thread contexts should be reused.");
+    ar_thread_ctx_destroy(&ctx);
+
+    AR_SUCCESS();
+}
+
+static void scratch_spike(void *args) {
+    ArArena **out = args;
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+    ar_arena_push(scratch.arena, MiB(1));
+    *out = scratch.arena;
+    ar_scratch_release(&scratch);
+}
+
+ArTestCaseResult test_thread_ctx_trim(void) {
+    // Recycled contexts shouldn't hold on to what their last thread used.
+    ArArena *scratch = NULL;
+    ArThread thread = ar_thread_create(scratch_spike, &scratch);
+    AR_ASSERT(ar_thread_valid(thread));
+    ar_thread_join(thread);
+
+    AR_ASSERT(scratch != NULL);
+    AR_ASSERT(ar_arena_stats_get(scratch).commited <= ar_os_page_size());
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_arena_stats(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArArena *arena = ar_arena_create_desc((ArArenaDesc) {
+            .capacity = MiB(1),
+            .name = ar_str_lit("stats \"test\""),
+        });
+    ar_arena_push(arena, KiB(64));
+    ar_arena_pop(arena, KiB(32));
+    ar_arena_reset(arena);
+
+    ArArenaStats stats = ar_arena_stats_get(arena);
+    AR_ASSERT(stats.capacity == MiB(1));
+    AR_ASSERT(stats.position == 0);
+
+    ArStr json = ar_arena_stats_dump(scratch.arena, AR_ARENA_STATS_FORMAT_JSON);
+
+#ifdef ARKIN_ARENA_STATS
+    AR_ASSERT(ar_str_match(stats.name, ar_str_lit("stats \"test\""), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(stats.peak_position >= KiB(64));
+    AR_ASSERT(stats.commit_count > 0);
+    AR_ASSERT(stats.decommit_count > 0);
+
+    AR_ASSERT(json.data[0] == '[' && json.data[json.len - 1] == ']');
+    AR_ASSERT(ar_str_find(json, ar_str_lit("\"name\":\"stats \\\"test\\\"\""), 0) != json.len);
+#else
+    AR_ASSERT(stats.peak_position == 0);
+    AR_ASSERT(json.len == 0);
+#endif
+
+    ar_arena_destroy(&arena);
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_alloc_trace(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArArena *arena = ar_arena_create(MiB(1));
+    U32 line = __LINE__ + 2;
+    for (U32 i = 0; i < 16; i++) {
+        ar_arena_push(arena, KiB(16));
+    }
+
+    U32 count = 0;
+    ArAllocSite *sites = ar_alloc_trace_collect(scratch.arena, &count);
+
+#ifdef ARKIN_ALLOC_TRACE
+    AR_ASSERT(sites != NULL && count > 0);
+
+    B8 found = false;
+    for (U32 i = 0; i < count; i++) {
+        AR_ASSERT_MSG(i == 0 || sites[i - 1].bytes >= sites[i].bytes, "Sites should be sorted by volume.");
+        if (sites[i].file != NULL && strcmp(sites[i].file, __FILE__) == 0 && sites[i].line == line) {
+            AR_ASSERT(sites[i].count >= 16);
+            AR_ASSERT(sites[i].bytes >= KiB(16) * 16);
+            found = true;
+        }
+    }
+    AR_ASSERT(found);
+
+    ArStr report = ar_alloc_trace_report(scratch.arena, 8);
+    AR_ASSERT(report.len != 0);
+#else
+    (void) line;
+    AR_ASSERT(sites == NULL && count == 0);
+#endif
+
+    ar_arena_destroy(&arena);
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+#ifdef ARKIN_OS_LINUX
+typedef struct SharedNode SharedNode;
+struct SharedNode {
+    ArOffPtr next;
+    ArOffStr name;
+    U64 value;
+};
+
+typedef struct SharedRoot SharedRoot;
+struct SharedRoot {
+    ArOffPtr first;
+    U64 count;
+    // Written by the child process.
+    U64 child_sum;
+    ArOffStr child_note;
+};
+
+// Walks the list and checks every node. Returns the sum of the values or zero
+// if anything is off.
+static U64 shared_list_sum(SharedRoot *root) {
+    U64 sum = 0;
+    U64 count = 0;
+    for (SharedNode *node = ar_off_ptr_get(&root->first); node != NULL; node = ar_off_ptr_get(&node->next)) {
+        ArTemp scratch = ar_scratch_get(NULL, 0);
+        ArStr expected = ar_str_pushf(scratch.arena, "node %llu", node->value);
+        B8 matches = ar_str_match(ar_off_str_get(&node->name), expected, AR_STR_MATCH_FLAG_EXACT);
+        ar_scratch_release(&scratch);
+        if (!matches) {
+            return 0;
+        }
+        sum += node->value;
+        count++;
+    }
+    return count == root->count ? sum : 0;
+}
+
+ArTestCaseResult test_arena_shared(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+    ArStr name = ar_str_pushf(scratch.arena, "arkin_test_%d", (I32) getpid());
+
+    ArArena *arena = ar_arena_create_shared(name, MiB(1));
+    AR_ASSERT(arena != NULL);
+    SharedRoot *root = ar_arena_push_type(arena, SharedRoot);
+    AR_ASSERT(ar_arena_shared_first(arena) == root);
+
+    // Pushed to the front, so the list runs from the last node to the first.
+    U64 expected_sum = 0;
+    for (U64 i = 1; i <= 100; i++) {
+        SharedNode *node = ar_arena_push_type(arena, SharedNode);
+        node->value = i;
+        ar_off_str_set(&node->name, ar_str_pushf(arena, "node %llu", i));
+        node->next = 0;
+        ar_off_ptr_set(&node->next, ar_off_ptr_get(&root->first));
+        ar_off_ptr_set(&root->first, node);
+        root->count++;
+        expected_sum += i;
+    }
+    AR_ASSERT(shared_list_sum(root) == expected_sum);
+
+    // A second mapping in the same process sits at another address.
+    ArArena *attached = ar_arena_attach_shared(name);
+    AR_ASSERT(attached != NULL && attached != arena);
+    SharedRoot *attached_root = ar_arena_shared_first(attached);
+    AR_ASSERT(attached_root != root);
+    AR_ASSERT(shared_list_sum(attached_root) == expected_sum);
+    ar_arena_destroy(&attached);
+
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    AR_ASSERT(ar_arena_create_shared(name, MiB(1)) == NULL);
+    ar_err_accum_end(scratch.arena);
+
+    // The child pushes into the arena too, the parent sees it through its own
+    // mapping.
+    pid_t pid = fork();
+    AR_ASSERT(pid >= 0);
+    if (pid == 0) {
+        ArArena *child = ar_arena_attach_shared(name);
+        if (child == NULL) {
+            _exit(1);
+        }
+        SharedRoot *child_root = ar_arena_shared_first(child);
+        child_root->child_sum = shared_list_sum(child_root);
+        ar_off_str_set(&child_root->child_note, ar_str_pushf(child, "from %d", (I32) getpid()));
+        ar_arena_destroy(&child);
+        // The copy of the creator's mapping inherited through fork doesn't
+        // own the name.
+        ar_arena_destroy(&arena);
+        _exit(0);
+    }
+    I32 status = 0;
+    AR_ASSERT(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    AR_ASSERT(root->child_sum == expected_sum);
+    ArStr note = ar_str_pushf(scratch.arena, "from %d", (I32) pid);
+    AR_ASSERT(ar_str_match(ar_off_str_get(&root->child_note), note, AR_STR_MATCH_FLAG_EXACT));
+
+    // Neither the attached mapping nor the child removed the name.
+    ArArena *again = ar_arena_attach_shared(name);
+    AR_ASSERT(again != NULL);
+    ar_arena_destroy(&again);
+
+    // Offset pointers also work on plain memory.
+    ArOffPtr off = 0;
+    AR_ASSERT(ar_off_ptr_get(&off) == NULL);
+    ar_off_ptr_set(&off, &expected_sum);
+    AR_ASSERT(ar_off_ptr_get(&off) == &expected_sum);
+    ar_off_ptr_set(&off, NULL);
+    AR_ASSERT(off == 0);
+
+    // Destroying the creator removes the name.
+    ar_arena_destroy(&arena);
+    AR_ASSERT(arena == NULL);
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    AR_ASSERT(ar_arena_attach_shared(name) == NULL);
+    ar_err_accum_end(scratch.arena);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_arena_reservation_layout(void) {
+    U64 page_size = ar_os_page_size();
+    ArReservation *reservation = ar_reservation_create(page_size * 64);
+    AR_ASSERT(reservation != NULL);
+
+    // Two pages plus the allocation info round up to three, then comes the
+    // guard page.
+    U8 *a = ar_reservation_reserve(reservation, page_size * 2);
+    U8 *b = ar_reservation_reserve(reservation, page_size * 5);
+    U8 *c = ar_reservation_reserve(reservation, page_size);
+    U8 *last = ar_reservation_reserve(reservation, page_size);
+    AR_ASSERT(a != NULL && b != NULL && c != NULL && last != NULL);
+    U8 *a_start = (U8 *) ((Usize) a / page_size * page_size);
+    AR_ASSERT(b == a + page_size * 4);
+
+    // Running off the end of one slot faults instead of reaching the next.
+    // Under the address sanitizer the child exits with an error instead of
+    // dying from the signal.
+    pid_t pid = fork();
+    AR_ASSERT(pid >= 0);
+    if (pid == 0) {
+        a_start[page_size * 3] = 1;
+        _exit(0);
+    }
+    I32 status = 0;
+    AR_ASSERT(waitpid(pid, &status, 0) == pid);
+    AR_ASSERT((WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV) || (WIFEXITED(status) && WEXITSTATUS(status) != 0));
+
+    // Released neighbours merge into one block that fits a larger slot.
+    ar_os_mem_release(b);
+    ar_os_mem_release(a);
+    ar_os_mem_release(c);
+    U8 *merged = ar_reservation_reserve(reservation, page_size * 10);
+    AR_ASSERT(merged == a);
+    memset(merged, 0xab, page_size * 10);
+    ar_os_mem_release(merged);
+
+    // Once everything is back the whole range is available again.
+    ar_os_mem_release(last);
+    U8 *all = ar_reservation_reserve(reservation, page_size * 62);
+    AR_ASSERT(all == a);
+    ar_os_mem_release(all);
+
+    ar_reservation_destroy(&reservation);
+    AR_SUCCESS();
+}
+#endif
+
+ArTestResult test_arena(ArArena *arena) {
+    ArTestState state = ar_test_begin(arena);
+
+    AR_RUN_TEST(&state, test_arena_push_pop);
+    AR_RUN_TEST(&state, test_arena_prefault);
+    AR_RUN_TEST(&state, test_arena_prefault_flag);
+    AR_RUN_TEST(&state, test_arena_reservation);
+    AR_RUN_TEST(&state, test_arena_scratch);
+    AR_RUN_TEST(&state, test_thread_ctx_reuse);
+    AR_RUN_TEST(&state, test_thread_ctx_trim);
+    AR_RUN_TEST(&state, test_arena_stats);
+    AR_RUN_TEST(&state, test_alloc_trace);
+#ifdef ARKIN_OS_LINUX
+    AR_RUN_TEST(&state, test_arena_shared);
+    AR_RUN_TEST(&state, test_arena_reservation_layout);
+#endif
+
+    return ar_test_end(state);
+}
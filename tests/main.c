@@ -23,10 +23,13 @@ I32 main(void) {
     ArArena *arena = ar_arena_create_default();
 
     check(test_core(arena));
+    check(test_arena(arena));
     check(test_ll(arena));
     check(test_strings(arena));
     check(test_hash_map(arena));
     check(test_pool(arena));
+    check(test_radix_tree(arena));
+    check(test_os(arena));
 
     ar_arena_destroy(&arena);
     arkin_terminate();
@@ -0,0 +1,617 @@
+#include "arkin_core.h"
+#include "arkin_test.h"
+#include "test.h"
+
+#include <stdlib.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Writes 'contents' to a fresh temporary file and returns its path.
+static ArStr write_temp_file(ArArena *arena, ArStr contents) {
+    char path[] = "/tmp/arkin_test_XXXXXX";
+    I32 fd = mkstemp(path);
+    if (fd < 0) {
+        return (ArStr) {0};
+    }
+    U64 written = 0;
+    while (written < contents.len) {
+        ssize_t len = write(fd, contents.data + written, contents.len - written);
+        if (len <= 0) {
+            break;
+        }
+        written += len;
+    }
+    close(fd);
+    return ar_str_push_copy(arena, ar_str_cstr(path));
+}
+
+static void remove_temp_file(ArStr path) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+    ArStr cpath = ar_str_pushf(scratch.arena, "%.*s", (I32) path.len, path.data);
+    unlink((const char *) cpath.data);
+    ar_scratch_release(&scratch);
+}
+
+// Reads every record and checks them against the list.
+static B8 read_records(ArFileReader *reader, const char **expected, U32 count) {
+    U32 i = 0;
+    ArStr record;
+    while (ar_file_reader_next(reader, &record)) {
+        if (i >= count || !ar_str_match(record, ar_str_cstr(expected[i]), AR_STR_MATCH_FLAG_EXACT)) {
+            return false;
+        }
+        i++;
+    }
+    return i == count;
+}
+
+ArTestCaseResult test_file_reader_lines(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr path = write_temp_file(scratch.arena, ar_str_lit("alpha\nbeta\n\ngamma delta\nlast"));
+    AR_ASSERT(path.len > 0);
+    const char *expected[] = {"alpha", "beta", "", "gamma delta", "last"};
+
+    // Mapped, then streamed through a buffer smaller than most records so
+    // they straddle reads and the buffer has to grow.
+    B8 no_map[] = {false, true};
+    for (U32 i = 0; i < ar_arrlen(no_map); i++) {
+        ArFileReader *reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {
+            .path = path,
+            .buffer_size = 4,
+            .no_map = no_map[i],
+        });
+        AR_ASSERT(reader != NULL);
+        AR_ASSERT(read_records(reader, expected, ar_arrlen(expected)));
+        ar_file_reader_close(&reader);
+        AR_ASSERT(reader == NULL);
+    }
+
+    remove_temp_file(path);
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_file_reader_delim(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr path = write_temp_file(scratch.arena, ar_str_lit("one\r\ntwo\rstill two\r\n\r\nthree\r\n"));
+    AR_ASSERT(path.len > 0);
+    const char *expected[] = {"one", "two\rstill two", "", "three"};
+
+    // Buffer sizes that split the delimiter across reads.
+    U64 buffer_sizes[] = {1, 3, 4, 0};
+    for (U32 i = 0; i < ar_arrlen(buffer_sizes); i++) {
+        ArFileReader *reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {
+            .path = path,
+            .delim = ar_str_lit("\r\n"),
+            .buffer_size = buffer_sizes[i],
+            .no_map = buffer_sizes[i] != 0,
+        });
+        AR_ASSERT(reader != NULL);
+        AR_ASSERT(read_records(reader, expected, ar_arrlen(expected)));
+        ar_file_reader_close(&reader);
+    }
+
+    remove_temp_file(path);
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_file_reader_edge_cases(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr empty = write_temp_file(scratch.arena, ar_str_lit(""));
+    AR_ASSERT(empty.len > 0);
+    ArFileReader *reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {.path = empty});
+    AR_ASSERT(reader != NULL);
+    ArStr record;
+    AR_ASSERT(!ar_file_reader_next(reader, &record));
+    AR_ASSERT(!ar_file_reader_next(reader, &record));
+    ar_file_reader_close(&reader);
+    remove_temp_file(empty);
+
+    // Records over the limit come back cut at it.
+    ArStr path = write_temp_file(scratch.arena, ar_str_lit("0123456789abcdef\nxy\n"));
+    AR_ASSERT(path.len > 0);
+    reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {
+        .path = path,
+        .buffer_size = 4,
+        .max_record_size = 8,
+        .no_map = true,
+    });
+    AR_ASSERT(reader != NULL);
+    const char *expected[] = {"01234567", "89abcdef", "", "xy"};
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    AR_ASSERT(read_records(reader, expected, ar_arrlen(expected)));
+    ar_err_accum_end(scratch.arena);
+    ar_file_reader_close(&reader);
+    remove_temp_file(path);
+
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {.path = ar_str_lit("/nonexistent/arkin")});
+    ar_err_accum_end(scratch.arena);
+    AR_ASSERT(reader == NULL);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_file_reader_pipe(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    I32 fds[2];
+    AR_ASSERT(pipe(fds) == 0);
+    ArStr contents = ar_str_lit("first\nsecond\nthird");
+    AR_ASSERT(write(fds[1], contents.data, contents.len) == (ssize_t) contents.len);
+    close(fds[1]);
+
+    ArFileReader *reader = ar_file_reader_open(scratch.arena, (ArFileReaderDesc) {
+        .fd = fds[0],
+        .buffer_size = 8,
+    });
+    AR_ASSERT(reader != NULL);
+    const char *expected[] = {"first", "second", "third"};
+    AR_ASSERT(read_records(reader, expected, ar_arrlen(expected)));
+    ar_file_reader_close(&reader);
+    // Descriptors passed in stay open.
+    AR_ASSERT(close(fds[0]) == 0);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_file_read_write(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr path = write_temp_file(scratch.arena, ar_str_lit(""));
+    AR_ASSERT(path.len > 0);
+
+    // More strings than one writev call takes, with some empty ones.
+    ArStrList list = AR_STR_LIST_INIT;
+    for (U32 i = 0; i < 3000; i++) {
+        ar_str_list_push(scratch.arena, &list, i % 7 == 0 ? ar_str_lit("") : ar_str_pushf(scratch.arena, "line %u\n", i));
+    }
+    ArStr expected = ar_str_list_join(scratch.arena, list);
+    AR_ASSERT(ar_os_file_write_all(path, list));
+
+    ArStr contents = ar_os_file_read_all(scratch.arena, path);
+    AR_ASSERT(ar_str_match(contents, expected, AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(contents.data[contents.len] == 0);
+
+    ArStr view = ar_os_file_map(path);
+    AR_ASSERT(ar_str_match(view, expected, AR_STR_MATCH_FLAG_EXACT));
+    ar_os_file_unmap(&view);
+    AR_ASSERT(view.data == NULL && view.len == 0);
+
+    // Rewriting truncates.
+    ArStrList short_list = AR_STR_LIST_INIT;
+    ar_str_list_push(scratch.arena, &short_list, ar_str_lit("short"));
+    AR_ASSERT(ar_os_file_write_all(path, short_list));
+    contents = ar_os_file_read_all(scratch.arena, path);
+    AR_ASSERT(ar_str_match(contents, ar_str_lit("short"), AR_STR_MATCH_FLAG_EXACT));
+
+    AR_ASSERT(ar_os_file_write_all(path, AR_STR_LIST_INIT));
+    contents = ar_os_file_read_all(scratch.arena, path);
+    AR_ASSERT(contents.data != NULL && contents.len == 0);
+    view = ar_os_file_map(path);
+    AR_ASSERT(view.data != NULL && view.len == 0);
+    ar_os_file_unmap(&view);
+    remove_temp_file(path);
+
+    // Files in /proc report a size of zero.
+    contents = ar_os_file_read_all(scratch.arena, ar_str_lit("/proc/self/status"));
+    AR_ASSERT(contents.len > 0 && ar_str_find(contents, ar_str_lit("Name:"), AR_STR_MATCH_FLAG_EXACT) == 0);
+    view = ar_os_file_map(ar_str_lit("/proc/self/status"));
+    AR_ASSERT(view.len > 0 && ar_str_find(view, ar_str_lit("Name:"), AR_STR_MATCH_FLAG_EXACT) == 0);
+    ar_os_file_unmap(&view);
+    // Usually more than a page, so the buffer has to grow.
+    view = ar_os_file_map(ar_str_lit("/proc/self/maps"));
+    AR_ASSERT(view.len > 0 && view.data[view.len - 1] == '\n');
+    ar_os_file_unmap(&view);
+
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    AR_ASSERT(ar_os_file_read_all(scratch.arena, ar_str_lit("/nonexistent/arkin")).data == NULL);
+    AR_ASSERT(ar_os_file_map(ar_str_lit("/nonexistent/arkin")).data == NULL);
+    AR_ASSERT(!ar_os_file_write_all(ar_str_lit("/nonexistent/arkin"), list));
+    ar_err_accum_end(scratch.arena);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+typedef struct FileNoCtxArgs FileNoCtxArgs;
+struct FileNoCtxArgs {
+    ArArena *arena;
+    ArStr path;
+    B8 ok;
+};
+
+// Runs on a thread without a context, so there are no scratch arenas.
+static void file_no_ctx_job(void *args) {
+    FileNoCtxArgs *file_args = args;
+    ArStr contents = ar_os_file_read_all(file_args->arena, file_args->path);
+    ArStr proc = ar_os_file_read_all(file_args->arena, ar_str_lit("/proc/self/status"));
+    file_args->ok = ar_str_match(contents, ar_str_lit("no context"), AR_STR_MATCH_FLAG_EXACT) && proc.len > 0;
+}
+
+ArTestCaseResult test_file_read_no_ctx(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    FileNoCtxArgs args = {
+        .arena = scratch.arena,
+        .path = write_temp_file(scratch.arena, ar_str_lit("no context")),
+    };
+    AR_ASSERT(args.path.len > 0);
+    ArThread thread = ar_thread_create_no_ctx(file_no_ctx_job, &args);
+    AR_ASSERT(ar_thread_valid(thread));
+    ar_thread_join(thread);
+    AR_ASSERT(args.ok);
+
+    remove_temp_file(args.path);
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+// Copies a file block by block through the ring, with more blocks than fit in
+// flight at once, and checks the copy.
+static B8 io_ring_copy(ArIoRing *ring, ArStr contents, ArStr src_path, ArStr dst_path, U32 block_size) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    I32 src = open((const char *) src_path.data, O_RDONLY);
+    I32 dst = open((const char *) dst_path.data, O_WRONLY | O_TRUNC);
+    U32 block_count = (contents.len + block_size - 1) / block_size;
+    U8 *buffers = ar_arena_push_arr_no_zero(scratch.arena, U8, (U64) block_count * block_size);
+    ArIoCompletion completions[4];
+
+    // Reads everything, then writes it all back out. Blocks are identified
+    // by their index in 'user_data'.
+    B8 success = src >= 0 && dst >= 0;
+    for (U32 pass = 0; pass < 2 && success; pass++) {
+        U32 submitted = 0;
+        U32 completed = 0;
+        while (completed < block_count && success) {
+            while (submitted < block_count) {
+                U64 offset = (U64) submitted * block_size;
+                ArIoRequest request = {
+                    .op = pass == 0 ? AR_IO_OP_READ : AR_IO_OP_WRITE,
+                    .fd = pass == 0 ? src : dst,
+                    .offset = offset,
+                    .buffer = buffers + offset,
+                    .len = ar_min(block_size, contents.len - offset),
+                    .user_data = (void *) (U64) submitted,
+                };
+                if (ar_io_ring_submit(ring, &request, 1) == 0) {
+                    break;
+                }
+                submitted++;
+            }
+
+            U32 count = ar_io_ring_poll(ring, completions, ar_arrlen(completions));
+            if (count == 0) {
+                count = ar_io_ring_wait(ring, completions, ar_arrlen(completions), 1);
+            }
+            for (U32 i = 0; i < count; i++) {
+                U64 offset = (U64) completions[i].user_data * block_size;
+                success &= completions[i].result == (I64) ar_min(block_size, contents.len - offset);
+            }
+            completed += count;
+        }
+        success &= ar_io_ring_in_flight(ring) == 0;
+        if (pass == 0) {
+            success &= memcmp(buffers, contents.data, contents.len) == 0;
+        }
+    }
+
+    close(src);
+    close(dst);
+    ar_scratch_release(&scratch);
+    return success;
+}
+
+ArTestCaseResult test_io_ring(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    U8 *data = ar_arena_push_arr_no_zero(scratch.arena, U8, KiB(100) + 123);
+    for (U64 i = 0; i < KiB(100) + 123; i++) {
+        data[i] = (U8) (i * 31 + i / 4096);
+    }
+    ArStr contents = ar_str(data, KiB(100) + 123);
+    ArStr src_path = write_temp_file(scratch.arena, contents);
+    ArStr dst_path = write_temp_file(scratch.arena, ar_str_lit(""));
+    AR_ASSERT(src_path.len > 0 && dst_path.len > 0);
+
+    B8 no_io_uring[] = {false, true};
+    for (U32 i = 0; i < ar_arrlen(no_io_uring); i++) {
+        ArIoRing *ring = ar_io_ring_create(scratch.arena, (ArIoRingDesc) {
+            .depth = 8,
+            .worker_count = 3,
+            .no_io_uring = no_io_uring[i],
+        });
+        AR_ASSERT(ring != NULL);
+        if (no_io_uring[i]) {
+            AR_ASSERT(!ar_io_ring_uses_io_uring(ring));
+        }
+
+        AR_ASSERT(io_ring_copy(ring, contents, src_path, dst_path, KiB(4)));
+        ArStr copy = ar_os_file_read_all(scratch.arena, dst_path);
+        AR_ASSERT(ar_str_match(copy, contents, AR_STR_MATCH_FLAG_EXACT));
+
+        // Failures come back as negative errno values.
+        U8 buffer[16];
+        ArIoRequest bad = {.op = AR_IO_OP_READ, .fd = -1, .buffer = buffer, .len = sizeof(buffer)};
+        AR_ASSERT(ar_io_ring_submit(ring, &bad, 1) == 1);
+        ArIoCompletion completion;
+        AR_ASSERT(ar_io_ring_wait(ring, &completion, 1, 1) == 1);
+        AR_ASSERT(completion.result == -EBADF);
+
+        // Destroying waits for requests still in flight.
+        ArIoRequest requests[8];
+        for (U32 j = 0; j < ar_arrlen(requests); j++) {
+            requests[j] = bad;
+        }
+        AR_ASSERT(ar_io_ring_submit(ring, requests, ar_arrlen(requests)) == 8);
+        AR_ASSERT(ar_io_ring_submit(ring, requests, 1) == 0);
+        AR_ASSERT(ar_io_ring_in_flight(ring) == 8);
+        ar_io_ring_destroy(&ring);
+        AR_ASSERT(ring == NULL);
+    }
+
+    remove_temp_file(src_path);
+    remove_temp_file(dst_path);
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+typedef struct DirWalkResult DirWalkResult;
+struct DirWalkResult {
+    ArMutex mutex;
+    ArArena *arena;
+    ArRadixTree *entries;
+    U64 count;
+    U32 max_batch;
+};
+
+static void collect_entries(const ArDirEntry *entries, U32 count, void *args) {
+    DirWalkResult *result = args;
+    ar_mutex_lock(result->mutex);
+    for (U32 i = 0; i < count; i++) {
+        ArDirEntry *entry = ar_arena_push_type(result->arena, ArDirEntry);
+        *entry = entries[i];
+        entry->path = ar_str_push_copy(result->arena, entries[i].path);
+        ar_radix_tree_set(result->entries, entry->path, entry);
+    }
+    result->count += count;
+    result->max_batch = ar_max(result->max_batch, count);
+    ar_mutex_unlock(result->mutex);
+}
+
+ArTestCaseResult test_dir_walk(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    char root_buffer[] = "/tmp/arkin_test_XXXXXX";
+    AR_ASSERT(mkdtemp(root_buffer) != NULL);
+    ArStr root = ar_str_push_copy(scratch.arena, ar_str_cstr(root_buffer));
+
+    // Relative path, size of the contents and whether it's a directory.
+    // Directories come before what's inside of them.
+    typedef struct {
+        const char *path;
+        I64 size;
+    } Node;
+    Node nodes[32] = {
+        {"a.txt", 5},
+        {"sub1", -1},
+        {"sub1/b.txt", 10},
+        {"sub1/deep", -1},
+        {"sub1/deep/c.txt", 3},
+        {"sub1/deep/deeper", -1},
+        {"sub2", -1},
+    };
+    U32 node_count = 7;
+    for (U32 i = 0; i < 20; i++) {
+        nodes[node_count++] = (Node) {(const char *) ar_str_pushf(scratch.arena, "sub2/f%02u", i).data, 1};
+    }
+
+    ArStr *paths = ar_arena_push_arr(scratch.arena, ArStr, node_count);
+    for (U32 i = 0; i < node_count; i++) {
+        paths[i] = ar_str_pushf(scratch.arena, "%.*s/%s", (I32) root.len, root.data, nodes[i].path);
+        if (nodes[i].size < 0) {
+            AR_ASSERT(mkdir((const char *) paths[i].data, 0755) == 0);
+        } else {
+            ArStrList list = AR_STR_LIST_INIT;
+            ar_str_list_push(scratch.arena, &list, ar_str(ar_arena_push_arr(scratch.arena, U8, nodes[i].size), nodes[i].size));
+            AR_ASSERT(ar_os_file_write_all(paths[i], list));
+        }
+    }
+    ArStr link = ar_str_pushf(scratch.arena, "%.*s/link", (I32) root.len, root.data);
+    AR_ASSERT(symlink("sub1", (const char *) link.data) == 0);
+
+    struct {
+        U32 thread_count;
+        U32 batch_size;
+        U64 buffer_size;
+        B8 stat;
+        ArStr root;
+    } cases[] = {
+        {1, 0, 0, false, root},
+        {4, 3, 0, true, root},
+        // Buffers holding only a few entries need several reads.
+        {2, 1, 128, true, ar_str_pushf(scratch.arena, "%.*s/", (I32) root.len, root.data)},
+    };
+    for (U32 c = 0; c < ar_arrlen(cases); c++) {
+        DirWalkResult result = {
+            .mutex = ar_mutex_create(),
+            .arena = scratch.arena,
+            .entries = ar_radix_tree_init(scratch.arena),
+        };
+        AR_ASSERT(ar_os_dir_walk((ArDirWalkDesc) {
+            .root = cases[c].root,
+            .func = collect_entries,
+            .args = &result,
+            .thread_count = cases[c].thread_count,
+            .batch_size = cases[c].batch_size,
+            .buffer_size = cases[c].buffer_size,
+            .stat = cases[c].stat,
+        }));
+        ar_mutex_destroy(result.mutex);
+
+        // Every entry once, nothing below the link.
+        AR_ASSERT(result.count == node_count + 1);
+        AR_ASSERT(ar_radix_tree_count(result.entries) == node_count + 1);
+        if (cases[c].batch_size != 0) {
+            AR_ASSERT(result.max_batch <= cases[c].batch_size);
+        }
+        for (U32 i = 0; i < node_count; i++) {
+            const ArDirEntry *entry = ar_radix_tree_get(result.entries, paths[i]);
+            AR_ASSERT(entry != NULL);
+            AR_ASSERT(entry->type == (nodes[i].size < 0 ? AR_DIR_ENTRY_TYPE_DIR : AR_DIR_ENTRY_TYPE_FILE));
+            if (cases[c].stat && nodes[i].size >= 0) {
+                AR_ASSERT(entry->size == (U64) nodes[i].size && entry->mtime_ns > 0);
+            }
+        }
+        const ArDirEntry *link_entry = ar_radix_tree_get(result.entries, link);
+        AR_ASSERT(link_entry != NULL && link_entry->type == AR_DIR_ENTRY_TYPE_SYMLINK);
+    }
+
+    ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+    AR_ASSERT(!ar_os_dir_walk((ArDirWalkDesc) {.root = paths[0], .func = collect_entries}));
+    ar_err_accum_end(scratch.arena);
+
+    unlink((const char *) link.data);
+    for (U32 i = node_count; i-- > 0;) {
+        if (nodes[i].size < 0) {
+            rmdir((const char *) paths[i].data);
+        } else {
+            unlink((const char *) paths[i].data);
+        }
+    }
+    AR_ASSERT(rmdir(root_buffer) == 0);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_ring_buffer(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArRingBuffer *ring = ar_ring_buffer_create(scratch.arena, (ArRingBufferDesc) {.capacity = 100});
+    AR_ASSERT(ring != NULL);
+    U64 capacity = ar_ring_buffer_capacity(ring);
+    AR_ASSERT(capacity >= 100 && capacity % ar_os_page_size() == 0);
+
+    U8 *data = ar_arena_push_arr_no_zero(scratch.arena, U8, capacity * 2);
+    for (U64 i = 0; i < capacity * 2; i++) {
+        data[i] = (U8) (i * 7 + i / 251);
+    }
+
+    // Moves the positions close to the end so the next write wraps.
+    U64 head = capacity - 10;
+    AR_ASSERT(ar_ring_buffer_write(ring, ar_str(data, head)) == head);
+    ar_ring_buffer_consume(ring, head);
+    AR_ASSERT(ar_ring_buffer_len(ring) == 0);
+
+    AR_ASSERT(ar_ring_buffer_write(ring, ar_str(data, 100)) == 100);
+    ArStr span = ar_ring_buffer_read_span(ring);
+    AR_ASSERT(ar_str_match(span, ar_str(data, 100), AR_STR_MATCH_FLAG_EXACT));
+
+    // Filling it up leaves no room, the free space is contiguous too.
+    U64 free;
+    U8 *dst = ar_ring_buffer_write_span(ring, &free);
+    AR_ASSERT(free == capacity - 100);
+    memcpy(dst, data + 100, free);
+    ar_ring_buffer_commit(ring, free);
+    AR_ASSERT(ar_ring_buffer_write(ring, ar_str(data, 1)) == 0);
+    span = ar_ring_buffer_read_span(ring);
+    AR_ASSERT(ar_str_match(span, ar_str(data, capacity), AR_STR_MATCH_FLAG_EXACT));
+
+    ar_ring_buffer_consume(ring, 50);
+    span = ar_ring_buffer_read_span(ring);
+    AR_ASSERT(span.len == capacity - 50 && ar_str_match(span, ar_str(data + 50, capacity - 50), AR_STR_MATCH_FLAG_EXACT));
+    ar_ring_buffer_write_span(ring, &free);
+    AR_ASSERT(free == 50);
+
+    ar_ring_buffer_destroy(&ring);
+    AR_ASSERT(ring == NULL);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+typedef struct RingBufferStream RingBufferStream;
+struct RingBufferStream {
+    ArRingBuffer *ring;
+    U64 len;
+};
+
+static U8 stream_byte(U64 i) {
+    return (U8) (i ^ (i >> 8) ^ (i >> 16));
+}
+
+static void ring_buffer_produce(void *args) {
+    RingBufferStream *stream = args;
+    U64 written = 0;
+    U32 rng = 3;
+    while (written < stream->len) {
+        U64 free;
+        U8 *dst = ar_ring_buffer_write_span(stream->ring, &free);
+        rng = rng * 1103515245 + 12345;
+        U64 len = ar_min(ar_min(free, (rng >> 16) % 5000), stream->len - written);
+        for (U64 i = 0; i < len; i++) {
+            dst[i] = stream_byte(written + i);
+        }
+        ar_ring_buffer_commit(stream->ring, len);
+        written += len;
+    }
+}
+
+ArTestCaseResult test_ring_buffer_spsc(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    RingBufferStream stream = {
+        .ring = ar_ring_buffer_create(scratch.arena, (ArRingBufferDesc) {.capacity = KiB(8), .spsc = true}),
+        .len = MiB(4),
+    };
+    AR_ASSERT(stream.ring != NULL);
+    ArThread producer = ar_thread_create(ring_buffer_produce, &stream);
+
+    U64 read = 0;
+    B8 matches = true;
+    U32 rng = 5;
+    while (read < stream.len) {
+        ArStr span = ar_ring_buffer_read_span(stream.ring);
+        rng = rng * 1103515245 + 12345;
+        U64 len = ar_min(span.len, (rng >> 16) % 7000);
+        for (U64 i = 0; i < len; i++) {
+            matches &= span.data[i] == stream_byte(read + i);
+        }
+        ar_ring_buffer_consume(stream.ring, len);
+        read += len;
+    }
+    ar_thread_join(producer);
+    AR_ASSERT(matches);
+    AR_ASSERT(ar_ring_buffer_len(stream.ring) == 0);
+    ar_ring_buffer_destroy(&stream.ring);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestResult test_os(ArArena *arena) {
+    ArTestState state = ar_test_begin(arena);
+
+    AR_RUN_TEST(&state, test_file_reader_lines);
+    AR_RUN_TEST(&state, test_file_reader_delim);
+    AR_RUN_TEST(&state, test_file_reader_edge_cases);
+    AR_RUN_TEST(&state, test_file_reader_pipe);
+    AR_RUN_TEST(&state, test_file_read_write);
+    AR_RUN_TEST(&state, test_file_read_no_ctx);
+    AR_RUN_TEST(&state, test_io_ring);
+    AR_RUN_TEST(&state, test_dir_walk);
+    AR_RUN_TEST(&state, test_ring_buffer);
+    AR_RUN_TEST(&state, test_ring_buffer_spsc);
+
+    return ar_test_end(state);
+}
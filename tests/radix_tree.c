@@ -0,0 +1,240 @@
+#include "arkin_core.h"
+#include "arkin_test.h"
+#include "test.h"
+
+// Values are the index of the key plus one, since NULL means not found.
+#define value_of(i) ((void *) (U64) ((i) + 1))
+
+ArTestCaseResult test_radix_tree_get(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArRadixTree *tree = ar_radix_tree_init(scratch.arena);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("")) == NULL);
+
+    const char *keys[] = {"romane", "romanus", "romulus", "rubens", "ruber", "rubicon", "rubicundus", "rub", "", "r"};
+    for (U32 i = 0; i < ar_arrlen(keys); i++) {
+        ar_radix_tree_set(tree, ar_str_cstr(keys[i]), value_of(i));
+    }
+    AR_ASSERT(ar_radix_tree_count(tree) == ar_arrlen(keys));
+
+    for (U32 i = 0; i < ar_arrlen(keys); i++) {
+        AR_ASSERT(ar_radix_tree_get(tree, ar_str_cstr(keys[i])) == value_of(i));
+    }
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("ru")) == NULL);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("roman")) == NULL);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("rubiconx")) == NULL);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("x")) == NULL);
+
+    // Replacing keeps the count.
+    ar_radix_tree_set(tree, ar_str_lit("rub"), value_of(100));
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("rub")) == value_of(100));
+    AR_ASSERT(ar_radix_tree_count(tree) == ar_arrlen(keys));
+
+    AR_ASSERT(ar_radix_tree_remove(tree, ar_str_lit("rub")));
+    AR_ASSERT(!ar_radix_tree_remove(tree, ar_str_lit("rub")));
+    AR_ASSERT(ar_radix_tree_remove(tree, ar_str_lit("rubicon")));
+    AR_ASSERT(ar_radix_tree_remove(tree, ar_str_lit("")));
+    AR_ASSERT(!ar_radix_tree_remove(tree, ar_str_lit("rubi")));
+    AR_ASSERT(ar_radix_tree_count(tree) == ar_arrlen(keys) - 3);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("rub")) == NULL);
+    AR_ASSERT(ar_radix_tree_get(tree, ar_str_lit("rubicundus")) == value_of(6));
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_radix_tree_longest_prefix(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArRadixTree *tree = ar_radix_tree_init(scratch.arena);
+    const char *routes[] = {"/", "/api/", "/api/users", "/api/users/", "/static/"};
+    for (U32 i = 0; i < ar_arrlen(routes); i++) {
+        ar_radix_tree_set(tree, ar_str_cstr(routes[i]), value_of(i));
+    }
+
+    struct {
+        const char *path;
+        I32 route;
+    } cases[] = {
+        {"/", 0},
+        {"/index.html", 0},
+        {"/api", 0},
+        {"/api/", 1},
+        {"/api/orders", 1},
+        {"/api/users", 2},
+        {"/api/usersx", 2},
+        {"/api/users/42", 3},
+        {"/static/app.js", 4},
+        {"/stat", 0},
+        {"", -1},
+        {"api", -1},
+    };
+    for (U32 i = 0; i < ar_arrlen(cases); i++) {
+        ArStr match;
+        void *value = ar_radix_tree_longest_prefix(tree, ar_str_cstr(cases[i].path), &match);
+        if (cases[i].route < 0) {
+            AR_ASSERT(value == NULL && match.len == 0);
+        } else {
+            AR_ASSERT(value == value_of(cases[i].route));
+            AR_ASSERT(ar_str_match(match, ar_str_cstr(routes[cases[i].route]), AR_STR_MATCH_FLAG_EXACT));
+        }
+    }
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_radix_tree_iter(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArRadixTree *tree = ar_radix_tree_init(scratch.arena);
+    const char *keys[] = {"b", "ab", "abc", "a", "abd", "ac", "", "abcd", "bcd"};
+    for (U32 i = 0; i < ar_arrlen(keys); i++) {
+        ar_radix_tree_set(tree, ar_str_cstr(keys[i]), value_of(i));
+    }
+
+    struct {
+        const char *prefix;
+        const char *expected[9];
+        U32 count;
+    } cases[] = {
+        {"", {"", "a", "ab", "abc", "abcd", "abd", "ac", "b", "bcd"}, 9},
+        {"a", {"a", "ab", "abc", "abcd", "abd", "ac"}, 6},
+        {"ab", {"ab", "abc", "abcd", "abd"}, 4},
+        {"abc", {"abc", "abcd"}, 2},
+        {"bc", {"bcd"}, 1},
+        {"abe", {0}, 0},
+        {"c", {0}, 0},
+    };
+    for (U32 i = 0; i < ar_arrlen(cases); i++) {
+        U32 count = 0;
+        for (ArRadixTreeIter iter = ar_radix_tree_iter_init(tree, ar_str_cstr(cases[i].prefix));
+                ar_radix_tree_iter_valid(&iter);
+                ar_radix_tree_iter_next(&iter)) {
+            AR_ASSERT(count < cases[i].count);
+            ArStr key = ar_radix_tree_iter_key(&iter);
+            AR_ASSERT(ar_str_match(key, ar_str_cstr(cases[i].expected[count]), AR_STR_MATCH_FLAG_EXACT));
+            AR_ASSERT(ar_radix_tree_iter_value(&iter) == ar_radix_tree_get(tree, key));
+            count++;
+        }
+        AR_ASSERT(count == cases[i].count);
+    }
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+static I32 key_compare(ArStr a, ArStr b) {
+    I32 cmp = memcmp(a.data, b.data, ar_min(a.len, b.len));
+    if (cmp != 0) {
+        return cmp;
+    }
+    return a.len < b.len ? -1 : a.len > b.len;
+}
+
+// Random keys over a small alphabet for deep shared prefixes and a full
+// byte range in the second position so nodes grow to 256 children, checked
+// against a plain array.
+ArTestCaseResult test_radix_tree_random(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    enum { KEY_COUNT = 3000 };
+    ArStr *keys = ar_arena_push_arr(scratch.arena, ArStr, KEY_COUNT);
+    B8 *present = ar_arena_push_arr(scratch.arena, B8, KEY_COUNT);
+    ArRadixTree *tree = ar_radix_tree_init(scratch.arena);
+    U32 rng = 7;
+    for (U32 i = 0; i < KEY_COUNT; i++) {
+        U8 *data = ar_arena_push_arr(scratch.arena, U8, 8);
+        rng = rng * 1103515245 + 12345;
+        U64 len = (rng >> 16) % 8;
+        for (U64 j = 0; j < len; j++) {
+            rng = rng * 1103515245 + 12345;
+            data[j] = j == 1 ? (U8) (rng >> 16) : 'a' + (rng >> 16) % 3;
+        }
+        keys[i] = ar_str(data, len);
+        ar_radix_tree_set(tree, keys[i], value_of(i));
+    }
+
+    // Later duplicates replaced earlier values.
+    U64 count = 0;
+    for (U32 i = 0; i < KEY_COUNT; i++) {
+        present[i] = true;
+        for (U32 j = i + 1; j < KEY_COUNT; j++) {
+            if (ar_str_match(keys[i], keys[j], AR_STR_MATCH_FLAG_EXACT)) {
+                present[i] = false;
+                break;
+            }
+        }
+        count += present[i];
+    }
+    AR_ASSERT(ar_radix_tree_count(tree) == count);
+
+    // Removes every third key.
+    for (U32 i = 0; i < KEY_COUNT; i += 3) {
+        if (present[i]) {
+            AR_ASSERT(ar_radix_tree_remove(tree, keys[i]));
+            present[i] = false;
+            count--;
+        }
+    }
+    AR_ASSERT(ar_radix_tree_count(tree) == count);
+
+    for (U32 i = 0; i < KEY_COUNT; i++) {
+        void *expected = NULL;
+        for (U32 j = 0; j < KEY_COUNT; j++) {
+            if (present[j] && ar_str_match(keys[i], keys[j], AR_STR_MATCH_FLAG_EXACT)) {
+                expected = value_of(j);
+            }
+        }
+        AR_ASSERT(ar_radix_tree_get(tree, keys[i]) == expected);
+    }
+
+    for (U32 i = 0; i < 200; i++) {
+        ArStr query = keys[i];
+        I64 best = -1;
+        for (U32 j = 0; j < KEY_COUNT; j++) {
+            B8 is_prefix = present[j] && keys[j].len <= query.len && memcmp(keys[j].data, query.data, keys[j].len) == 0;
+            if (is_prefix && (best < 0 || keys[j].len > keys[best].len)) {
+                best = j;
+            }
+        }
+        void *value = ar_radix_tree_longest_prefix(tree, query, NULL);
+        AR_ASSERT(value == (best >= 0 ? value_of(best) : NULL));
+    }
+
+    const char *prefixes[] = {"", "a", "ab", "c", "bb"};
+    for (U32 p = 0; p < ar_arrlen(prefixes); p++) {
+        ArStr prefix = ar_str_cstr(prefixes[p]);
+        U64 expected = 0;
+        for (U32 j = 0; j < KEY_COUNT; j++) {
+            expected += present[j] && keys[j].len >= prefix.len && memcmp(keys[j].data, prefix.data, prefix.len) == 0;
+        }
+
+        U64 seen = 0;
+        ArStr last = {0};
+        for (ArRadixTreeIter iter = ar_radix_tree_iter_init(tree, prefix);
+                ar_radix_tree_iter_valid(&iter);
+                ar_radix_tree_iter_next(&iter)) {
+            ArStr key = ar_radix_tree_iter_key(&iter);
+            AR_ASSERT(seen == 0 || key_compare(last, key) < 0);
+            AR_ASSERT(key.len >= prefix.len && memcmp(key.data, prefix.data, prefix.len) == 0);
+            last = key;
+            seen++;
+        }
+        AR_ASSERT(seen == expected);
+    }
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestResult test_radix_tree(ArArena *arena) {
+    ArTestState state = ar_test_begin(arena);
+
+    AR_RUN_TEST(&state, test_radix_tree_get);
+    AR_RUN_TEST(&state, test_radix_tree_longest_prefix);
+    AR_RUN_TEST(&state, test_radix_tree_iter);
+    AR_RUN_TEST(&state, test_radix_tree_random);
+
+    return ar_test_end(state);
+}
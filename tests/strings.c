@@ -3,6 +3,8 @@
 #include "arkin_test.h"
 #include "test.h"
 #include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
 
 ArTestCaseResult test_char_helpers(void) {
     AR_ASSERT(ar_char_to_lower('a') == 'a');
@@ -11,6 +13,19 @@ ArTestCaseResult test_char_helpers(void) {
     AR_ASSERT(ar_char_to_upper('a') == 'A');
     AR_ASSERT(ar_char_to_upper('A') == 'A');
 
+    for (U32 i = 0; i < 256; i++) {
+        char c = (char) i;
+        B8 lower = i >= 'a' && i <= 'z';
+        B8 upper = i >= 'A' && i <= 'Z';
+        AR_ASSERT(ar_char_is_lower(c) == lower);
+        AR_ASSERT(ar_char_is_upper(c) == upper);
+        AR_ASSERT(ar_char_is_alpha(c) == (lower || upper));
+        AR_ASSERT(ar_char_is_numeric(c) == (i >= '0' && i <= '9'));
+        AR_ASSERT(ar_char_is_whitespace(c) == (i == ' ' || (i >= '\t' && i <= '\r')));
+        AR_ASSERT((U8) ar_char_to_lower(c) == (upper ? i + 32 : i));
+        AR_ASSERT((U8) ar_char_to_upper(c) == (lower ? i - 32 : i));
+    }
+
     AR_SUCCESS();
 }
 
@@ -66,6 +81,52 @@ ArTestCaseResult test_string_match(void) {
     AR_SUCCESS();
 }
 
+ArTestCaseResult test_string_case(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr lower = ar_str_to_lower(scratch.arena, ar_str_lit("Hello, World! @[`{ 123"));
+    AR_ASSERT(ar_str_match(lower, ar_str_lit("hello, world! @[`{ 123"), AR_STR_MATCH_FLAG_EXACT));
+    ArStr upper = ar_str_to_upper(scratch.arena, ar_str_lit("Hello, World! @[`{ 123"));
+    AR_ASSERT(ar_str_match(upper, ar_str_lit("HELLO, WORLD! @[`{ 123"), AR_STR_MATCH_FLAG_EXACT));
+
+    // Every byte value at every offset of the vector and scalar paths.
+    U8 bytes[256 + 77];
+    for (U32 i = 0; i < ar_arrlen(bytes); i++) {
+        bytes[i] = (U8) (i * 7 + 3);
+    }
+    ArStr str = ar_str(bytes, ar_arrlen(bytes));
+    lower = ar_str_to_lower(scratch.arena, str);
+    upper = ar_str_to_upper(scratch.arena, str);
+    AR_ASSERT(lower.len == str.len && upper.len == str.len);
+    for (U64 i = 0; i < str.len; i++) {
+        AR_ASSERT(lower.data[i] == (U8) ar_char_to_lower(str.data[i]));
+        AR_ASSERT(upper.data[i] == (U8) ar_char_to_upper(str.data[i]));
+    }
+
+    // Case insensitive compare, with a single mismatch moved across the
+    // vector blocks and the tail.
+    AR_ASSERT(ar_str_match(lower, upper, AR_STR_MATCH_FLAG_CASE_INSENSITIVE));
+    AR_ASSERT(ar_str_match(str, upper, AR_STR_MATCH_FLAG_CASE_INSENSITIVE));
+    AR_ASSERT(!ar_str_match(str, upper, AR_STR_MATCH_FLAG_EXACT));
+    U8 mixed[ar_arrlen(bytes)];
+    memcpy(mixed, upper.data, upper.len);
+    for (U64 i = 0; i < str.len; i++) {
+        U8 saved = mixed[i];
+        // Only the case bit differs from '@' and '`', which are not letters.
+        mixed[i] = ar_char_is_alpha(saved) ? '@' : saved ^ 1;
+        AR_ASSERT(!ar_str_match(lower, ar_str(mixed, str.len), AR_STR_MATCH_FLAG_CASE_INSENSITIVE));
+        mixed[i] = saved;
+    }
+    AR_ASSERT(!ar_str_match(ar_str_lit("@"), ar_str_lit("`"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE));
+    AR_ASSERT(!ar_str_match(ar_str_lit("[\\]^_@[\\]^_@[\\]^_@"), ar_str_lit("{|}~\x7f`{|}~\x7f`{|}~\x7f`"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE));
+
+    ArStr empty = ar_str_to_lower(scratch.arena, (ArStr) {0});
+    AR_ASSERT(empty.len == 0);
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
 ArTestCaseResult test_string_sub(void) {
     ArStr str = ar_str_lit("foobar");
 
@@ -143,6 +204,353 @@ ArTestCaseResult test_string_find(void) {
     AR_SUCCESS();
 }
 
+ArTestCaseResult test_string_find_long(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    U64 len = KiB(4);
+    U8 *data = ar_arena_push_arr_no_zero(scratch.arena, U8, len);
+    memset(data, 'a', len);
+    ArStr str = ar_str(data, len);
+
+    ArStr needle = ar_str_lit("aaab");
+    AR_ASSERT(ar_str_find(str, needle, AR_STR_MATCH_FLAG_EXACT) == len);
+
+    data[100] = 'b';
+    data[3000] = 'B';
+    AR_ASSERT(ar_str_find(str, needle, AR_STR_MATCH_FLAG_EXACT) == 97);
+    AR_ASSERT(ar_str_find(str, needle, AR_STR_MATCH_FLAG_LAST) == 97);
+    AR_ASSERT(ar_str_find(str, needle, AR_STR_MATCH_FLAG_LAST | AR_STR_MATCH_FLAG_CASE_INSENSITIVE) == 2997);
+
+    // Long enough to take the Horspool path.
+    U8 *long_needle = ar_arena_push_arr_no_zero(scratch.arena, U8, 300);
+    memset(long_needle, 'a', 300);
+    long_needle[299] = 'b';
+    AR_ASSERT(ar_str_find(str, ar_str(long_needle, 300), AR_STR_MATCH_FLAG_EXACT) == len);
+    AR_ASSERT(ar_str_find(str, ar_str(long_needle, 300), AR_STR_MATCH_FLAG_CASE_INSENSITIVE) == 2701);
+
+    AR_ASSERT(ar_str_find(ar_str_lit("ab"), ar_str_lit("abc"), AR_STR_MATCH_FLAG_EXACT) == 2);
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_scan(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    U64 len = 200;
+    U8 *data = ar_arena_push_arr_no_zero(scratch.arena, U8, len);
+    memset(data, ' ', len);
+    ArStr str = ar_str(data, len);
+
+    AR_ASSERT(ar_str_find_char(str, 'x', AR_STR_MATCH_FLAG_EXACT) == len);
+    AR_ASSERT(ar_str_trim(str).len == 0);
+
+    // Straddling the 64 byte blocks.
+    data[63] = 'x';
+    data[64] = 'X';
+    data[130] = 'y';
+    AR_ASSERT(ar_str_find_char(str, 'x', AR_STR_MATCH_FLAG_EXACT) == 63);
+    AR_ASSERT(ar_str_find_char(str, 'X', AR_STR_MATCH_FLAG_EXACT) == 64);
+    AR_ASSERT(ar_str_find_char(str, 'x', AR_STR_MATCH_FLAG_LAST) == 63);
+    AR_ASSERT(ar_str_find_char(str, 'x', AR_STR_MATCH_FLAG_LAST | AR_STR_MATCH_FLAG_CASE_INSENSITIVE) == 64);
+    AR_ASSERT(ar_str_find_any_char(str, ar_str_lit("yX"), AR_STR_MATCH_FLAG_EXACT) == 64);
+    AR_ASSERT(ar_str_find_any_char(str, ar_str_lit("yX"), AR_STR_MATCH_FLAG_LAST) == 130);
+    AR_ASSERT(ar_str_find_any_char(str, ar_str_lit("Y"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE) == 130);
+    AR_ASSERT(ar_str_find_any_char(str, ar_str_lit(""), AR_STR_MATCH_FLAG_EXACT) == len);
+
+    data[10] = '\t';
+    data[190] = '\v';
+    ArStr trimmed = ar_str_trim(str);
+    AR_ASSERT(trimmed.data == data + 63);
+    AR_ASSERT(trimmed.len == 68);
+
+    ArStrList fields = ar_str_split_char(scratch.arena, str, 'x', AR_STR_MATCH_FLAG_CASE_INSENSITIVE);
+    AR_ASSERT(fields.first->str.len == 63);
+    AR_ASSERT(fields.first->next->str.len == 0);
+    AR_ASSERT(fields.last->str.data == data + 65);
+    AR_ASSERT(fields.last->str.len == len - 65);
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_matcher(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStrList patterns = {0};
+    ar_str_list_push(scratch.arena, &patterns, ar_str_lit("he"));
+    ar_str_list_push(scratch.arena, &patterns, ar_str_lit("she"));
+    ar_str_list_push(scratch.arena, &patterns, ar_str_lit("his"));
+    ar_str_list_push(scratch.arena, &patterns, ar_str_lit("hers"));
+
+    ArStrMatcher *matcher = ar_str_matcher_create(scratch.arena, patterns, AR_STR_MATCH_FLAG_EXACT);
+    AR_ASSERT(ar_str_matcher_pattern_count(matcher) == 4);
+
+    struct {
+        U32 pattern;
+        U64 offset;
+    } expected[] = {
+        {1, 1},
+        {0, 2},
+        {3, 2},
+    };
+
+    ArStr str = ar_str_lit("ushers");
+    U32 i = 0;
+    for (ArStrMatcherIter iter = ar_str_matcher_iter_init(matcher, str);
+            ar_str_matcher_iter_valid(&iter);
+            ar_str_matcher_iter_next(&iter)) {
+        ArStrMatch match = ar_str_matcher_iter_get(&iter);
+        AR_ASSERT(i < ar_arrlen(expected));
+        AR_ASSERT(match.pattern == expected[i].pattern);
+        AR_ASSERT(match.offset == expected[i].offset);
+        AR_ASSERT(match.str.data == str.data + match.offset);
+        i++;
+    }
+    AR_ASSERT(i == ar_arrlen(expected));
+
+    AR_ASSERT(!ar_str_matcher_contains(matcher, ar_str_lit("HERS")));
+    matcher = ar_str_matcher_create(scratch.arena, patterns, AR_STR_MATCH_FLAG_CASE_INSENSITIVE);
+    AR_ASSERT(ar_str_matcher_contains(matcher, ar_str_lit("HERS")));
+    AR_ASSERT(!ar_str_matcher_contains(matcher, ar_str_lit("hs")));
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_regex(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArRegex *regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("(\\w+)@(\\w+)\\.(com|org)"),
+    });
+    AR_ASSERT(regex != NULL);
+    AR_ASSERT(ar_regex_capture_count(regex) == 4);
+
+    ArStr str = ar_str_lit("mail foo@bar.org or baz@qux.com");
+    ArStr captures[5];
+    AR_ASSERT(ar_regex_find(regex, str, captures, ar_arrlen(captures)));
+    AR_ASSERT(captures[0].data == str.data + 5);
+    AR_ASSERT(ar_str_match(captures[0], ar_str_lit("foo@bar.org"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(ar_str_match(captures[1], ar_str_lit("foo"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(ar_str_match(captures[2], ar_str_lit("bar"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(ar_str_match(captures[3], ar_str_lit("org"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(captures[4].data == NULL);
+
+    AR_ASSERT(ar_regex_search(regex, str));
+    AR_ASSERT(!ar_regex_match(regex, str));
+    AR_ASSERT(ar_regex_match(regex, ar_str_lit("a@b.com")));
+    AR_ASSERT(!ar_regex_search(regex, ar_str_lit("a@b.net")));
+    ar_regex_destroy(&regex);
+    AR_ASSERT(regex == NULL);
+
+    // Leftmost first, lazy quantifiers and unset groups.
+    regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("a(b)?|ab(c)|x.*?y"),
+    });
+    AR_ASSERT(ar_regex_find(regex, ar_str_lit("zabc"), captures, 3));
+    AR_ASSERT(ar_str_match(captures[0], ar_str_lit("ab"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(ar_str_match(captures[1], ar_str_lit("b"), AR_STR_MATCH_FLAG_EXACT));
+    AR_ASSERT(captures[2].data == NULL);
+    AR_ASSERT(ar_regex_find(regex, ar_str_lit("xyzy"), captures, 1));
+    AR_ASSERT(ar_str_match(captures[0], ar_str_lit("xy"), AR_STR_MATCH_FLAG_EXACT));
+    ar_regex_destroy(&regex);
+
+    // A star over a lazy body that can match empty stops after the empty
+    // iteration rather than retrying with a longer one.
+    regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("(a?\?)*"),
+    });
+    str = ar_str_lit("a");
+    AR_ASSERT(ar_regex_find(regex, str, captures, 1));
+    AR_ASSERT(captures[0].data == str.data && captures[0].len == 0);
+    ar_regex_destroy(&regex);
+
+    regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("(?: )([a-c]{0,2}?)*"),
+    });
+    str = ar_str_lit("bxc b1b1xa");
+    AR_ASSERT(ar_regex_find(regex, str, captures, 1));
+    AR_ASSERT(captures[0].data == str.data + 3 && captures[0].len == 1);
+    ar_regex_destroy(&regex);
+
+    regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("^[a-f]{2,3}$"),
+        .flags = AR_STR_MATCH_FLAG_CASE_INSENSITIVE,
+    });
+    AR_ASSERT(ar_regex_search(regex, ar_str_lit("aBc")));
+    AR_ASSERT(!ar_regex_search(regex, ar_str_lit("abcd")));
+    AR_ASSERT(!ar_regex_search(regex, ar_str_lit(" ab")));
+    ar_regex_destroy(&regex);
+
+    // A cache too small for every state still matches correctly.
+    regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("[ab]*a[ab]{8}"),
+        .cache_size = 1024,
+    });
+    AR_ASSERT(ar_regex_match(regex, ar_str_lit("babaabbbbbbbb")));
+    AR_ASSERT(!ar_regex_match(regex, ar_str_lit("bbabbabbbbbbb")));
+    ar_regex_destroy(&regex);
+
+    ArRegex *glob = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("src/**/*.[ch]"),
+        .glob = true,
+    });
+    AR_ASSERT(ar_regex_match(glob, ar_str_lit("src/os/linux/file.c")));
+    AR_ASSERT(ar_regex_match(glob, ar_str_lit("src//file.h")));
+    AR_ASSERT(!ar_regex_match(glob, ar_str_lit("src/file.cpp")));
+    AR_ASSERT(!ar_regex_search(glob, ar_str_lit("a/src/x/file.c")));
+    ar_regex_destroy(&glob);
+
+    glob = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("*.TXT"),
+        .glob = true,
+        .flags = AR_STR_MATCH_FLAG_CASE_INSENSITIVE,
+    });
+    AR_ASSERT(ar_regex_match(glob, ar_str_lit("notes.txt")));
+    AR_ASSERT(!ar_regex_match(glob, ar_str_lit("dir/notes.txt")));
+    ar_regex_destroy(&glob);
+
+    const char *invalid[] = {"(a", "a)", "[a", "*a", "a**", "\\q", "a{3,1}", "(?i)a"};
+    for (U32 i = 0; i < ar_arrlen(invalid); i++) {
+        ar_err_accum_begin(AR_ERR_ACCUM_TYPE_IGNORE);
+        regex = ar_regex_create((ArRegexDesc) {
+            .pattern = ar_str_cstr(invalid[i]),
+        });
+        ar_err_accum_end(scratch.arena);
+        AR_ASSERT(regex == NULL);
+    }
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+// Runs on a thread without a context, so there are no scratch arenas.
+static void strings_no_ctx_job(void *args) {
+    B8 *ok = args;
+
+    ArRegex *regex = ar_regex_create((ArRegexDesc) {
+        .pattern = ar_str_lit("a(b)"),
+    });
+    ArStr captures[2];
+    *ok = regex != NULL && ar_regex_find(regex, ar_str_lit("xab"), captures, ar_arrlen(captures)) &&
+        ar_str_match(captures[1], ar_str_lit("b"), AR_STR_MATCH_FLAG_EXACT);
+    if (regex != NULL) {
+        ar_regex_destroy(&regex);
+    }
+
+    // Halfway cases go through the slow path, short and long.
+    F64 f = 0;
+    *ok = *ok && ar_str_to_f64(ar_str_lit("9007199254740993.0000000000000001"), &f) && f == 9007199254740994.0;
+    ArStr long_halfway = ar_str_lit("9007199254740993.00000000000000000000000000000000000000000000000000000000000000000"
+        "00000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001");
+    *ok = *ok && ar_str_to_f64(long_halfway, &f) && f == 9007199254740994.0;
+
+    ArArena *arena = ar_arena_create(MiB(1));
+    ArStrList patterns = AR_STR_LIST_INIT;
+    ar_str_list_push(arena, &patterns, ar_str_lit("he"));
+    ar_str_list_push(arena, &patterns, ar_str_lit("she"));
+    ArStrMatcher *matcher = ar_str_matcher_create(arena, patterns, 0);
+    *ok = *ok && matcher != NULL && ar_str_matcher_contains(matcher, ar_str_lit("ushers"));
+    ar_arena_destroy(&arena);
+}
+
+ArTestCaseResult test_string_no_ctx(void) {
+    B8 ok = false;
+    ArThread thread = ar_thread_create_no_ctx(strings_no_ctx_job, &ok);
+    AR_ASSERT(ar_thread_valid(thread));
+    ar_thread_join(thread);
+    AR_ASSERT(ok);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_utf8(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    ArStr text = ar_str_lit("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80");
+    AR_ASSERT(ar_str_utf8_valid(text));
+    AR_ASSERT(!ar_str_is_ascii(text));
+    AR_ASSERT(ar_str_is_ascii(ar_str_lit("plain ascii text, long enough to take the vector path")));
+    AR_ASSERT(ar_str_utf8_valid(ar_str_lit("")));
+
+    const char *invalid[] = {
+        "\x80",
+        "\xc0\x80",
+        "\xe0\x80\x80",
+        "\xed\xa0\x80",
+        "\xf4\x90\x80\x80",
+        "\xf5\x80\x80\x80",
+        "\xe2\x82",
+    };
+    for (U32 i = 0; i < ar_arrlen(invalid); i++) {
+        AR_ASSERT(!ar_str_utf8_valid(ar_str_cstr(invalid[i])));
+    }
+
+    // Errors past the first vector blocks and in the zero padded tail.
+    U8 long_text[200];
+    memset(long_text, 'x', sizeof(long_text));
+    AR_ASSERT(ar_str_utf8_valid(ar_str(long_text, sizeof(long_text))));
+    long_text[150] = 0xc3;
+    AR_ASSERT(!ar_str_utf8_valid(ar_str(long_text, sizeof(long_text))));
+    long_text[151] = 0xa9;
+    AR_ASSERT(ar_str_utf8_valid(ar_str(long_text, sizeof(long_text))));
+    long_text[199] = 0xe2;
+    AR_ASSERT(!ar_str_utf8_valid(ar_str(long_text, sizeof(long_text))));
+    AR_ASSERT(ar_str_utf8_valid(ar_str(long_text, 128)));
+
+    U32 expected[] = {'a', 0xe9, 0x20ac, 0x1f600};
+    U64 offsets[] = {0, 1, 3, 6};
+    U32 i = 0;
+    for (ArUtf8Iter iter = ar_utf8_iter_init(text); ar_utf8_iter_valid(&iter); ar_utf8_iter_next(&iter)) {
+        AR_ASSERT(i < ar_arrlen(expected));
+        AR_ASSERT(ar_utf8_iter_get(&iter) == expected[i]);
+        AR_ASSERT(iter.offset == offsets[i]);
+        i++;
+    }
+    AR_ASSERT(i == ar_arrlen(expected));
+
+    // Each maximal invalid prefix is replaced once.
+    U32 codepoint;
+    AR_ASSERT(ar_utf8_decode(ar_str_lit("\xf0\x9f\x98"), &codepoint) == 3);
+    AR_ASSERT(codepoint == AR_UTF8_REPLACEMENT);
+    AR_ASSERT(ar_utf8_decode(ar_str_lit("\xe0\x80"), &codepoint) == 1);
+    AR_ASSERT(codepoint == AR_UTF8_REPLACEMENT);
+    AR_ASSERT(ar_utf8_decode(ar_str_lit(""), &codepoint) == 0);
+
+    U8 encoded[AR_UTF8_MAX_LENGTH];
+    AR_ASSERT(ar_utf8_encode(0x1f600, encoded) == 4);
+    AR_ASSERT(memcmp(encoded, "\xf0\x9f\x98\x80", 4) == 0);
+    AR_ASSERT(ar_utf8_encode(0xd800, encoded) == 3);
+    AR_ASSERT(memcmp(encoded, "\xef\xbf\xbd", 3) == 0);
+
+    ArStrBuilder builder = ar_str_builder_init(scratch.arena, 0);
+    for (U32 j = 0; j < ar_arrlen(expected); j++) {
+        ar_str_builder_push_codepoint(&builder, expected[j]);
+    }
+    AR_ASSERT(ar_str_match(ar_str_builder_finalize(scratch.arena, &builder), text, AR_STR_MATCH_FLAG_EXACT));
+
+    U64 len;
+    U16 *utf16 = ar_str_to_utf16(scratch.arena, text, &len);
+    U16 expected_utf16[] = {'a', 0xe9, 0x20ac, 0xd83d, 0xde00};
+    AR_ASSERT(len == ar_arrlen(expected_utf16));
+    AR_ASSERT(memcmp(utf16, expected_utf16, sizeof(expected_utf16)) == 0);
+    AR_ASSERT(utf16[len] == 0);
+    AR_ASSERT(ar_str_match(ar_str_from_utf16(scratch.arena, utf16, len), text, AR_STR_MATCH_FLAG_EXACT));
+
+    U16 unpaired[] = {'a', 0xdc00, 'b', 0xd800};
+    ArStr replaced = ar_str_from_utf16(scratch.arena, unpaired, ar_arrlen(unpaired));
+    AR_ASSERT(ar_str_match(replaced, ar_str_lit("a\xef\xbf\xbd" "b\xef\xbf\xbd"), AR_STR_MATCH_FLAG_EXACT));
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
 ArTestCaseResult test_string_split(void) {
     ArTemp scratch = ar_scratch_get(NULL, 0);
 
@@ -215,6 +623,161 @@ ArTestCaseResult test_string_split(void) {
     AR_SUCCESS();
 }
 
+ArTestCaseResult test_string_split_iter(void) {
+    {
+        ArStr str = ar_str_lit("fooSPLITbarsplitqux");
+        const char *expected[] = {"foo", "bar", "qux"};
+
+        U32 i = 0;
+        for (ArStrSplitIter iter = ar_str_split_iter_init(str, ar_str_lit("split"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE);
+                ar_str_split_iter_valid(&iter);
+                ar_str_split_iter_next(&iter)) {
+            AR_ASSERT(i < ar_arrlen(expected));
+            AR_ASSERT(ar_str_match(ar_str_split_iter_get(&iter), ar_str_cstr(expected[i]), AR_STR_MATCH_FLAG_EXACT));
+            i++;
+        }
+        AR_ASSERT(i == ar_arrlen(expected));
+    }
+
+    {
+        ArStr str = ar_str_lit("/foo//bar/");
+        const char *expected[] = {"", "foo", "", "bar"};
+
+        U32 i = 0;
+        for (ArStrSplitIter iter = ar_str_split_iter_init(str, ar_str_lit("/"), AR_STR_MATCH_FLAG_EXACT);
+                ar_str_split_iter_valid(&iter);
+                ar_str_split_iter_next(&iter)) {
+            AR_ASSERT(i < ar_arrlen(expected));
+            AR_ASSERT(ar_str_match(ar_str_split_iter_get(&iter), ar_str_cstr(expected[i]), AR_STR_MATCH_FLAG_EXACT));
+            i++;
+        }
+        AR_ASSERT(i == ar_arrlen(expected));
+    }
+
+    {
+        ArStrSplitIter iter = ar_str_split_iter_init(ar_str_lit(""), ar_str_lit(","), AR_STR_MATCH_FLAG_EXACT);
+        AR_ASSERT(!ar_str_split_iter_valid(&iter));
+
+        iter = ar_str_split_iter_init(ar_str_lit("foo"), ar_str_lit(""), AR_STR_MATCH_FLAG_EXACT);
+        AR_ASSERT(ar_str_match(ar_str_split_iter_get(&iter), ar_str_lit("foo"), AR_STR_MATCH_FLAG_EXACT));
+        ar_str_split_iter_next(&iter);
+        AR_ASSERT(!ar_str_split_iter_valid(&iter));
+    }
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_parse(void) {
+    U64 u = 0;
+    AR_ASSERT(ar_str_to_u64(ar_str_lit("1234567890123"), &u) && u == 1234567890123ull);
+    AR_ASSERT(ar_str_to_u64(ar_str_lit("18446744073709551615"), &u) && u == U64_MAX);
+    AR_ASSERT(!ar_str_to_u64(ar_str_lit("18446744073709551616"), &u));
+    AR_ASSERT(!ar_str_to_u64(ar_str_lit("-1"), &u));
+    AR_ASSERT(!ar_str_to_u64(ar_str_lit("12a"), &u));
+    AR_ASSERT(!ar_str_to_u64(ar_str_lit(""), &u));
+
+    I64 i = 0;
+    AR_ASSERT(ar_str_to_i64(ar_str_lit("-9223372036854775808"), &i) && i == I64_MIN);
+    AR_ASSERT(ar_str_to_i64(ar_str_lit("+42"), &i) && i == 42);
+    AR_ASSERT(!ar_str_to_i64(ar_str_lit("9223372036854775808"), &i));
+
+    // Parses slices without needing a null-terminator.
+    ArStr column = ar_str_lit("123,456");
+    AR_ASSERT(ar_str_to_u64(ar_str_sub(column, 0, 2), &u) && u == 123);
+
+    F64 f = 0.0;
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("0.1"), &f) && f == 0.1);
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("-2.5e-3"), &f) && f == -2.5e-3);
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("1.7976931348623157e308"), &f) && f == 1.7976931348623157e308);
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("4.9406564584124654e-324"), &f) && f == 4.9406564584124654e-324);
+    // Halfway between two doubles, rounds to even.
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("9007199254740993"), &f) && f == 9007199254740992.0);
+    // More digits than fit into 64 bits.
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("3.14159265358979323846264338327950288"), &f) && f == 3.141592653589793);
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("1e400"), &f) && f == __builtin_inf());
+    AR_ASSERT(ar_str_to_f64(ar_str_lit("nan"), &f) && f != f);
+    AR_ASSERT(!ar_str_to_f64(ar_str_lit("1e"), &f));
+    AR_ASSERT(!ar_str_to_f64(ar_str_lit("."), &f));
+    AR_ASSERT(!ar_str_to_f64(ar_str_lit("1.5x"), &f));
+
+    ArStr strs[] = {ar_str_lit("1.5"), ar_str_lit("2"), ar_str_lit("x"), ar_str_lit("4")};
+    F64 values[ar_arrlen(strs)] = {0};
+    AR_ASSERT(ar_str_to_f64_array(strs, 2, values) == 2);
+    AR_ASSERT(values[0] == 1.5 && values[1] == 2.0);
+    AR_ASSERT(ar_str_to_f64_array(strs, ar_arrlen(strs), values) == 2);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_array(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    {
+        ArStrArray array = ar_str_array_init(scratch.arena, 0, 0);
+        AR_ASSERT(array.count == 0 && array.len == 0);
+
+        // Grows both the blob and the offsets a few times over.
+        for (U32 i = 0; i < 1000; i++) {
+            ar_str_array_push(&array, ar_str_pushf(scratch.arena, "%u", i));
+        }
+        ar_str_array_push(&array, ar_str_lit(""));
+        AR_ASSERT(array.count == 1001);
+        for (U32 i = 0; i < 1000; i++) {
+            ArStr expected = ar_str_pushf(scratch.arena, "%u", i);
+            AR_ASSERT(ar_str_match(ar_str_array_get(&array, i), expected, AR_STR_MATCH_FLAG_EXACT));
+        }
+        AR_ASSERT(ar_str_array_get(&array, 1000).len == 0);
+
+        ArStrList list = ar_str_array_to_list(scratch.arena, &array);
+        U32 i = 0;
+        for (ArStrListNode *node = list.first; node != NULL; node = node->next) {
+            AR_ASSERT(node->str.data == ar_str_array_get(&array, i).data);
+            AR_ASSERT(node->str.len == ar_str_array_get(&array, i).len);
+            i++;
+        }
+        AR_ASSERT(i == 1001);
+
+        ArStrArray copy = ar_str_array_from_list(scratch.arena, list);
+        AR_ASSERT(copy.count == array.count && copy.len == array.len);
+        AR_ASSERT(copy.capacity == array.len);
+        AR_ASSERT(memcmp(copy.data, array.data, array.len) == 0);
+        AR_ASSERT(ar_str_match(ar_str_array_get(&copy, 999), ar_str_lit("999"), AR_STR_MATCH_FLAG_EXACT));
+    }
+
+    {
+        ArStr str = ar_str_lit("/foo//bar/");
+        ArStrArray array = ar_str_split_char_array(scratch.arena, str, '/', AR_STR_MATCH_FLAG_EXACT);
+        const char *expected[] = {"", "foo", "", "bar"};
+        AR_ASSERT(array.count == ar_arrlen(expected));
+        for (U32 i = 0; i < ar_arrlen(expected); i++) {
+            AR_ASSERT(ar_str_match(ar_str_array_get(&array, i), ar_str_cstr(expected[i]), AR_STR_MATCH_FLAG_EXACT));
+        }
+        AR_ASSERT(ar_str_match(ar_str(array.data, array.len), ar_str_lit("foobar"), AR_STR_MATCH_FLAG_EXACT));
+
+        // Long enough for the block scan, with tokens short and long, and
+        // short ones right at the end.
+        ArStr words = ar_str_lit("a bb ccc dddddddddddddddddddddddddddddddddddddddd  eeeee ffffffffffffffff gg h");
+        array = ar_str_split_char_array(scratch.arena, words, ' ', AR_STR_MATCH_FLAG_EXACT);
+        ArStrList list = ar_str_split_char(scratch.arena, words, ' ', AR_STR_MATCH_FLAG_EXACT);
+        U32 i = 0;
+        for (ArStrListNode *node = list.first; node != NULL; node = node->next) {
+            AR_ASSERT(ar_str_match(ar_str_array_get(&array, i), node->str, AR_STR_MATCH_FLAG_EXACT));
+            i++;
+        }
+        AR_ASSERT(i == array.count && i == 9);
+
+        array = ar_str_split_array(scratch.arena, ar_str_lit("fooSPLITbarsplitqux"), ar_str_lit("split"), AR_STR_MATCH_FLAG_CASE_INSENSITIVE);
+        AR_ASSERT(array.count == 3);
+        AR_ASSERT(ar_str_match(ar_str_array_get(&array, 2), ar_str_lit("qux"), AR_STR_MATCH_FLAG_EXACT));
+
+        array = ar_str_split_array(scratch.arena, ar_str_lit(""), ar_str_lit(","), AR_STR_MATCH_FLAG_EXACT);
+        AR_ASSERT(array.count == 0);
+    }
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
 ArTestCaseResult test_string_list(void) {
     ArTemp scratch = ar_scratch_get(NULL, 0);
 
@@ -283,6 +846,257 @@ static ArStr format_func(ArArena *arena, const char *fmt, ...) {
     return format;
 }
 
+ArTestCaseResult test_string_format_fast(void) {
+    char buffer[128];
+
+    U64 len = ar_format(buffer, sizeof(buffer), "%d|%5u|%-4x|%#o|%+.3d|%lld", -42, 7u, 255u, 8u, 5, -9223372036854775807ll - 1);
+    AR_ASSERT(strcmp(buffer, "-42|    7|ff  |010|+005|-9223372036854775808") == 0);
+    AR_ASSERT(len == strlen(buffer));
+
+    ar_format(buffer, sizeof(buffer), "%S|%.2S|%5S", ar_str_lit("foo"), ar_str_lit("bar"), ar_str_lit("qux"));
+    AR_ASSERT(strcmp(buffer, "foo|ba|  qux") == 0);
+
+    ar_format(buffer, sizeof(buffer), "%R %R %R %R %R %R", 0.1, 1.0, -2.5, 1e21, 5e-324, 1.7976931348623157e308);
+    AR_ASSERT(strcmp(buffer, "0.1 1 -2.5 1e+21 5e-324 1.7976931348623157e+308") == 0);
+
+    ar_format(buffer, sizeof(buffer), "%.2f %s", 1.005, "done");
+    AR_ASSERT(strcmp(buffer, "1.00 done") == 0);
+
+    // %n writes through the pointer type its length modifier names.
+    signed char n_hh = 0x7f;
+    short n_h = 0x7fff;
+    intmax_t n_j = -1;
+    ptrdiff_t n_t = -1;
+    ar_format(buffer, sizeof(buffer), "a%hhnbc%hnd%jnef%tn", &n_hh, &n_h, &n_j, &n_t);
+    AR_ASSERT(n_hh == 1 && n_h == 3 && n_j == 4 && n_t == 6);
+
+    // Truncates like snprintf.
+    len = ar_format(buffer, 4, "%s", "foobar");
+    AR_ASSERT(len == 6);
+    AR_ASSERT(strcmp(buffer, "foo") == 0);
+
+    len = ar_format_u64(buffer, 18446744073709551615ull);
+    AR_ASSERT(len == 20);
+    AR_ASSERT(memcmp(buffer, "18446744073709551615", len) == 0);
+
+    len = ar_format_i64(buffer, -1);
+    AR_ASSERT(len == 2);
+    AR_ASSERT(memcmp(buffer, "-1", len) == 0);
+
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_rope(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    {
+        ArRope *rope = ar_rope_init(scratch.arena, ar_str_lit("hello world"));
+        AR_ASSERT(ar_rope_len(rope) == 11);
+
+        ar_rope_insert(rope, 5, ar_str_lit(","));
+        ar_rope_insert(rope, 12, ar_str_lit("!"));
+        ar_rope_insert(rope, 0, ar_str_lit("> "));
+        ar_rope_insert(rope, 1000, ar_str_lit("?"));
+        ArStr flat = ar_rope_flatten(scratch.arena, rope);
+        AR_ASSERT(ar_str_match(flat, ar_str_lit("> hello, world!?"), AR_STR_MATCH_FLAG_EXACT));
+        AR_ASSERT(ar_rope_get(rope, 2) == 'h');
+        AR_ASSERT(ar_rope_get(rope, 15) == '?');
+
+        ar_rope_delete(rope, 8, 7);
+        ar_rope_delete(rope, 0, 2);
+        ar_rope_delete(rope, 6, 1000);
+        flat = ar_rope_flatten(scratch.arena, rope);
+        AR_ASSERT(ar_str_match(flat, ar_str_lit("hello,"), AR_STR_MATCH_FLAG_EXACT));
+
+        ar_rope_delete(rope, 0, ar_rope_len(rope));
+        AR_ASSERT(ar_rope_len(rope) == 0);
+        ar_rope_insert(rope, 0, ar_str_lit("again"));
+        flat = ar_rope_flatten(scratch.arena, rope);
+        AR_ASSERT(ar_str_match(flat, ar_str_lit("again"), AR_STR_MATCH_FLAG_EXACT));
+    }
+
+    {
+        // Random edits checked against a flat buffer.
+        U8 expected[4096];
+        U64 len = 0;
+        ArRope *rope = ar_rope_init(scratch.arena, (ArStr) {0});
+        U32 rng = 1;
+        U64 cursor = 0;
+        for (U32 i = 0; i < 4000; i++) {
+            rng = rng * 1103515245 + 12345;
+            U64 pos = len > 0 ? (rng >> 8) % (len + 1) : 0;
+            U64 n = (rng >> 4) % 24 + 1;
+            if ((rng >> 28) % 3 != 0 && len + n <= sizeof(expected)) {
+                U8 bytes[24];
+                for (U64 j = 0; j < n; j++) {
+                    bytes[j] = 'a' + (i + j) % 26;
+                }
+                // Typing right after the previous insert.
+                if ((rng >> 20) % 2 == 0) {
+                    pos = ar_min(cursor, len);
+                    n = 1;
+                }
+                memmove(expected + pos + n, expected + pos, len - pos);
+                memcpy(expected + pos, bytes, n);
+                len += n;
+                ar_rope_insert(rope, pos, ar_str(bytes, n));
+                cursor = pos + n;
+            } else {
+                n = ar_min(n, len - pos);
+                memmove(expected + pos, expected + pos + n, len - pos - n);
+                len -= n;
+                ar_rope_delete(rope, pos, n);
+            }
+            AR_ASSERT(ar_rope_len(rope) == len);
+        }
+
+        ArStr flat = ar_rope_flatten(scratch.arena, rope);
+        AR_ASSERT(ar_str_match(flat, ar_str(expected, len), AR_STR_MATCH_FLAG_EXACT));
+        for (U64 i = 0; i < len; i++) {
+            AR_ASSERT(ar_rope_get(rope, i) == expected[i]);
+        }
+
+        U64 start = len / 3;
+        U64 pos = start;
+        for (ArRopeIter iter = ar_rope_iter_init(rope, start, len / 2);
+                ar_rope_iter_valid(&iter);
+                ar_rope_iter_next(&iter)) {
+            ArStr chunk = ar_rope_iter_get(&iter);
+            AR_ASSERT(chunk.len > 0);
+            AR_ASSERT(memcmp(chunk.data, expected + pos, chunk.len) == 0);
+            pos += chunk.len;
+        }
+        AR_ASSERT(pos == start + len / 2);
+    }
+
+    ar_scratch_release(&scratch);
+    AR_SUCCESS();
+}
+
+ArTestCaseResult test_string_builder(void) {
+    ArTemp scratch = ar_scratch_get(NULL, 0);
+
+    {
+        ArStrBuilder builder = ar_str_builder_init(scratch.arena, 0);
+        ar_str_builder_push(&builder, ar_str_lit("foo"));
+        ar_str_builder_push_char(&builder, ',');
+        ar_str_builder_pushf(&builder, " %d %s", 42, "bar");
+
+        AR_ASSERT(builder.chunk_count == 1);
+        ArStr str = ar_str_builder_finalize(scratch.arena, &builder);
+        AR_ASSERT(ar_str_match(str, ar_str_lit("foo, 42 bar"), AR_STR_MATCH_FLAG_EXACT));
+    }
+
+    {
+        // Small chunks to force spilling over chunk boundaries.
+        ArStrBuilder builder = ar_str_builder_init(scratch.arena, 8);
+        ArStrList expected = {0};
+        for (U32 i = 0; i < 100; i++) {
+            ar_str_builder_pushf(&builder, "%u:", i);
+            ar_str_list_push(scratch.arena, &expected, ar_str_pushf(scratch.arena, "%u:", i));
+            ar_str_builder_push(&builder, ar_str_lit("a string longer than a chunk;"));
+            ar_str_list_push(scratch.arena, &expected, ar_str_lit("a string longer than a chunk;"));
+        }
+
+        ArStr expected_str = ar_str_list_join(scratch.arena, expected);
+        AR_ASSERT(builder.chunk_count > 1);
+        AR_ASSERT(builder.len == expected_str.len);
+
+        ArStr str = ar_str_builder_finalize(scratch.arena, &builder);
+        AR_ASSERT(ar_str_match(str, expected_str, AR_STR_MATCH_FLAG_EXACT));
+
+        U64 count = 0;
+        ArIoVec *iovecs = ar_str_builder_iovecs(scratch.arena, &builder, &count);
+        U64 offset = 0;
+        for (U64 i = 0; i < count; i++) {
+            AR_ASSERT(memcmp(iovecs[i].base, expected_str.data + offset, iovecs[i].len) == 0);
+            offset += iovecs[i].len;
+        }
+        AR_ASSERT(offset == expected_str.len);
+    }
+
+    {
+        ArStrBuilder builder = ar_str_builder_init(scratch.arena, 0);
+        ArStr str = ar_str_builder_finalize(scratch.arena, &builder);
+        AR_ASSERT(str.len == 0);
+    }
+
+    ar_scratch_release(&scratch);
+
+    AR_SUCCESS();
+}
+
+typedef struct InternThreadArgs InternThreadArgs;
+struct InternThreadArgs {
+    ArStrIntern *intern;
+    U32 ids[256];
+};
+
+static void intern_thread(void *args) {
+    InternThreadArgs *intern_args = args;
+    char buffer[32];
+    for (U32 i = 0; i < ar_arrlen(intern_args->ids); i++) {
+        U32 len = ar_format(buffer, sizeof(buffer), "field_%u", i);
+        intern_args->ids[i] = ar_str_intern(intern_args->intern, ar_str((U8 *) buffer, len));
+    }
+}
+
+ArTestCaseResult test_string_intern(void) {
+    {
+        ArStrIntern *intern = ar_str_intern_create((ArStrInternDesc) {0});
+
+        U32 foo = ar_str_intern(intern, ar_str_lit("foo"));
+        U32 bar = ar_str_intern(intern, ar_str_lit("bar"));
+        AR_ASSERT(foo == 0);
+        AR_ASSERT(bar == 1);
+        AR_ASSERT(ar_str_intern(intern, ar_str_lit("foo")) == foo);
+        AR_ASSERT(ar_str_intern_find(intern, ar_str_lit("bar")) == bar);
+        AR_ASSERT(ar_str_intern_find(intern, ar_str_lit("qux")) == AR_STR_INTERN_INVALID_ID);
+        AR_ASSERT(ar_str_match(ar_str_intern_get(intern, foo), ar_str_lit("foo"), AR_STR_MATCH_FLAG_EXACT));
+        AR_ASSERT(ar_str_intern_get(intern, 2).len == 0);
+
+        // Grows the table past its initial size.
+        char buffer[32];
+        for (U32 i = 0; i < 1000; i++) {
+            U32 len = ar_format(buffer, sizeof(buffer), "%u", i);
+            AR_ASSERT(ar_str_intern(intern, ar_str((U8 *) buffer, len)) == i + 2);
+        }
+        AR_ASSERT(ar_str_intern_count(intern) == 1002);
+        AR_ASSERT(ar_str_intern_find(intern, ar_str_lit("999")) == 1001);
+        AR_ASSERT(ar_str_intern_find(intern, ar_str_lit("foo")) == foo);
+
+        ar_str_intern_destroy(&intern);
+        AR_ASSERT(intern == NULL);
+    }
+
+    {
+        ArStrIntern *intern = ar_str_intern_create((ArStrInternDesc) {
+            .thread_safe = true,
+        });
+
+        InternThreadArgs args[4] = {0};
+        ArThread threads[ar_arrlen(args)];
+        for (U32 i = 0; i < ar_arrlen(args); i++) {
+            args[i].intern = intern;
+            threads[i] = ar_thread_create(intern_thread, &args[i]);
+        }
+        for (U32 i = 0; i < ar_arrlen(args); i++) {
+            ar_thread_join(threads[i]);
+        }
+
+        AR_ASSERT(ar_str_intern_count(intern) == 256);
+        for (U32 i = 0; i < ar_arrlen(args[0].ids); i++) {
+            for (U32 j = 1; j < ar_arrlen(args); j++) {
+                AR_ASSERT(args[j].ids[i] == args[0].ids[i]);
+            }
+        }
+
+        ar_str_intern_destroy(&intern);
+    }
+
+    AR_SUCCESS();
+}
+
 ArTestCaseResult test_string_format(void) {
     ArTemp scratch = ar_scratch_get(NULL, 0);
 
@@ -292,6 +1106,15 @@ ArTestCaseResult test_string_format(void) {
     format = ar_str_pushf(scratch.arena, "foo%d", 42);
     AR_ASSERT(ar_str_match(format, ar_str_lit("foo42"), 0));
 
+    // Longer than what gets formatted into up front.
+    char long_str[400];
+    memset(long_str, 'x', sizeof(long_str) - 1);
+    long_str[sizeof(long_str) - 1] = 0;
+    ArStr long_format = ar_str_pushf(scratch.arena, "%s%d", long_str, 7);
+    AR_ASSERT(long_format.len == 400);
+    AR_ASSERT(long_format.data[398] == 'x' && long_format.data[399] == '7');
+    AR_ASSERT(ar_str_match(format, ar_str_lit("foo42"), 0));
+
     ar_scratch_release(&scratch);
 
     AR_SUCCESS();
@@ -313,12 +1136,26 @@ ArTestResult test_strings(ArArena *arena) {
 
     AR_RUN_TEST(&state, test_char_helpers);
     AR_RUN_TEST(&state, test_string_match);
+    AR_RUN_TEST(&state, test_string_case);
     AR_RUN_TEST(&state, test_string_sub);
     AR_RUN_TEST(&state, test_string_find);
+    AR_RUN_TEST(&state, test_string_find_long);
+    AR_RUN_TEST(&state, test_string_scan);
+    AR_RUN_TEST(&state, test_string_matcher);
+    AR_RUN_TEST(&state, test_string_regex);
+    AR_RUN_TEST(&state, test_string_no_ctx);
+    AR_RUN_TEST(&state, test_string_utf8);
     AR_RUN_TEST(&state, test_string_split);
+    AR_RUN_TEST(&state, test_string_split_iter);
+    AR_RUN_TEST(&state, test_string_array);
     AR_RUN_TEST(&state, test_string_list);
+    AR_RUN_TEST(&state, test_string_parse);
     AR_RUN_TEST(&state, test_string_format);
+    AR_RUN_TEST(&state, test_string_format_fast);
+    AR_RUN_TEST(&state, test_string_builder);
+    AR_RUN_TEST(&state, test_string_rope);
     AR_RUN_TEST(&state, test_string_copy);
+    AR_RUN_TEST(&state, test_string_intern);
 
     return ar_test_end(state);
 }
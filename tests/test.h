@@ -4,9 +4,12 @@
 #include "arkin_test.h"
 
 extern ArTestResult test_core(ArArena *arena);
+extern ArTestResult test_arena(ArArena *arena);
 extern ArTestResult test_ll(ArArena *arena);
 extern ArTestResult test_strings(ArArena *arena);
 extern ArTestResult test_hash_map(ArArena *arena);
 extern ArTestResult test_pool(ArArena *arena);
+extern ArTestResult test_radix_tree(ArArena *arena);
+extern ArTestResult test_os(ArArena *arena);
 
 #endif